@@ -0,0 +1,242 @@
+#ifndef TB_MATH_NUM_ARRAY_ALIGNED_H
+#define TB_MATH_NUM_ARRAY_ALIGNED_H
+
+#include <array>
+#include <bit>
+#include <initializer_list>
+#include "num_array.h"
+#include "view.h"
+
+namespace tb::math {
+
+  // Storage layouts of an aligned_num_array
+  //
+  // The storage starts at a multiple of Alignment bytes. If Padded, each
+  // row (the last dimension) is also padded to a multiple of Alignment bytes,
+  // so that every row starts aligned and is a whole number of registers.
+  template<std::size_t Alignment, bool Padded = true>
+    struct aligned {
+      static_assert(std::has_single_bit(Alignment), "Alignment must be a power of two");
+      static constexpr std::size_t alignment = Alignment;
+      static constexpr bool padded = Padded;
+    };
+
+  // The size in bytes of the widest vector register enabled (at least 16).
+  inline constexpr std::size_t simd_alignment =
+    std::max<std::size_t>(16, simd::native<float>::width * sizeof(float));
+
+  // A layout padding rows to the widest vector register
+  using simd_layout = aligned<simd_alignment>;
+}
+
+namespace tb::math::detail {
+
+  // The extent of a row of n elements of T padded as specified by Layout
+  template<typename T, typename Layout, std::size_t N>
+    inline constexpr std::size_t padded_extent = [] {
+      if constexpr (Layout::padded && Layout::alignment > sizeof(T)) {
+        static_assert(Layout::alignment % sizeof(T) == 0);
+        constexpr auto w = Layout::alignment / sizeof(T);
+        return (N + w - 1) / w * w;
+      } else {
+        return N;
+      }
+    }();
+
+  template<std::size_t M, std::size_t... N>
+    inline constexpr std::size_t last_extent = std::get<sizeof...(N)>(std::array{ M, N... });
+
+  // num_array<T, E...> with its last extent replaced by P
+  template<typename T, std::size_t P, typename I, std::size_t... E>
+    struct with_last_extent { };
+  template<typename T, std::size_t P, std::size_t... I, std::size_t... E>
+    struct with_last_extent<T, P, std::index_sequence<I...>, E...> {
+      static constexpr std::size_t extents[] = { E... };
+      using type = num_array<T, (I + 1 < sizeof...(E) ? extents[I] : P)...>;
+    };
+
+  template<typename T, typename Layout, std::size_t M, std::size_t... N>
+    using padded_storage_t = with_last_extent<
+      T, padded_extent<T, Layout, last_extent<M, N...>>,
+      std::make_index_sequence<sizeof...(N) + 1>, M, N...>::type;
+
+  template<Number T, typename Layout, std::size_t M, std::size_t... N>
+    struct element_of<aligned_num_array<T, Layout, M, N...>> { using type = T; };
+  template<Number T, typename Layout, std::size_t M, std::size_t... N>
+    struct shape_of<aligned_num_array<T, Layout, M, N...>>
+    { using type = std::index_sequence<M, N...>; };
+  template<Number T, typename Layout, std::size_t M, std::size_t N, std::size_t... K>
+    struct sub_operand<aligned_num_array<T, Layout, M, N, K...>>
+    { using type = num_array_view<const T, N, K...>; };
+
+  template<Number T, typename Layout, std::size_t M, std::size_t... N>
+    inline constexpr bool is_dense<aligned_num_array<T, Layout, M, N...>> =
+      padded_storage_t<T, Layout, M, N...>::n_elements() == (M * ... * N);
+}
+
+namespace tb::math {
+
+  // A num_array whose storage is aligned as specified by Layout (an
+  // aligned<Alignment, Padded>), with rows padded to whole registers.
+  //
+  // Elements are accessed as in a num_array; a row of a matrix (or higher
+  // order array) is a num_array_view that skips the padding. Arithmetic with
+  // scalars, and with arrays of the same type, processes the padded rows
+  // whole, with full-width vector loads and stores. Other operations see
+  // only the elements, through view() or as an Array_expression, so that it
+  // can be used wherever a num_array is accepted.
+  //
+  // NOTE: The padding elements are zero on construction, but their values
+  // are unspecified after arithmetic (e.g. x /= 0 leaves them NaN).
+  template<Number T, typename Layout, std::size_t M, std::size_t... N>
+    class aligned_num_array : public num_array_base<T, M, N...> {
+    public:
+      using element_type    = T;
+      using value_type      = T;
+      using size_type       = std::size_t;
+      using storage_type    = detail::padded_storage_t<T, Layout, M, N...>;
+      using view_type       = num_array_view<T, M, N...>;
+      using const_view_type = num_array_view<const T, M, N...>;
+
+      static constexpr std::size_t alignment = Layout::alignment;
+
+      constexpr aligned_num_array() { clear_padding(storage_); } // uninitialized elements
+      constexpr aligned_num_array(const T& x) : storage_(x) { clear_padding(storage_); }
+      constexpr aligned_num_array(const num_array<T, M, N...>& x)
+      { clear_padding(storage_); *this = x; }
+      constexpr aligned_num_array(
+        const std::initializer_list<typename num_array<T, M, N...>::value_type>& init_list)
+        : aligned_num_array(num_array<T, M, N...>(init_list)) { }
+      template<detail::Conforming_expression<std::index_sequence<M, N...>> E>
+        constexpr aligned_num_array(const E& x) { clear_padding(storage_); *this = x; }
+
+      constexpr aligned_num_array& operator=(const num_array<T, M, N...>& x)
+      { return assign(storage_, x, [](T& y, const T& z){ y = z; }); }
+      template<detail::Conforming_expression<std::index_sequence<M, N...>> E>
+        constexpr aligned_num_array& operator=(const E& x)
+        { return assign(storage_, x, [](T& y, const auto& z){ y = z; }); }
+
+      // Returns the i-th element of a one-dimensional array, or a view of
+      // the i-th "row" otherwise.
+      constexpr decltype(auto) operator[](size_type i) const noexcept
+      {
+        if constexpr (sizeof...(N) == 0) return storage_[i];
+        else return view()[i];
+      }
+      constexpr decltype(auto) operator[](size_type i) noexcept
+      {
+        if constexpr (sizeof...(N) == 0) return storage_[i];
+        else return view()[i];
+      }
+
+      template<Index_type Index, Index_type... Indices>
+        constexpr auto& operator()(Index i, Indices... j) const noexcept
+          requires (sizeof...(Indices) == sizeof...(N))
+        { return storage_(i, j...); }
+      template<Index_type Index, Index_type... Indices>
+        constexpr auto& operator()(Index i, Indices... j) noexcept
+          requires (sizeof...(Indices) == sizeof...(N))
+        { return storage_(i, j...); }
+
+      // The first element, at a multiple of alignment bytes
+      constexpr const T* data() const noexcept { return detail::all_elements(storage_); }
+      constexpr T*       data()       noexcept { return detail::all_elements(storage_); }
+
+      // The elements, without the padding
+      constexpr const_view_type view() const noexcept { return { data(), strides() }; }
+      constexpr view_type       view()       noexcept { return { data(), strides() }; }
+
+      // The elements and the padding
+      constexpr const storage_type& storage() const noexcept { return storage_; }
+
+      static constexpr auto strides() noexcept
+      {
+        return []<std::size_t... S>(const num_array<T, S...>*) {
+          return detail::row_major_strides<std::ptrdiff_t, S...>();
+        }(static_cast<const storage_type*>(nullptr));
+      }
+
+      // Arithmetic operations
+
+      constexpr auto& operator+=(const T& x) { storage_ += x; return *this; }
+      constexpr auto& operator-=(const T& x) { storage_ -= x; return *this; }
+      constexpr auto& operator*=(const T& x) { storage_ *= x; return *this; }
+      constexpr auto& operator/=(const T& x) { storage_ /= x; return *this; }
+
+      constexpr auto& operator+=(const aligned_num_array& x) { storage_ += x.storage_; return *this; }
+      constexpr auto& operator-=(const aligned_num_array& x) { storage_ -= x.storage_; return *this; }
+      // Element-wise (Hadamard) product and quotient. The padding is skipped
+      // by a quotient, in which it would be 0 / 0.
+      constexpr auto& operator*=(const aligned_num_array& x) { storage_ *= x.storage_; return *this; }
+      constexpr auto& operator/=(const aligned_num_array& x)
+      {
+        if constexpr (detail::is_dense<aligned_num_array>) storage_ /= x.storage_;
+        else assign(storage_, x.storage_, [](T& y, const T& z){ y /= z; });
+        return *this;
+      }
+
+      template<Array_expression E>
+        constexpr auto& operator+=(const E& x)
+          requires detail::Same_shape<E, aligned_num_array>
+        { return assign(storage_, x, [](T& y, const auto& z){ y += z; }); }
+      template<Array_expression E>
+        constexpr auto& operator-=(const E& x)
+          requires detail::Same_shape<E, aligned_num_array>
+        { return assign(storage_, x, [](T& y, const auto& z){ y -= z; }); }
+      template<Array_expression E>
+        constexpr auto& operator*=(const E& x)
+          requires detail::Same_shape<E, aligned_num_array>
+        { return assign(storage_, x, [](T& y, const auto& z){ y *= z; }); }
+      template<Array_expression E>
+        constexpr auto& operator/=(const E& x)
+          requires detail::Same_shape<E, aligned_num_array>
+        { return assign(storage_, x, [](T& y, const auto& z){ y /= z; }); }
+
+    private:
+      static constexpr std::size_t row_extent = detail::last_extent<M, N...>;
+
+      // Applies func(y, x') to the elements y of s (part of the storage),
+      // where x' is the corresponding element of x, skipping the padding.
+      template<typename S>
+        constexpr aligned_num_array& assign(S& s, const auto& x, auto func)
+        {
+          if constexpr (S::order() == 1) {
+            for (std::size_t j = 0; j < row_extent; ++j) func(s[j], detail::subscript(x, j));
+          } else {
+            for (std::size_t i = 0; i < S::size(); ++i) assign(s[i], detail::subscript(x, i), func);
+          }
+          return *this;
+        }
+
+      template<typename S>
+        static constexpr void clear_padding(S& s)
+        {
+          if constexpr (S::order() == 1) {
+            for (std::size_t j = row_extent; j < S::size(); ++j) s[j] = T(0);
+          } else {
+            for (auto& row : s) clear_padding(row);
+          }
+        }
+
+      alignas(alignment) storage_type storage_;
+    };
+
+  // Aligned aliases: the vectors and matrices of vector.h and matrix.h, with
+  // rows padded to a power of two bytes (e.g. a vec3 of floats to 16).
+
+  template<Number T, std::size_t N>
+    using aligned_vec = aligned_num_array<T, aligned<std::bit_ceil(N * sizeof(T))>, N>;
+  template<Number T, std::size_t N>
+    using aligned_mat = aligned_num_array<T, aligned<std::bit_ceil(N * sizeof(T))>, N, N>;
+
+  using avec3f = aligned_vec<float, 3>;
+  using avec4f = aligned_vec<float, 4>;
+  using avec3d = aligned_vec<double, 3>;
+  using avec4d = aligned_vec<double, 4>;
+
+  using amat3f = aligned_mat<float, 3>;
+  using amat4f = aligned_mat<float, 4>;
+  using amat3d = aligned_mat<double, 3>;
+  using amat4d = aligned_mat<double, 4>;
+}
+#endif//TB_MATH_NUM_ARRAY_ALIGNED_H
@@ -0,0 +1,224 @@
+#ifndef TB_MATH_NUM_ARRAY_ARENA_H
+#define TB_MATH_NUM_ARRAY_ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+
+namespace tb::math {
+
+  // A bump allocator: memory is carved from large blocks obtained from an
+  // upstream resource, and deallocation does nothing. rewind() (or reset())
+  // makes the memory allocated since a mark() available again, and keeps
+  // the blocks, so once an arena has grown to the size of a workload (e.g.
+  // the temporaries of a frame), repeating it does not call the upstream
+  // resource at all.
+  //
+  // NOTE: An arena is not thread-safe; see thread_arena().
+  class arena : public std::pmr::memory_resource {
+    struct block {
+      block* next;
+      std::size_t size; // bytes after the header
+    };
+
+  public:
+    using size_type = std::size_t;
+
+    // A position in the arena, to which it can be rewound
+    struct marker {
+      block* current;
+      std::byte* top;
+    };
+
+    explicit arena(size_type block_size = 1 << 20,
+                   std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+      : block_size_(block_size), upstream_(upstream) { }
+    ~arena() { release(); }
+
+    arena(const arena&) = delete;
+    arena& operator=(const arena&) = delete;
+
+    marker mark() const noexcept { return { current_, top_ }; }
+    void rewind(const marker& m) noexcept { current_ = m.current; top_ = m.top; }
+    void reset() noexcept { rewind({ first_, first_ ? begin(first_) : nullptr }); }
+
+    // Returns the blocks to the upstream resource.
+    void release() noexcept;
+
+    // The total size of the blocks obtained from upstream
+    size_type capacity() const noexcept;
+
+    std::pmr::memory_resource* upstream_resource() const noexcept { return upstream_; }
+
+  private:
+    void* do_allocate(size_type bytes, size_type alignment) override;
+    void do_deallocate(void*, size_type, size_type) noexcept override { }
+    bool do_is_equal(const std::pmr::memory_resource& x) const noexcept override
+    { return this == &x; }
+
+    static std::byte* begin(block* b) noexcept { return reinterpret_cast<std::byte*>(b + 1); }
+    static std::byte* end(block* b) noexcept { return begin(b) + b->size; }
+
+    // Returns p aligned up, if [p, p + bytes) aligned fits in b.
+    static std::byte* fit(block* b, std::byte* p, size_type bytes, size_type alignment) noexcept
+    {
+      const auto a = (reinterpret_cast<std::uintptr_t>(p) + alignment - 1) & ~(alignment - 1);
+      const auto q = p + (a - reinterpret_cast<std::uintptr_t>(p));
+      return static_cast<size_type>(end(b) - q) >= bytes ? q : nullptr;
+    }
+
+    size_type block_size_;
+    std::pmr::memory_resource* upstream_;
+    block* first_ = nullptr;
+    block* current_ = nullptr;
+    std::byte* top_ = nullptr;
+  };
+
+  inline void*
+  arena::do_allocate(size_type bytes, size_type alignment)
+  {
+    // The current block, then the following ones, kept from before a rewind
+    const auto start = current_ ? current_ : first_;
+    for (auto b = start; b; b = b->next) {
+      if (auto p = fit(b, b == current_ ? top_ : begin(b), bytes, alignment)) {
+        current_ = b;
+        top_ = p + bytes;
+        return p;
+      }
+    }
+
+    // A new block, at the end of the list
+    auto last = start;
+    while (last && last->next) last = last->next;
+    const auto size = std::max({ block_size_, last ? 2 * last->size : 0,
+                                 bytes + alignment });
+    auto b = static_cast<block*>(upstream_->allocate(sizeof(block) + size, alignof(block)));
+    *b = { nullptr, size };
+    (last ? last->next : first_) = b;
+    current_ = b;
+    const auto p = fit(b, begin(b), bytes, alignment);
+    top_ = p + bytes;
+    return p;
+  }
+
+  inline void
+  arena::release() noexcept
+  {
+    while (first_) {
+      const auto next = first_->next;
+      upstream_->deallocate(first_, sizeof(block) + first_->size, alignof(block));
+      first_ = next;
+    }
+    current_ = nullptr;
+    top_ = nullptr;
+  }
+
+  inline arena::size_type
+  arena::capacity() const noexcept
+  {
+    size_type result = 0;
+    for (auto b = first_; b; b = b->next) result += b->size;
+    return result;
+  }
+
+  // The arena of the calling thread, for temporaries (see arena_scope).
+  inline arena&
+  thread_arena()
+  {
+    thread_local arena a;
+    return a;
+  }
+}
+
+namespace tb::math::detail {
+
+  inline std::pmr::memory_resource*&
+  thread_resource() noexcept
+  {
+    thread_local std::pmr::memory_resource* r = nullptr;
+    return r;
+  }
+
+  // Scratch space of n value-initialized Ts from thread_arena(), aligned to
+  // a cache line. The arena is rewound at the end of its scope, so scratch
+  // buffers must be destroyed in the reverse order of their construction.
+  template<typename T>
+    class scratch_buffer {
+    public:
+      explicit scratch_buffer(std::size_t n)
+        : mark_(thread_arena().mark()), n_(n),
+          data_(static_cast<T*>(thread_arena().allocate(
+            n * sizeof(T), std::max<std::size_t>(64, alignof(T)))))
+      {
+        std::uninitialized_value_construct_n(data_, n_);
+      }
+      ~scratch_buffer()
+      {
+        std::destroy_n(data_, n_);
+        thread_arena().rewind(mark_);
+      }
+
+      scratch_buffer(const scratch_buffer&) = delete;
+      scratch_buffer& operator=(const scratch_buffer&) = delete;
+
+      T* data() noexcept { return data_; }
+
+    private:
+      arena::marker mark_;
+      std::size_t n_;
+      T* data_;
+    };
+}
+
+namespace tb::math {
+
+  // The memory resource from which dynamic_num_arrays created on the calling
+  // thread allocate their elements, unless another is given: that of the
+  // innermost resource_scope, or std::pmr::get_default_resource().
+  inline std::pmr::memory_resource*
+  array_resource() noexcept
+  {
+    const auto r = detail::thread_resource();
+    return r ? r : std::pmr::get_default_resource();
+  }
+
+  // Makes r the array_resource() of the calling thread until the end of the
+  // scope.
+  class resource_scope {
+  public:
+    explicit resource_scope(std::pmr::memory_resource* r) noexcept
+      : previous_(std::exchange(detail::thread_resource(), r)) { }
+    ~resource_scope() { detail::thread_resource() = previous_; }
+
+    resource_scope(const resource_scope&) = delete;
+    resource_scope& operator=(const resource_scope&) = delete;
+
+  private:
+    std::pmr::memory_resource* previous_;
+  };
+
+  // Allocates the dynamic_num_arrays created on the calling thread until the
+  // end of the scope (including the results and temporaries of operators,
+  // transpose, matrix_product, ...) from thread_arena(), and frees them all
+  // at once at the end of the scope. Scopes can be nested.
+  //
+  // NOTE: Arrays allocated within the scope must not be used after it. To
+  // keep a result, assign it to an array created outside the scope: an array
+  // keeps its own memory resource when assigned to, so the elements are
+  // copied.
+  class arena_scope : resource_scope {
+  public:
+    arena_scope() : arena_scope(thread_arena()) { }
+    explicit arena_scope(arena& a) noexcept
+      : resource_scope(&a), arena_(a), mark_(a.mark()) { }
+    ~arena_scope() { arena_.rewind(mark_); }
+
+  private:
+    arena& arena_;
+    arena::marker mark_;
+  };
+}
+#endif//TB_MATH_NUM_ARRAY_ARENA_H
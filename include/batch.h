@@ -0,0 +1,110 @@
+#ifndef TB_MATH_NUM_ARRAY_BATCH_H
+#define TB_MATH_NUM_ARRAY_BATCH_H
+
+#include <ranges>
+#include <stdexcept>
+#include "matrix.h"
+#include "thread_pool.h"
+
+namespace tb::math::detail {
+
+  template<typename R>
+    using range_element_t = std::remove_cvref_t<std::ranges::range_reference_t<R>>;
+
+  // True if R is a random access range of num_arrays with the given shape
+  template<typename R, typename Shape>
+    concept Batch_of = std::ranges::random_access_range<R> && std::ranges::sized_range<R>
+                    && is_num_array<range_element_t<R>>::value
+                    && std::same_as<shape_t<range_element_t<R>>, Shape>;
+
+  // True if R is an output Batch_of num_arrays with the given shape
+  template<typename R, typename Shape>
+    concept Output_batch_of = Batch_of<R, Shape>
+      && std::is_assignable_v<std::ranges::range_reference_t<R>, range_element_t<R>>;
+}
+
+namespace tb::math {
+
+  // Batched operations
+  //
+  // These apply a matrix operation to each element of a batch (a random
+  // access range, such as a std::vector or std::span, of num_arrays) and
+  // write the i-th result to the i-th element of an output batch of the same
+  // size, which is not resized. The work is divided among the threads of a
+  // thread_pool (the default pool unless one is given) in pieces of at most
+  // grain elements, or an automatic size if grain is 0. Since each result
+  // has a fixed place in the output, the output does not depend on the
+  // number of threads or on how the work was divided.
+  //
+  // std::invalid_argument is thrown if the batches differ in size.
+
+  // Batch Transform
+  // y[i] = a * x[i], for a matrix a
+  template<Matrix_expression E, typename X, typename Y>
+    void
+    batch_transform(thread_pool& pool, const E& a, const X& x, Y&& y,
+                    std::size_t grain = 0)
+      requires detail::Batch_of<X, std::index_sequence<E::extent(1)>>
+            && detail::Output_batch_of<Y, std::index_sequence<E::extent(0)>>
+    {
+      const auto n = std::ranges::size(x);
+      if (n != std::ranges::size(y)) throw std::invalid_argument("Incompatible batch sizes");
+      const auto first_x = std::ranges::begin(x);
+      const auto first_y = std::ranges::begin(y);
+      pool.parallel_for(0, n, grain, [&](std::size_t i, std::size_t j) {
+        for (; i < j; ++i) first_y[i] = matrix_vector_product(a, first_x[i]);
+      });
+    }
+
+  template<Matrix_expression E, typename X, typename Y>
+    void
+    batch_transform(const E& a, const X& x, Y&& y, std::size_t grain = 0)
+      requires detail::Batch_of<X, std::index_sequence<E::extent(1)>>
+            && detail::Output_batch_of<Y, std::index_sequence<E::extent(0)>>
+    {
+      batch_transform(thread_pool::default_pool(), a, x, y, grain);
+    }
+
+  // Batched Matrix Product
+  // c[i] = a[i] * b[i]
+  template<typename A, typename B, typename C>
+    void
+    matrix_product(thread_pool& pool, const A& a, const B& b, C&& c,
+                   std::size_t grain = 0)
+      requires detail::Batch_of<A, detail::shape_t<detail::range_element_t<A>>>
+            && (detail::range_element_t<A>::order() == 2)
+            && detail::Batch_of<B, std::index_sequence<
+                 detail::range_element_t<A>::extent(1),
+                 detail::range_element_t<B>::extent(1)>>
+            && detail::Output_batch_of<C, std::index_sequence<
+                 detail::range_element_t<A>::extent(0),
+                 detail::range_element_t<B>::extent(1)>>
+    {
+      const auto n = std::ranges::size(a);
+      if (n != std::ranges::size(b) || n != std::ranges::size(c)) {
+        throw std::invalid_argument("Incompatible batch sizes");
+      }
+      const auto first_a = std::ranges::begin(a);
+      const auto first_b = std::ranges::begin(b);
+      const auto first_c = std::ranges::begin(c);
+      pool.parallel_for(0, n, grain, [&](std::size_t i, std::size_t j) {
+        for (; i < j; ++i) first_c[i] = matrix_product(first_a[i], first_b[i]);
+      });
+    }
+
+  template<typename A, typename B, typename C>
+    void
+    matrix_product(const A& a, const B& b, C&& c, std::size_t grain = 0)
+      requires detail::Batch_of<A, detail::shape_t<detail::range_element_t<A>>>
+            && (detail::range_element_t<A>::order() == 2)
+            && detail::Batch_of<B, std::index_sequence<
+                 detail::range_element_t<A>::extent(1),
+                 detail::range_element_t<B>::extent(1)>>
+            && detail::Output_batch_of<C, std::index_sequence<
+                 detail::range_element_t<A>::extent(0),
+                 detail::range_element_t<B>::extent(1)>>
+    {
+      matrix_product(thread_pool::default_pool(), a, b, c, grain);
+    }
+}
+#endif//TB_MATH_NUM_ARRAY_BATCH_H
@@ -0,0 +1,756 @@
+#ifndef TB_MATH_DYNAMIC_NUM_ARRAY_H
+#define TB_MATH_DYNAMIC_NUM_ARRAY_H
+
+#include <array>
+#include <cmath>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <utility>
+#include "arena.h"
+#include "num_array.h"
+#include "gemm.h"
+
+namespace tb::math::detail {
+
+  // Copies the elements of x to out in row-major order.
+  template<Number T, std::size_t M, std::size_t... N>
+    constexpr auto
+    flat_copy(const num_array<T, M, N...>& x, auto out)
+    {
+      if constexpr (sizeof...(N) == 0) {
+        return std::copy(x.begin(), x.end(), out);
+      } else {
+        for (const auto& row : x) out = flat_copy(row, out);
+        return out;
+      }
+    }
+
+  // The element type of a product of arrays of T1 and T2: R, or their
+  // common type if R is void
+  template<typename R, typename T1, typename T2>
+    using product_result_t = std::conditional_t<std::is_void_v<R>, std::common_type_t<T1, T2>, R>;
+}
+
+namespace tb::math {
+
+  template<Number T, std::size_t Rank> class dynamic_num_array;
+
+  template<typename T>
+    struct is_dynamic_num_array : std::false_type { };
+  template<Number T, std::size_t Rank>
+    struct is_dynamic_num_array<dynamic_num_array<T, Rank>> : std::true_type { };
+
+  // Class template for num_arrays of a fixed order (Rank) whose extents are
+  // only known at runtime. Elements are stored contiguously in row-major
+  // order on the heap, aligned to a cache line, so large arrays can be
+  // returned and passed by value (moved) without copying their elements.
+  //
+  // The elements are allocated from a std::pmr::memory_resource: the one
+  // given to the constructor, or else array_resource() (see arena.h), which
+  // is the default resource unless a resource_scope or arena_scope selects
+  // another for the calling thread. Copies allocate from array_resource(),
+  // moves take the resource along with the elements, and assignment keeps
+  // the resource of the array assigned to.
+  template<Number T, std::size_t Rank>
+    class dynamic_num_array {
+      static_assert(Rank > 0);
+    public:
+      using element_type    = std::remove_const<T>::type;
+      using value_type      = element_type;
+      using size_type       = std::size_t;
+      using extents_type    = std::array<size_type, Rank>;
+      using pointer         = value_type*;
+      using const_pointer   = const value_type*;
+      using iterator        = pointer;
+      using const_iterator  = const_pointer;
+      using resource_type   = std::pmr::memory_resource;
+
+      static constexpr std::size_t alignment = 64;
+
+      dynamic_num_array() noexcept : extents_{ } { } // empty array
+      explicit dynamic_num_array(resource_type* resource) noexcept
+        : extents_{ }, resource_(resource) { }
+      explicit dynamic_num_array(const extents_type& extents,
+                                 resource_type* resource = array_resource());
+      dynamic_num_array(const extents_type& extents, const T& value,
+                        resource_type* resource = array_resource());
+      template<Index_type... Extents>
+        explicit dynamic_num_array(Extents... extents)
+          requires (sizeof...(Extents) == Rank)
+          : dynamic_num_array(extents_type{ static_cast<size_type>(extents)... })
+        { }
+      template<Number U>
+        dynamic_num_array(const dynamic_num_array<U, Rank>& x)
+          requires std::common_with<T, U>;
+      template<Number U, std::size_t M, std::size_t... N>
+        dynamic_num_array(const num_array<U, M, N...>& x)
+          requires (sizeof...(N) + 1 == Rank) && std::common_with<T, U>;
+
+      dynamic_num_array(const dynamic_num_array& x);
+      dynamic_num_array(const dynamic_num_array& x, resource_type* resource);
+      dynamic_num_array(dynamic_num_array&& x) noexcept;
+      ~dynamic_num_array() { release(); }
+
+      dynamic_num_array& operator=(const dynamic_num_array& x);
+      dynamic_num_array& operator=(dynamic_num_array&& x);
+      dynamic_num_array& operator=(const T& x)
+      { std::fill_n(data_, n_elements(), x); return *this; }
+
+      // Structure
+
+      size_type size() const noexcept { return extents_[0]; } // number of "rows"
+      static constexpr auto order() { return Rank; }
+      size_type extent(std::size_t i) const { return extents_[i]; }
+      const extents_type& extents() const noexcept { return extents_; }
+      size_type n_elements() const noexcept { return n_elements(extents_); }
+      bool empty() const noexcept { return n_elements() == 0; }
+
+      // Element access
+
+      template<Index_type... Indices>
+        auto& operator()(Indices... i) const noexcept
+          requires (sizeof...(Indices) == Rank)
+        { return data_[offset(i...)]; }
+
+      template<Index_type... Indices>
+        auto& operator()(Indices... i) noexcept
+          requires (sizeof...(Indices) == Rank)
+        { return data_[offset(i...)]; }
+
+      template<Index_type... Indices>
+        auto& at(Indices... i) const
+          requires (sizeof...(Indices) == Rank)
+        { assert(in_bounds(i...)); return data_[offset(i...)]; }
+
+      template<Index_type... Indices>
+        auto& at(Indices... i)
+          requires (sizeof...(Indices) == Rank)
+        { assert(in_bounds(i...)); return data_[offset(i...)]; }
+
+      auto& operator[](size_type i) const noexcept requires (Rank == 1)
+      { return data_[i]; }
+      auto& operator[](size_type i)       noexcept requires (Rank == 1)
+      { return data_[i]; }
+
+      const_pointer data() const noexcept { return data_; }
+      pointer       data()       noexcept { return data_; }
+
+      resource_type* resource() const noexcept { return resource_; }
+
+      // Iterators (over all elements, in row-major order)
+
+      const_iterator begin()  const noexcept { return data_; }
+      iterator       begin()        noexcept { return data_; }
+
+      const_iterator end()    const noexcept { return data_ + n_elements(); }
+      iterator       end()          noexcept { return data_ + n_elements(); }
+
+      const_iterator cbegin() const noexcept { return begin(); }
+      const_iterator cend()   const noexcept { return end(); }
+
+      // Arithmetic operations
+
+      auto& operator+=(const T& rhs) { return transform(rhs, simd::add_assign{}); }
+      auto& operator-=(const T& rhs) { return transform(rhs, simd::sub_assign{}); }
+      auto& operator*=(const T& rhs) { return transform(rhs, simd::mul_assign{}); }
+      auto& operator/=(const T& rhs) { return transform(rhs, simd::div_assign{}); }
+
+      auto& operator+=(const dynamic_num_array& rhs)
+      { return transform(rhs, simd::add_assign{}); }
+      auto& operator-=(const dynamic_num_array& rhs)
+      { return transform(rhs, simd::sub_assign{}); }
+      // Element-wise (Hadamard) product and quotient
+      auto& operator*=(const dynamic_num_array& rhs)
+      { return transform(rhs, simd::mul_assign{}); }
+      auto& operator/=(const dynamic_num_array& rhs)
+      { return transform(rhs, simd::div_assign{}); }
+
+    private:
+      static size_type n_elements(const extents_type& extents) noexcept
+      {
+        size_type n = 1;
+        for (auto e : extents) n *= e;
+        return n;
+      }
+
+      template<Index_type... Indices>
+        size_type offset(Indices... i) const noexcept
+        {
+          const size_type index[] = { static_cast<size_type>(i)... };
+          size_type result = index[0];
+          for (std::size_t k = 1; k < Rank; ++k)
+            result = result * extents_[k] + index[k];
+          return result;
+        }
+
+      template<Index_type... Indices>
+        bool in_bounds(Indices... i) const noexcept
+        {
+          const size_type index[] = { static_cast<size_type>(i)... };
+          for (std::size_t k = 0; k < Rank; ++k)
+            if (index[k] >= extents_[k]) return false;
+          return true;
+        }
+
+      auto& transform(const T& x, auto op)
+      {
+        simd::transform(data_, x, op, n_elements());
+        return *this;
+      }
+
+      auto& transform(const dynamic_num_array& x, auto op)
+      {
+        if (extents_ != x.extents_)
+          throw std::invalid_argument("Incompatible extents");
+        simd::transform(data_, x.data_, op, n_elements());
+        return *this;
+      }
+
+      pointer allocate(size_type n)
+      {
+        if (n == 0) return nullptr;
+        return static_cast<pointer>(resource_->allocate(n * sizeof(T), alignment));
+      }
+
+      void release() noexcept
+      {
+        if (!data_) return;
+        std::destroy_n(data_, n_elements());
+        resource_->deallocate(data_, n_elements() * sizeof(T), alignment);
+        data_ = nullptr;
+      }
+
+      extents_type extents_;
+      resource_type* resource_ = array_resource();
+      pointer data_ = nullptr;
+    };
+
+  // Construct an array with the given extents. The elements are default
+  // initialized (uninitialized for arithmetic types), as with num_array.
+  template<Number T, std::size_t Rank>
+    dynamic_num_array<T, Rank>::dynamic_num_array(const extents_type& extents,
+                                                  resource_type* resource)
+      : extents_(extents), resource_(resource), data_(allocate(n_elements(extents)))
+    {
+      std::uninitialized_default_construct_n(data_, n_elements());
+    }
+
+  template<Number T, std::size_t Rank>
+    dynamic_num_array<T, Rank>::dynamic_num_array(const extents_type& extents,
+                                                  const T& value,
+                                                  resource_type* resource)
+      : extents_(extents), resource_(resource), data_(allocate(n_elements(extents)))
+    {
+      std::uninitialized_fill_n(data_, n_elements(), value);
+    }
+
+  template<Number T, std::size_t Rank>
+    template<Number U>
+      dynamic_num_array<T, Rank>::dynamic_num_array(
+        const dynamic_num_array<U, Rank>& x)
+          requires std::common_with<T, U>
+        : extents_(x.extents()), data_(allocate(x.n_elements()))
+      {
+        std::uninitialized_copy_n(x.begin(), n_elements(), data_);
+      }
+
+  template<Number T, std::size_t Rank>
+    template<Number U, std::size_t M, std::size_t... N>
+      dynamic_num_array<T, Rank>::dynamic_num_array(
+        const num_array<U, M, N...>& x)
+          requires (sizeof...(N) + 1 == Rank) && std::common_with<T, U>
+        : extents_{ M, N... }, data_(allocate(x.n_elements()))
+      {
+        std::uninitialized_default_construct_n(data_, n_elements());
+        detail::flat_copy(x, data_);
+      }
+
+  template<Number T, std::size_t Rank>
+    dynamic_num_array<T, Rank>::dynamic_num_array(const dynamic_num_array& x)
+      : dynamic_num_array(x, array_resource())
+    { }
+
+  template<Number T, std::size_t Rank>
+    dynamic_num_array<T, Rank>::dynamic_num_array(const dynamic_num_array& x,
+                                                  resource_type* resource)
+      : extents_(x.extents_), resource_(resource), data_(allocate(x.n_elements()))
+    {
+      std::uninitialized_copy_n(x.data_, n_elements(), data_);
+    }
+
+  // Moving an array steals its buffer (and resource) and leaves it empty.
+  template<Number T, std::size_t Rank>
+    dynamic_num_array<T, Rank>::dynamic_num_array(dynamic_num_array&& x) noexcept
+      : extents_(std::exchange(x.extents_, extents_type{ })),
+        resource_(x.resource_),
+        data_(std::exchange(x.data_, nullptr))
+    { }
+
+  template<Number T, std::size_t Rank>
+    dynamic_num_array<T, Rank>&
+    dynamic_num_array<T, Rank>::operator=(const dynamic_num_array& x)
+    {
+      if (this == &x) return *this;
+      if (n_elements() == x.n_elements()) {
+        extents_ = x.extents_;
+        std::copy_n(x.data_, n_elements(), data_);
+      } else {
+        *this = dynamic_num_array(x, resource_);
+      }
+      return *this;
+    }
+
+  // The buffer of x is only stolen if it was allocated from an equal
+  // resource; otherwise the elements are copied, so an array never refers
+  // to memory of a resource (e.g. an arena) other than its own.
+  template<Number T, std::size_t Rank>
+    dynamic_num_array<T, Rank>&
+    dynamic_num_array<T, Rank>::operator=(dynamic_num_array&& x)
+    {
+      if (this == &x) return *this;
+      if (*resource_ != *x.resource_) return *this = static_cast<const dynamic_num_array&>(x);
+      release();
+      extents_ = std::exchange(x.extents_, extents_type{ });
+      data_ = std::exchange(x.data_, nullptr);
+      return *this;
+    }
+
+  // Operations
+  //
+  // Operators taking an rvalue array of the result type reuse its storage, so
+  // a chain such as a + b * 2 - c allocates a single new array.
+
+  // Scalar addition
+  template<Number T, Scalar U, std::size_t Rank>
+    auto
+    operator+(const dynamic_num_array<T, Rank>& lhs, const U& rhs)
+      requires std::common_with<T, U>
+    {
+      using R = std::common_type<T, U>::type;
+      return std::move(dynamic_num_array<R, Rank>(lhs) += rhs);
+    }
+
+  template<Number T, Scalar U, std::size_t Rank>
+    auto
+    operator+(dynamic_num_array<T, Rank>&& lhs, const U& rhs)
+      requires std::same_as<T, std::common_type_t<T, U>>
+    {
+      return std::move(lhs += rhs);
+    }
+
+  // Scalar subtraction
+  template<Number T, Scalar U, std::size_t Rank>
+    auto
+    operator-(const dynamic_num_array<T, Rank>& lhs, const U& rhs)
+      requires std::common_with<T, U>
+    {
+      using R = std::common_type<T, U>::type;
+      return std::move(dynamic_num_array<R, Rank>(lhs) -= rhs);
+    }
+
+  template<Number T, Scalar U, std::size_t Rank>
+    auto
+    operator-(dynamic_num_array<T, Rank>&& lhs, const U& rhs)
+      requires std::same_as<T, std::common_type_t<T, U>>
+    {
+      return std::move(lhs -= rhs);
+    }
+
+  // Scalar multiplication
+  template<Number T, Scalar U, std::size_t Rank>
+    auto
+    operator*(const dynamic_num_array<T, Rank>& lhs, const U& rhs)
+      requires std::common_with<T, U>
+    {
+      using R = std::common_type<T, U>::type;
+      return std::move(dynamic_num_array<R, Rank>(lhs) *= rhs);
+    }
+
+  template<Number T, Scalar U, std::size_t Rank>
+    auto
+    operator*(dynamic_num_array<T, Rank>&& lhs, const U& rhs)
+      requires std::same_as<T, std::common_type_t<T, U>>
+    {
+      return std::move(lhs *= rhs);
+    }
+
+  // Commutative scalar multiplication
+  template<Number T, Scalar U, std::size_t Rank>
+    auto
+    operator*(const U& lhs, const dynamic_num_array<T, Rank>& rhs)
+      requires std::common_with<T, U>
+    {
+      return rhs * lhs;
+    }
+
+  template<Number T, Scalar U, std::size_t Rank>
+    auto
+    operator*(const U& lhs, dynamic_num_array<T, Rank>&& rhs)
+      requires std::common_with<T, U>
+    {
+      return std::move(rhs) * lhs;
+    }
+
+  // Scalar division
+  template<Number T, Scalar U, std::size_t Rank>
+    auto
+    operator/(const dynamic_num_array<T, Rank>& lhs, const U& rhs)
+      requires std::common_with<T, U>
+    {
+      using R = std::common_type<T, U>::type;
+      return std::move(dynamic_num_array<R, Rank>(lhs) /= rhs);
+    }
+
+  template<Number T, Scalar U, std::size_t Rank>
+    auto
+    operator/(dynamic_num_array<T, Rank>&& lhs, const U& rhs)
+      requires std::same_as<T, std::common_type_t<T, U>>
+    {
+      return std::move(lhs /= rhs);
+    }
+
+  // Negation
+  template<Number T, std::size_t Rank>
+    auto
+    operator-(dynamic_num_array<T, Rank> rhs)
+    {
+      for (auto& x : rhs) x = -x;
+      return rhs;
+    }
+
+  // Element-wise addition
+  template<Number T, Number U, std::size_t Rank>
+    auto
+    operator+(const dynamic_num_array<T, Rank>& lhs,
+              const dynamic_num_array<U, Rank>& rhs)
+      requires std::common_with<T, U>
+    {
+      using R = std::common_type<T, U>::type;
+      if constexpr (std::same_as<U, R>) {
+        return std::move(dynamic_num_array<R, Rank>(lhs) += rhs);
+      } else {
+        return std::move(dynamic_num_array<R, Rank>(lhs) 
+                         += dynamic_num_array<R, Rank>(rhs));
+      }
+    }
+
+  template<Number T, std::size_t Rank>
+    auto
+    operator+(dynamic_num_array<T, Rank>&& lhs, 
+              const dynamic_num_array<T, Rank>& rhs)
+    {
+      return std::move(lhs += rhs);
+    }
+
+  template<Number T, std::size_t Rank>
+    auto
+    operator+(const dynamic_num_array<T, Rank>& lhs,
+              dynamic_num_array<T, Rank>&& rhs)
+    {
+      return std::move(rhs += lhs);
+    }
+
+  template<Number T, std::size_t Rank>
+    auto
+    operator+(dynamic_num_array<T, Rank>&& lhs, dynamic_num_array<T, Rank>&& rhs)
+    {
+      return std::move(lhs += rhs);
+    }
+
+  // Element-wise subtraction
+  template<Number T, Number U, std::size_t Rank>
+    auto
+    operator-(const dynamic_num_array<T, Rank>& lhs,
+              const dynamic_num_array<U, Rank>& rhs)
+      requires std::common_with<T, U>
+    {
+      using R = std::common_type<T, U>::type;
+      if constexpr (std::same_as<U, R>) {
+        return std::move(dynamic_num_array<R, Rank>(lhs) -= rhs);
+      } else {
+        return std::move(dynamic_num_array<R, Rank>(lhs) 
+                         -= dynamic_num_array<R, Rank>(rhs));
+      }
+    }
+
+  template<Number T, std::size_t Rank>
+    auto
+    operator-(dynamic_num_array<T, Rank>&& lhs, 
+              const dynamic_num_array<T, Rank>& rhs)
+    {
+      return std::move(lhs -= rhs);
+    }
+
+  // Element-wise (Hadamard) product and quotient
+  template<Number T, Number U, std::size_t Rank>
+    auto
+    hadamard_product(const dynamic_num_array<T, Rank>& lhs,
+                     const dynamic_num_array<U, Rank>& rhs)
+      requires std::common_with<T, U>
+    {
+      using R = std::common_type<T, U>::type;
+      if constexpr (std::same_as<U, R>) {
+        return std::move(dynamic_num_array<R, Rank>(lhs) *= rhs);
+      } else {
+        return std::move(dynamic_num_array<R, Rank>(lhs) 
+                         *= dynamic_num_array<R, Rank>(rhs));
+      }
+    }
+
+  template<Number T, std::size_t Rank>
+    auto
+    hadamard_product(dynamic_num_array<T, Rank>&& lhs, 
+                     const dynamic_num_array<T, Rank>& rhs)
+    {
+      return std::move(lhs *= rhs);
+    }
+
+  template<Number T, std::size_t Rank>
+    auto
+    hadamard_product(const dynamic_num_array<T, Rank>& lhs,
+                     dynamic_num_array<T, Rank>&& rhs)
+    {
+      return std::move(rhs *= lhs);
+    }
+
+  template<Number T, Number U, std::size_t Rank>
+    auto
+    hadamard_quotient(const dynamic_num_array<T, Rank>& lhs,
+                      const dynamic_num_array<U, Rank>& rhs)
+      requires std::common_with<T, U>
+    {
+      using R = std::common_type<T, U>::type;
+      if constexpr (std::same_as<U, R>) {
+        return std::move(dynamic_num_array<R, Rank>(lhs) /= rhs);
+      } else {
+        return std::move(dynamic_num_array<R, Rank>(lhs) 
+                         /= dynamic_num_array<R, Rank>(rhs));
+      }
+    }
+
+  template<Number T, std::size_t Rank>
+    auto
+    hadamard_quotient(dynamic_num_array<T, Rank>&& lhs, 
+                      const dynamic_num_array<T, Rank>& rhs)
+    {
+      return std::move(lhs /= rhs);
+    }
+
+  // Fused multiply-add: a * b + c element-wise, as fma() of num_arrays. An
+  // rvalue c is reused for the result.
+  template<Number T, std::size_t Rank>
+    auto
+    fma(const dynamic_num_array<T, Rank>& a, const dynamic_num_array<T, Rank>& b,
+        dynamic_num_array<T, Rank> c)
+    {
+      if (a.extents() != b.extents() || a.extents() != c.extents())
+        throw std::invalid_argument("Incompatible extents");
+      simd::multiply_add(c.data(), a.data(), b.data(), c.data(), c.n_elements());
+      return c;
+    }
+
+  // y = alpha * x + y, in place, with fused multiply-adds as fma().
+  template<Scalar U, Number T, std::size_t Rank>
+    auto&
+    axpy(const U& alpha, const dynamic_num_array<T, Rank>& x, dynamic_num_array<T, Rank>& y)
+      requires std::convertible_to<U, T>
+    {
+      if (x.extents() != y.extents())
+        throw std::invalid_argument("Incompatible extents");
+      simd::axpy(T(alpha), x.data(), y.data(), y.n_elements());
+      return y;
+    }
+
+  // Element-wise comparisons
+  template<Number T, Number U, std::size_t Rank>
+    bool
+    operator==(const dynamic_num_array<T, Rank>& lhs,
+               const dynamic_num_array<U, Rank>& rhs)
+      requires std::common_with<T, U>
+    {
+      return lhs.extents() == rhs.extents() 
+          && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+    }
+
+  template<Number T, Number U, std::size_t Rank>
+    bool
+    operator!=(const dynamic_num_array<T, Rank>& lhs,
+               const dynamic_num_array<U, Rank>& rhs)
+      requires std::common_with<T, U>
+    {
+      return !(lhs == rhs);
+    }
+
+  // Scalar comparisons
+  template<Number T, Scalar U, std::size_t Rank>
+    bool
+    operator==(const dynamic_num_array<T, Rank>& lhs, const U& rhs)
+      requires std::common_with<T, U>
+    {
+      using C = std::common_type_t<T, U>;
+      return std::all_of(lhs.begin(), lhs.end(), 
+                         [&](const T& x){ return C(x) == C(rhs); });
+    }
+
+  template<Number T, Scalar U, std::size_t Rank>
+    bool
+    operator!=(const dynamic_num_array<T, Rank>& lhs, const U& rhs)
+      requires std::common_with<T, U>
+    {
+      return !(lhs == rhs);
+    }
+
+  // Returns an array where elements are the absolute value of the 
+  // corresponding elements of v
+  template<Number T, std::size_t Rank>
+    auto
+    abs(dynamic_num_array<T, Rank> v)
+    {
+      for (auto& x : v) x = detail::absolute{}(x);
+      return v;
+    }
+
+  // Vector and matrix operations
+
+  // Dot Product
+  // Returns the dot(scalar) product of two vectors
+  template<Number T1, Number T2>
+    [[nodiscard]] auto
+    dot_product(const dynamic_num_array<T1, 1>& v, 
+                const dynamic_num_array<T2, 1>& w)
+    {
+      if (v.size() != w.size())
+        throw std::invalid_argument("Incompatible extents");
+      using R = detail::accumulator_t<std::common_type_t<T1, T2>>;
+      if constexpr (simd::Small_integer<T1> && simd::Small_integer<T2>) {
+        return R(simd::integer_dot(v.data(), w.data(), v.size()));
+      }
+      R result{0};
+      for (std::size_t i = 0; i < v.size(); ++i) {
+        result += w[i] * v[i];
+      }
+      return result;
+    }
+
+  template<Number T>
+    [[nodiscard]] auto
+    transpose(const dynamic_num_array<T, 2>& x)
+    {
+      constexpr std::size_t block = 32; // transpose in cache-sized tiles
+      const auto m = x.extent(0), n = x.extent(1);
+      dynamic_num_array<T, 2> result(n, m);
+      for (std::size_t i0 = 0; i0 < m; i0 += block) {
+        for (std::size_t j0 = 0; j0 < n; j0 += block) {
+          for (std::size_t i = i0; i < std::min(i0 + block, m); ++i) {
+            for (std::size_t j = j0; j < std::min(j0 + block, n); ++j) {
+              result(j, i) = x(i, j);
+            }
+          }
+        }
+      }
+      return result;
+    }
+
+  // Matrix and vector products, with elements of the type given first, e.g.
+  // matrix_product<std::int32_t>(a, b), or else of the common type of the
+  // elements of the operands
+  template<typename U = void, Number T1, Number T2>
+    [[nodiscard]] auto
+    matrix_product(const dynamic_num_array<T1, 2>& lhs, 
+                   const dynamic_num_array<T2, 2>& rhs)
+      requires std::is_void_v<U> || Number<U>
+    {
+      using R = detail::product_result_t<U, T1, T2>;
+      const auto m = lhs.extent(0), n = lhs.extent(1), p = rhs.extent(1);
+      if (n != rhs.extent(0))
+        throw std::invalid_argument("Incompatible extents");
+
+      dynamic_num_array<R, 2> result(m, p);
+      // NOTE: gemm() accumulates in the accumulator type of R, where the loop
+      // below would round each partial sum to R (or overflow int32).
+      if (m * n * p >= detail::gemm_threshold
+          || !std::same_as<detail::sum_t<detail::accumulator_t<R>, T1, T2>, R>) {
+        detail::gemm(m, n, p, lhs.data(), n, rhs.data(), p, result.data(), p);
+        return result;
+      }
+      result = R(0);
+      for (std::size_t i = 0; i < m; ++i) {
+        for (std::size_t k = 0; k < n; ++k) {
+          const R x = lhs(i, k);
+          for (std::size_t j = 0; j < p; ++j) result(i, j) += x * rhs(k, j);
+        }
+      }
+      return result;
+    }
+
+  template<typename U = void, Number T1, Number T2>
+    [[nodiscard]] auto
+    vector_matrix_product(const dynamic_num_array<T1, 1>& lhs, 
+                          const dynamic_num_array<T2, 2>& rhs)
+      requires std::is_void_v<U> || Number<U>
+    {
+      using R = detail::product_result_t<U, T1, T2>;
+      const auto m = rhs.extent(0), n = rhs.extent(1);
+      if (lhs.size() != m)
+        throw std::invalid_argument("Incompatible extents");
+
+      using A = detail::sum_t<detail::accumulator_t<R>, T1, T2>;
+      dynamic_num_array<A, 1> sums({ n }, A(0));
+      for (std::size_t k = 0; k < m; ++k) {
+        const A x = lhs[k];
+        for (std::size_t j = 0; j < n; ++j) sums[j] += x * rhs(k, j);
+      }
+      if constexpr (std::same_as<A, R>) return sums;
+      else return dynamic_num_array<R, 1>(sums);
+    }
+
+  template<typename U = void, Number T1, Number T2>
+    [[nodiscard]] auto
+    matrix_vector_product(const dynamic_num_array<T1, 2>& lhs,
+                          const dynamic_num_array<T2, 1>& rhs)
+      requires std::is_void_v<U> || Number<U>
+    {
+      using R = detail::product_result_t<U, T1, T2>;
+      const auto m = lhs.extent(0), n = lhs.extent(1);
+      if (rhs.size() != n)
+        throw std::invalid_argument("Incompatible extents");
+
+      // The products are computed in the type of the sums, as by the
+      // products of num_arrays
+      using S = detail::sum_t<detail::accumulator_t<R>, T1, T2>;
+      dynamic_num_array<R, 1> result(m);
+      for (std::size_t i = 0; i < m; ++i) {
+        S sum = 0;
+        for (std::size_t k = 0; k < n; ++k) sum += S(lhs(i, k)) * S(rhs[k]);
+        result[i] = sum;
+      }
+      return result;
+    }
+
+  // operator* override for matrix multiplication
+  template<Number T1, Number T2>
+    [[nodiscard]] auto
+    operator*(const dynamic_num_array<T1, 2>& lhs, 
+              const dynamic_num_array<T2, 2>& rhs)
+    {
+      return matrix_product(lhs, rhs);
+    }
+
+  template<Number T1, Number T2>
+    [[nodiscard]] auto
+    operator*(const dynamic_num_array<T1, 1>& lhs, 
+              const dynamic_num_array<T2, 2>& rhs)
+    {
+      return vector_matrix_product(lhs, rhs);
+    }
+
+  template<Number T1, Number T2>
+    [[nodiscard]] auto
+    operator*(const dynamic_num_array<T1, 2>& lhs,
+              const dynamic_num_array<T2, 1>& rhs)
+    {
+      return matrix_vector_product(lhs, rhs);
+    }
+}
+#endif//TB_MATH_DYNAMIC_NUM_ARRAY_H
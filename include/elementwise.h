@@ -0,0 +1,581 @@
+#ifndef TB_MATH_NUM_ARRAY_ELEMENTWISE_H
+#define TB_MATH_NUM_ARRAY_ELEMENTWISE_H
+
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include "dynamic_num_array.h"
+#include "simd.h"
+
+namespace tb::math {
+
+  // Accuracy of the elementary functions below:
+  //  - precise: within a few ULP of the exact result, as the functions of
+  //    <cmath> (the bounds are given with each function).
+  //  - fast: shorter polynomials, with a relative error below 1e-5 for
+  //    float and 1e-10 for double (absolute, for sin and cos), and an
+  //    estimate of 1 / sqrt(x) where the target has one.
+  enum class accuracy { precise, fast };
+}
+
+namespace tb::math::detail {
+
+  // Constants of the elementary functions, for float and double.
+  template<std::floating_point T>
+    struct elementary_constants;
+
+  template<>
+    struct elementary_constants<float> {
+      // exp(x) is 0 below exp_min and infinite above exp_max.
+      static constexpr float exp_min = -105, exp_max = 89;
+      // ln(2) = ln2_hi + ln2_lo, where ln2_hi * n is exact for |n| < 2^15
+      static constexpr float ln2_hi = 0x1.63p-1f, ln2_lo = -0x1.bd0106p-13f;
+      static constexpr float log2e = 0x1.715476p0f;
+      // 2/3 = two_thirds[0] + two_thirds[1], for the logarithm of pow()
+      static constexpr float two_thirds[] = { 0x1.555556p-1f, -0x1.555556p-26f };
+      static constexpr float two_over_pi = 0x1.45f306p-1f;
+      // pi / 2 as a sum of parts of 11 bits (but the last), so that each
+      // part times n is exact for |n| < 2^13.
+      static constexpr float pi_2[] = { 0x1.92p0f, 0x1.fb4p-12f, 0x1.444p-24f, 0x1.68c234p-39f };
+      // tanh(x) rounds to 1 above tanh_max.
+      static constexpr float tanh_max = 9;
+    };
+
+  template<>
+    struct elementary_constants<double> {
+      static constexpr double exp_min = -746, exp_max = 710;
+      static constexpr double ln2_hi = 0x1.62e42feep-1, ln2_lo = 0x1.a39ef35793c76p-33;
+      static constexpr double log2e = 0x1.71547652b82fep0;
+      static constexpr double two_thirds[] = { 0x1.5555555555555p-1, 0x1.5555555555555p-55 };
+      static constexpr double two_over_pi = 0x1.45f306dc9c883p-1;
+      // In parts of 33 bits, for |n| < 2^20
+      static constexpr double pi_2[] = { 0x1.921fb544p0, 0x1.0b4611a6p-34, 0x1.3198a2ep-69,
+                                         0x1.b839a252049c1p-104 };
+      static constexpr double tanh_max = 20;
+    };
+
+  // The coefficients c[k] = term(First + k) of a series, for k in [0, N)
+  template<typename T, std::size_t N, std::size_t First = 0>
+    constexpr auto
+    series(auto term)
+    {
+      std::array<T, N> c{ };
+      for (std::size_t k = 0; k < N; ++k) c[k] = T(term(First + k));
+      return c;
+    }
+
+  constexpr long double
+  inverse_factorial(std::size_t k)
+  {
+    long double x = 1;
+    for (std::size_t i = 2; i <= k; ++i) x /= i;
+    return x;
+  }
+
+  // The number of terms of the series of the elementary functions. They
+  // are taken from the Taylor series of each on the reduced range of its
+  // argument, and chosen for the accuracy A.
+  template<typename T, accuracy A>
+    constexpr std::size_t terms(std::size_t float_fast, std::size_t float_precise,
+                                std::size_t double_fast, std::size_t double_precise)
+    {
+      if constexpr (sizeof(T) == 4) return A == accuracy::fast ? float_fast : float_precise;
+      else return A == accuracy::fast ? double_fast : double_precise;
+    }
+
+  // c[0] + x * (c[1] + x * (c[2] + ...)), with fused multiply-adds
+  template<typename P, typename T, std::size_t N>
+    inline P
+    polynomial(P x, const std::array<T, N>& c)
+    {
+      P p(c[N - 1]);
+      for (std::size_t i = N - 1; i-- > 0; ) p = fma(p, x, P(c[i]));
+      return p;
+    }
+
+  // x rounded to an integer (ties to even), for |x| < 2^(digits - 2)
+  template<typename P>
+    inline P
+    round_integer(P x)
+    {
+      using T = P::value_type;
+      constexpr T magic = T(1.5) * T(std::uint64_t(1) << (std::numeric_limits<T>::digits - 1));
+      return (x + P(magic)) - P(magic);
+    }
+
+  // x - n * pi / 2 or x - n * ln(2), with the constant in parts
+  template<typename P, typename T, std::size_t N>
+    inline P
+    reduce(P x, P n, const T (&parts)[N])
+    {
+      for (const T c : parts) x = fma(n, P(-c), x);
+      return x;
+    }
+
+  // A number hi + lo in twice the precision of P, with |lo| at most about
+  // half an ulp of hi.
+  template<typename P>
+    struct double_word {
+      P hi, lo;
+    };
+
+  // a + b exactly, for |a| >= |b| (or a = 0)
+  template<typename P>
+    inline double_word<P>
+    fast_two_sum(P a, P b)
+    {
+      const P s = a + b;
+      return { s, b - (s - a) };
+    }
+
+  // a + b exactly
+  template<typename P>
+    inline double_word<P>
+    two_sum(P a, P b)
+    {
+      const P s = a + b;
+      const P c = s - a;
+      return { s, (a - (s - c)) + (b - c) };
+    }
+
+  // a * b exactly (but for underflow): with a fused multiply-add, or else by
+  // Dekker's product of the halves of a and b split as by Veltkamp.
+  template<typename P>
+    inline double_word<P>
+    two_product(P a, P b)
+    {
+      using T = P::value_type;
+      if constexpr (simd::Fusable<T>) {
+        // p is not written a * b, which the compiler may contract into
+        // the sums of p by the caller, so that they add the exact product
+        const P p = fma(a, b, P(T(0)));
+        return { p, fma(a, b, P(T(0)) - p) };
+      } else {
+        const P p = a * b;
+        constexpr T c = T((std::uint64_t(1) << (std::numeric_limits<T>::digits + 1) / 2) + 1);
+        const P ta = P(c) * a, tb = P(c) * b;
+        const P ah = ta - (ta - a), bh = tb - (tb - b);
+        const P al = a - ah, bl = b - bh;
+        return { p, ((ah * bh - p) + ah * bl + al * bh) + al * bl };
+      }
+    }
+
+  template<typename P>
+    inline double_word<P>
+    operator*(double_word<P> a, double_word<P> b)
+    {
+      const auto p = two_product(a.hi, b.hi);
+      return { p.hi, p.lo + (a.hi * b.lo + a.lo * b.hi) };
+    }
+
+  // exp(x): x = n * ln(2) + r, with |r| <= ln(2) / 2, so exp(x) = 2^n *
+  // exp(r). 2^n is applied in two factors, so that its exponent is always
+  // in range and a result below the normal range is rounded once.
+  //
+  // exp(x + dx), for dx of the order of an ulp of x (the low part of a
+  // double_word), adds dx to r.
+  template<accuracy A>
+    struct exp_kernel {
+      template<typename P>
+        P operator()(P x) const
+        { return (*this)(x, P(typename P::value_type(0))); }
+
+      template<typename P>
+        P operator()(P x, P dx) const
+        {
+          using T = P::value_type;
+          using C = elementary_constants<T>;
+          static constexpr auto c = series<T, terms<T, A>(6, 8, 10, 14)>(inverse_factorial);
+          x = min(max(x, P(C::exp_min)), P(C::exp_max)); // keeps NaN
+          const P n = round_integer(x * P(C::log2e));
+          const P p = polynomial(reduce(x, n, { C::ln2_hi, C::ln2_lo }) + dx, c);
+          const P h = round_integer(n * P(T(0.5)));
+          return p * pow2(h) * pow2(n - h);
+        }
+    };
+
+  // exp(x) - 1, for |x| <= 2 * tanh_max, without the loss of accuracy of
+  // exp(x) - 1 for small x.
+  template<accuracy A>
+    struct expm1_kernel {
+      template<typename P>
+        P operator()(P x) const
+        {
+          using T = P::value_type;
+          using C = elementary_constants<T>;
+          static constexpr auto c = series<T, terms<T, A>(4, 6, 8, 12), 2>(inverse_factorial);
+          const P n = round_integer(x * P(C::log2e));
+          const P r = reduce(x, n, { C::ln2_hi, C::ln2_lo });
+          const P q = fma(r * r, polynomial(r, c), r); // exp(r) - 1
+          const P t = pow2(n);
+          return fma(t, q, t - P(T(1)));
+        }
+    };
+
+  // log(x): x = m * 2^e with m in [sqrt(1/2), sqrt(2)), and log(m) =
+  // 2 atanh(s) for s = (m - 1) / (m + 1), arranged as in fdlibm.
+  template<accuracy A>
+    struct log_kernel {
+      template<typename P>
+        P operator()(P x) const
+        {
+          using T = P::value_type;
+          using C = elementary_constants<T>;
+          using limits = std::numeric_limits<T>;
+          static constexpr auto c = series<T, terms<T, A>(2, 4, 5, 10)>(
+            [](std::size_t k) { return 2.0L / (2 * k + 3); });
+
+          // Subnormal x are scaled into the normal range.
+          const auto subnormal = x < P(limits::min());
+          constexpr T scale = T(1) / limits::epsilon();
+          P e;
+          const P m = split(select(subnormal, x * P(scale), x), e);
+          e = e - select(subnormal, P(T(limits::digits - 1)), P(T(0)));
+
+          const P f = m - P(T(1));
+          const P s = f / (f + P(T(2)));
+          const P z = s * s;
+          const P hf = P(T(0.5)) * f * f;
+          const P r = z * polynomial(z, c);
+          const P y = fma(e, P(C::ln2_hi), f - (hf - fma(s, hf + r, e * P(C::ln2_lo))));
+
+          P result = select(x < P(T(0)), P(limits::quiet_NaN()), y);
+          result = select(x == P(T(0)), P(-limits::infinity()), result);
+          result = select(x == P(limits::infinity()), x, result);
+          return select(x == x, result, x);
+        }
+    };
+
+  // sin(x) and cos(x): x = n * pi / 2 + r, with |r| <= pi / 4, and the
+  // result is +-sin(r) or +-cos(r) by the quadrant of n.
+  template<accuracy A, bool Cosine>
+    struct sincos_kernel {
+      template<typename P>
+        P operator()(P x) const
+        {
+          using T = P::value_type;
+          using C = elementary_constants<T>;
+          static constexpr auto s = series<T, terms<T, A>(3, 4, 5, 8)>(
+            [](std::size_t k) { return (k % 2 ? -1 : 1) * -inverse_factorial(2 * k + 3); });
+          static constexpr auto c = series<T, terms<T, A>(3, 5, 6, 8)>(
+            [](std::size_t k) { return (k % 2 ? 1 : -1) * inverse_factorial(2 * k + 2); });
+
+          const P n = round_integer(x * P(C::two_over_pi));
+          const P r = reduce(x, n, C::pi_2);
+          const P z = r * r;
+          const P sin_r = fma(r * z, polynomial(z, s), r);
+          const P cos_r = fma(z, polynomial(z, c), P(T(1)));
+
+          P q = Cosine ? n + P(T(1)) : n; // the quadrant, in [0, 4)
+          q = q - P(T(4)) * round_integer(q * P(T(0.25)) - P(T(0.375)));
+          const P odd = q - P(T(2)) * round_integer(q * P(T(0.5)) - P(T(0.25)));
+          const P y = select(P(T(0.5)) < odd, cos_r, sin_r);
+          return select(P(T(1.5)) < q, P(T(0)) - y, y);
+        }
+    };
+
+  // tanh(x) = (exp(2x) - 1) / (exp(2x) + 1)
+  template<accuracy A>
+    struct tanh_kernel {
+      template<typename P>
+        P operator()(P x) const
+        {
+          using T = P::value_type;
+          using C = elementary_constants<T>;
+          const P y = P(T(2)) * min(max(x, P(-C::tanh_max)), P(C::tanh_max));
+          const P e = expm1_kernel<A>{}(y);
+          return e / (e + P(T(2)));
+        }
+    };
+
+  template<accuracy A>
+    struct sqrt_kernel {
+      template<typename P>
+        P operator()(P x) const { return sqrt(x); }
+    };
+
+  // 1 / sqrt(x). The fast form refines the estimate of the target with a
+  // step of Newton's method, unless it is 0 or infinite.
+  template<accuracy A>
+    struct rsqrt_kernel {
+      template<typename P>
+        P operator()(P x) const
+        {
+          using T = P::value_type;
+          if constexpr (A == accuracy::fast && std::same_as<P, simd::pack<T>>
+                        && requires(P::V::type v) { P::V::rsqrt(v); }) {
+            const P y = rsqrt_estimate(x);
+            const P h = P(T(0.5)) * x * y;
+            const P z = y * fma(P(T(0)) - h, y, P(T(1.5)));
+            return select(z == z, z, y);
+          } else {
+            return P(T(1)) / sqrt(x);
+          }
+        }
+    };
+
+  // log(x) as a double_word, for pow(): as in log_kernel, but with s =
+  // (m - 1) / (m + 1) and the first terms of 2 atanh(s) = 2s + 2s^3 / 3 +
+  // s^5 * q(s^2) in double_words, for a relative error of about 2^-64 for
+  // double (2^-34 for float). The low part is 0 unless x is positive and
+  // finite.
+  template<typename P>
+    inline double_word<P>
+    log_double_word(P x)
+    {
+      using T = P::value_type;
+      using C = elementary_constants<T>;
+      using limits = std::numeric_limits<T>;
+      static constexpr auto c = series<T, sizeof(T) == 4 ? 5 : 11, 2>(
+        [](std::size_t k) { return 2.0L / (2 * k + 1); });
+
+      const auto subnormal = x < P(limits::min());
+      constexpr T scale = T(1) / limits::epsilon();
+      P e;
+      const P m = split(select(subnormal, x * P(scale), x), e);
+      e = e - select(subnormal, P(T(limits::digits - 1)), P(T(0)));
+
+      const P f = m - P(T(1)); // exact
+      const auto d = fast_two_sum(P(T(1)), m);
+      const P s_hi = f / d.hi;
+      const auto q = two_product(s_hi, d.hi);
+      const double_word<P> s = { s_hi, (((f - q.hi) - q.lo) - s_hi * d.lo) / d.hi };
+
+      const auto z = s * s;
+      const auto u = fast_two_sum(P(C::two_thirds[0]), z.hi * polynomial(z.hi, c));
+      const auto t = (s * z) * double_word<P>{ u.hi, u.lo + P(C::two_thirds[1]) };
+      const auto l = fast_two_sum(P(T(2)) * s.hi, t.hi);
+      const auto k = two_sum(e * P(C::ln2_hi), l.hi);
+      const auto y = fast_two_sum(k.hi, k.lo + (fma(e, P(C::ln2_lo), l.lo)
+                                               + (P(T(2)) * s.lo + t.lo)));
+
+      const auto finite = x < P(limits::infinity());
+      P hi = select(x == P(T(0)), P(-limits::infinity()), y.hi);
+      hi = select(finite, hi, x);
+      const P lo = select(x == P(T(0)), P(T(0)), y.lo);
+      return { select(x == x, hi, x), select(finite, lo, P(T(0))) };
+    }
+
+  // pow(x, y) = exp(y * log(x)), but for y = 0 or |x| = 1, and for x < 0,
+  // where it is +-exp(y * log(-x)) for an integral y (by its parity) and
+  // NaN for any other, as by <cmath>. The precise form multiplies a
+  // double_word logarithm, so that the error of y * log(x) is well below
+  // an ulp of the result.
+  template<accuracy A>
+    struct pow_kernel {
+      template<typename P>
+        P operator()(P x, P y) const
+        {
+          using T = P::value_type;
+          using C = elementary_constants<T>;
+          using limits = std::numeric_limits<T>;
+          const P zero(T(0)), one(T(1)), half(T(0.5));
+          const P ax = abs(x);
+          P z;
+          if constexpr (A == accuracy::precise) {
+            const auto l = log_double_word(ax);
+            const auto p = two_product(l.hi, y);
+            const P lo = fma(l.lo, y, p.lo);
+            z = exp_kernel<A>{}(p.hi, select(abs(p.hi) < P(C::exp_max), lo, zero));
+          } else {
+            z = exp_kernel<A>{}(y * log_kernel<A>{}(ax));
+          }
+          z = select(ax == one, one, z);
+
+          // The parity of y by r = y mod 4, which is exact. Above 2^digits
+          // y is even (and so are infinities); a NaN y is not integral.
+          constexpr T even = T(std::uint64_t(1) << limits::digits);
+          const P w = select(abs(y) < P(even), y, select(y == y, zero, y));
+          const P r = w - P(T(4)) * round_integer(w * P(T(0.25)));
+          const P integral = select(round_integer(r) == r, one, zero);
+          const P odd = integral - select(round_integer(r * half) == r * half, integral, zero);
+
+          // x < 0, or -0 (for which 1 / x < 0), and x finite and negative
+          const P negative = select(x < zero, one, select(one / x < zero, one, zero));
+          const P finite = select(x < zero, select(P(-limits::infinity()) < x, one, zero), zero);
+          z = select(half < negative * odd, z * P(T(-1)), z);
+          z = select(half < finite - finite * integral, P(limits::quiet_NaN()), z);
+          return select(y == zero, one, z);
+        }
+    };
+
+  // Applies the kernel f to the n elements at x (and y), in place: to
+  // pack<T> for as much of the range as possible if T is Elementary, and to
+  // scalar<T> for the rest, which give the same results.
+  template<typename T, typename F>
+    inline void
+    transform_elementary(T* x, std::size_t n, F f)
+    {
+      std::size_t m = 0;
+      if constexpr (simd::Elementary<T> && simd::Packable<T, true>) {
+        using P = simd::pack<T>;
+        m = n - n % P::width;
+        for (std::size_t i = 0; i < m; i += P::width) f(P::load(x + i)).store(x + i);
+      }
+      for (std::size_t i = m; i < n; ++i) x[i] = f(simd::scalar<T>(x[i])).v;
+    }
+
+  template<typename T, typename F>
+    inline void
+    transform_elementary(T* x, const T* y, std::size_t n, F f)
+    {
+      std::size_t m = 0;
+      if constexpr (simd::Elementary<T> && simd::Packable<T, true>) {
+        using P = simd::pack<T>;
+        m = n - n % P::width;
+        for (std::size_t i = 0; i < m; i += P::width) {
+          f(P::load(x + i), P::load(y + i)).store(x + i);
+        }
+      }
+      for (std::size_t i = m; i < n; ++i) {
+        x[i] = f(simd::scalar<T>(x[i]), simd::scalar<T>(y[i])).v;
+      }
+    }
+
+  // An Array_expression or dynamic_num_array of floating point elements
+  template<typename X>
+    concept Floating_array =
+      (Array_expression<X> && std::floating_point<element_t<X>>) ||
+      (is_dynamic_num_array<X>::value && std::floating_point<typename X::value_type>);
+
+  // The array of the result of an elementary function of x, initialized to
+  // x: x evaluated into a num_array, or a dynamic_num_array copied from x,
+  // or moved if x is an rvalue.
+  template<typename X>
+    auto
+    elementary_result(X&& x)
+    {
+      using A = std::remove_cvref_t<X>;
+      if constexpr (is_dynamic_num_array<A>::value) return A(std::forward<X>(x));
+      else return eval(x);
+    }
+
+  template<typename X, typename F>
+    auto
+    elementary(X&& x, F f)
+    {
+      auto result = elementary_result(std::forward<X>(x));
+      transform_elementary(result.data(), result.n_elements(), f);
+      return result;
+    }
+}
+
+namespace tb::math {
+
+  // Elementary Functions
+  //
+  // The functions below return an array of the shape of x, whose elements
+  // are the function of those of x. x is an Array_expression or
+  // dynamic_num_array of float or double (whose storage is reused if it is
+  // an rvalue), e.g. exp(a - 1) or exp<accuracy::fast>(std::move(b)).
+  //
+  // They are computed by polynomials, with the vectorized kernels in simd.h
+  // where the target has the operations involved (SSE2, AVX2, AVX-512F),
+  // and give the same results, lane by lane, on the rest of the elements.
+  // Infinities and NaNs are handled as by <cmath>, but the sign of a zero
+  // result is not specified.
+
+  // exp(x). Precise to 1.5 ULP.
+  template<accuracy A = accuracy::precise, typename X>
+    [[nodiscard]] auto
+    exp(X&& x) requires detail::Floating_array<std::remove_cvref_t<X>>
+    {
+      return detail::elementary(std::forward<X>(x), detail::exp_kernel<A>{});
+    }
+
+  // log(x), the natural logarithm. Precise to 1 ULP.
+  template<accuracy A = accuracy::precise, typename X>
+    [[nodiscard]] auto
+    log(X&& x) requires detail::Floating_array<std::remove_cvref_t<X>>
+    {
+      return detail::elementary(std::forward<X>(x), detail::log_kernel<A>{});
+    }
+
+  // sin(x) and cos(x). Precise to 2.5 ULP for |x| < 8192 (float) or 2^20
+  // (double), beyond which the reduction of x by multiples of pi / 2 is
+  // inexact and the results lose accuracy (and meaning, above 2^22 for
+  // float or 2^51 for double).
+  template<accuracy A = accuracy::precise, typename X>
+    [[nodiscard]] auto
+    sin(X&& x) requires detail::Floating_array<std::remove_cvref_t<X>>
+    {
+      return detail::elementary(std::forward<X>(x), detail::sincos_kernel<A, false>{});
+    }
+
+  template<accuracy A = accuracy::precise, typename X>
+    [[nodiscard]] auto
+    cos(X&& x) requires detail::Floating_array<std::remove_cvref_t<X>>
+    {
+      return detail::elementary(std::forward<X>(x), detail::sincos_kernel<A, true>{});
+    }
+
+  // tanh(x). Precise to 3 ULP.
+  template<accuracy A = accuracy::precise, typename X>
+    [[nodiscard]] auto
+    tanh(X&& x) requires detail::Floating_array<std::remove_cvref_t<X>>
+    {
+      return detail::elementary(std::forward<X>(x), detail::tanh_kernel<A>{});
+    }
+
+  // sqrt(x), correctly rounded.
+  template<accuracy A = accuracy::precise, typename X>
+    [[nodiscard]] auto
+    sqrt(X&& x) requires detail::Floating_array<std::remove_cvref_t<X>>
+    {
+      return detail::elementary(std::forward<X>(x), detail::sqrt_kernel<A>{});
+    }
+
+  // 1 / sqrt(x). Precise to 1.5 ULP; the fast form has a relative error below
+  // 2^-21 for float (and 2^-27 for double with AVX-512F).
+  template<accuracy A = accuracy::precise, typename X>
+    [[nodiscard]] auto
+    rsqrt(X&& x) requires detail::Floating_array<std::remove_cvref_t<X>>
+    {
+      return detail::elementary(std::forward<X>(x), detail::rsqrt_kernel<A>{});
+    }
+
+  // pow(x, y), where y is a scalar or an array of the shape of x. For x < 0
+  // it is NaN unless y is integral, as by <cmath>. Precise to 2 ULP; the
+  // relative error of the fast form grows with |y * log(x)|, by the bound
+  // of fast exp() and log() for each unit of it.
+  template<accuracy A = accuracy::precise, typename X, Scalar Y>
+    [[nodiscard]] auto
+    pow(X&& x, const Y& y) requires detail::Floating_array<std::remove_cvref_t<X>>
+    {
+      return detail::elementary(std::forward<X>(x), [y](auto p) {
+        using P = decltype(p);
+        return detail::pow_kernel<A>{}(p, P(typename P::value_type(y)));
+      });
+    }
+
+  template<accuracy A = accuracy::precise, typename X, Array_expression Y>
+    [[nodiscard]] auto
+    pow(X&& x, const Y& y)
+      requires detail::Floating_array<std::remove_cvref_t<X>>
+            && detail::Same_shape<std::remove_cvref_t<X>, Y>
+    {
+      auto result = detail::elementary_result(std::forward<X>(x));
+      using R = decltype(result);
+      const R exponent(y);
+      detail::transform_elementary(result.data(), exponent.data(),
+                                   result.n_elements(), detail::pow_kernel<A>{});
+      return result;
+    }
+
+  template<accuracy A = accuracy::precise, typename X, std::floating_point T, std::size_t Rank>
+    [[nodiscard]] auto
+    pow(X&& x, const dynamic_num_array<T, Rank>& y)
+      requires std::same_as<std::remove_cvref_t<X>, dynamic_num_array<T, Rank>>
+    {
+      if (x.extents() != y.extents()) throw std::invalid_argument("Incompatible extents");
+      auto result = detail::elementary_result(std::forward<X>(x));
+      detail::transform_elementary(result.data(), y.data(), result.n_elements(),
+                                   detail::pow_kernel<A>{});
+      return result;
+    }
+}
+#endif//TB_MATH_NUM_ARRAY_ELEMENTWISE_H
@@ -0,0 +1,122 @@
+#ifndef TB_MATH_NUM_ARRAY_FACTORIZATION_H
+#define TB_MATH_NUM_ARRAY_FACTORIZATION_H
+
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <utility>
+#include "num_array.h"
+
+// LU and Cholesky factorizations of small square matrices.
+//
+// The factors overwrite the matrix, and the right-hand sides of the solves
+// are overwritten with the solutions, so nothing is allocated: a system of
+// fixed size is factored and solved entirely on the stack. A right-hand side
+// is either a vector of N elements or an N x K matrix of K columns.
+namespace tb::math {
+
+  // The row interchanges of an LU factorization: at step k, row k was
+  // interchanged with row pivots[k] (>= k).
+  template<std::size_t N>
+    using lu_pivots = std::array<std::size_t, N>;
+
+  // LU Factorization
+  // P A = L U with partial pivoting. L (with a unit diagonal, which is not
+  // stored) overwrites the strict lower triangle of a, and U the upper
+  // triangle. Returns the sign of the permutation P (1 or -1), or 0 if a is
+  // singular, in which case the factorization is completed but U has a zero
+  // on its diagonal.
+  template<std::floating_point T, std::size_t N>
+    constexpr int
+    lu_factor(num_array<T, N, N>& a, lu_pivots<N>& pivots) noexcept
+    {
+      const auto abs = [](T x) { return x < 0 ? -x : x; };
+      int sign = 1;
+      for (std::size_t k = 0; k < N; ++k) {
+        auto p = k;
+        for (std::size_t i = k + 1; i < N; ++i) {
+          if (abs(a(i, k)) > abs(a(p, k))) p = i;
+        }
+        pivots[k] = p;
+        if (a(p, k) == T(0)) {
+          sign = 0;
+          continue;
+        }
+        if (p != k) {
+          std::swap(a[p], a[k]);
+          sign = -sign;
+        }
+        const auto r = T(1) / a(k, k);
+        for (std::size_t i = k + 1; i < N; ++i) {
+          const auto l = a(i, k) *= r;
+          for (std::size_t j = k + 1; j < N; ++j) a(i, j) -= l * a(k, j);
+        }
+      }
+      return sign;
+    }
+
+  // LU Solve
+  // Overwrites b with the solution x of A x = b, given the factorization of
+  // A by lu_factor().
+  // NOTE: If A is singular, x has non-finite elements.
+  template<std::floating_point T, std::size_t N, typename B>
+    constexpr void
+    lu_solve(const num_array<T, N, N>& lu, const lu_pivots<N>& pivots, B& b) noexcept
+      requires is_num_array<B>::value && std::same_as<detail::element_t<B>, T>
+            && (B::extent(0) == N)
+    {
+      for (std::size_t k = 0; k < N; ++k) {
+        if (pivots[k] != k) std::swap(b[k], b[pivots[k]]);
+      }
+      for (std::size_t i = 1; i < N; ++i) {
+        for (std::size_t k = 0; k < i; ++k) b[i] -= b[k] * lu(i, k);
+      }
+      for (std::size_t i = N; i-- > 0; ) {
+        for (std::size_t k = i + 1; k < N; ++k) b[i] -= b[k] * lu(i, k);
+        b[i] /= lu(i, i);
+      }
+    }
+
+  // Cholesky Factorization
+  // A = L transpose(L), for a symmetric positive definite A. L overwrites
+  // the lower triangle of a; the strict upper triangle is not referenced.
+  // Returns false if a is not positive definite.
+  template<std::floating_point T, std::size_t N>
+    bool
+    cholesky_factor(num_array<T, N, N>& a) noexcept
+    {
+      for (std::size_t j = 0; j < N; ++j) {
+        auto d = a(j, j);
+        for (std::size_t k = 0; k < j; ++k) d -= a(j, k) * a(j, k);
+        if (!(d > T(0))) return false;
+        a(j, j) = std::sqrt(d);
+        const auto r = T(1) / a(j, j);
+        for (std::size_t i = j + 1; i < N; ++i) {
+          auto x = a(i, j);
+          for (std::size_t k = 0; k < j; ++k) x -= a(i, k) * a(j, k);
+          a(i, j) = x * r;
+        }
+      }
+      return true;
+    }
+
+  // Cholesky Solve
+  // Overwrites b with the solution x of A x = b, given the factorization of
+  // A by cholesky_factor().
+  template<std::floating_point T, std::size_t N, typename B>
+    constexpr void
+    cholesky_solve(const num_array<T, N, N>& l, B& b) noexcept
+      requires is_num_array<B>::value && std::same_as<detail::element_t<B>, T>
+            && (B::extent(0) == N)
+    {
+      for (std::size_t i = 0; i < N; ++i) {
+        for (std::size_t k = 0; k < i; ++k) b[i] -= b[k] * l(i, k);
+        b[i] /= l(i, i);
+      }
+      for (std::size_t i = N; i-- > 0; ) {
+        for (std::size_t k = i + 1; k < N; ++k) b[i] -= b[k] * l(k, i);
+        b[i] /= l(i, i);
+      }
+    }
+}
+#endif//TB_MATH_NUM_ARRAY_FACTORIZATION_H
@@ -0,0 +1,351 @@
+#ifndef TB_MATH_NUM_ARRAY_GEMM_H
+#define TB_MATH_NUM_ARRAY_GEMM_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "arena.h"
+#include "num_array.h" // accumulator_t
+#include "simd.h"
+
+// Cache-blocked general matrix multiplication over row-major storage.
+//
+// The product is computed as in BLIS: the rhs is packed into panels of nc
+// columns that stay in the L3 cache, the lhs into blocks of mc rows that stay
+// in L2, and a register-tiled micro-kernel multiplies an mr x kc strip of the
+// lhs by a kc x nr strip of the rhs, accumulating an mr x nr tile of the
+// result in registers.
+namespace tb::math::detail {
+
+  // Products with at least this many multiply-adds (M * N * P) are computed
+  // with gemm() by matrix_product().
+  inline constexpr std::size_t gemm_threshold = 32 * 32 * 32;
+
+  template<typename T>
+    struct gemm_blocking {
+      using V = simd::native<T>;
+      static constexpr bool vectorized =
+        simd::Vectorizable<simd::add_assign, T> &&
+        simd::Vectorizable<simd::mul_assign, T>;
+
+      static constexpr std::size_t mr = 4;
+      static constexpr std::size_t nr = vectorized ? 2 * V::width : 4;
+      static constexpr std::size_t mc = 96;
+      static constexpr std::size_t kc = 256;
+      static constexpr std::size_t nc = 2048;
+    };
+
+  // Packs the mb x kb block of a (row stride lda) into strips of mr rows,
+  // stored column by column and padded with zeros.
+  template<typename R, typename T>
+    void
+    gemm_pack_lhs(std::size_t mb, std::size_t kb, const T* a, std::size_t lda,
+                  R* packed)
+    {
+      constexpr auto mr = gemm_blocking<R>::mr;
+      for (std::size_t i = 0; i < mb; i += mr) {
+        const auto rows = std::min(mr, mb - i);
+        for (std::size_t k = 0; k < kb; ++k) {
+          for (std::size_t r = 0; r < mr; ++r) {
+            *packed++ = r < rows ? static_cast<R>(a[(i + r) * lda + k]) : R(0);
+          }
+        }
+      }
+    }
+
+  // Packs the kb x nb block of b (row stride ldb) into strips of nr columns,
+  // stored row by row and padded with zeros.
+  template<typename R, typename T>
+    void
+    gemm_pack_rhs(std::size_t kb, std::size_t nb, const T* b, std::size_t ldb,
+                  R* packed)
+    {
+      constexpr auto nr = gemm_blocking<R>::nr;
+      for (std::size_t j = 0; j < nb; j += nr) {
+        const auto cols = std::min(nr, nb - j);
+        for (std::size_t k = 0; k < kb; ++k) {
+          for (std::size_t c = 0; c < nr; ++c) {
+            *packed++ = c < cols ? static_cast<R>(b[k * ldb + j + c]) : R(0);
+          }
+        }
+      }
+    }
+
+  // c[0:rows, 0:cols] += a * b, where a is a packed mr x kb strip and b is a
+  // packed kb x nr strip.
+  template<typename R>
+    void
+    gemm_micro_kernel(std::size_t kb, const R* a, const R* b,
+                      R* c, std::size_t ldc, std::size_t rows, std::size_t cols)
+    {
+      using blocking = gemm_blocking<R>;
+      constexpr auto mr = blocking::mr, nr = blocking::nr;
+      R tile[mr][nr];
+
+      if constexpr (blocking::vectorized) {
+        using V = blocking::V;
+        constexpr auto w = V::width;
+        typename V::type acc[mr][2];
+        for (auto& row : acc) row[0] = row[1] = V::broadcast(R(0));
+
+        for (std::size_t k = 0; k < kb; ++k, a += mr, b += nr) {
+          const auto b0 = V::load(b), b1 = V::load(b + w);
+          for (std::size_t r = 0; r < mr; ++r) {
+            const auto x = V::broadcast(a[r]);
+            acc[r][0] = V::apply(simd::add_assign{}, acc[r][0],
+                                 V::apply(simd::mul_assign{}, x, b0));
+            acc[r][1] = V::apply(simd::add_assign{}, acc[r][1],
+                                 V::apply(simd::mul_assign{}, x, b1));
+          }
+        }
+        for (std::size_t r = 0; r < mr; ++r) {
+          V::store(tile[r], acc[r][0]);
+          V::store(tile[r] + w, acc[r][1]);
+        }
+      } else {
+        for (auto& row : tile) std::fill_n(row, nr, R(0));
+        for (std::size_t k = 0; k < kb; ++k, a += mr, b += nr) {
+          for (std::size_t r = 0; r < mr; ++r) {
+            for (std::size_t s = 0; s < nr; ++s) tile[r][s] += a[r] * b[s];
+          }
+        }
+      }
+
+      for (std::size_t r = 0; r < rows; ++r) {
+        for (std::size_t s = 0; s < cols; ++s) c[r * ldc + s] += tile[r][s];
+      }
+    }
+
+#if defined(__AVX2__)
+  // Products of the 8- and 16-bit integers of simd.h, in int32, are blocked
+  // as above, with the k of the packed strips in groups of g: four bytes
+  // (with VNNI, when the rhs is int8, and the lhs is uint8 or is made uint8
+  // by adding 128 and subtracting 128 times the sums of the columns of the
+  // rhs at the end), or else two int16s, which fill a 32-bit lane.
+  template<typename T1, typename T2>
+    struct integer_gemm_blocking {
+      using L = simd::integer_lanes;
+      static constexpr bool dot4 = L::dot4_product && std::same_as<T2, std::int8_t>
+                                && sizeof(T1) == 1;
+      using lhs_type = std::conditional_t<dot4, std::uint8_t, std::int16_t>;
+      using rhs_type = std::conditional_t<dot4, std::int8_t, std::int16_t>;
+      static constexpr std::int32_t lhs_offset = std::same_as<T1, std::int8_t> && dot4 ? 128 : 0;
+
+      static constexpr std::size_t g = dot4 ? 4 : 2;
+      static constexpr std::size_t mr = 4;
+      static constexpr std::size_t nr = 2 * L::width;
+      static constexpr std::size_t mc = 96;
+      static constexpr std::size_t kc = 512;
+      static constexpr std::size_t nc = 2048;
+    };
+
+  // Packs the mb x kb block of a into strips of mr rows, stored by groups of
+  // g columns, each row of a group in a 32-bit lane, and padded with zeros.
+  template<typename T1, typename T2>
+    void
+    integer_gemm_pack_lhs(std::size_t mb, std::size_t kb, const T1* a, std::size_t lda,
+                          typename integer_gemm_blocking<T1, T2>::lhs_type* packed)
+    {
+      using blocking = integer_gemm_blocking<T1, T2>;
+      using P = blocking::lhs_type;
+      constexpr auto mr = blocking::mr, g = blocking::g;
+      for (std::size_t i = 0; i < mb; i += mr) {
+        const auto rows = std::min(mr, mb - i);
+        for (std::size_t k0 = 0; k0 < kb; k0 += g) {
+          for (std::size_t r = 0; r < mr; ++r) {
+            for (std::size_t k = k0; k < k0 + g; ++k) {
+              *packed++ = r < rows && k < kb
+                ? static_cast<P>(a[(i + r) * lda + k] + blocking::lhs_offset) : P(0);
+            }
+          }
+        }
+      }
+    }
+
+  // Packs the kb x nb block of b into strips of nr columns, stored by groups
+  // of g rows, each column of a group in a 32-bit lane, and padded with
+  // zeros.
+  template<typename T1, typename T2>
+    void
+    integer_gemm_pack_rhs(std::size_t kb, std::size_t nb, const T2* b, std::size_t ldb,
+                          typename integer_gemm_blocking<T1, T2>::rhs_type* packed)
+    {
+      using blocking = integer_gemm_blocking<T1, T2>;
+      using P = blocking::rhs_type;
+      constexpr auto nr = blocking::nr, g = blocking::g;
+      for (std::size_t j = 0; j < nb; j += nr) {
+        const auto cols = std::min(nr, nb - j);
+        for (std::size_t k0 = 0; k0 < kb; k0 += g) {
+          for (std::size_t c = 0; c < nr; ++c) {
+            for (std::size_t k = k0; k < k0 + g; ++k) {
+              *packed++ = c < cols && k < kb ? static_cast<P>(b[k * ldb + j + c]) : P(0);
+            }
+          }
+        }
+      }
+    }
+
+  // c[0:rows, 0:cols] += a * b, where a is a packed mr x kb strip and b is a
+  // packed kb x nr strip (with kb a multiple of g), wrapping around.
+  template<typename T1, typename T2>
+    void
+    integer_gemm_micro_kernel(std::size_t kb,
+                              const typename integer_gemm_blocking<T1, T2>::lhs_type* a,
+                              const typename integer_gemm_blocking<T1, T2>::rhs_type* b,
+                              std::int32_t* c, std::size_t ldc, std::size_t rows, std::size_t cols)
+    {
+      using blocking = integer_gemm_blocking<T1, T2>;
+      using L = blocking::L;
+      constexpr auto mr = blocking::mr, nr = blocking::nr, g = blocking::g;
+      constexpr auto w = L::width * g; // elements of a vector
+      std::int32_t tile[mr][nr];
+
+      typename L::type acc[mr][2];
+      for (auto& row : acc) row[0] = row[1] = L::zero();
+      for (std::size_t k = 0; k < kb; k += g, a += mr * g, b += nr * g) {
+        const auto b0 = L::load(b), b1 = L::load(b + w);
+        for (std::size_t r = 0; r < mr; ++r) {
+          std::int32_t group;
+          std::memcpy(&group, a + r * g, sizeof(group));
+          const auto x = L::broadcast(group);
+          if constexpr (blocking::dot4) {
+            acc[r][0] = L::dot4(acc[r][0], x, b0);
+            acc[r][1] = L::dot4(acc[r][1], x, b1);
+          } else {
+            acc[r][0] = L::dot2(acc[r][0], x, b0);
+            acc[r][1] = L::dot2(acc[r][1], x, b1);
+          }
+        }
+      }
+      for (std::size_t r = 0; r < mr; ++r) {
+        L::store(tile[r], acc[r][0]);
+        L::store(tile[r] + L::width, acc[r][1]);
+      }
+
+      for (std::size_t r = 0; r < rows; ++r) {
+        for (std::size_t s = 0; s < cols; ++s) {
+          auto& x = c[r * ldc + s];
+          x = static_cast<std::int32_t>(static_cast<std::uint32_t>(x)
+                                        + static_cast<std::uint32_t>(tile[r][s]));
+        }
+      }
+    }
+
+  // c = a * b in int32 (see gemm()), wrapping around.
+  template<typename T1, typename T2>
+    void
+    integer_gemm(std::size_t m, std::size_t n, std::size_t p,
+                 const T1* a, std::size_t lda, const T2* b, std::size_t ldb,
+                 std::int32_t* c, std::size_t ldc)
+    {
+      using blocking = integer_gemm_blocking<T1, T2>;
+      constexpr auto mr = blocking::mr, nr = blocking::nr, g = blocking::g;
+      constexpr auto mc = blocking::mc, kc = blocking::kc, nc = blocking::nc;
+
+      for (std::size_t i = 0; i < m; ++i) std::fill_n(c + i * ldc, p, 0);
+
+      const auto panel_width = (std::min(nc, p) + nr - 1) / nr * nr;
+      const auto depth = (std::min(kc, n) + g - 1) / g * g;
+      scratch_buffer<typename blocking::lhs_type> packed_a(mc * depth);
+      scratch_buffer<typename blocking::rhs_type> packed_b(depth * panel_width);
+      for (std::size_t jc = 0; jc < p; jc += nc) {
+        const auto nb = std::min(nc, p - jc);
+        for (std::size_t pc = 0; pc < n; pc += kc) {
+          const auto kb = std::min(kc, n - pc), kg = (kb + g - 1) / g * g;
+          integer_gemm_pack_rhs<T1>(kb, nb, b + pc * ldb + jc, ldb, packed_b.data());
+          for (std::size_t ic = 0; ic < m; ic += mc) {
+            const auto mb = std::min(mc, m - ic);
+            integer_gemm_pack_lhs<T1, T2>(mb, kb, a + ic * lda + pc, lda, packed_a.data());
+            for (std::size_t jr = 0; jr < nb; jr += nr) {
+              for (std::size_t ir = 0; ir < mb; ir += mr) {
+                integer_gemm_micro_kernel<T1, T2>(kg, packed_a.data() + ir * kg,
+                                                  packed_b.data() + jr * kg,
+                                                  c + (ic + ir) * ldc + jc + jr, ldc,
+                                                  std::min(mr, mb - ir), std::min(nr, nb - jr));
+              }
+            }
+          }
+        }
+      }
+
+      if constexpr (blocking::lhs_offset != 0) {
+        // (a + offset) * b - offset * (the sums of the columns of b)
+        scratch_buffer<std::uint32_t> sums(p);
+        for (std::size_t k = 0; k < n; ++k) {
+          for (std::size_t j = 0; j < p; ++j) sums.data()[j] += static_cast<std::uint32_t>(b[k * ldb + j]);
+        }
+        for (std::size_t i = 0; i < m; ++i) {
+          for (std::size_t j = 0; j < p; ++j) {
+            auto& x = c[i * ldc + j];
+            x = static_cast<std::int32_t>(static_cast<std::uint32_t>(x)
+                                          - blocking::lhs_offset * sums.data()[j]);
+          }
+        }
+      }
+    }
+#endif
+
+  // c = a * b, where a is m x n, b is n x p and c is m x p, each stored row
+  // by row with the given row strides.
+  template<typename R, typename T1, typename T2>
+    void
+    gemm(std::size_t m, std::size_t n, std::size_t p,
+         const T1* a, std::size_t lda, const T2* b, std::size_t ldb,
+         R* c, std::size_t ldc)
+    {
+      using blocking = gemm_blocking<R>;
+      constexpr auto mr = blocking::mr, nr = blocking::nr;
+      constexpr auto mc = blocking::mc, kc = blocking::kc, nc = blocking::nc;
+
+      // Results with a wider accumulator type (the 16-bit floats) are
+      // computed in it, and rounded to R once.
+      if constexpr (!std::same_as<accumulator_t<R>, R>) {
+        using A = accumulator_t<R>;
+        scratch_buffer<A> sums(m * p);
+        gemm(m, n, p, a, lda, b, ldb, sums.data(), p);
+        for (std::size_t i = 0; i < m; ++i) {
+          std::copy_n(sums.data() + i * p, p, c + i * ldc);
+        }
+        return;
+      }
+      // Products of 8- and 16-bit integers are widened to int32 by the
+      // integer kernels of simd.h or else summed in uint32, and wrap around.
+      if constexpr (!std::same_as<sum_t<R, T1, T2>, R>) {
+#if defined(__AVX2__)
+        integer_gemm(m, n, p, a, lda, b, ldb, c, ldc);
+#else
+        gemm(m, n, p, a, lda, b, ldb, reinterpret_cast<std::uint32_t*>(c), ldc);
+#endif
+        return;
+      }
+
+      for (std::size_t i = 0; i < m; ++i) std::fill_n(c + i * ldc, p, R(0));
+
+      const auto panel_width = (std::min(nc, p) + nr - 1) / nr * nr;
+      // NOTE: The packed panels are scratch space from the thread's arena, so
+      // repeated products do not allocate.
+      detail::scratch_buffer<R> packed_a(mc * kc), packed_b(kc * panel_width);
+      for (std::size_t jc = 0; jc < p; jc += nc) {
+        const auto nb = std::min(nc, p - jc);
+        for (std::size_t pc = 0; pc < n; pc += kc) {
+          const auto kb = std::min(kc, n - pc);
+          gemm_pack_rhs(kb, nb, b + pc * ldb + jc, ldb, packed_b.data());
+          for (std::size_t ic = 0; ic < m; ic += mc) {
+            const auto mb = std::min(mc, m - ic);
+            gemm_pack_lhs(mb, kb, a + ic * lda + pc, lda, packed_a.data());
+            for (std::size_t jr = 0; jr < nb; jr += nr) {
+              for (std::size_t ir = 0; ir < mb; ir += mr) {
+                gemm_micro_kernel(kb, packed_a.data() + ir * kb,
+                                  packed_b.data() + jr * kb,
+                                  c + (ic + ir) * ldc + jc + jr, ldc,
+                                  std::min(mr, mb - ir), std::min(nr, nb - jr));
+              }
+            }
+          }
+        }
+      }
+    }
+}
+#endif//TB_MATH_NUM_ARRAY_GEMM_H
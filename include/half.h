@@ -0,0 +1,224 @@
+#ifndef TB_MATH_NUM_ARRAY_HALF_H
+#define TB_MATH_NUM_ARRAY_HALF_H
+
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include "dynamic_num_array.h"
+#include "simd.h"
+
+// 16-bit floating point element types, for arrays that are stored in half
+// the memory of floats: float16 (IEEE binary16) and bfloat16 (the range of
+// a float, with 8 bits of precision).
+//
+// They are storage types: arithmetic on them is done in float, and rounded
+// to 16 bits only when the result is stored. Their accumulator type is
+// float, so dot_product() and matrix_product() sum the products of their
+// elements in float, and round each result once.
+namespace tb::math::detail {
+
+  // The encodings of the formats, with the bits of their limits
+  struct binary16_format {
+    static constexpr int digits = 11, min_exponent = -13, max_exponent = 16;
+    static constexpr std::uint16_t min = 0x0400, max = 0x7bff, epsilon = 0x1400;
+    static constexpr std::uint16_t infinity = 0x7c00, quiet_nan = 0x7e00;
+
+    static constexpr float widen(std::uint16_t h) noexcept
+    { return simd::half_to_float(h); }
+    static constexpr std::uint16_t narrow(float x) noexcept
+    { return simd::float_to_half(x); }
+
+    static void widen(const std::uint16_t* x, std::size_t n, float* y) noexcept
+    { simd::half_to_float(x, n, y); }
+    static void narrow(const float* x, std::size_t n, std::uint16_t* y) noexcept
+    { simd::float_to_half(x, n, y); }
+  };
+
+  struct bfloat16_format {
+    static constexpr int digits = 8, min_exponent = -125, max_exponent = 128;
+    static constexpr std::uint16_t min = 0x0080, max = 0x7f7f, epsilon = 0x3c00;
+    static constexpr std::uint16_t infinity = 0x7f80, quiet_nan = 0x7fc0;
+
+    static constexpr float widen(std::uint16_t h) noexcept
+    { return simd::bfloat16_to_float(h); }
+    static constexpr std::uint16_t narrow(float x) noexcept
+    { return simd::float_to_bfloat16(x); }
+
+    static void widen(const std::uint16_t* x, std::size_t n, float* y) noexcept
+    { simd::bfloat16_to_float(x, n, y); }
+    static void narrow(const float* x, std::size_t n, std::uint16_t* y) noexcept
+    { simd::float_to_bfloat16(x, n, y); }
+  };
+
+  // x rounded to a float with round-to-odd: an inexact result has its last
+  // bit set. Narrowing that float to 16 bits then rounds as narrowing x
+  // would, which rounding x to nearest first does not (ties may be made).
+  constexpr float
+  round_to_odd(double x) noexcept
+  {
+    const auto y = static_cast<float>(x);
+    auto bits = std::bit_cast<std::uint32_t>(y);
+    if (y == x || x != x || (bits & 1)) return y;
+    // Step from y towards x (the sign bit is unchanged)
+    const double ay = y < 0 ? -double(y) : double(y), ax = x < 0 ? -x : x;
+    bits = ay < ax ? bits + 1 : bits - 1;
+    return std::bit_cast<float>(bits);
+  }
+}
+
+namespace tb::math {
+
+  // 16-bit Floating Point Numbers
+  // A number stored in the 16-bit format given by Format, which converts
+  // implicitly to and from float (and from the other arithmetic types), so
+  // that it is a Number.
+  // NOTE: The default constructor leaves the value uninitialized, as for
+  // float.
+  template<typename Format>
+    class half_float {
+    public:
+      using format_type = Format;
+      using accumulator_type = float;
+
+      half_float() noexcept = default;
+      constexpr half_float(float x) noexcept : bits_(Format::narrow(x)) { }
+      constexpr half_float(double x) noexcept
+        : bits_(Format::narrow(detail::round_to_odd(x))) { }
+      template<typename U>
+          requires std::is_arithmetic_v<U>
+        constexpr half_float(U x) noexcept
+          : half_float(static_cast<double>(x)) { }
+
+      constexpr operator float() const noexcept { return Format::widen(bits_); }
+
+      // The encoding of the number
+      static constexpr half_float from_bits(std::uint16_t bits) noexcept
+      {
+        half_float x;
+        x.bits_ = bits;
+        return x;
+      }
+      constexpr std::uint16_t bits() const noexcept { return bits_; }
+
+      constexpr half_float& operator+=(float x) noexcept
+      { return *this = float(*this) + x; }
+      constexpr half_float& operator-=(float x) noexcept
+      { return *this = float(*this) - x; }
+      constexpr half_float& operator*=(float x) noexcept
+      { return *this = float(*this) * x; }
+      constexpr half_float& operator/=(float x) noexcept
+      { return *this = float(*this) / x; }
+
+    private:
+      std::uint16_t bits_;
+    };
+
+  using float16 = half_float<detail::binary16_format>;
+  using bfloat16 = half_float<detail::bfloat16_format>;
+
+  static_assert(sizeof(float16) == 2 && std::is_trivially_copyable_v<float16>);
+  static_assert(Number<float16> && Number<bfloat16>);
+
+  template<typename T>
+    struct is_half_float : std::false_type { };
+  template<typename Format>
+    struct is_half_float<half_float<Format>> : std::true_type { };
+}
+
+namespace tb::math::detail {
+
+  // y[i] = static_cast<T>(x[i]) for i in [0, n), with the vectorized
+  // kernels for conversions between float and the 16-bit floats.
+  // NOTE: The 16-bit floats are passed to the kernels as their encodings.
+  template<typename T, typename U>
+    void
+    convert_n(const U* x, std::size_t n, T* y)
+    {
+      if constexpr (is_half_float<U>::value && std::same_as<T, float>) {
+        U::format_type::widen(reinterpret_cast<const std::uint16_t*>(x), n, y);
+      } else if constexpr (std::same_as<U, float> && is_half_float<T>::value) {
+        T::format_type::narrow(x, n, reinterpret_cast<std::uint16_t*>(y));
+      } else {
+        for (std::size_t i = 0; i < n; ++i) y[i] = static_cast<T>(x[i]);
+      }
+    }
+}
+
+namespace tb::math {
+
+  // Element Type Conversion
+  // Returns a copy of x with elements of type T. Conversions between float
+  // and float16 or bfloat16 are vectorized (with F16C or AVX-512F for
+  // float16, and AVX2 or AVX-512F for bfloat16).
+  template<Number T, Number U, std::size_t M, std::size_t... N>
+    [[nodiscard]] num_array<T, M, N...>
+    convert(const num_array<U, M, N...>& x)
+    {
+      num_array<T, M, N...> result;
+      detail::convert_n(x.data(), x.n_elements(), result.data());
+      return result;
+    }
+
+  template<Number T, Number U, std::size_t Rank>
+    [[nodiscard]] dynamic_num_array<T, Rank>
+    convert(const dynamic_num_array<U, Rank>& x)
+    {
+      dynamic_num_array<T, Rank> result(x.extents());
+      detail::convert_n(x.data(), x.n_elements(), result.data());
+      return result;
+    }
+}
+
+// The common type with an arithmetic type is float (or the wider type, for
+// double and long double). That of two 16-bit floats of a format is the
+// format itself, so that expressions of them are stored in 16 bits.
+template<typename Format, typename U>
+    requires std::is_arithmetic_v<U>
+  struct std::common_type<tb::math::half_float<Format>, U>
+  { using type = std::common_type_t<float, U>; };
+template<typename Format, typename U>
+    requires std::is_arithmetic_v<U>
+  struct std::common_type<U, tb::math::half_float<Format>>
+  { using type = std::common_type_t<float, U>; };
+
+template<typename Format>
+  class std::numeric_limits<tb::math::half_float<Format>> {
+    using T = tb::math::half_float<Format>;
+  public:
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_signed = true;
+    static constexpr bool is_integer = false;
+    static constexpr bool is_exact = false;
+    static constexpr bool has_infinity = true;
+    static constexpr bool has_quiet_NaN = true;
+    static constexpr bool has_signaling_NaN = false;
+    static constexpr std::float_denorm_style has_denorm = std::denorm_present;
+    static constexpr bool has_denorm_loss = false;
+    static constexpr std::float_round_style round_style = std::round_to_nearest;
+    static constexpr bool is_iec559 = std::same_as<Format, tb::math::detail::binary16_format>;
+    static constexpr bool is_bounded = true;
+    static constexpr bool is_modulo = false;
+    static constexpr int digits = Format::digits;
+    static constexpr int digits10 = (digits - 1) * 30103 / 100000;
+    static constexpr int max_digits10 = 2 + digits * 30103 / 100000;
+    static constexpr int radix = 2;
+    static constexpr int min_exponent = Format::min_exponent;
+    static constexpr int min_exponent10 = (min_exponent - 1) * 30103 / 100000;
+    static constexpr int max_exponent = Format::max_exponent;
+    static constexpr int max_exponent10 = max_exponent * 30103 / 100000;
+    static constexpr bool traps = false;
+    static constexpr bool tinyness_before = false;
+
+    static constexpr T min() noexcept { return T::from_bits(Format::min); }
+    static constexpr T max() noexcept { return T::from_bits(Format::max); }
+    static constexpr T lowest() noexcept { return T::from_bits(Format::max | 0x8000); }
+    static constexpr T epsilon() noexcept { return T::from_bits(Format::epsilon); }
+    static constexpr T round_error() noexcept { return T(0.5f); }
+    static constexpr T infinity() noexcept { return T::from_bits(Format::infinity); }
+    static constexpr T quiet_NaN() noexcept { return T::from_bits(Format::quiet_nan); }
+    static constexpr T signaling_NaN() noexcept { return T::from_bits(Format::quiet_nan); }
+    static constexpr T denorm_min() noexcept { return T::from_bits(1); }
+  };
+#endif//TB_MATH_NUM_ARRAY_HALF_H
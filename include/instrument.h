@@ -0,0 +1,326 @@
+#ifndef TB_MATH_NUM_ARRAY_INSTRUMENT_H
+#define TB_MATH_NUM_ARRAY_INSTRUMENT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string_view>
+#include <type_traits>
+#ifdef TB_MATH_INSTRUMENT
+#include <atomic>
+#include <mutex>
+#include <vector>
+#endif
+
+// Instrumentation
+//
+// Counts of the operations of num_array.h, vector.h and matrix.h: how many
+// times each is called, and the elements, arithmetic operations (flops) and
+// bytes of memory it reads and writes. Counting is enabled by defining
+// TB_MATH_INSTRUMENT (e.g. -DTB_MATH_INSTRUMENT) before any header of the
+// library is included. Otherwise the hooks in the operations are empty and
+// compile to nothing, and totals() is empty.
+//
+// Each thread counts into its own counters, without synchronization, and
+// totals() adds up those of all threads (including those that have exited)
+// when it is called.
+//
+// An operation called by another one (the dot products of a
+// matrix_vector_product(), the inverse() of a solve(), or the evaluation of
+// a num_array constructed from an expression) is part of the outer one, and
+// is not counted by itself. Elements and bytes are those of the operands,
+// each read once, and of the result: the least memory traffic of the
+// operation, as for a roofline model, not that of its loops. The flops of
+// det(), inverse() and solve() are the nominal ones of LU factorization
+// (2n³/3, 2n³, and 2n³/3 + 2n²k for k right-hand sides), whichever method
+// is used for their size.
+//
+// NOTE: TB_MATH_INSTRUMENT must be defined in all translation units of a
+// program, or in none, since the operations are inline functions.
+namespace tb::math::instrument {
+
+  enum class operation : std::size_t {
+    construct,              // a num_array constructed from an expression, a
+                            // value or another element type
+    elementwise,            // assignment of an expression, or a compound
+                            // assignment (+=, ...)
+    dot_product,
+    cross_product,
+    outer_product,
+    matrix_product,
+    matrix_vector_product,
+    vector_matrix_product,
+    transpose,
+    det,
+    inverse,
+    solve,
+  };
+
+  inline constexpr std::size_t n_operations = 12;
+
+  inline constexpr bool enabled =
+#ifdef TB_MATH_INSTRUMENT
+    true;
+#else
+    false;
+#endif
+
+  constexpr std::string_view
+  name(operation op) noexcept
+  {
+    constexpr std::string_view names[n_operations] = {
+      "construct", "elementwise", "dot_product", "cross_product", "outer_product",
+      "matrix_product", "matrix_vector_product", "vector_matrix_product",
+      "transpose", "det", "inverse", "solve"
+    };
+    return names[static_cast<std::size_t>(op)];
+  }
+
+  struct counts {
+    std::uint64_t calls = 0;
+    std::uint64_t elements = 0;
+    std::uint64_t flops = 0;
+    std::uint64_t bytes = 0;
+
+    constexpr counts& operator+=(const counts& x) noexcept
+    {
+      calls += x.calls, elements += x.elements, flops += x.flops, bytes += x.bytes;
+      return *this;
+    }
+
+    constexpr bool operator==(const counts&) const = default;
+  };
+
+  // Report
+  // The counts of each operation
+  class report {
+  public:
+    constexpr const counts& operator[](operation op) const noexcept
+    { return counts_[static_cast<std::size_t>(op)]; }
+    constexpr counts&       operator[](operation op)       noexcept
+    { return counts_[static_cast<std::size_t>(op)]; }
+
+    // The sum over all operations
+    constexpr counts total() const noexcept
+    {
+      counts result;
+      for (const auto& c : counts_) result += c;
+      return result;
+    }
+
+    constexpr report& operator+=(const report& x) noexcept
+    {
+      for (std::size_t i = 0; i < n_operations; ++i) counts_[i] += x.counts_[i];
+      return *this;
+    }
+
+    constexpr bool operator==(const report&) const = default;
+
+  private:
+    std::array<counts, n_operations> counts_{};
+  };
+
+  // Writes a table of the operations that were called, one per line, with
+  // their counts.
+  template<typename CharT, typename Traits>
+    std::basic_ostream<CharT, Traits>&
+    operator<<(std::basic_ostream<CharT, Traits>& os, const report& r)
+    {
+      const auto flags = os.flags();
+      os.setf(os.dec, os.basefield);
+      const auto row = [&os](const auto& label, const auto&... x) {
+        os.setf(os.left, os.adjustfield);
+        os.width(22);
+        os << label;
+        os.setf(os.right, os.adjustfield);
+        ((os.width(16), os << x), ...);
+        os << '\n';
+      };
+      row("operation", "calls", "elements", "flops", "bytes");
+      for (std::size_t i = 0; i < n_operations; ++i) {
+        const auto op = static_cast<operation>(i);
+        const counts& c = r[op];
+        if (c.calls != 0) row(name(op), c.calls, c.elements, c.flops, c.bytes);
+      }
+      os.flags(flags);
+      return os;
+    }
+}
+
+#ifdef TB_MATH_INSTRUMENT
+namespace tb::math::detail {
+
+  // The counters of a thread, which only that thread writes to (with a
+  // relaxed load and store rather than an atomic addition), and which other
+  // threads may read at any time. The counts of a thread that exits are
+  // added to those of the registry.
+  class thread_counters {
+  public:
+    thread_counters();
+    ~thread_counters();
+
+    thread_counters(const thread_counters&) = delete;
+    thread_counters& operator=(const thread_counters&) = delete;
+
+    void add(instrument::operation op, const instrument::counts& x) noexcept
+    {
+      auto& c = counters_[static_cast<std::size_t>(op)];
+      const std::uint64_t values[] = { x.calls, x.elements, x.flops, x.bytes };
+      for (std::size_t i = 0; i < 4; ++i) {
+        c[i].store(c[i].load(std::memory_order_relaxed) + values[i], std::memory_order_relaxed);
+      }
+    }
+
+    instrument::report load() const noexcept
+    {
+      instrument::report result;
+      for (std::size_t k = 0; k < instrument::n_operations; ++k) {
+        const auto& c = counters_[k];
+        result[static_cast<instrument::operation>(k)] = {
+          c[0].load(std::memory_order_relaxed), c[1].load(std::memory_order_relaxed),
+          c[2].load(std::memory_order_relaxed), c[3].load(std::memory_order_relaxed) };
+      }
+      return result;
+    }
+
+    void clear() noexcept
+    {
+      for (auto& c : counters_)
+        for (auto& x : c) x.store(0, std::memory_order_relaxed);
+    }
+
+    // The number of counted operations being executed by the thread
+    std::size_t depth = 0;
+
+  private:
+    std::array<std::array<std::atomic<std::uint64_t>, 4>, instrument::n_operations> counters_{};
+  };
+
+  // The counters of all threads, and the counts of those that have exited
+  struct counter_registry {
+    std::mutex mutex;
+    std::vector<thread_counters*> threads;
+    instrument::report exited;
+  };
+
+  // Never destroyed: the threads of a static thread_pool (see thread_pool.h)
+  // may exit, and deregister their counters, after static objects are.
+  inline counter_registry&
+  registry() noexcept
+  {
+    static auto& r = *new counter_registry;
+    return r;
+  }
+
+  inline
+  thread_counters::thread_counters()
+  {
+    auto& r = registry();
+    const std::lock_guard lock(r.mutex);
+    r.threads.push_back(this);
+  }
+
+  inline
+  thread_counters::~thread_counters()
+  {
+    auto& r = registry();
+    const std::lock_guard lock(r.mutex);
+    r.exited += load();
+    std::erase(r.threads, this);
+  }
+
+  inline thread_counters&
+  local_counters()
+  {
+    thread_local thread_counters c;
+    return c;
+  }
+
+  // Counted Scope
+  // Counts an operation when it is constructed, unless another counted
+  // operation of the thread is in progress, of which it is then a part.
+  class counted_scope {
+  public:
+    constexpr counted_scope(instrument::operation op, const instrument::counts& x) noexcept
+    {
+      if (std::is_constant_evaluated()) return;
+      counters_ = &local_counters();
+      if (counters_->depth++ == 0) counters_->add(op, x);
+    }
+    constexpr ~counted_scope()
+    {
+      if (counters_) --counters_->depth;
+    }
+
+    counted_scope(const counted_scope&) = delete;
+    counted_scope& operator=(const counted_scope&) = delete;
+
+  private:
+    thread_counters* counters_ = nullptr;
+  };
+}
+
+namespace tb::math::instrument {
+
+  // The counts of all threads since the last reset()
+  inline report
+  totals()
+  {
+    auto& r = detail::registry();
+    const std::lock_guard lock(r.mutex);
+    report result = r.exited;
+    for (const auto* t : r.threads) result += t->load();
+    return result;
+  }
+
+  // The counts of the calling thread since the last reset()
+  inline report
+  thread_totals()
+  {
+    return detail::local_counters().load();
+  }
+
+  // Sets all counts to zero.
+  // NOTE: Operations that other threads count while the counts are reset
+  // may be lost, or counted.
+  inline void
+  reset()
+  {
+    auto& r = detail::registry();
+    const std::lock_guard lock(r.mutex);
+    r.exited = report();
+    for (auto* t : r.threads) t->clear();
+  }
+}
+#else
+namespace tb::math::detail {
+
+  class counted_scope {
+  public:
+    constexpr counted_scope(instrument::operation, const instrument::counts&) noexcept { }
+
+    counted_scope(const counted_scope&) = delete;
+    counted_scope& operator=(const counted_scope&) = delete;
+  };
+}
+
+namespace tb::math::instrument {
+
+  inline report totals() { return {}; }
+  inline report thread_totals() { return {}; }
+  inline void reset() { }
+}
+#endif
+
+namespace tb::math::instrument {
+
+  // Writes the totals() of all threads to os, as a table.
+  template<typename CharT, typename Traits>
+    void
+    dump(std::basic_ostream<CharT, Traits>& os)
+    {
+      os << totals();
+    }
+}
+#endif//TB_MATH_NUM_ARRAY_INSTRUMENT_H
@@ -3,51 +3,347 @@
 
 #include "num_array.h"
 #include "vector.h" // dot_product()
+#include "gemm.h"
+#include "factorization.h"
 
 namespace tb::math {
 
   template<Number T>
     using mat2 = num_array<T, 2, 2>;
+  template<Number T>
+    using mat3 = num_array<T, 3, 3>;
+  template<Number T>
+    using mat4 = num_array<T, 4, 4>;
 
   using mat2f = mat2<float>;
-  // ...
+  using mat3f = mat3<float>;
+  using mat4f = mat4<float>;
+
+  using mat2d = mat2<double>;
+  using mat3d = mat3<double>;
+  using mat4d = mat4<double>;
+}
+
+namespace tb::math::detail {
+
+  // For gemm(): a pointer to the first element of a matrix whose rows are
+  // stored contiguously, and the distance between the starts of its rows. 
+  // The pointer is null if x is not stored that way (e.g. an expression).
+  template<Matrix_expression E>
+    constexpr auto
+    row_major_storage(const E& x)
+    {
+      using Storage = std::pair<const element_t<E>*, std::size_t>;
+      if constexpr (is_num_array<E>::value) {
+        return Storage(x.data(), E::extent(1));
+      } else if constexpr (is_aligned_num_array<E>::value) {
+        return Storage(x.data(), E::storage_type::extent(1));
+      } else if constexpr (is_num_array_view<E>::value) {
+        if (x.stride(1) == 1 && x.stride(0) >= 0) {
+          return Storage(x.data(), static_cast<std::size_t>(x.stride(0)));
+        }
+        return Storage(nullptr, 0);
+      } else {
+        return Storage(nullptr, 0);
+      }
+    }
+
+  // True if the operands are dense arrays of T (num_arrays, or aligned ones
+  // without padding), for which simd.h has 4x4 matrix kernels. (Their
+  // extents are checked by the caller.)
+  template<typename T, typename... E>
+    concept Vectorized_4x4 = simd::matrix_4x4<T>::vectorized
+      && ((is_dense<E> && std::same_as<element_t<E>, T>) && ...);
+
+  // The type of the sums of products of elements of E1 and E2, for a
+  // product of element type R. The elements are converted to it before
+  // they are multiplied, so that e.g. an int64 result of int32 matrices
+  // does not overflow in their products.
+  template<typename R, typename E1, typename E2>
+    using product_sum_t = sum_t<accumulator_t<R>, element_t<E1>, element_t<E2>>;
+
+  // Element (I, J) of lhs * rhs for small matrices, with the sum over k
+  // unrolled.
+  template<Number R, std::size_t I, std::size_t J, typename E1, typename E2,
+           std::size_t... K>
+    constexpr R
+    product_element(const E1& lhs, const E2& rhs, std::index_sequence<K...>)
+    {
+      using S = product_sum_t<R, E1, E2>;
+      S sum = 0;
+      ((sum += S(lhs(I, K)) * S(rhs(K, J))), ...);
+      return sum;
+    }
+
+  // The element type of inverses and solutions: integers give doubles.
+  template<typename T>
+    using floating_t = std::conditional_t<std::floating_point<T>, T, double>;
+
+  // The type in which det() computes the determinant of a matrix of up to
+  // 4x4 Ts: int64 for integers narrower than that, whose products (and, for
+  // unsigned integers, their differences) may not be representable in T, or
+  // else T itself, so that 64-bit integers stay exact.
+  template<typename T>
+    using det_t = std::conditional_t<std::integral<T> && (sizeof(T) < sizeof(std::int64_t)),
+                                     std::int64_t, T>;
+
+  // The adjugate (transposed matrix of cofactors) of a matrix of up to 4x4
+  // is written out in full, and returned in adj along with the determinant.
+  // The elements of a are read more than once, so it should not be an
+  // expensive expression.
+  template<Matrix_expression E, Number T>
+    constexpr T
+    adjugate(const E& a, num_array<T, 1, 1>& adj)
+      requires Same_shape<E, num_array<T, 1, 1>>
+    {
+      adj(0, 0) = 1;
+      return a(0, 0);
+    }
+
+  template<Matrix_expression E, Number T>
+    constexpr T
+    adjugate(const E& a, num_array<T, 2, 2>& adj)
+      requires Same_shape<E, num_array<T, 2, 2>>
+    {
+      adj(0, 0) =  a(1, 1); adj(0, 1) = -a(0, 1);
+      adj(1, 0) = -a(1, 0); adj(1, 1) =  a(0, 0);
+      return (a(0, 0) * a(1, 1)) - (a(0, 1) * a(1, 0));
+    }
+
+  template<Matrix_expression E, Number T>
+    constexpr T
+    adjugate(const E& a, num_array<T, 3, 3>& adj)
+      requires Same_shape<E, num_array<T, 3, 3>>
+    {
+      adj(0, 0) = a(1, 1) * a(2, 2) - a(1, 2) * a(2, 1);
+      adj(0, 1) = a(0, 2) * a(2, 1) - a(0, 1) * a(2, 2);
+      adj(0, 2) = a(0, 1) * a(1, 2) - a(0, 2) * a(1, 1);
+      adj(1, 0) = a(1, 2) * a(2, 0) - a(1, 0) * a(2, 2);
+      adj(1, 1) = a(0, 0) * a(2, 2) - a(0, 2) * a(2, 0);
+      adj(1, 2) = a(0, 2) * a(1, 0) - a(0, 0) * a(1, 2);
+      adj(2, 0) = a(1, 0) * a(2, 1) - a(1, 1) * a(2, 0);
+      adj(2, 1) = a(0, 1) * a(2, 0) - a(0, 0) * a(2, 1);
+      adj(2, 2) = a(0, 0) * a(1, 1) - a(0, 1) * a(1, 0);
+      return a(0, 0) * adj(0, 0) + a(0, 1) * adj(1, 0) + a(0, 2) * adj(2, 0);
+    }
+
+  // The 2x2 minors of rows 0-1 (s) and rows 2-3 (c) of a 4x4 matrix. By the
+  // Laplace expansion along the first two rows, the determinant and the
+  // cofactors are sums of their products.
+  template<Number T>
+    struct minors_4x4 {
+      T s0, s1, s2, s3, s4, s5;
+      T c0, c1, c2, c3, c4, c5;
+
+      template<Matrix_expression E>
+        constexpr explicit minors_4x4(const E& a)
+          : s0(a(0, 0) * a(1, 1) - a(1, 0) * a(0, 1)),
+            s1(a(0, 0) * a(1, 2) - a(1, 0) * a(0, 2)),
+            s2(a(0, 0) * a(1, 3) - a(1, 0) * a(0, 3)),
+            s3(a(0, 1) * a(1, 2) - a(1, 1) * a(0, 2)),
+            s4(a(0, 1) * a(1, 3) - a(1, 1) * a(0, 3)),
+            s5(a(0, 2) * a(1, 3) - a(1, 2) * a(0, 3)),
+            c0(a(2, 0) * a(3, 1) - a(3, 0) * a(2, 1)),
+            c1(a(2, 0) * a(3, 2) - a(3, 0) * a(2, 2)),
+            c2(a(2, 0) * a(3, 3) - a(3, 0) * a(2, 3)),
+            c3(a(2, 1) * a(3, 2) - a(3, 1) * a(2, 2)),
+            c4(a(2, 1) * a(3, 3) - a(3, 1) * a(2, 3)),
+            c5(a(2, 2) * a(3, 3) - a(3, 2) * a(2, 3))
+        { }
+
+      constexpr T det() const
+      { return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0; }
+    };
+
+  // The determinant of a matrix of up to 4x4 with elements of type T, for
+  // det(). The 3x3 one is expanded along the first row, as adjugate() does.
+  template<Number T, Matrix_expression E>
+    constexpr T
+    closed_form_det(const E& x)
+    {
+      constexpr auto N = E::extent(0);
+      if constexpr (N == 1) {
+        return x(0, 0);
+      } else if constexpr (N == 2) {
+        return (x(0, 0) * x(1, 1)) - (x(0, 1) * x(1, 0));
+      } else if constexpr (N == 3) {
+        const T c0 = x(1, 1) * x(2, 2) - x(1, 2) * x(2, 1);
+        const T c1 = x(1, 2) * x(2, 0) - x(1, 0) * x(2, 2);
+        const T c2 = x(1, 0) * x(2, 1) - x(1, 1) * x(2, 0);
+        return x(0, 0) * c0 + x(0, 1) * c1 + x(0, 2) * c2;
+      } else {
+        return minors_4x4<T>(x).det();
+      }
+    }
+
+  template<Matrix_expression E, Number T>
+    constexpr T
+    adjugate(const E& a, num_array<T, 4, 4>& adj)
+      requires Same_shape<E, num_array<T, 4, 4>>
+    {
+      const minors_4x4<T> m(a);
+      const auto [s0, s1, s2, s3, s4, s5, c0, c1, c2, c3, c4, c5] = m;
+
+      adj(0, 0) =  a(1, 1) * c5 - a(1, 2) * c4 + a(1, 3) * c3;
+      adj(0, 1) = -a(0, 1) * c5 + a(0, 2) * c4 - a(0, 3) * c3;
+      adj(0, 2) =  a(3, 1) * s5 - a(3, 2) * s4 + a(3, 3) * s3;
+      adj(0, 3) = -a(2, 1) * s5 + a(2, 2) * s4 - a(2, 3) * s3;
+      adj(1, 0) = -a(1, 0) * c5 + a(1, 2) * c2 - a(1, 3) * c1;
+      adj(1, 1) =  a(0, 0) * c5 - a(0, 2) * c2 + a(0, 3) * c1;
+      adj(1, 2) = -a(3, 0) * s5 + a(3, 2) * s2 - a(3, 3) * s1;
+      adj(1, 3) =  a(2, 0) * s5 - a(2, 2) * s2 + a(2, 3) * s1;
+      adj(2, 0) =  a(1, 0) * c4 - a(1, 1) * c2 + a(1, 3) * c0;
+      adj(2, 1) = -a(0, 0) * c4 + a(0, 1) * c2 - a(0, 3) * c0;
+      adj(2, 2) =  a(3, 0) * s4 - a(3, 1) * s2 + a(3, 3) * s0;
+      adj(2, 3) = -a(2, 0) * s4 + a(2, 1) * s2 - a(2, 3) * s0;
+      adj(3, 0) = -a(1, 0) * c3 + a(1, 1) * c1 - a(1, 2) * c0;
+      adj(3, 1) =  a(0, 0) * c3 - a(0, 1) * c1 + a(0, 2) * c0;
+      adj(3, 2) = -a(3, 0) * s3 + a(3, 1) * s1 - a(3, 2) * s0;
+      adj(3, 3) =  a(2, 0) * s3 - a(2, 1) * s1 + a(2, 2) * s0;
+      return m.det();
+    }
 }
 
 namespace tb::math {
 
-  template<Number T, std::size_t M, std::size_t N>
+  template<Matrix_expression E>
     [[nodiscard]] constexpr auto
-    transpose(const num_array<T, M, N>& x)
+    transpose(const E& x)
     {
+      constexpr auto M = E::extent(0), N = E::extent(1);
+      using T = detail::element_t<E>;
+      const detail::counted_scope scope(instrument::operation::transpose,
+        detail::operation_cost<T, E>(M * N));
       num_array<T, N, M> result;
-      for (std::size_t i = 0; i < M; ++i) {
-        for (std::size_t j = 0; j < N; ++j) {
-          result(j, i) = x(i, j);
+      if constexpr (M == 4 && N == 4 && detail::Vectorized_4x4<T, E>) {
+        if (!std::is_constant_evaluated()) {
+          simd::matrix_4x4<T>::transpose(x.data(), result.data());
+          return result;
+        }
+      }
+      if constexpr (detail::Small<E>) {
+        detail::unroll<M>([&](auto i) {
+          detail::unroll<N>([&](auto j) { result(j, i) = x(i, j); });
+        });
+      } else {
+        for (std::size_t i = 0; i < M; ++i) {
+          for (std::size_t j = 0; j < N; ++j) {
+            result(j, i) = x(i, j);
+          }
         }
       }
       return result;
     }
   
-  // Determinate of a 2x2 matrix
-  template<Number T>
+  // Determinant of a square matrix
+  // Up to 4x4 it is written out in full, exactly for integers: those 
+  // narrower than 64 bits are converted to int64 first, which is then the
+  // result type. Larger matrices are LU factored in the element type of 
+  // inverses (double for integers).
+  template<Matrix_expression E>
+    [[nodiscard]] constexpr auto
+    det(const E& x) 
+      requires (E::extent(0) == E::extent(1))
+    {
+      constexpr auto N = E::extent(0);
+      const detail::counted_scope scope(instrument::operation::det,
+        detail::operation_cost<detail::element_t<E>, E>(1, 2 * N * N * N / 3));
+      if constexpr (N <= 4) {
+        using R = detail::det_t<detail::element_t<E>>;
+        if constexpr (std::same_as<detail::element_t<E>, R>) {
+          return detail::closed_form_det<R>(x);
+        } else {
+          const num_array<R, N, N> a = x;
+          return detail::closed_form_det<R>(a);
+        }
+      } else {
+        using R = detail::floating_t<detail::element_t<E>>;
+        num_array<R, N, N> a = x;
+        lu_pivots<N> pivots;
+        R result = lu_factor(a, pivots);
+        for (std::size_t i = 0; i < N; ++i) result *= a(i, i);
+        return result;
+      }
+    }
+
+  // Inverse of a square matrix
+  // Up to 4x4 it is the adjugate divided by the determinant, written out in
+  // full; larger matrices are LU factored.
+  // NOTE: The inverse of a singular matrix has non-finite elements.
+  template<Matrix_expression E>
     [[nodiscard]] constexpr auto
-    det(const num_array<T, 2, 2>& x) 
+    inverse(const E& x)
+      requires (E::extent(0) == E::extent(1))
     {
-      return (x(0,0) * x(1,1)) - (x(0,1) * x(1,0));
+      constexpr auto N = E::extent(0);
+      using R = detail::floating_t<detail::element_t<E>>;
+      const detail::counted_scope scope(instrument::operation::inverse,
+        detail::operation_cost<R, E>(N * N, 2 * N * N * N));
+      if constexpr (N <= 4) {
+        // The adjugate of integers is computed in R, as their differences
+        // may not be representable in the element type (e.g. unsigned).
+        num_array<R, N, N> result;
+        R d;
+        if constexpr (std::same_as<detail::element_t<E>, R>) {
+          d = detail::adjugate(x, result);
+        } else {
+          const num_array<R, N, N> a = x;
+          d = detail::adjugate(a, result);
+        }
+        const R r = R(1) / d;
+        for (std::size_t i = 0; i < N; ++i) {
+          for (std::size_t j = 0; j < N; ++j) result(i, j) *= r;
+        }
+        return result;
+      } else {
+        num_array<R, N, N> a = x;
+        lu_pivots<N> pivots;
+        lu_factor(a, pivots);
+        num_array<R, N, N> result(R(0));
+        for (std::size_t i = 0; i < N; ++i) result(i, i) = 1;
+        lu_solve(a, pivots, result);
+        return result;
+      }
     }
 
-  template<Number T1, Number T2, std::size_t M, std::size_t N, std::size_t P,
-           Number R = std::common_type<T1, T2>::type>
+  template<Matrix_expression E1, Matrix_expression E2,
+           Number R = std::common_type<detail::element_t<E1>, 
+                                       detail::element_t<E2>>::type>
     [[nodiscard]] constexpr auto
-    matrix_product(const num_array<T1, M, N>& lhs, const num_array<T2, N, P>& rhs)
+    matrix_product(const E1& lhs, const E2& rhs)
+      requires (E1::extent(1) == E2::extent(0))
     {
-      //using R = typename std::common_type<T, U>::type;
+      constexpr auto M = E1::extent(0), N = E1::extent(1), P = E2::extent(1);
+      const detail::counted_scope scope(instrument::operation::matrix_product,
+        detail::operation_cost<R, E1, E2>(M * P, 2 * M * N * P));
       num_array<R, M, P> result;
+      if constexpr (detail::Small<E1, E2>) {
+        if constexpr (M == 4 && N == 4 && P == 4 && detail::Vectorized_4x4<R, E1, E2>) {
+          if (!std::is_constant_evaluated()) {
+            simd::matrix_4x4<R>::product(lhs.data(), rhs.data(), result.data());
+            return result;
+          }
+        }
+        [&]<std::size_t... I>(std::index_sequence<I...>) {
+          ((result(I / P, I % P) = detail::product_element<R, I / P, I % P>(
+              lhs, rhs, std::make_index_sequence<N>())), ...);
+        }(std::make_index_sequence<M * P>());
+        return result;
+      }
+      if (!std::is_constant_evaluated() && M * N * P >= detail::gemm_threshold) {
+        const auto [a, lda] = detail::row_major_storage(lhs);
+        const auto [b, ldb] = detail::row_major_storage(rhs);
+        if (a && b) {
+          detail::gemm(M, N, P, a, lda, b, ldb, result.data(), P);
+          return result;
+        }
+      }
+      using S = detail::product_sum_t<R, E1, E2>;
       for (std::size_t i = 0; i < M; ++i) {
         for (std::size_t j = 0; j < P; ++j) {
-          R sum = 0;
+          S sum = 0;
           for (std::size_t k = 0; k < N; ++k) {
-            sum += lhs(i, k) * rhs(k, j);
+            sum += S(lhs(i, k)) * S(rhs(k, j));
           }
           result(i, j) = sum;
         }
@@ -55,54 +351,146 @@ namespace tb::math {
       return result;
     }
   
-  template<Number T1, Number T2, std::size_t M, std::size_t N,
-           Number R = std::common_type<T1, T2>::type>
+  template<Vector_expression E1, Matrix_expression E2,
+           Number R = std::common_type<detail::element_t<E1>, 
+                                       detail::element_t<E2>>::type>
     [[nodiscard]] constexpr auto
-    vector_matrix_product(const num_array<T1, M>& lhs, 
-                          const num_array<T2, M, N>& rhs)
+    vector_matrix_product(const E1& lhs, const E2& rhs)
+      requires (E1::size() == E2::extent(0))
     {
+      constexpr auto M = E2::extent(0), N = E2::extent(1);
+      const detail::counted_scope scope(instrument::operation::vector_matrix_product,
+        detail::operation_cost<R, E1, E2>(N, 2 * M * N));
+      using S = detail::product_sum_t<R, E1, E2>;
       num_array<R, N> result;
       for (std::size_t j = 0; j < N; ++j) {
-        R sum = 0;
+        S sum = 0;
         for (std::size_t k = 0; k < M; ++k) {
-          sum += lhs[k] * rhs(k, j);
+          sum += S(lhs[k]) * S(rhs(k, j));
         }
         result[j] = sum;
       }
       return result;
     }
 
-  template<Number T1, Number T2, std::size_t M, std::size_t N,
-           Number R = std::common_type<T1, T2>::type>
+  template<Matrix_expression E1, Vector_expression E2,
+           Number R = std::common_type<detail::element_t<E1>, 
+                                       detail::element_t<E2>>::type>
     [[nodiscard]] constexpr auto
-    matrix_vector_product(const num_array<T1, M, N>& lhs,
-                          const num_array<T2, N>& rhs)
+    matrix_vector_product(const E1& lhs, const E2& rhs)
+      requires (E1::extent(1) == E2::size())
     {
+      constexpr auto M = E1::extent(0), N = E1::extent(1);
+      const detail::counted_scope scope(instrument::operation::matrix_vector_product,
+        detail::operation_cost<R, E1, E2>(M, 2 * M * N));
+      using S = detail::product_sum_t<R, E1, E2>;
       num_array<R, M> result;
-      for (std::size_t i = 0; i < M; ++i) {
-        result[i] = dot_product(lhs[i], rhs);
+      if constexpr (detail::Small<E1>) {
+        if constexpr (M == 4 && N == 4 && detail::Vectorized_4x4<R, E1, E2>) {
+          if (!std::is_constant_evaluated()) {
+            simd::matrix_4x4<R>::vector_product(lhs.data(), rhs.data(), result.data());
+            return result;
+          }
+        }
+        detail::unroll<M>([&](auto i) {
+          S sum = 0;
+          detail::unroll<N>([&](auto k) { sum += S(lhs(i, k)) * S(rhs[k]); });
+          result[i] = sum;
+        });
+      } else {
+        for (std::size_t i = 0; i < M; ++i) {
+          S sum = 0;
+          for (std::size_t k = 0; k < N; ++k) {
+            sum += S(lhs(i, k)) * S(rhs[k]);
+          }
+          result[i] = sum;
+        }
       }
       return result;
     }
+
+  // The products with elements of type R, given first, as for
+  // dynamic_num_arrays: e.g. matrix_product<std::int32_t>(a, b)
+  template<Number R, Matrix_expression E1, Matrix_expression E2>
+    [[nodiscard]] constexpr auto
+    matrix_product(const E1& lhs, const E2& rhs)
+      requires (E1::extent(1) == E2::extent(0))
+    {
+      return matrix_product<E1, E2, R>(lhs, rhs);
+    }
+
+  template<Number R, Vector_expression E1, Matrix_expression E2>
+    [[nodiscard]] constexpr auto
+    vector_matrix_product(const E1& lhs, const E2& rhs)
+      requires (E1::size() == E2::extent(0))
+    {
+      return vector_matrix_product<E1, E2, R>(lhs, rhs);
+    }
+
+  template<Number R, Matrix_expression E1, Vector_expression E2>
+    [[nodiscard]] constexpr auto
+    matrix_vector_product(const E1& lhs, const E2& rhs)
+      requires (E1::extent(1) == E2::size())
+    {
+      return matrix_vector_product<E1, E2, R>(lhs, rhs);
+    }
   
+  // Solve
+  // The solution x of a x = b, for a square matrix a and a vector b, or a
+  // matrix b of right-hand sides in its columns. Systems of up to 4x4 are
+  // solved with inverse(), larger ones by LU factorization.
+  // NOTE: If a is singular, x has non-finite elements.
+  template<Matrix_expression E1, Array_expression E2>
+    [[nodiscard]] constexpr auto
+    solve(const E1& a, const E2& b)
+      requires (E1::extent(0) == E1::extent(1)) && (E2::order() <= 2)
+            && (E2::extent(0) == E1::extent(0))
+    {
+      constexpr auto N = E1::extent(0);
+      using R = detail::floating_t<std::common_type_t<detail::element_t<E1>,
+                                                      detail::element_t<E2>>>;
+      using Result = detail::array_of_shape<R, detail::shape_t<E2>>::type;
+      constexpr auto K = E2::n_elements() / N; // right-hand sides
+      const detail::counted_scope scope(instrument::operation::solve,
+        detail::operation_cost<R, E1, E2>(N * K, 2 * N * N * N / 3 + 2 * N * N * K));
+      if constexpr (N <= 4) {
+        const auto inv = inverse(a);
+        Result x(R(0));
+        for (std::size_t i = 0; i < N; ++i) {
+          for (std::size_t k = 0; k < N; ++k) x[i] += b[k] * inv(i, k);
+        }
+        return x;
+      } else {
+        num_array<R, N, N> lu = a;
+        lu_pivots<N> pivots;
+        lu_factor(lu, pivots);
+        Result x = b;
+        lu_solve(lu, pivots, x);
+        return x;
+      }
+    }
+
   // operator* override for matrix multiplication
-  template<Number T1, Number T2, std::size_t M, std::size_t N, std::size_t P>
+  template<Matrix_expression E1, Matrix_expression E2>
     [[nodiscard]] constexpr auto
-    operator*(const num_array<T1, M, N>& lhs, const num_array<T2, N, P>& rhs)
+    operator*(const E1& lhs, const E2& rhs)
+      requires (E1::extent(1) == E2::extent(0))
     {
       return matrix_product(lhs, rhs);
     }
 
-  template<Number T1, Number T2, std::size_t M, std::size_t N>
+  template<Vector_expression E1, Matrix_expression E2>
     [[nodiscard]] constexpr auto
-    operator*(const num_array<T1, M>& lhs, const num_array<T2, M, N>& rhs)
+    operator*(const E1& lhs, const E2& rhs)
+      requires (E1::size() == E2::extent(0))
     {
       return vector_matrix_product(lhs, rhs);
     }
 
-  template<Number T1, Number T2, std::size_t M, std::size_t N>
+  template<Matrix_expression E1, Vector_expression E2>
     [[nodiscard]] constexpr auto
-    operator*(const num_array<T1, M, N>& lhs, const num_array<T2, N>& rhs)
+    operator*(const E1& lhs, const E2& rhs)
+      requires (E1::extent(1) == E2::size())
     {
       return matrix_vector_product(lhs, rhs);
     }
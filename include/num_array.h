@@ -4,7 +4,15 @@
 #include <concepts>
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <functional>
 #include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "instrument.h"
+#include "simd.h"
 
 namespace tb::math {
 
@@ -30,6 +38,331 @@ namespace tb::math {
 
       -x; // negation
     };
+
+  template<Number T, std::size_t M, std::size_t... N> class num_array_base;
+  template<Number T, std::size_t M, std::size_t... N> class num_array;
+  template<typename Op, typename... Args> class num_array_expr;
+  template<typename T, std::size_t M, std::size_t... N> class num_array_view;
+  template<Number T, typename Layout, std::size_t M, std::size_t... N> 
+    class aligned_num_array;
+
+  namespace detail { template<typename A> struct temporary; }
+
+  template<typename T> 
+    struct is_num_array : std::false_type { };
+  template<Number T, std::size_t M, std::size_t... N>
+    struct is_num_array<num_array<T, M, N...>> : std::true_type { };
+  template<typename A>
+    struct is_num_array<detail::temporary<A>> : is_num_array<A> { };
+
+  template<typename T> 
+    struct is_num_array_expr : std::false_type { };
+  template<typename Op, typename... Args>
+    struct is_num_array_expr<num_array_expr<Op, Args...>> : std::true_type { };
+
+  template<typename T> 
+    struct is_num_array_view : std::false_type { };
+  template<typename T, std::size_t M, std::size_t... N>
+    struct is_num_array_view<num_array_view<T, M, N...>> : std::true_type { };
+
+  template<typename T> 
+    struct is_aligned_num_array : std::false_type { };
+  template<Number T, typename Layout, std::size_t M, std::size_t... N>
+    struct is_aligned_num_array<aligned_num_array<T, Layout, M, N...>> 
+      : std::true_type { };
+  template<typename A>
+    struct is_aligned_num_array<detail::temporary<A>> : is_aligned_num_array<A> { };
+
+  // An Array_expression is a num_array, a view of (part of) a num_array (see
+  // view.h), a num_array with aligned storage (see aligned.h) or an 
+  // unevaluated element-wise expression of these.
+  template<typename T>
+    concept Array_expression = is_num_array<T>::value 
+                            || is_num_array_view<T>::value
+                            || is_aligned_num_array<T>::value
+                            || is_num_array_expr<T>::value;
+
+  // Array_expressions of order 1 and 2.
+  template<typename T>
+    concept Vector_expression = Array_expression<T> && T::order() == 1;
+  template<typename T>
+    concept Matrix_expression = Array_expression<T> && T::order() == 2;
+
+  // A Scalar is a Number that is not an Array_expression.
+  template<typename T>
+    concept Scalar = !Array_expression<T> && Number<T>;
+}
+
+namespace tb::math::detail {
+
+  // The element type of an operand (scalars are their own element type).
+  template<typename T>
+    struct element_of { using type = T; };
+  template<Number T, std::size_t M, std::size_t... N>
+    struct element_of<num_array<T, M, N...>> 
+    { using type = num_array<T, M, N...>::element_type; };
+  template<typename Op, typename... Args>
+    struct element_of<num_array_expr<Op, Args...>>
+    { using type = num_array_expr<Op, Args...>::element_type; };
+  template<typename T, std::size_t M, std::size_t... N>
+    struct element_of<num_array_view<T, M, N...>>
+    { using type = std::remove_const_t<T>; };
+  template<typename A>
+    struct element_of<temporary<A>> : element_of<A> { };
+
+  template<typename T>
+    using element_t = element_of<T>::type;
+
+  // The type in which sums of products of Ts are accumulated: T, unless it
+  // names a wider accumulator_type (as the 16-bit floats of half.h do), or
+  // is an 8- or 16-bit integer, whose sums are int32 (as in simd.h).
+  template<typename T>
+    struct accumulator { using type = T; };
+  template<typename T>
+      requires requires { typename T::accumulator_type; }
+    struct accumulator<T> { using type = T::accumulator_type; };
+  template<simd::Small_integer T>
+    struct accumulator<T> { using type = std::int32_t; };
+
+  template<typename T>
+    using accumulator_t = accumulator<T>::type;
+
+  // The type in which sums of products of Ts are computed, for an
+  // accumulator type A: A, or uint32 for the int32 sums of 8- and 16-bit
+  // integers, which then wrap around (as those of simd::integer_dot do)
+  // rather than overflow.
+  template<typename A, typename... T>
+    using sum_t = std::conditional_t<std::same_as<A, std::int32_t> && (simd::Small_integer<T> && ...),
+                                     std::uint32_t, A>;
+
+  // The extents of an Array_expression as a std::index_sequence.
+  template<typename T>
+    struct shape_of { };
+  template<Number T, std::size_t M, std::size_t... N>
+    struct shape_of<num_array<T, M, N...>> 
+    { using type = std::index_sequence<M, N...>; };
+  template<typename Op, typename... Args>
+    struct shape_of<num_array_expr<Op, Args...>>
+    { using type = num_array_expr<Op, Args...>::shape_type; };
+  template<typename T, std::size_t M, std::size_t... N>
+    struct shape_of<num_array_view<T, M, N...>> 
+    { using type = std::index_sequence<M, N...>; };
+  template<typename A>
+    struct shape_of<temporary<A>> : shape_of<A> { };
+
+  template<typename T>
+    using shape_t = shape_of<T>::type;
+
+  // The shape of the first Array_expression in Args.
+  template<typename... Args>
+    struct common_shape { };
+  template<typename A, typename... Args>
+    struct common_shape<A, Args...>
+      : std::conditional_t<Array_expression<A>, shape_of<A>, common_shape<Args...>>
+    { };
+
+  template<typename E1, typename E2>
+    concept Same_shape = std::same_as<shape_t<E1>, shape_t<E2>>;
+
+  // An Array_expression, other than a num_array, with the extents of Shape.
+  // These can be assigned to a num_array of that shape.
+  template<typename E, typename Shape>
+    concept Conforming_expression = Array_expression<E> 
+                                 && !is_num_array<E>::value
+                                 && std::same_as<shape_t<E>, Shape>;
+
+  // The num_array type with element type T and the extents of Shape.
+  template<typename T, typename Shape>
+    struct array_of_shape { };
+  template<typename T, std::size_t... N>
+    struct array_of_shape<T, std::index_sequence<N...>>
+    { using type = num_array<T, N...>; };
+
+  template<typename T, typename Shape>
+    struct base_of_shape { };
+  template<typename T, std::size_t... N>
+    struct base_of_shape<T, std::index_sequence<N...>>
+    { using type = num_array_base<T, N...>; };
+
+  // An rvalue num_array (aligned or not) operand of an expression, which is
+  // moved into the expression, so that e.g. auto e = f() + b does not refer
+  // to the result of f() once the statement ends.
+  template<typename A>
+    struct temporary : A {
+      constexpr temporary(A&& x) : A(std::move(x)) { }
+    };
+
+  // A num_array (aligned or not) argument of type T&&, when T&& is an rvalue.
+  template<typename T>
+    concept Temporary_array = !std::is_reference_v<T> && !std::is_const_v<T>
+                           && (is_num_array<T>::value || is_aligned_num_array<T>::value);
+
+  // The type of the operand of an expression built from an argument of type
+  // T&& (by the operators below, which forward their arguments).
+  template<typename T>
+    using operand_of = std::conditional_t<Temporary_array<T>, temporary<T>, std::remove_cvref_t<T>>;
+
+  // Arguments of types E1&& and E2&& of an element-wise operation, at least 
+  // one of which is a Temporary_array.
+  template<typename E1, typename E2>
+    concept Temporary_operands = (Temporary_array<E1> || Temporary_array<E2>)
+      && Array_expression<std::remove_cvref_t<E1>> && Array_expression<std::remove_cvref_t<E2>>
+      && Same_shape<std::remove_cvref_t<E1>, std::remove_cvref_t<E2>>
+      && std::common_with<element_t<std::remove_cvref_t<E1>>, element_t<std::remove_cvref_t<E2>>>;
+
+  // Operands are held by an expression as follows: num_arrays (aligned or
+  // not) by reference, temporary num_arrays, views, sub-expressions and
+  // scalars by value.
+  template<typename T>
+    struct operand { using type = T; };
+  template<Number T, std::size_t M, std::size_t... N>
+    struct operand<num_array<T, M, N...>> { using type = const num_array<T, M, N...>&; };
+  template<Number T, typename Layout, std::size_t M, std::size_t... N>
+    struct operand<aligned_num_array<T, Layout, M, N...>> 
+    { using type = const aligned_num_array<T, Layout, M, N...>&; };
+
+  template<typename T>
+    using operand_t = operand<T>::type;
+
+  // True if the elements of an E are stored contiguously in row-major 
+  // order, without padding (see aligned.h).
+  template<typename E>
+    inline constexpr bool is_dense = is_num_array<E>::value;
+
+  // The type of an operand after subscripting the expression that holds it.
+  template<typename T>
+    struct sub_operand { using type = T; };
+  template<Number T, std::size_t M, std::size_t... N>
+    struct sub_operand<num_array<T, M, N...>> 
+    { using type = num_array<T, N...>; };
+  template<typename Op, typename... Args>
+    struct sub_operand<num_array_expr<Op, Args...>>
+    { using type = num_array_expr<Op, typename sub_operand<Args>::type...>; };
+  template<typename T, std::size_t M, std::size_t... N>
+    struct sub_operand<num_array_view<T, M, N...>> 
+    { using type = num_array_view<T, N...>; };
+  template<typename A>
+    struct sub_operand<temporary<A>> : sub_operand<A> { };
+
+  struct absolute {
+    template<typename T>
+      constexpr T operator()(const T& x) const
+      {
+        if constexpr (std::is_unsigned_v<T>) return x;
+        else return std::abs(x);
+      }
+  };
+
+  struct multiply_add {
+    template<typename T>
+      constexpr T operator()(const T& x, const T& y, const T& z) const
+      { return simd::multiply_add(x, y, z); }
+  };
+
+  struct assign {
+    constexpr void operator()(auto& x, const auto& y) const { x = y; }
+  };
+
+  // True if the elements of an operand are reached by a single flat index
+  // in row-major order: scalars (which are broadcast), num_arrays, and
+  // expressions of these. Views and aligned arrays are strided or padded.
+  template<typename T>
+    inline constexpr bool is_flat = !Array_expression<T> || is_num_array<T>::value;
+  template<typename Op, typename... Args>
+    inline constexpr bool is_flat<num_array_expr<Op, Args...>> = (is_flat<Args> && ...);
+
+  // The k-th element of a flat operand. Not usable in constant expressions
+  // (see num_array::data()).
+  template<typename T>
+    decltype(auto)
+    flat_subscript(const T& x, std::size_t k)
+    {
+      if constexpr (is_num_array<T>::value) return x.data()[k];
+      else if constexpr (is_num_array_expr<T>::value) return x.flat(k);
+      else return (x);
+    }
+
+  // The cost of evaluating all the elements of an operand, for instrument.h:
+  // the arithmetic operations of its expressions, and the elements (and
+  // bytes) of the arrays it reads. Scalars cost nothing.
+  template<typename T>
+    struct expression_cost {
+      static constexpr std::size_t flops = 0, reads = 0, bytes = 0;
+    };
+  template<typename T>
+      requires Array_expression<T> && (!is_num_array_expr<T>::value)
+    struct expression_cost<T> {
+      static constexpr std::size_t flops = 0, reads = T::n_elements();
+      static constexpr std::size_t bytes = reads * sizeof(typename T::element_type);
+    };
+  template<typename Op, typename... Args>
+    struct expression_cost<num_array_expr<Op, Args...>> {
+      static constexpr std::size_t flops = 
+        (std::same_as<Op, multiply_add> ? 2 : 1) * num_array_expr<Op, Args...>::n_elements()
+        + (expression_cost<Args>::flops + ...);
+      static constexpr std::size_t reads = (expression_cost<Args>::reads + ...);
+      static constexpr std::size_t bytes = (expression_cost<Args>::bytes + ...);
+    };
+
+  // The counts of an operation (see instrument.h) that reads its operands
+  // E... and writes n elements of type R, with the given flops besides those
+  // of its operands.
+  template<typename R, typename... E>
+    constexpr instrument::counts
+    operation_cost(std::size_t n, std::size_t flops = 0)
+    {
+      return { 1, (expression_cost<E>::reads + ... + n),
+               (expression_cost<E>::flops + ... + flops),
+               (expression_cost<E>::bytes + ... + (n * sizeof(R))) };
+    }
+
+  // The counts of the assignment of an E to an array A with op (assign, or
+  // a compound assignment, which also reads A).
+  template<typename A, typename E, typename Op>
+    constexpr instrument::counts
+    assignment_cost(Op)
+    {
+      if constexpr (std::same_as<Op, assign>) {
+        return operation_cost<typename A::element_type, E>(A::n_elements());
+      } else {
+        return operation_cost<typename A::element_type, E, A>(A::n_elements(), A::n_elements());
+      }
+    }
+
+  template<typename T>
+    constexpr decltype(auto)
+    subscript(const T& x, std::size_t i)
+    {
+      if constexpr (Array_expression<T>) return x[i];
+      else return x; // scalars are broadcast
+    }
+
+  // Arrays with no extent larger than this are small: their loops are 
+  // unrolled at compile time, so that small fixed-size math (e.g. vec3, 
+  // mat4) compiles to straight-line code.
+  inline constexpr std::size_t small_extent = 4;
+
+  template<std::size_t... N>
+    inline constexpr bool is_small_extents = ((N <= small_extent) && ...);
+
+  template<typename Shape>
+    inline constexpr bool is_small_shape = false;
+  template<std::size_t... N>
+    inline constexpr bool is_small_shape<std::index_sequence<N...>> = is_small_extents<N...>;
+
+  template<typename... E>
+    concept Small = (is_small_shape<shape_t<E>> && ...);
+
+  // Calls f(std::integral_constant<std::size_t, I>()) for each I in [0, N),
+  // in order, unrolled at compile time.
+  template<std::size_t N, typename F>
+    constexpr void
+    unroll(F&& f)
+    {
+      [&]<std::size_t... I>(std::index_sequence<I...>) {
+        (f(std::integral_constant<std::size_t, I>()), ...);
+      }(std::make_index_sequence<N>());
+    }
 }
 
 namespace tb::math {
@@ -43,8 +376,8 @@ namespace tb::math {
       static consteval auto order() { return sizeof...(N) + 1; }// "rank"
       static consteval auto extent(std::size_t i) { return extents_[i]; }
       //number of total elements in the array...
-      //static consteval auto n_elements() { return (M * ... * N); }
-      //static consteval bool empty() { return n_elements() == 0; }      
+      static consteval auto n_elements() { return (M * ... * N); }
+      static consteval bool empty() { return n_elements() == 0; }
     };
 
   // Class template for the num_array family of classes.
@@ -57,6 +390,8 @@ namespace tb::math {
       using size_type       = sub_array::size_type;
       using iterator        = sub_array*;
       using const_iterator  = const sub_array*;
+      using flat_iterator       = element_type*;
+      using const_flat_iterator = const element_type*;
 
       constexpr num_array() { } // uninitialized num_array
       template<Number U>
@@ -64,6 +399,18 @@ namespace tb::math {
           requires std::common_with<T, U>;
       constexpr num_array(const T& x);
       constexpr num_array(const std::initializer_list<sub_array>& init_list);
+      template<detail::Conforming_expression<std::index_sequence<M, N...>> E>
+        constexpr num_array(const E& x)
+        {
+          const detail::counted_scope scope(instrument::operation::construct,
+            detail::operation_cost<T, E>(num_array::n_elements()));
+          *this = x;
+        }
+
+      // Evaluates an expression directly into this array.
+      template<detail::Conforming_expression<std::index_sequence<M, N...>> E>
+        constexpr auto& operator=(const E& x)
+        { return evaluate(x, detail::assign{}); }
 
       constexpr auto& operator[](size_type i) const noexcept { return data_[i]; }
       constexpr auto& operator[](size_type i)       noexcept { return data_[i]; }
@@ -90,6 +437,8 @@ namespace tb::math {
 
       constexpr auto& apply(auto func);
       constexpr auto& apply(const num_array&, auto func);
+      template<detail::Conforming_expression<std::index_sequence<M, N...>> E>
+        constexpr auto& apply(const E&, auto func);
 
       // Iterators
 
@@ -102,23 +451,67 @@ namespace tb::math {
       constexpr const_iterator cbegin() const noexcept { return begin(); }
       constexpr const_iterator cend()   const noexcept { return end(); }
 
+      // Flat access
+      //
+      // The elements are stored contiguously in row-major order, without
+      // padding, so data() points to n_elements() elements, which can be
+      // passed to std algorithms, std::memcpy or BLAS-style kernels.
+      // NOTE: The pointer is formed from the array itself, not its first row,
+      // which is too small an object for all the elements; for this reason it
+      // cannot be used in constant expressions.
+      element_type*       data()       noexcept
+      { return reinterpret_cast<element_type*>(this); }
+      const element_type* data() const noexcept
+      { return reinterpret_cast<const element_type*>(this); }
+
+      const_flat_iterator begin_flat() const noexcept { return data(); }
+      flat_iterator       begin_flat()       noexcept { return data(); }
+
+      const_flat_iterator end_flat()   const noexcept { return data() + this->n_elements(); }
+      flat_iterator       end_flat()         noexcept { return data() + this->n_elements(); }
+
       // Arithmetic operations
 
       constexpr auto& operator+=(const T& rhs)
-      { return apply([&](sub_array& x){ x += rhs; }); }
+      { return transform(rhs, simd::add_assign{}); }
       constexpr auto& operator-=(const T& rhs)
-      { return apply([&](sub_array& x){ x -= rhs; }); }
+      { return transform(rhs, simd::sub_assign{}); }
       constexpr auto& operator*=(const T& rhs)
-      { return apply([&](sub_array& x){ x *= rhs; }); }
+      { return transform(rhs, simd::mul_assign{}); }
       constexpr auto& operator/=(const T& rhs)
-      { return apply([&](sub_array& x){ x /= rhs; }); }
+      { return transform(rhs, simd::div_assign{}); }
 
       constexpr auto& operator+=(const num_array& rhs)
-      { return apply(rhs, [](sub_array& x, const sub_array& y){ x += y; }); }
+      { return transform(rhs, simd::add_assign{}); }
       constexpr auto& operator-=(const num_array& rhs)
-      { return apply(rhs, [](sub_array& x, const sub_array& y){ x -= y; }); }
+      { return transform(rhs, simd::sub_assign{}); }
+      // Element-wise (Hadamard) product and quotient
+      constexpr auto& operator*=(const num_array& rhs)
+      { return transform(rhs, simd::mul_assign{}); }
+      constexpr auto& operator/=(const num_array& rhs)
+      { return transform(rhs, simd::div_assign{}); }
+
+      template<detail::Conforming_expression<std::index_sequence<M, N...>> E>
+        constexpr auto& operator+=(const E& rhs)
+        { return evaluate(rhs, simd::add_assign{}); }
+      template<detail::Conforming_expression<std::index_sequence<M, N...>> E>
+        constexpr auto& operator-=(const E& rhs)
+        { return evaluate(rhs, simd::sub_assign{}); }
+      template<detail::Conforming_expression<std::index_sequence<M, N...>> E>
+        constexpr auto& operator*=(const E& rhs)
+        { return evaluate(rhs, simd::mul_assign{}); }
+      template<detail::Conforming_expression<std::index_sequence<M, N...>> E>
+        constexpr auto& operator/=(const E& rhs)
+        { return evaluate(rhs, simd::div_assign{}); }
 
     private:
+      template<Number, std::size_t, std::size_t...> friend class num_array;
+
+      template<typename E>
+        constexpr auto& evaluate(const E& x, auto op);
+      constexpr auto& transform(const T& x, auto op);
+      constexpr auto& transform(const num_array& x, auto op);
+
       sub_array data_[M];
     };
   
@@ -128,14 +521,20 @@ namespace tb::math {
       num_array<T, M, N...>::num_array(const num_array<U, M, N...>& x)
         requires std::common_with<T, U>
     {
-      std::copy(x.begin(), x.end(), begin());
+      const detail::counted_scope scope(instrument::operation::construct,
+        detail::operation_cost<T, num_array<U, M, N...>>(num_array::n_elements()));
+      if (std::is_constant_evaluated()) std::copy(x.begin(), x.end(), begin());
+      else std::copy(x.begin_flat(), x.end_flat(), begin_flat());
     }
 
   template<Number T, std::size_t M, std::size_t... N>
     constexpr 
     num_array<T, M, N...>::num_array(const T& x)
     {
-      std::fill_n(data_, this->size(), x);
+      const detail::counted_scope scope(instrument::operation::construct,
+        detail::operation_cost<T>(num_array::n_elements()));
+      if (std::is_constant_evaluated()) std::fill_n(data_, this->size(), x);
+      else std::fill_n(data(), this->n_elements(), x);
     }
 
   template<Number T, std::size_t M, std::size_t... N>
@@ -162,6 +561,77 @@ namespace tb::math {
       for (auto i = begin(); i != end(); ++i, ++j) func(*i, *j);
       return *this;
     }
+
+  template<Number T, std::size_t M, std::size_t... N>
+    template<detail::Conforming_expression<std::index_sequence<M, N...>> E>
+      constexpr auto&
+      num_array<T, M, N...>::apply(const E& x, auto func)
+      {
+        if constexpr (detail::is_small_extents<M, N...>) {
+          detail::unroll<M>([&](auto i) { func(data_[i], x[i]); });
+        } else {
+          for (size_type i = 0; i < this->size(); ++i) func(data_[i], x[i]);
+        }
+        return *this;
+      }
+
+  // Evaluates the expression x into the array with the assignment op (e.g.
+  // simd::add_assign for +=), element by element: in a single flat loop
+  // outside of constant evaluation if x is made of num_arrays and scalars,
+  // or row by row otherwise. Small arrays are unrolled row by row instead.
+  template<Number T, std::size_t M, std::size_t... N>
+    template<typename E>
+      constexpr auto&
+      num_array<T, M, N...>::evaluate(const E& x, auto op)
+      {
+        const detail::counted_scope scope(instrument::operation::elementwise,
+          detail::assignment_cost<num_array, E>(op));
+        if constexpr (detail::is_flat<E> && !detail::is_small_extents<M, N...>) {
+          if (!std::is_constant_evaluated()) {
+            element_type* p = data();
+            for (std::size_t k = 0; k < this->n_elements(); ++k) {
+              op(p[k], detail::flat_subscript(x, k));
+            }
+            return *this;
+          }
+        }
+        return apply(x, [op](sub_array& y, const auto& z) { y.evaluate(z, op); });
+      }
+
+  // Applies the compound assignment op to every element of the array with x,
+  // using the vectorized kernels in simd.h outside of constant evaluation.
+  template<Number T, std::size_t M, std::size_t... N>
+    constexpr auto&
+    num_array<T, M, N...>::transform(const T& x, auto op)
+    {
+      const detail::counted_scope scope(instrument::operation::elementwise,
+        detail::assignment_cost<num_array, T>(op));
+      if (std::is_constant_evaluated() || this->empty()) {
+        for (auto& y : data_) y.transform(x, op);
+      } else if constexpr (detail::is_small_extents<M, N...>) {
+        simd::transform_n<num_array::n_elements()>(data(), x, op);
+      } else {
+        simd::transform(data(), x, op, this->n_elements());
+      }
+      return *this;
+    }
+
+  template<Number T, std::size_t M, std::size_t... N>
+    constexpr auto&
+    num_array<T, M, N...>::transform(const num_array& x, auto op)
+    {
+      const detail::counted_scope scope(instrument::operation::elementwise,
+        detail::assignment_cost<num_array, num_array>(op));
+      if (std::is_constant_evaluated() || this->empty()) {
+        auto j = x.begin();
+        for (auto& y : data_) y.transform(*j++, op);
+      } else if constexpr (detail::is_small_extents<M, N...>) {
+        simd::transform_n<num_array::n_elements()>(data(), x.data(), op);
+      } else {
+        simd::transform(data(), x.data(), op, this->n_elements());
+      }
+      return *this;
+    }
   
   // Specialization of the num_array class for "one-dimensional" arrays 
   // (vectors). 
@@ -175,6 +645,8 @@ namespace tb::math {
       using const_pointer   = const value_type*;
       using iterator        = pointer;
       using const_iterator  = const_pointer;
+      using flat_iterator       = iterator;
+      using const_flat_iterator = const_iterator;
 
       constexpr num_array() { } // uninitialized num_array;
       template<Number U>
@@ -182,6 +654,18 @@ namespace tb::math {
           requires std::common_with<T, U>;
       constexpr num_array(const T& x);
       constexpr num_array(const std::initializer_list<T>&);
+      template<detail::Conforming_expression<std::index_sequence<N>> E>
+        constexpr num_array(const E& x)
+        {
+          const detail::counted_scope scope(instrument::operation::construct,
+            detail::operation_cost<T, E>(N));
+          *this = x;
+        }
+
+      // Evaluates an expression directly into this array.
+      template<detail::Conforming_expression<std::index_sequence<N>> E>
+        constexpr auto& operator=(const E& x)
+        { return evaluate(x, detail::assign{}); }
 
       constexpr auto& operator[](size_type i) const noexcept { return data_[i]; }
       constexpr auto& operator[](size_type i)       noexcept { return data_[i]; }
@@ -194,6 +678,8 @@ namespace tb::math {
 
       constexpr auto& apply(auto func);
       constexpr auto& apply(const num_array&, auto func);
+      template<detail::Conforming_expression<std::index_sequence<N>> E>
+        constexpr auto& apply(const E&, auto func);
 
       // Iterators
 
@@ -206,23 +692,66 @@ namespace tb::math {
       constexpr const_iterator cbegin() const noexcept { return begin(); }
       constexpr const_iterator cend()   const noexcept { return end(); }
 
+      // Flat access, as for arrays of higher order, but also in constant
+      // expressions
+
+      constexpr const_pointer data() const noexcept { return data_; }
+      constexpr pointer       data()       noexcept { return data_; }
+
+      constexpr const_flat_iterator begin_flat() const noexcept { return begin(); }
+      constexpr flat_iterator       begin_flat()       noexcept { return begin(); }
+
+      constexpr const_flat_iterator end_flat()   const noexcept { return end(); }
+      constexpr flat_iterator       end_flat()         noexcept { return end(); }
+
       // Arithmetic operations
 
       constexpr auto& operator+=(const T& rhs)
-      { return apply([&](T& x){ x += rhs; }); }
+      { return transform(rhs, simd::add_assign{}); }
       constexpr auto& operator-=(const T& rhs)
-      { return apply([&](T& x){ x -= rhs; }); }
+      { return transform(rhs, simd::sub_assign{}); }
       constexpr auto& operator*=(const T& rhs)
-      { return apply([&](T& x){ x *= rhs; }); }
+      { return transform(rhs, simd::mul_assign{}); }
       constexpr auto& operator/=(const T& rhs) 
-      { return apply([&](T& x){ x /= rhs; }); }
+      { return transform(rhs, simd::div_assign{}); }
 
       constexpr auto& operator+=(const num_array& rhs)
-      { return apply(rhs, [](T& x, const T& y){ x += y; }); }
+      { return transform(rhs, simd::add_assign{}); }
       constexpr auto& operator-=(const num_array& rhs)
-      { return apply(rhs, [](T& x, const T& y){ x -= y; }); }
-      
+      { return transform(rhs, simd::sub_assign{}); }
+      // Element-wise (Hadamard) product and quotient
+      constexpr auto& operator*=(const num_array& rhs)
+      { return transform(rhs, simd::mul_assign{}); }
+      constexpr auto& operator/=(const num_array& rhs)
+      { return transform(rhs, simd::div_assign{}); }
+
+      template<detail::Conforming_expression<std::index_sequence<N>> E>
+        constexpr auto& operator+=(const E& rhs)
+        { return evaluate(rhs, simd::add_assign{}); }
+      template<detail::Conforming_expression<std::index_sequence<N>> E>
+        constexpr auto& operator-=(const E& rhs)
+        { return evaluate(rhs, simd::sub_assign{}); }
+      template<detail::Conforming_expression<std::index_sequence<N>> E>
+        constexpr auto& operator*=(const E& rhs)
+        { return evaluate(rhs, simd::mul_assign{}); }
+      template<detail::Conforming_expression<std::index_sequence<N>> E>
+        constexpr auto& operator/=(const E& rhs)
+        { return evaluate(rhs, simd::div_assign{}); }
+
     private:
+      template<Number, std::size_t, std::size_t...> friend class num_array;
+
+      template<typename E>
+        constexpr auto& evaluate(const E& x, auto op)
+        {
+          const detail::counted_scope scope(instrument::operation::elementwise,
+            detail::assignment_cost<num_array, E>(op));
+          for (size_type i = 0; i < N; ++i) op(data_[i], x[i]);
+          return *this;
+        }
+      constexpr auto& transform(const T& x, auto op);
+      constexpr auto& transform(const num_array& x, auto op);
+
       T data_[N];
     };
   
@@ -232,6 +761,8 @@ namespace tb::math {
       num_array<T, N>::num_array(const num_array<U, N>& x)
         requires std::common_with<T, U>
     {
+      const detail::counted_scope scope(instrument::operation::construct,
+        detail::operation_cost<T, num_array<U, N>>(N));
       std::copy(x.begin(), x.end(), begin());
     }
 
@@ -239,6 +770,8 @@ namespace tb::math {
     constexpr 
     num_array<T, N>::num_array(const T& value)
     {
+      const detail::counted_scope scope(instrument::operation::construct,
+        detail::operation_cost<T>(N));
       std::fill_n(data_, this->size(), value);
     }
 
@@ -276,140 +809,434 @@ namespace tb::math {
       while (i != end()) func(*i++, *j++);
       return *this;
     }
+
+  template<Number T, std::size_t N>
+    template<detail::Conforming_expression<std::index_sequence<N>> E>
+      constexpr auto&
+      num_array<T, N>::apply(const E& x, auto func)
+      {
+        for (size_type i = 0; i < this->size(); ++i) func(data_[i], x[i]);
+        return *this;
+      }
+
+  template<Number T, std::size_t N>
+    constexpr auto&
+    num_array<T, N>::transform(const T& x, auto op)
+    {
+      const detail::counted_scope scope(instrument::operation::elementwise,
+        detail::assignment_cost<num_array, T>(op));
+      if (std::is_constant_evaluated()) {
+        for (auto& y : data_) op(y, x);
+      } else if constexpr (detail::is_small_extents<N>) {
+        simd::transform_n<N>(data_, x, op);
+      } else {
+        simd::transform(data_, x, op, N);
+      }
+      return *this;
+    }
+
+  template<Number T, std::size_t N>
+    constexpr auto&
+    num_array<T, N>::transform(const num_array& x, auto op)
+    {
+      const detail::counted_scope scope(instrument::operation::elementwise,
+        detail::assignment_cost<num_array, num_array>(op));
+      if (std::is_constant_evaluated()) {
+        for (std::size_t i = 0; i < N; ++i) op(data_[i], x.data_[i]);
+      } else if constexpr (detail::is_small_extents<N>) {
+        simd::transform_n<N>(data_, x.data_, op);
+      } else {
+        simd::transform(data_, x.data_, op, N);
+      }
+      return *this;
+    }
   
+  // Expression templates
+  //
+  // The arithmetic operators below do not compute their result directly. 
+  // Instead they return a num_array_expr that records the operation and its 
+  // operands, so that a chain such as a + b * 2 - c is evaluated in a single
+  // pass, element by element, when it is assigned to (or used to construct) a
+  // num_array. No intermediate arrays are created.
+  //
+  // NOTE: num_array operands that are lvalues are held by reference. An 
+  // expression must not outlive the arrays it refers to; use eval() to obtain
+  // a num_array. Temporary num_arrays are moved into the expression.
+  template<typename Op, typename... Args>
+    class num_array_expr 
+      : public detail::base_of_shape<
+                 std::common_type_t<detail::element_t<Args>...>,
+                 typename detail::common_shape<Args...>::type>::type 
+    {
+    public:
+      using element_type  = std::common_type_t<detail::element_t<Args>...>;
+      using shape_type    = detail::common_shape<Args...>::type;
+      using array_type    = detail::array_of_shape<element_type, shape_type>::type;
+      using size_type     = std::size_t;
+
+      constexpr explicit num_array_expr(const Args&... args) : args_(args...) { }
+
+      // Moves temporary num_array operands into the expression (see 
+      // detail::temporary).
+      template<typename... Xs>
+        constexpr explicit num_array_expr(std::in_place_t, Xs&&... xs) 
+          : args_(std::forward<Xs>(xs)...) { }
+
+      // Returns the i-th element of a one-dimensional expression, or the 
+      // sub-expression of the i-th "row" otherwise.
+      constexpr auto operator[](size_type i) const;
+
+      template<Index_type Index, Index_type... Indices>
+        constexpr auto operator()(Index i, Indices... j) const
+          requires (sizeof...(Indices) + 1 == shape_type::size())
+        {
+          if constexpr (sizeof...(Indices) == 0) return (*this)[i];
+          else return (*this)[i](j...);
+        }
+
+      // The k-th element in row-major order, if the operands are num_arrays
+      // and scalars.
+      element_type flat(size_type k) const requires detail::is_flat<num_array_expr>
+      {
+        return std::apply([k](const auto&... x) { 
+          return static_cast<element_type>(
+            Op{}(static_cast<element_type>(detail::flat_subscript(x, k))...));
+        }, args_);
+      }
+
+    private:
+      std::tuple<detail::operand_t<Args>...> args_;
+    };
+
+  template<typename Op, typename... Args>
+    constexpr auto
+    num_array_expr<Op, Args...>::operator[](size_type i) const
+    {
+      if constexpr (num_array_expr::order() == 1) {
+        return std::apply([i](const auto&... x) { 
+          return static_cast<element_type>(
+            Op{}(static_cast<element_type>(detail::subscript(x, i))...));
+        }, args_);
+      } else {
+        return std::apply([i](const auto&... x) {
+          return num_array_expr<Op, typename detail::sub_operand<Args>::type...>(
+            detail::subscript(x, i)...);
+        }, args_);
+      }
+    }
+
+  // Evaluates an Array_expression into a num_array.
+  template<Array_expression E>
+    [[nodiscard]] constexpr auto
+    eval(const E& x)
+    {
+      using R = detail::array_of_shape<detail::element_t<E>, 
+                                       detail::shape_t<E>>::type;
+      return R(x);
+    }
+
   // Operations
   
   // Scalar addition
-  template<Number T, Number U, std::size_t M, std::size_t... N>
+  template<Array_expression E, Scalar U>
     constexpr auto
-    operator+(const num_array<T, M, N...>& lhs, const U& rhs)
-      requires std::common_with<T, U>    
+    operator+(const E& lhs, const U& rhs)
+      requires std::common_with<detail::element_t<E>, U>
     {
-      using R = typename std::common_type<T, U>::type;
-      return num_array<R, M, N...>(lhs) += rhs;
+      return num_array_expr<std::plus<>, E, U>(lhs, rhs);
     }
 
   // Scalar subtraction
-  template<Number T, Number U, std::size_t M, std::size_t... N>
+  template<Array_expression E, Scalar U>
     constexpr auto
-    operator-(const num_array<T, M, N...>& lhs, const U& rhs)
-      requires std::common_with<T, U>
+    operator-(const E& lhs, const U& rhs)
+      requires std::common_with<detail::element_t<E>, U>
     {
-      using R = typename std::common_type<T, U>::type;
-      return num_array<R, M, N...>(lhs) -= rhs;
+      return num_array_expr<std::minus<>, E, U>(lhs, rhs);
     }
 
   // Scalar multiplication
-  template<Number T, Number U, std::size_t M, std::size_t... N>
+  template<Array_expression E, Scalar U>
     constexpr auto
-    operator*(const num_array<T, M, N...>& lhs, const U& rhs)
-      requires std::common_with<T, U>
+    operator*(const E& lhs, const U& rhs)
+      requires std::common_with<detail::element_t<E>, U>
     {
-      using R = typename std::common_type<T, U>::type;
-      return num_array<R, M, N...>(lhs) *= rhs;
+      return num_array_expr<std::multiplies<>, E, U>(lhs, rhs);
     }
   
   // Commutative scalar multiplication
-  template<Number T, Number U, std::size_t M, std::size_t... N>
+  template<Scalar U, Array_expression E>
     constexpr auto
-    operator*(const U& lhs, const num_array<T, M, N...>& rhs)
-      requires std::common_with<T, U>
+    operator*(const U& lhs, const E& rhs)
+      requires std::common_with<detail::element_t<E>, U>
     {
-      using R = typename std::common_type<T, U>::type;
-      return num_array<R, M, N...>(rhs) *= lhs;
+      return num_array_expr<std::multiplies<>, U, E>(lhs, rhs);
     }
 
   // Negation
-  template<Number T, std::size_t M, std::size_t... N>
+  template<Array_expression E>
     constexpr auto
-    operator-(const num_array<T, M, N...>& rhs)
+    operator-(const E& rhs)
     {
-      return num_array<T, M, N...>(rhs).apply([](T& x){ x = -x; });
+      return num_array_expr<std::negate<>, E>(rhs);
     }
 
   // Scalar division
-  template<Number T, Number U, std::size_t M, std::size_t... N>
+  template<Array_expression E, Scalar U>
     constexpr auto
-    operator/(const num_array<T, M, N...>& lhs, const U& rhs)
-      requires std::common_with<T, U>
+    operator/(const E& lhs, const U& rhs)
+      requires std::common_with<detail::element_t<E>, U>
     {
-      using R = typename std::common_type<T, U>::type;
-      return num_array<R, M, N...>(lhs) /= rhs;
+      return num_array_expr<std::divides<>, E, U>(lhs, rhs);
     }
 
   // Element-wise addition
-  template<Number T, Number U, std::size_t M, std::size_t... N>
+  template<Array_expression E1, Array_expression E2>
     constexpr auto
-    operator+(const num_array<T, M, N...>& lhs, 
-              const num_array<U, M, N...>& rhs)
-      requires std::common_with<T, U>
+    operator+(const E1& lhs, const E2& rhs)
+      requires detail::Same_shape<E1, E2> 
+            && std::common_with<detail::element_t<E1>, detail::element_t<E2>>
     {
-      using R = std::common_type<T, U>::type;
-      return num_array<R, M, N...>(lhs) += rhs;
+      return num_array_expr<std::plus<>, E1, E2>(lhs, rhs);
     }
 
   // Element-wise Subtraction
-  template<Number T, Number U, std::size_t M, std::size_t... N>
+  template<Array_expression E1, Array_expression E2>
+    constexpr auto
+    operator-(const E1& lhs, const E2& rhs)
+      requires detail::Same_shape<E1, E2> 
+            && std::common_with<detail::element_t<E1>, detail::element_t<E2>>
+    {
+      return num_array_expr<std::minus<>, E1, E2>(lhs, rhs);
+    }
+
+  // Element-wise (Hadamard) product
+  //
+  // NOTE: operator* of two arrays is the matrix product (see matrix.h).
+  template<Array_expression E1, Array_expression E2>
     constexpr auto
-    operator-(const num_array<T, M, N...>& lhs, 
-              const num_array<U, M, N...>& rhs)
-      requires std::common_with<T, U>
+    hadamard_product(const E1& lhs, const E2& rhs)
+      requires detail::Same_shape<E1, E2> 
+            && std::common_with<detail::element_t<E1>, detail::element_t<E2>>
     {
-      using R = std::common_type<T, U>::type;
-      return num_array<R, M, N...>(lhs) -= rhs;
+      return num_array_expr<std::multiplies<>, E1, E2>(lhs, rhs);
+    }
+
+  // Element-wise quotient
+  template<Array_expression E1, Array_expression E2>
+    constexpr auto
+    hadamard_quotient(const E1& lhs, const E2& rhs)
+      requires detail::Same_shape<E1, E2> 
+            && std::common_with<detail::element_t<E1>, detail::element_t<E2>>
+    {
+      return num_array_expr<std::divides<>, E1, E2>(lhs, rhs);
+    }
+
+  // Operations on temporary num_arrays
+  //
+  // These take precedence over the operations above when a num_array 
+  // operand is an rvalue, and move it into the expression.
+  template<typename E, Scalar U>
+    constexpr auto
+    operator+(E&& lhs, const U& rhs)
+      requires detail::Temporary_array<E> && std::common_with<detail::element_t<E>, U>
+    {
+      return num_array_expr<std::plus<>, detail::temporary<E>, U>(
+        std::in_place, std::move(lhs), rhs);
+    }
+
+  template<typename E, Scalar U>
+    constexpr auto
+    operator-(E&& lhs, const U& rhs)
+      requires detail::Temporary_array<E> && std::common_with<detail::element_t<E>, U>
+    {
+      return num_array_expr<std::minus<>, detail::temporary<E>, U>(
+        std::in_place, std::move(lhs), rhs);
+    }
+
+  template<typename E, Scalar U>
+    constexpr auto
+    operator*(E&& lhs, const U& rhs)
+      requires detail::Temporary_array<E> && std::common_with<detail::element_t<E>, U>
+    {
+      return num_array_expr<std::multiplies<>, detail::temporary<E>, U>(
+        std::in_place, std::move(lhs), rhs);
+    }
+
+  template<Scalar U, typename E>
+    constexpr auto
+    operator*(const U& lhs, E&& rhs)
+      requires detail::Temporary_array<E> && std::common_with<detail::element_t<E>, U>
+    {
+      return num_array_expr<std::multiplies<>, U, detail::temporary<E>>(
+        std::in_place, lhs, std::move(rhs));
+    }
+
+  template<typename E>
+    constexpr auto
+    operator-(E&& rhs)
+      requires detail::Temporary_array<E>
+    {
+      return num_array_expr<std::negate<>, detail::temporary<E>>(std::in_place, std::move(rhs));
+    }
+
+  template<typename E, Scalar U>
+    constexpr auto
+    operator/(E&& lhs, const U& rhs)
+      requires detail::Temporary_array<E> && std::common_with<detail::element_t<E>, U>
+    {
+      return num_array_expr<std::divides<>, detail::temporary<E>, U>(
+        std::in_place, std::move(lhs), rhs);
+    }
+
+  template<typename E1, typename E2>
+    constexpr auto
+    operator+(E1&& lhs, E2&& rhs) requires detail::Temporary_operands<E1, E2>
+    {
+      return num_array_expr<std::plus<>, detail::operand_of<E1>, detail::operand_of<E2>>(
+        std::in_place, std::forward<E1>(lhs), std::forward<E2>(rhs));
+    }
+
+  template<typename E1, typename E2>
+    constexpr auto
+    operator-(E1&& lhs, E2&& rhs) requires detail::Temporary_operands<E1, E2>
+    {
+      return num_array_expr<std::minus<>, detail::operand_of<E1>, detail::operand_of<E2>>(
+        std::in_place, std::forward<E1>(lhs), std::forward<E2>(rhs));
+    }
+
+  template<typename E1, typename E2>
+    constexpr auto
+    hadamard_product(E1&& lhs, E2&& rhs) requires detail::Temporary_operands<E1, E2>
+    {
+      return num_array_expr<std::multiplies<>, detail::operand_of<E1>, detail::operand_of<E2>>(
+        std::in_place, std::forward<E1>(lhs), std::forward<E2>(rhs));
+    }
+
+  template<typename E1, typename E2>
+    constexpr auto
+    hadamard_quotient(E1&& lhs, E2&& rhs) requires detail::Temporary_operands<E1, E2>
+    {
+      return num_array_expr<std::divides<>, detail::operand_of<E1>, detail::operand_of<E2>>(
+        std::in_place, std::forward<E1>(lhs), std::forward<E2>(rhs));
     }
 
   // Element-wise comparisons
-  template<Number T, Number U, std::size_t M, std::size_t... N>
+  template<Array_expression E1, Array_expression E2>
     constexpr bool
-    operator==(const num_array<T, M, N...>& lhs, 
-               const num_array<U, M, N...>& rhs)
-      requires std::common_with<T, U>
+    operator==(const E1& lhs, const E2& rhs)
+      requires detail::Same_shape<E1, E2> 
+            && std::common_with<detail::element_t<E1>, detail::element_t<E2>>
     {
-      for (std::size_t i = 0; i < M; ++i) {
-        if (lhs[i] != rhs[i]) { return false; }
+      using C = std::common_type_t<detail::element_t<E1>, detail::element_t<E2>>;
+      if constexpr (detail::is_flat<E1> && detail::is_flat<E2>) {
+        if (!std::is_constant_evaluated()) { // element by element, in one loop
+          for (std::size_t k = 0; k < E1::n_elements(); ++k) {
+            if (C(detail::flat_subscript(lhs, k)) != C(detail::flat_subscript(rhs, k))) return false;
+          }
+          return true;
+        }
+      }
+      for (std::size_t i = 0; i < lhs.size(); ++i) {
+        if constexpr (E1::order() == 1) {
+          if (C(lhs[i]) != C(rhs[i])) { return false; }
+        } else if (lhs[i] != rhs[i]) { return false; }
       }
       return true;
     }
 
-  template<Number T, Number U, std::size_t M, std::size_t... N>
+  template<Array_expression E1, Array_expression E2>
     constexpr bool
-    operator!=(const num_array<T, M, N...>& lhs, 
-               const num_array<U, M, N...>& rhs)
-      requires std::common_with<T, U>
+    operator!=(const E1& lhs, const E2& rhs)
+      requires detail::Same_shape<E1, E2> 
+            && std::common_with<detail::element_t<E1>, detail::element_t<E2>>
     {
       return !(lhs == rhs);
     }
 
   // Scalar comparisons
-  template<Number T, Number U, std::size_t M, std::size_t... N>
+  template<Array_expression E, Scalar U>
     constexpr bool
-    operator==(const num_array<T, M, N...>& lhs, const U& rhs)
-      requires std::common_with<T, U>
+    operator==(const E& lhs, const U& rhs)
+      requires std::common_with<detail::element_t<E>, U>
     {
-      for (std::size_t i = 0; i < M; ++i) {
-        if (lhs[i] != rhs) { return false; }
+      using C = std::common_type_t<detail::element_t<E>, U>;
+      if constexpr (detail::is_flat<E>) {
+        if (!std::is_constant_evaluated()) {
+          for (std::size_t k = 0; k < E::n_elements(); ++k) {
+            if (C(detail::flat_subscript(lhs, k)) != C(rhs)) return false;
+          }
+          return true;
+        }
+      }
+      for (std::size_t i = 0; i < lhs.size(); ++i) {
+        if constexpr (E::order() == 1) {
+          if (C(lhs[i]) != C(rhs)) { return false; }
+        } else if (lhs[i] != rhs) { return false; }
       }
       return true;
     }
 
-  template<Number T, Number U, std::size_t M, std::size_t... N>
+  template<Array_expression E, Scalar U>
     constexpr bool
-    operator!=(const num_array<T, M, N...>& lhs, const U& rhs)
-      requires std::common_with<T, U>
+    operator!=(const E& lhs, const U& rhs)
+      requires std::common_with<detail::element_t<E>, U>
     {
       return !(lhs == rhs);
     }
 
   // Returns a num_array where elements are the absolute value of the 
   // corresponding elements of v
-  template<Number T, std::size_t M, std::size_t... N>
+  template<Array_expression E>
+    constexpr auto
+    abs(const E& v)
+    {
+      return eval(num_array_expr<detail::absolute, E>(v));
+    }
+
+  // Fused multiply-add
+  // Returns a num_array whose elements are a[i] * b[i] + c[i], evaluated in
+  // a single pass without a temporary for the product. Each is rounded once
+  // if the element type has vector FMA instructions on the target (see
+  // simd::Fusable), as by std::fma(). Arrays of a single type are processed
+  // by the vectorized kernel in simd.h, unless they are small, for which the
+  // loop is unrolled instead.
+  template<Array_expression E1, Array_expression E2, Array_expression E3>
     constexpr auto
-    abs(const num_array<T, M, N...>& v)
+    fma(const E1& a, const E2& b, const E3& c)
+      requires detail::Same_shape<E1, E2> && detail::Same_shape<E1, E3>
     {
-      num_array<T, M, N...> result;
-      result.apply(v, [](T& x, const T& y){ x = std::abs(y); });
-      return result;
+      if constexpr (is_num_array<E1>::value && !detail::Small<E1>
+                    && std::same_as<E1, E2> && std::same_as<E1, E3>) {
+        if (!std::is_constant_evaluated()) {
+          const detail::counted_scope scope(instrument::operation::construct,
+            detail::operation_cost<detail::element_t<E1>, E1, E2, E3>(E1::n_elements(),
+                                                                  2 * E1::n_elements()));
+          E1 result;
+          simd::multiply_add(result.data(), a.data(), b.data(), c.data(), E1::n_elements());
+          return result;
+        }
+      }
+      return eval(num_array_expr<detail::multiply_add, E1, E2, E3>(a, b, c));
+    }
+
+  // y = alpha * x + y, in place, with fused multiply-adds as fma().
+  template<Scalar U, Array_expression E, Number T, std::size_t M, std::size_t... N>
+    constexpr auto&
+    axpy(const U& alpha, const E& x, num_array<T, M, N...>& y)
+      requires detail::Same_shape<E, num_array<T, M, N...>> 
+            && std::convertible_to<U, T>
+    {
+      if constexpr (std::same_as<E, num_array<T, M, N...>> && !detail::is_small_extents<M, N...>) {
+        if (!std::is_constant_evaluated()) {
+          const detail::counted_scope scope(instrument::operation::elementwise,
+            detail::operation_cost<T, E, E>(y.n_elements(), 2 * y.n_elements()));
+          simd::axpy(T(alpha), x.data(), y.data(), y.n_elements());
+          return y;
+        }
+      }
+      // Each element of y is read before it is assigned.
+      return y = num_array_expr<detail::multiply_add, T, E, num_array<T, M, N...>>(T(alpha), x, y);
     }
 } // namespace tb::math
 #endif//TB_MATH_NUM_ARRAY_H
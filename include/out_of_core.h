@@ -0,0 +1,309 @@
+#ifndef TB_MATH_NUM_ARRAY_OUT_OF_CORE_H
+#define TB_MATH_NUM_ARRAY_OUT_OF_CORE_H
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "dynamic_num_array.h"
+#include "reduce.h"
+#include "serialization.h"
+
+namespace tb::math {
+
+  // How an out_of_core_matrix is processed: in tiles of whole rows, of which
+  // depth are held in memory at a time (one being processed while the
+  // others are read ahead), within about memory_budget bytes in all.
+  struct out_of_core_options {
+    std::size_t memory_budget = std::size_t(256) << 20;
+    std::size_t depth = 2;
+  };
+
+  // A matrix stored in a num_array file (see serialization.h) rather than in
+  // memory, so it can be larger than memory. Its rows are processed in tiles,
+  // which are read into a bounded pool of buffers by for_each_tile(): the
+  // next tiles are read in the background while the current one is
+  // processed, so that reading and computing overlap.
+  //
+  // The reductions of reduce.h (sum, min, max, mean, the norms, ...) accept
+  // an out_of_core_matrix, as do matrix_vector_product,
+  // vector_matrix_product and transpose below.
+  //
+  // std::runtime_error is thrown if the file cannot be read or written, or
+  // does not hold a matrix of T in this machine's byte order.
+  template<Number T>
+    class out_of_core_matrix {
+    public:
+      using element_type = T;
+      using value_type   = T;
+      using size_type    = std::size_t;
+      using tile_type    = dynamic_num_array<T, 2>;
+
+      // Opens the matrix in the file at path, written by write_binary() or
+      // create().
+      explicit out_of_core_matrix(const std::filesystem::path& path,
+                                  out_of_core_options options = { });
+
+      // Creates a file at path for an m x n matrix of zeros.
+      static out_of_core_matrix create(const std::filesystem::path& path,
+                                       size_type m, size_type n,
+                                       out_of_core_options options = { });
+
+      out_of_core_matrix(out_of_core_matrix&& x) noexcept
+        : fd_(std::exchange(x.fd_, -1)), rows_(x.rows_), cols_(x.cols_),
+          offset_(x.offset_), options_(x.options_) { }
+      out_of_core_matrix& operator=(out_of_core_matrix&&) = delete;
+      ~out_of_core_matrix() { if (fd_ >= 0) ::close(fd_); }
+
+      // Structure
+
+      size_type size() const noexcept { return rows_; } // number of rows
+      static constexpr auto order() { return 2; }
+      size_type extent(std::size_t i) const { return i == 0 ? rows_ : cols_; }
+      size_type n_elements() const noexcept { return rows_ * cols_; }
+      bool empty() const noexcept { return n_elements() == 0; }
+
+      // The number of rows of a tile (all but the last)
+      size_type tile_rows() const noexcept
+      {
+        const auto row_bytes = std::max<size_type>(cols_ * sizeof(T), 1);
+        return std::max<size_type>(options_.memory_budget / options_.depth / row_bytes, 1);
+      }
+
+      // Reads rows [first, first + x.size()) into x.
+      void read_rows(size_type first, tile_type& x) const;
+
+      // Writes x to rows [first, first + x.size()).
+      void write_rows(size_type first, const tile_type& x);
+
+      // Reads or writes the n elements from the first-th on, in row-major
+      // order.
+      void read(size_type first, T* data, size_type n) const;
+      void write(size_type first, const T* data, size_type n);
+
+      // Calls f(first, tile) for each tile, in order, where tile holds rows
+      // [first, first + tile.size()) of the matrix.
+      template<typename F>
+        void for_each_tile(F f) const;
+
+    private:
+      out_of_core_matrix(int fd, out_of_core_options options)
+        : fd_(fd), options_(options) { }
+
+      void check_range(size_type first, size_type n) const
+      {
+        if (first > n_elements() || n > n_elements() - first)
+          throw std::out_of_range("Elements out of range");
+      }
+
+      void transfer(auto io, auto data, size_type first, size_type n) const;
+
+      int fd_;
+      size_type rows_ = 0, cols_ = 0;
+      size_type offset_ = 0; // of the elements in the file
+      out_of_core_options options_;
+    };
+
+  template<Number T>
+    out_of_core_matrix<T>::out_of_core_matrix(const std::filesystem::path& path,
+                                              out_of_core_options options)
+      : out_of_core_matrix(::open(path.c_str(), O_RDWR), options)
+    {
+      if (fd_ < 0) fd_ = ::open(path.c_str(), O_RDONLY);
+      if (fd_ < 0) throw std::runtime_error("Cannot open num_array file");
+      if (options_.depth == 0) options_.depth = 1;
+
+      array_header h;
+      std::uint64_t extents[2];
+      const bool valid = ::pread(fd_, &h, sizeof(h), 0) == sizeof(h)
+        && std::equal(h.magic, h.magic + 4, detail::array_magic)
+        && h.endianness == detail::native_endianness && h.rank == 2 && h.count == 1
+        && ::pread(fd_, extents, sizeof(extents), sizeof(h)) == sizeof(extents);
+      if (!valid) {
+        ::close(std::exchange(fd_, -1));
+        throw std::runtime_error("Not a num_array matrix file of this machine's byte order");
+      }
+      detail::check_header<T>(h);
+      rows_ = extents[0];
+      cols_ = extents[1];
+      offset_ = h.data_offset;
+    }
+
+  template<Number T>
+    out_of_core_matrix<T>
+    out_of_core_matrix<T>::create(const std::filesystem::path& path, size_type m, size_type n,
+                                  out_of_core_options options)
+    {
+      {
+        std::ofstream os(path, std::ios::binary | std::ios::trunc);
+        const std::uint64_t extents[] = { m, n };
+        detail::write_header<T>(os, extents, 1);
+        if (!os) throw std::runtime_error("Cannot create num_array file");
+      }
+      std::filesystem::resize_file(path, detail::data_offset(2) + m * n * sizeof(T));
+      return out_of_core_matrix(path, options);
+    }
+
+  // Reads or writes, with io = ::pread or ::pwrite, the n elements at data
+  // from element first on.
+  template<Number T>
+    void
+    out_of_core_matrix<T>::transfer(auto io, auto data, size_type first, size_type n) const
+    {
+      auto bytes = reinterpret_cast<std::conditional_t<
+        std::is_const_v<std::remove_pointer_t<decltype(data)>>, const char*, char*>>(data);
+      auto remaining = n * sizeof(T);
+      auto position = static_cast<off_t>(offset_ + first * sizeof(T));
+      while (remaining > 0) {
+        const auto k = io(fd_, bytes, remaining, position);
+        if (k <= 0) throw std::runtime_error("Cannot access num_array file");
+        bytes += k;
+        remaining -= static_cast<size_type>(k);
+        position += k;
+      }
+    }
+
+  template<Number T>
+    void
+    out_of_core_matrix<T>::read(size_type first, T* data, size_type n) const
+    {
+      check_range(first, n);
+      transfer(::pread, data, first, n);
+    }
+
+  template<Number T>
+    void
+    out_of_core_matrix<T>::write(size_type first, const T* data, size_type n)
+    {
+      check_range(first, n);
+      transfer(::pwrite, data, first, n);
+    }
+
+  template<Number T>
+    void
+    out_of_core_matrix<T>::read_rows(size_type first, tile_type& x) const
+    {
+      if (x.extent(1) != cols_) throw std::invalid_argument("Incompatible extents");
+      read(first * cols_, x.data(), x.n_elements());
+    }
+
+  template<Number T>
+    void
+    out_of_core_matrix<T>::write_rows(size_type first, const tile_type& x)
+    {
+      if (x.extent(1) != cols_) throw std::invalid_argument("Incompatible extents");
+      write(first * cols_, x.data(), x.n_elements());
+    }
+
+  template<Number T>
+    template<typename F>
+      void
+      out_of_core_matrix<T>::for_each_tile(F f) const
+      {
+        const auto rows = tile_rows(), depth = options_.depth;
+        const auto n_tiles = (rows_ + rows - 1) / rows;
+        std::vector<tile_type> buffers(std::min(depth, n_tiles));
+        std::deque<std::future<void>> pending; // reads, in the order of the tiles
+
+        const auto read_ahead = [&](size_type k) {
+          auto& tile = buffers[k % buffers.size()];
+          const auto first = k * rows, n = std::min(rows, rows_ - first);
+          if (tile.size() != n) tile = tile_type(n, cols_);
+          pending.push_back(std::async(std::launch::async, [this, first, &tile] {
+            read_rows(first, tile);
+          }));
+        };
+
+        for (size_type k = 0; k < buffers.size(); ++k) read_ahead(k);
+        for (size_type k = 0; k < n_tiles; ++k) {
+          pending.front().get();
+          pending.pop_front();
+          f(k * rows, std::as_const(buffers[k % buffers.size()]));
+          if (k + buffers.size() < n_tiles) read_ahead(k + buffers.size());
+        }
+      }
+
+  // Operations
+  //
+  // The vectors fit in memory, and the matrix is read once, tile by tile.
+
+  template<Number T>
+    [[nodiscard]] auto
+    matrix_vector_product(const out_of_core_matrix<T>& lhs, const dynamic_num_array<T, 1>& rhs)
+    {
+      if (rhs.size() != lhs.extent(1)) throw std::invalid_argument("Incompatible extents");
+      dynamic_num_array<T, 1> result(lhs.size());
+      lhs.for_each_tile([&](std::size_t first, const auto& tile) {
+        const auto y = matrix_vector_product(tile, rhs);
+        std::copy(y.begin(), y.end(), result.begin() + first);
+      });
+      return result;
+    }
+
+  template<Number T>
+    [[nodiscard]] auto
+    vector_matrix_product(const dynamic_num_array<T, 1>& lhs, const out_of_core_matrix<T>& rhs)
+    {
+      if (lhs.size() != rhs.size()) throw std::invalid_argument("Incompatible extents");
+      dynamic_num_array<T, 1> result({ rhs.extent(1) }, T(0));
+      rhs.for_each_tile([&](std::size_t first, const auto& tile) {
+        dynamic_num_array<T, 1> x(tile.size());
+        std::copy_n(lhs.begin() + first, tile.size(), x.begin());
+        result += vector_matrix_product(x, tile);
+      });
+      return result;
+    }
+
+  // Writes the transpose of x to a new file at path. x is transposed in
+  // blocks of half of options.memory_budget (the other half holds their
+  // transposes), as square as x allows, so that each read and write is of
+  // a whole row of a block, and of whole rows of the matrices when the
+  // blocks span them.
+  template<Number T>
+    [[nodiscard]] auto
+    transpose(const out_of_core_matrix<T>& x, const std::filesystem::path& path,
+              out_of_core_options options = { })
+    {
+      const auto m = x.size(), n = x.extent(1);
+      auto result = out_of_core_matrix<T>::create(path, n, m, options);
+      if (x.empty()) return result;
+
+      const auto elements = std::max<std::size_t>(options.memory_budget / 2 / sizeof(T), 1);
+      const auto side = std::max(static_cast<std::size_t>(std::sqrt(double(elements))), std::size_t(1));
+      const auto rows = std::min(m, side);
+      const auto cols = std::min(n, std::max<std::size_t>(elements / rows, 1));
+      dynamic_num_array<T, 2> block;
+      for (std::size_t i = 0; i < m; i += rows) {
+        for (std::size_t j = 0; j < n; j += cols) {
+          const auto p = std::min(rows, m - i), q = std::min(cols, n - j);
+          if (block.extent(0) != p || block.extent(1) != q) block = dynamic_num_array<T, 2>(p, q);
+          if (q == n) {
+            x.read(i * n, block.data(), p * n);
+          } else {
+            for (std::size_t k = 0; k < p; ++k) x.read((i + k) * n + j, block.data() + k * q, q);
+          }
+          const auto t = transpose(block);
+          if (p == m) {
+            result.write(j * m, t.data(), q * m);
+          } else {
+            for (std::size_t k = 0; k < q; ++k) result.write((j + k) * m + i, t.data() + k * p, p);
+          }
+        }
+      }
+      return result;
+    }
+}
+
+namespace tb::math::detail {
+
+  template<Number T>
+    struct element_of<out_of_core_matrix<T>> { using type = T; };
+}
+#endif//TB_MATH_NUM_ARRAY_OUT_OF_CORE_H
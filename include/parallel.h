@@ -0,0 +1,157 @@
+#ifndef TB_MATH_NUM_ARRAY_PARALLEL_H
+#define TB_MATH_NUM_ARRAY_PARALLEL_H
+
+#include "dynamic_num_array.h"
+#include "matrix.h"
+#include "thread_pool.h"
+
+namespace tb::math::execution {
+
+  // Execution policy for the multithreaded overloads of the matrix
+  // operations below, e.g. matrix_product(execution::par, a, b). The work is
+  // done on the default thread_pool, or on another with par.on(pool).
+  struct parallel_policy {
+    thread_pool* pool = nullptr;
+
+    constexpr parallel_policy on(thread_pool& p) const noexcept { return { &p }; }
+    thread_pool& get_pool() const { return pool ? *pool : thread_pool::default_pool(); }
+  };
+
+  inline constexpr parallel_policy par{};
+}
+
+namespace tb::math::detail {
+
+  // Products with fewer multiply-adds are not worth dividing among threads.
+  inline constexpr std::size_t parallel_gemm_threshold = 128 * 128 * 128;
+
+  // c = a * b as in gemm(), with c divided into tiles of about mc rows and
+  // 256 columns that are computed concurrently. Each tile is a complete
+  // gemm() of a strip of a by a strip of b, so tiles share no state.
+  template<typename R, typename T1, typename T2>
+    void
+    parallel_gemm(thread_pool& pool, std::size_t m, std::size_t n, std::size_t p,
+                  const T1* a, std::size_t lda, const T2* b, std::size_t ldb,
+                  R* c, std::size_t ldc)
+    {
+      using blocking = gemm_blocking<R>;
+      constexpr std::size_t rows = blocking::mc;
+      constexpr std::size_t cols = (256 + blocking::nr - 1) / blocking::nr * blocking::nr;
+      const auto row_tiles = (m + rows - 1) / rows, col_tiles = (p + cols - 1) / cols;
+      pool.parallel_for(0, row_tiles * col_tiles, 1, [&](std::size_t t, std::size_t last) {
+        for (; t < last; ++t) {
+          const auto i = t / col_tiles * rows, j = t % col_tiles * cols;
+          gemm(std::min(rows, m - i), n, std::min(cols, p - j),
+               a + i * lda, lda, b + j, ldb, c + i * ldc + j, ldc);
+        }
+      });
+    }
+
+  // b = transpose(a), where a is m x n, by recursively halving the larger
+  // dimension until the block fits in the L1 cache, which suits every level
+  // of the cache without knowing its size.
+  template<typename T, typename U>
+    void
+    transpose_recursive(std::size_t m, std::size_t n, const T* a, std::size_t lda,
+                        U* b, std::size_t ldb)
+    {
+      constexpr std::size_t leaf = 16; // elements per side
+      if (m <= leaf && n <= leaf) {
+        for (std::size_t i = 0; i < m; ++i) {
+          for (std::size_t j = 0; j < n; ++j) b[j * ldb + i] = a[i * lda + j];
+        }
+      } else if (m >= n) {
+        const auto h = m / 2;
+        transpose_recursive(h, n, a, lda, b, ldb);
+        transpose_recursive(m - h, n, a + h * lda, lda, b + h, ldb);
+      } else {
+        const auto h = n / 2;
+        transpose_recursive(m, h, a, lda, b, ldb);
+        transpose_recursive(m, n - h, a + h, lda, b + h * ldb, ldb);
+      }
+    }
+
+  // b = transpose(a), with strips of rows of a transposed concurrently.
+  template<typename T, typename U>
+    void
+    parallel_transpose(thread_pool& pool, std::size_t m, std::size_t n,
+                       const T* a, std::size_t lda, U* b, std::size_t ldb)
+    {
+      constexpr std::size_t strip = 64;
+      const auto grain = std::max<std::size_t>(strip, strip * strip / std::max<std::size_t>(n, 1));
+      pool.parallel_for(0, m, grain, [&](std::size_t i, std::size_t j) {
+        transpose_recursive(j - i, n, a + i * lda, lda, b + i, ldb);
+      });
+    }
+}
+
+namespace tb::math {
+
+  // Multithreaded matrix operations
+  //
+  // These compute the same results as the functions of the same name in
+  // matrix.h and dynamic_num_array.h, but divide the work among the threads
+  // of the policy's pool. Small matrices, and operands that are not stored
+  // in rows (e.g. expressions), are computed on the calling thread.
+
+  template<Matrix_expression E1, Matrix_expression E2,
+           Number R = std::common_type<detail::element_t<E1>,
+                                       detail::element_t<E2>>::type>
+    [[nodiscard]] auto
+    matrix_product(const execution::parallel_policy& policy, const E1& lhs, const E2& rhs)
+      requires (E1::extent(1) == E2::extent(0))
+    {
+      constexpr auto M = E1::extent(0), N = E1::extent(1), P = E2::extent(1);
+      const auto [a, lda] = detail::row_major_storage(lhs);
+      const auto [b, ldb] = detail::row_major_storage(rhs);
+      if (M * N * P < detail::parallel_gemm_threshold || !a || !b) {
+        return matrix_product<E1, E2, R>(lhs, rhs);
+      }
+      num_array<R, M, P> result;
+      detail::parallel_gemm(policy.get_pool(), M, N, P, a, lda, b, ldb, result.data(), P);
+      return result;
+    }
+
+  template<typename U = void, Number T1, Number T2>
+    [[nodiscard]] auto
+    matrix_product(const execution::parallel_policy& policy,
+                   const dynamic_num_array<T1, 2>& lhs,
+                   const dynamic_num_array<T2, 2>& rhs)
+      requires std::is_void_v<U> || Number<U>
+    {
+      using R = detail::product_result_t<U, T1, T2>;
+      const auto m = lhs.extent(0), n = lhs.extent(1), p = rhs.extent(1);
+      if (n != rhs.extent(0))
+        throw std::invalid_argument("Incompatible extents");
+      if (m * n * p < detail::parallel_gemm_threshold) {
+        return matrix_product<R>(lhs, rhs);
+      }
+      dynamic_num_array<R, 2> result(m, p);
+      detail::parallel_gemm(policy.get_pool(), m, n, p, lhs.data(), n,
+                            rhs.data(), p, result.data(), p);
+      return result;
+    }
+
+  template<Matrix_expression E>
+    [[nodiscard]] auto
+    transpose(const execution::parallel_policy& policy, const E& x)
+    {
+      constexpr auto M = E::extent(0), N = E::extent(1);
+      const auto [a, lda] = detail::row_major_storage(x);
+      if (!a) return transpose(x);
+      num_array<detail::element_t<E>, N, M> result;
+      detail::parallel_transpose(policy.get_pool(), M, N, a, lda, result.data(), M);
+      return result;
+    }
+
+  template<Number T>
+    [[nodiscard]] auto
+    transpose(const execution::parallel_policy& policy, const dynamic_num_array<T, 2>& x)
+    {
+      const auto m = x.extent(0), n = x.extent(1);
+      dynamic_num_array<T, 2> result(n, m);
+      detail::parallel_transpose(policy.get_pool(), m, n, x.data(), n, result.data(), m);
+      return result;
+    }
+}
+#endif//TB_MATH_NUM_ARRAY_PARALLEL_H
@@ -0,0 +1,235 @@
+#ifndef TB_MATH_NUM_ARRAY_QUANTIZED_H
+#define TB_MATH_NUM_ARRAY_QUANTIZED_H
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "dynamic_num_array.h"
+#include "simd.h"
+
+// Quantized arrays: arrays of 8-bit integers q that stand for the reals
+// scale * (q - zero_point), with one scale and zero point for the whole
+// array. They take a quarter of the memory of floats, and their dot,
+// matrix-vector and matrix products are computed exactly in int32 by the
+// integer kernels of simd.h and gemm.h; the zero points are then subtracted
+// from the sums, and only the results are scaled to float.
+//
+// NOTE: The sums of products are exact for up to 32768 products (see
+// simd.h). Those of 16-bit integers, which simd.h also multiplies, would
+// overflow after two, so they are not quantized element types.
+namespace tb::math {
+
+  template<typename T>
+    concept Quantized = std::same_as<T, std::int8_t> || std::same_as<T, std::uint8_t>;
+
+  // The affine map of a quantized array: x = scale * (q - zero_point)
+  struct quantization {
+    float scale = 1;
+    std::int32_t zero_point = 0;
+
+    constexpr bool operator==(const quantization&) const = default;
+  };
+
+  // Returns a quantization of Q for reals in [min, max], extended to include
+  // 0 (which is then exact). uint8 covers the range, with a zero point;
+  // int8 is symmetric, with a zero point of 0 and the largest magnitude
+  // mapped to 127 (so -128 is not used).
+  template<Quantized Q>
+    [[nodiscard]] quantization
+    choose_quantization(float min, float max)
+    {
+      using limits = std::numeric_limits<Q>;
+      min = std::min(min, 0.0f), max = std::max(max, 0.0f);
+      if constexpr (limits::is_signed) {
+        const float m = std::max(-min, max);
+        return { m > 0 ? m / limits::max() : 1.0f, 0 };
+      } else {
+        if (max == min) return { 1.0f, 0 };
+        const float scale = (max - min) / (limits::max() - limits::min());
+        const float zero_point = std::nearbyint(limits::min() - min / scale);
+        return { scale, static_cast<std::int32_t>(
+          std::clamp<float>(zero_point, limits::min(), limits::max())) };
+      }
+    }
+
+  // Quantized Array
+  // The integers of an array, and the quantization of their values.
+  template<Quantized Q, std::size_t Rank>
+    struct quantized_array {
+      using value_type = Q;
+
+      dynamic_num_array<Q, Rank> values;
+      quantization params;
+
+      const auto& extents() const noexcept { return values.extents(); }
+      std::size_t n_elements() const noexcept { return values.n_elements(); }
+    };
+}
+
+namespace tb::math::detail {
+
+  // x rounded to the nearest integer of Q in the quantization q
+  template<Quantized Q>
+    Q
+    quantize_value(float x, const quantization& q) noexcept
+    {
+      using limits = std::numeric_limits<Q>;
+      const float y = std::nearbyint(x / q.scale) + static_cast<float>(q.zero_point);
+      return static_cast<Q>(std::clamp<float>(y, limits::min(), limits::max()));
+    }
+
+  // The sum of the n elements of x, for the zero point corrections
+  template<Quantized Q>
+    std::int64_t
+    integer_sum(const Q* x, std::size_t n) noexcept
+    {
+      std::int64_t result = 0;
+      for (std::size_t i = 0; i < n; ++i) result += x[i];
+      return result;
+    }
+
+  // The real value of a sum of n products of quantized numbers, from the
+  // sum of the products of the integers (dot), and the sums of those of the
+  // lhs (sa) and rhs (sb):
+  //   Σ (a - za)(b - zb) = Σ ab - zb Σ a - za Σ b + n za zb
+  inline float
+  dequantize_sum(std::int32_t dot, std::int64_t sa, std::int64_t sb, std::size_t n,
+                 const quantization& a, const quantization& b) noexcept
+  {
+    const std::int64_t za = a.zero_point, zb = b.zero_point;
+    const auto sum = dot - zb * sa - za * sb + static_cast<std::int64_t>(n) * za * zb;
+    return a.scale * b.scale * static_cast<float>(sum);
+  }
+}
+
+namespace tb::math {
+
+  // Quantize
+  // Returns x rounded to the nearest integers of Q in the quantization
+  // params, or else in that chosen for the range of x.
+  template<Quantized Q, std::size_t Rank>
+    [[nodiscard]] quantized_array<Q, Rank>
+    quantize(const dynamic_num_array<float, Rank>& x, const quantization& params)
+    {
+      quantized_array<Q, Rank> result{ dynamic_num_array<Q, Rank>(x.extents()), params };
+      const float* p = x.data();
+      Q* q = result.values.data();
+      for (std::size_t i = 0; i < x.n_elements(); ++i) {
+        q[i] = detail::quantize_value<Q>(p[i], params);
+      }
+      return result;
+    }
+
+  template<Quantized Q, std::size_t Rank>
+    [[nodiscard]] quantized_array<Q, Rank>
+    quantize(const dynamic_num_array<float, Rank>& x)
+    {
+      const auto [min, max] = std::minmax_element(x.data(), x.data() + x.n_elements());
+      if (min == x.data() + x.n_elements()) return quantize<Q>(x, quantization());
+      return quantize<Q>(x, choose_quantization<Q>(*min, *max));
+    }
+
+  // Dequantize
+  // Returns the reals that the elements of x stand for.
+  template<Quantized Q, std::size_t Rank>
+    [[nodiscard]] dynamic_num_array<float, Rank>
+    dequantize(const quantized_array<Q, Rank>& x)
+    {
+      dynamic_num_array<float, Rank> result(x.extents());
+      const Q* q = x.values.data();
+      float* p = result.data();
+      for (std::size_t i = 0; i < x.n_elements(); ++i) {
+        p[i] = x.params.scale * static_cast<float>(q[i] - x.params.zero_point);
+      }
+      return result;
+    }
+
+  // Dot Product
+  // Returns the dot product of the reals of two quantized vectors.
+  // NOTE: The sums of products of the integers are computed in int32, and
+  // wrap around if they do not fit (see simd.h).
+  template<Quantized Q1, Quantized Q2>
+    [[nodiscard]] float
+    dot_product(const quantized_array<Q1, 1>& x, const quantized_array<Q2, 1>& y)
+    {
+      const auto n = x.n_elements();
+      if (n != y.n_elements())
+        throw std::invalid_argument("Incompatible extents");
+      const Q1* a = x.values.data();
+      const Q2* b = y.values.data();
+      return detail::dequantize_sum(simd::integer_dot(a, b, n),
+                                    y.params.zero_point ? detail::integer_sum(a, n) : 0,
+                                    x.params.zero_point ? detail::integer_sum(b, n) : 0,
+                                    n, x.params, y.params);
+    }
+
+  template<Quantized Q1, Quantized Q2>
+    [[nodiscard]] dynamic_num_array<float, 2>
+    matrix_product(const quantized_array<Q1, 2>& lhs, const quantized_array<Q2, 2>& rhs)
+    {
+      const auto m = lhs.extents()[0], n = lhs.extents()[1], p = rhs.extents()[1];
+      if (n != rhs.extents()[0])
+        throw std::invalid_argument("Incompatible extents");
+
+      const auto sums = matrix_product<std::int32_t>(lhs.values, rhs.values);
+      // The sums of the rows of lhs, and of the columns of rhs
+      std::vector<std::int64_t> row_sums(rhs.params.zero_point ? m : 0);
+      std::vector<std::int64_t> col_sums(lhs.params.zero_point ? p : 0);
+      for (std::size_t i = 0; i < row_sums.size(); ++i) {
+        row_sums[i] = detail::integer_sum(lhs.values.data() + i * n, n);
+      }
+      for (std::size_t k = 0; k < n && !col_sums.empty(); ++k) {
+        for (std::size_t j = 0; j < p; ++j) col_sums[j] += rhs.values(k, j);
+      }
+
+      dynamic_num_array<float, 2> result(m, p);
+      for (std::size_t i = 0; i < m; ++i) {
+        for (std::size_t j = 0; j < p; ++j) {
+          result(i, j) = detail::dequantize_sum(sums(i, j),
+                                                row_sums.empty() ? 0 : row_sums[i],
+                                                col_sums.empty() ? 0 : col_sums[j],
+                                                n, lhs.params, rhs.params);
+        }
+      }
+      return result;
+    }
+
+  template<Quantized Q1, Quantized Q2>
+    [[nodiscard]] dynamic_num_array<float, 1>
+    matrix_vector_product(const quantized_array<Q1, 2>& lhs, const quantized_array<Q2, 1>& rhs)
+    {
+      const auto m = lhs.extents()[0], n = lhs.extents()[1];
+      if (rhs.n_elements() != n)
+        throw std::invalid_argument("Incompatible extents");
+
+      const Q2* b = rhs.values.data();
+      const std::int64_t sb = lhs.params.zero_point ? detail::integer_sum(b, n) : 0;
+      dynamic_num_array<float, 1> result(m);
+      for (std::size_t i = 0; i < m; ++i) {
+        const Q1* a = lhs.values.data() + i * n;
+        result[i] = detail::dequantize_sum(simd::integer_dot(a, b, n),
+                                           rhs.params.zero_point ? detail::integer_sum(a, n) : 0,
+                                           sb, n, lhs.params, rhs.params);
+      }
+      return result;
+    }
+
+  template<Quantized Q1, Quantized Q2>
+    [[nodiscard]] auto
+    operator*(const quantized_array<Q1, 2>& lhs, const quantized_array<Q2, 2>& rhs)
+    {
+      return matrix_product(lhs, rhs);
+    }
+
+  template<Quantized Q1, Quantized Q2>
+    [[nodiscard]] auto
+    operator*(const quantized_array<Q1, 2>& lhs, const quantized_array<Q2, 1>& rhs)
+    {
+      return matrix_vector_product(lhs, rhs);
+    }
+}
+#endif//TB_MATH_NUM_ARRAY_QUANTIZED_H
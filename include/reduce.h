@@ -0,0 +1,528 @@
+#ifndef TB_MATH_NUM_ARRAY_REDUCE_H
+#define TB_MATH_NUM_ARRAY_REDUCE_H
+
+#include <cmath>
+#include <stdexcept>
+#include "dynamic_num_array.h"
+#include "simd.h"
+#include "view.h"
+
+namespace tb::math {
+
+  template<Number T> class out_of_core_matrix;
+
+  template<typename T>
+    struct is_out_of_core_matrix : std::false_type { };
+  template<Number T>
+    struct is_out_of_core_matrix<out_of_core_matrix<T>> : std::true_type { };
+
+  // A Reducible is an Array_expression, a dynamic_num_array or an
+  // out_of_core_matrix (see out_of_core.h).
+  template<typename T>
+    concept Reducible = Array_expression<T> || is_dynamic_num_array<T>::value
+                     || is_out_of_core_matrix<T>::value;
+
+  // Summation algorithms for sum() and mean():
+  //  - fast: several partial sums, one per SIMD lane and accumulator.
+  //  - pairwise: sums of halves, recursively, as in NumPy. The error grows
+  //    as O(log n) rather than O(n), for little extra cost.
+  //  - kahan: compensated summation. The error does not grow with n, but
+  //    each element costs four additions instead of one.
+  // The algorithms only differ for floating point elements.
+  enum class summation { fast, pairwise, kahan };
+}
+
+namespace tb::math::detail {
+
+  template<Number T, std::size_t Rank>
+    struct element_of<dynamic_num_array<T, Rank>> { using type = T; };
+
+  // The number of elements of x
+  template<Reducible E>
+    constexpr std::size_t
+    element_count(const E& x) noexcept
+    {
+      if constexpr (Array_expression<E>) return E::n_elements();
+      else return x.n_elements();
+    }
+
+  // Calls f(p, n) for consecutive ranges [p, p + n) of contiguous elements
+  // that together are the elements of x in row-major order. Rows of views
+  // with a non-unit stride, and of expressions, are copied (or evaluated)
+  // into a temporary one at a time.
+  template<Reducible E, typename F>
+    constexpr void
+    for_each_run(const E& x, F&& f)
+    {
+      if constexpr (is_dynamic_num_array<E>::value) {
+        if (!x.empty()) f(x.data(), x.n_elements());
+        return;
+      } else if constexpr (is_out_of_core_matrix<E>::value) { // tile by tile
+        x.for_each_tile([&f](std::size_t, const auto& tile) {
+          if (!tile.empty()) f(tile.data(), tile.n_elements());
+        });
+        return;
+      } else if constexpr (is_num_array<E>::value) {
+        if (!std::is_constant_evaluated()) { // the whole array at once
+          f(x.data(), E::n_elements());
+          return;
+        }
+      } else if constexpr (is_aligned_num_array<E>::value && E::order() == 1) {
+        f(x.data(), E::size());
+        return;
+      } else if constexpr (is_dense<E>) { // an aligned array without padding
+        if (!std::is_constant_evaluated()) {
+          f(reinterpret_cast<const element_t<E>*>(&x.storage()), E::n_elements());
+          return;
+        }
+      }
+      if constexpr (Array_expression<E> && E::order() > 1) {
+        for (std::size_t i = 0; i < E::size(); ++i) for_each_run(x[i], f);
+      } else if constexpr (is_num_array<E>::value) {
+        f(first_element(x), E::size());
+      } else if constexpr (Array_expression<E>) {
+        if constexpr (is_num_array_view<E>::value) {
+          if (x.stride(0) == 1) { f(x.data(), E::size()); return; }
+        }
+        const num_array<element_t<E>, E::size()> row(x);
+        f(first_element(row), E::size());
+      }
+    }
+
+  // Reduction kernels over a contiguous range
+  //
+  // Outside of constant evaluation these use the vectorized kernel in
+  // simd.h when the element type supports the operations involved.
+
+  template<typename T, bool Vectorized>
+    constexpr T
+    transform_reduce(const T* x, std::size_t n, T init, auto f, auto op)
+    {
+      if (std::is_constant_evaluated()) {
+        simd::scalar<T> result = init;
+        for (std::size_t i = 0; i < n; ++i) result = op(result, f(simd::scalar<T>(x[i])));
+        return result.v;
+      }
+      return simd::transform_reduce<T, Vectorized>(x, n, init, f, op);
+    }
+
+  // The type in which sum() and norm_l1() accumulate elements of type T:
+  // a 64-bit integer of the same signedness for integers, whose sums would
+  // soon overflow their own type, or else T.
+  template<typename T>
+    using wide_sum_t = std::conditional_t<std::signed_integral<T>, std::int64_t,
+                       std::conditional_t<std::unsigned_integral<T>, std::uint64_t, T>>;
+
+  inline constexpr auto identity = [](auto x) { return x; };
+  inline constexpr auto square   = [](auto x) { return x * x; };
+  inline constexpr auto plus     = [](auto x, auto y) { return x + y; };
+  inline constexpr auto times    = [](auto x, auto y) { return x * y; };
+  inline constexpr auto lesser   = [](auto x, auto y) { return min(x, y); };
+  inline constexpr auto greater  = [](auto x, auto y) { return max(x, y); };
+  inline constexpr auto absolute_value = [](auto x) { return abs(x); };
+  inline constexpr auto magnitude = [](auto x) { return x < 0 ? -x : x; };
+
+  template<typename T>
+    constexpr T
+    sum_run(const T* x, std::size_t n)
+    {
+      constexpr bool vectorized = simd::Vectorizable<simd::add_assign, T>;
+      return transform_reduce<T, vectorized>(x, n, T(0), identity, plus);
+    }
+
+  // The sum of f(x[i]), with each x[i] converted to the wider type S first
+  template<typename S, typename T>
+    constexpr S
+    widening_sum_run(const T* x, std::size_t n, auto f)
+    {
+      S result = 0;
+      for (std::size_t i = 0; i < n; ++i) result += f(static_cast<S>(x[i]));
+      return result;
+    }
+
+  // Pairwise summation: ranges of at most 128 elements are summed directly.
+  template<typename T>
+    constexpr T
+    pairwise_sum_run(const T* x, std::size_t n)
+    {
+      constexpr std::size_t block = 128;
+      if (n <= block) return sum_run(x, n);
+      const auto h = (n / 2 + block - 1) / block * block; // whole blocks first
+      return pairwise_sum_run(x, h) + pairwise_sum_run(x + h, n - h);
+    }
+
+  // Kahan summation, with one running sum and compensation per lane,
+  // continued from (and returned in) s and c.
+  template<typename T>
+    constexpr void
+    kahan_sum_run(const T* x, std::size_t n, T& s, T& c)
+    {
+      auto step = [](auto& sum, auto& comp, auto y) {
+        y = y - comp;
+        const auto t = sum + y;
+        comp = (t - sum) - y;
+        sum = t;
+      };
+      std::size_t i = 0;
+      if constexpr (simd::Packable<T>) {
+        using P = simd::pack<T>;
+        constexpr auto w = P::width;
+        if (!std::is_constant_evaluated() && n >= w) {
+          P sum = T(0), comp = T(0);
+          for (; i + w <= n; i += w) step(sum, comp, P::load(x + i));
+          T sums[w], comps[w];
+          sum.store(sums);
+          comp.store(comps);
+          for (std::size_t k = 0; k < w; ++k) {
+            step(s, c, sums[k]);
+            step(s, c, T(-comps[k]));
+          }
+        }
+      }
+      for (; i < n; ++i) step(s, c, x[i]);
+    }
+
+  // Reduces x with f and op, from the first element of x.
+  template<bool Vectorized, Reducible E>
+    constexpr auto
+    reduce_nonempty(const E& x, auto f, auto op)
+    {
+      using T = element_t<E>;
+      if (element_count(x) == 0) throw std::invalid_argument("Empty array");
+      bool first = true;
+      simd::scalar<T> result = T(0);
+      for_each_run(x, [&](const T* p, std::size_t n) {
+        if (first) { result = f(simd::scalar<T>(*p)); first = false; }
+        result = transform_reduce<T, Vectorized>(p, n, result.v, f, op);
+      });
+      return result.v;
+    }
+
+  // The row-major index of the first element of x equal to value, or 0.
+  template<Reducible E>
+    constexpr std::size_t
+    find_index(const E& x, element_t<E> value)
+    {
+      using T = element_t<E>;
+      std::size_t offset = 0, result = element_count(x);
+      for_each_run(x, [&](const T* p, std::size_t n) {
+        if (result != element_count(x)) return;
+        if (const auto q = std::find(p, p + n, value); q != p + n) {
+          result = offset + static_cast<std::size_t>(q - p);
+        }
+        offset += n;
+      });
+      return result == element_count(x) ? 0 : result;
+    }
+}
+
+namespace tb::math {
+
+  // Reductions
+  //
+  // These reduce all elements of a num_array, view, expression or
+  // dynamic_num_array to a single value. min, max, argmin and argmax throw
+  // std::invalid_argument if a dynamic_num_array is empty.
+
+  // Sum of the elements, as an int64 (or uint64, if unsigned) for integral
+  // elements
+  template<Reducible E>
+    [[nodiscard]] constexpr auto
+    sum(const E& x, summation method = summation::fast)
+    {
+      using T = detail::element_t<E>;
+      using S = detail::wide_sum_t<T>;
+      if constexpr (!std::same_as<S, T>) {
+        S result = 0;
+        detail::for_each_run(x, [&](const T* p, std::size_t n) {
+          result += detail::widening_sum_run<S>(p, n, detail::identity);
+        });
+        return result;
+      } else {
+        T result = 0;
+        if constexpr (std::floating_point<T>) {
+          if (method == summation::kahan) {
+            T c = 0;
+            detail::for_each_run(x, [&](const T* p, std::size_t n) {
+              detail::kahan_sum_run(p, n, result, c);
+            });
+            return result;
+          }
+          if (method == summation::pairwise) {
+            detail::for_each_run(x, [&](const T* p, std::size_t n) {
+              result += detail::pairwise_sum_run(p, n);
+            });
+            return result;
+          }
+        }
+        detail::for_each_run(x, [&](const T* p, std::size_t n) {
+          result += detail::sum_run(p, n);
+        });
+        return result;
+      }
+    }
+
+  // Product of the elements
+  template<Reducible E>
+    [[nodiscard]] constexpr auto
+    product(const E& x)
+    {
+      using T = detail::element_t<E>;
+      constexpr bool vectorized = simd::Vectorizable<simd::mul_assign, T>;
+      T result = 1;
+      detail::for_each_run(x, [&](const T* p, std::size_t n) {
+        result *= detail::transform_reduce<T, vectorized>(p, n, T(1), detail::identity,
+                                                          detail::times);
+      });
+      return result;
+    }
+
+  // Least element (the first element, if it is NaN)
+  template<Reducible E>
+    [[nodiscard]] constexpr auto
+    min(const E& x)
+    {
+      using T = detail::element_t<E>;
+      constexpr bool vectorized = simd::Vectorizable<simd::minimum, T>;
+      return detail::reduce_nonempty<vectorized>(x, detail::identity, detail::lesser);
+    }
+
+  // Greatest element (the first element, if it is NaN)
+  template<Reducible E>
+    [[nodiscard]] constexpr auto
+    max(const E& x)
+    {
+      using T = detail::element_t<E>;
+      constexpr bool vectorized = simd::Vectorizable<simd::maximum, T>;
+      return detail::reduce_nonempty<vectorized>(x, detail::identity, detail::greater);
+    }
+
+  // Row-major index of the first least element
+  template<Reducible E>
+    [[nodiscard]] constexpr std::size_t
+    argmin(const E& x)
+    {
+      return detail::find_index(x, min(x));
+    }
+
+  // Row-major index of the first greatest element
+  template<Reducible E>
+    [[nodiscard]] constexpr std::size_t
+    argmax(const E& x)
+    {
+      return detail::find_index(x, max(x));
+    }
+
+  // Arithmetic mean of the elements, as a double for integral elements
+  template<Reducible E>
+    [[nodiscard]] constexpr auto
+    mean(const E& x, summation method = summation::fast)
+    {
+      using T = detail::element_t<E>;
+      using R = std::conditional_t<std::floating_point<T>, T, double>;
+      return static_cast<R>(sum(x, method)) / static_cast<R>(detail::element_count(x));
+    }
+
+  // Sum of the absolute values of the elements, as an int64 (or uint64) for
+  // integral elements
+  template<Reducible E>
+    [[nodiscard]] constexpr auto
+    norm_l1(const E& x)
+    {
+      using T = detail::element_t<E>;
+      using S = detail::wide_sum_t<T>;
+      if constexpr (!std::same_as<S, T>) {
+        S result = 0;
+        detail::for_each_run(x, [&](const T* p, std::size_t n) {
+          if constexpr (std::is_signed_v<T>) {
+            result += detail::widening_sum_run<S>(p, n, detail::magnitude);
+          } else {
+            result += detail::widening_sum_run<S>(p, n, detail::identity);
+          }
+        });
+        return result;
+      } else {
+        constexpr bool vectorized = simd::Vectorizable<simd::add_assign, T>
+                                 && simd::Vectorizable<simd::sub_assign, T>
+                                 && simd::Vectorizable<simd::maximum, T>;
+        T result = 0;
+        detail::for_each_run(x, [&](const T* p, std::size_t n) {
+          result += detail::transform_reduce<T, vectorized>(p, n, T(0), detail::absolute_value,
+                                                            detail::plus);
+        });
+        return result;
+      }
+    }
+
+  // Euclidean norm, the square root of the sum of the squares of the
+  // elements, as a double for integral elements (whose squares are summed
+  // as doubles).
+  // NOTE: The sum of squares may overflow (or underflow) although the norm
+  // itself would not.
+  template<Reducible E>
+    [[nodiscard]] constexpr auto
+    norm_l2(const E& x)
+    {
+      using T = detail::element_t<E>;
+      using R = std::conditional_t<std::floating_point<T>, T, double>;
+      if constexpr (!std::same_as<R, T>) {
+        R result = 0;
+        detail::for_each_run(x, [&](const T* p, std::size_t n) {
+          result += detail::widening_sum_run<R>(p, n, detail::square);
+        });
+        return std::sqrt(result);
+      } else {
+        constexpr bool vectorized = simd::Vectorizable<simd::add_assign, T>
+                                 && simd::Vectorizable<simd::mul_assign, T>;
+        T result = 0;
+        detail::for_each_run(x, [&](const T* p, std::size_t n) {
+          result += detail::transform_reduce<T, vectorized>(p, n, T(0), detail::square,
+                                                            detail::plus);
+        });
+        return std::sqrt(result);
+      }
+    }
+
+  // Greatest absolute value of the elements
+  template<Reducible E>
+    [[nodiscard]] constexpr auto
+    norm_inf(const E& x)
+    {
+      using T = detail::element_t<E>;
+      constexpr bool vectorized = simd::Vectorizable<simd::sub_assign, T>
+                               && simd::Vectorizable<simd::maximum, T>;
+      T result = 0;
+      detail::for_each_run(x, [&](const T* p, std::size_t n) {
+        result = std::max(result, detail::transform_reduce<T, vectorized>(
+                                    p, n, T(0), detail::absolute_value, detail::greater));
+      });
+      return result;
+    }
+}
+
+namespace tb::math::detail {
+
+  // y = op(y, x) element-wise, for num_arrays y and x of the same shape.
+  template<Number T, std::size_t M, std::size_t... N, typename E>
+    constexpr void
+    combine(num_array<T, M, N...>& y, const E& x, auto op)
+    {
+      if constexpr (is_num_array<E>::value) {
+        if (!std::is_constant_evaluated()) {
+          simd::transform(y.data(), x.data(), op, E::n_elements());
+          return;
+        }
+      }
+      for (std::size_t i = 0; i < M; ++i) {
+        if constexpr (sizeof...(N) == 0) op(y[i], x[i]);
+        else combine(y[i], x[i], op);
+      }
+    }
+
+  // The num_array of M results of type R (a scalar or num_array).
+  template<typename T, std::size_t M, typename R>
+    struct stack_of { using type = num_array<T, M>; };
+  template<typename T, std::size_t M, Number U, std::size_t... N>
+    struct stack_of<T, M, num_array<U, N...>> { using type = num_array<T, M, N...>; };
+
+  // Reduces x along its Axis-th dimension with the compound operation op
+  // (one of the tags in simd.h), e.g. x(0, j) op= x(i, j) for i > 0, for
+  // Axis = 0 and a matrix x.
+  template<std::size_t Axis, Array_expression E>
+    constexpr auto
+    reduce_axis(const E& x, auto op)
+    {
+      using T = element_t<E>;
+      if constexpr (E::order() == 1) {
+        T result = x[0];
+        for (std::size_t i = 1; i < E::size(); ++i) op(result, x[i]);
+        return result;
+      } else if constexpr (Axis == 0) {
+        using R = decltype(eval(x[0]));
+        R result = x[0];
+        for (std::size_t i = 1; i < E::size(); ++i) {
+          if constexpr (is_num_array<E>::value) combine(result, x[i], op);
+          else combine(result, R(x[i]), op);
+        }
+        return result;
+      } else {
+        using R = decltype(reduce_axis<Axis - 1>(x[0], op));
+        typename stack_of<T, E::size(), R>::type result;
+        for (std::size_t i = 0; i < E::size(); ++i) {
+          result[i] = reduce_axis<Axis - 1>(x[i], op);
+        }
+        return result;
+      }
+    }
+}
+
+namespace tb::math {
+
+  // Reductions along one dimension
+  //
+  // These reduce an Array_expression along its Axis-th dimension to a
+  // num_array of one lower order (or a scalar for order 1), e.g. sum<0>(A)
+  // is the row vector of the column sums of a matrix A and sum<1>(A) the
+  // column vector of its row sums.
+
+  // Sums and products along the Axis-th dimension, as int64s (or uint64s,
+  // if unsigned) for integral elements, like sum()
+  template<std::size_t Axis, Array_expression E>
+    [[nodiscard]] constexpr auto
+    sum(const E& x) requires (Axis < E::order())
+    {
+      using S = detail::wide_sum_t<detail::element_t<E>>;
+      if constexpr (!std::same_as<S, detail::element_t<E>>) {
+        using A = detail::array_of_shape<S, detail::shape_t<E>>::type;
+        return detail::reduce_axis<Axis>(A(x), simd::add_assign{});
+      } else {
+        return detail::reduce_axis<Axis>(x, simd::add_assign{});
+      }
+    }
+
+  template<std::size_t Axis, Array_expression E>
+    [[nodiscard]] constexpr auto
+    product(const E& x) requires (Axis < E::order())
+    {
+      using S = detail::wide_sum_t<detail::element_t<E>>;
+      if constexpr (!std::same_as<S, detail::element_t<E>>) {
+        using A = detail::array_of_shape<S, detail::shape_t<E>>::type;
+        return detail::reduce_axis<Axis>(A(x), simd::mul_assign{});
+      } else {
+        return detail::reduce_axis<Axis>(x, simd::mul_assign{});
+      }
+    }
+
+  template<std::size_t Axis, Array_expression E>
+    [[nodiscard]] constexpr auto
+    min(const E& x) requires (Axis < E::order())
+    {
+      return detail::reduce_axis<Axis>(x, simd::minimum{});
+    }
+
+  template<std::size_t Axis, Array_expression E>
+    [[nodiscard]] constexpr auto
+    max(const E& x) requires (Axis < E::order())
+    {
+      return detail::reduce_axis<Axis>(x, simd::maximum{});
+    }
+
+  // Means along the Axis-th dimension, as doubles for integral elements
+  template<std::size_t Axis, Array_expression E>
+    [[nodiscard]] constexpr auto
+    mean(const E& x) requires (Axis < E::order())
+    {
+      using T = detail::element_t<E>;
+      using R = std::conditional_t<std::floating_point<T>, T, double>;
+      constexpr auto n = static_cast<R>(E::extent(Axis));
+      if constexpr (!std::same_as<T, R>) { // summed as doubles, which do not overflow
+        using A = detail::array_of_shape<R, detail::shape_t<E>>::type;
+        return mean<Axis>(A(x));
+      } else if constexpr (E::order() == 1) {
+        return sum<Axis>(x) / n;
+      } else {
+        return eval(sum<Axis>(x) / n);
+      }
+    }
+}
+#endif//TB_MATH_NUM_ARRAY_REDUCE_H
@@ -0,0 +1,388 @@
+#ifndef TB_MATH_NUM_ARRAY_SERIALIZATION_H
+#define TB_MATH_NUM_ARRAY_SERIALIZATION_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include "dynamic_num_array.h"
+#include "view.h"
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TB_MATH_HAS_MMAP 1
+#endif
+
+// Binary serialization
+//
+// A file holds count arrays of the same element type and extents, as a
+// header followed by their elements in row-major order, one array after the
+// other, exactly as they are laid out in memory:
+//
+//   array_header     32 bytes, in the byte order of the elements
+//   extents          rank unsigned 64-bit integers
+//   padding          up to header.data_offset, a multiple of alignment
+//   elements         count * (extent(0) * ... * extent(rank - 1)) elements
+//
+// The elements are written in the byte order of the machine, so writing and
+// reading on the same kind of machine is a single copy. read_binary() swaps
+// the bytes of files written on a machine of the other byte order. The
+// elements start at a multiple of header.alignment bytes from the start of
+// the file, so that a memory-mapped file (see mapped_array_file) can be
+// viewed in place, without copying or parsing anything.
+namespace tb::math {
+
+  // Element types, by kind and size
+  enum class element_code : std::uint8_t {
+    int8 = 1, uint8, int16, uint16, int32, uint32, int64, uint64, float32, float64
+  };
+
+  struct array_header {
+    char magic[4];              // "TBNA"
+    std::uint8_t version;       // 1
+    std::uint8_t endianness;    // 1 if little endian, 2 if big endian
+    element_code element_type;
+    std::uint8_t element_size;  // in bytes
+    std::uint32_t rank;
+    std::uint32_t alignment;    // of the elements in the file, in bytes
+    std::uint64_t count;        // number of arrays
+    std::uint64_t data_offset;  // of the first element from the start of the file
+  };
+  static_assert(sizeof(array_header) == 32);
+}
+
+namespace tb::math::detail {
+
+  inline constexpr char array_magic[4] = { 'T', 'B', 'N', 'A' };
+  inline constexpr std::uint32_t array_alignment = 64;
+
+  inline constexpr std::uint8_t native_endianness =
+    std::endian::native == std::endian::little ? 1 : 2;
+
+  // The element_code of an arithmetic type
+  template<typename T>
+    consteval element_code
+    element_code_of()
+    {
+      static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>,
+                    "Only arrays of arithmetic types can be serialized");
+      constexpr int size_index = std::countr_zero(sizeof(T)); // 0 for 1 byte, ...
+      if constexpr (std::is_floating_point_v<T>) {
+        static_assert(sizeof(T) == 4 || sizeof(T) == 8);
+        return sizeof(T) == 4 ? element_code::float32 : element_code::float64;
+      } else {
+        return static_cast<element_code>(1 + 2 * size_index + (std::is_unsigned_v<T> ? 1 : 0));
+      }
+    }
+
+  // Reverses the bytes of each of the n objects of the given size at p.
+  inline void
+  swap_bytes(void* p, std::size_t n, std::size_t size) noexcept
+  {
+    auto bytes = static_cast<unsigned char*>(p);
+    for (std::size_t i = 0; i < n; ++i, bytes += size) std::reverse(bytes, bytes + size);
+  }
+
+  inline void
+  swap_bytes(array_header& h) noexcept
+  {
+    swap_bytes(&h.rank, 1, sizeof(h.rank));
+    swap_bytes(&h.alignment, 1, sizeof(h.alignment));
+    swap_bytes(&h.count, 1, sizeof(h.count));
+    swap_bytes(&h.data_offset, 1, sizeof(h.data_offset));
+  }
+
+  inline std::uint64_t
+  data_offset(std::size_t rank) noexcept
+  {
+    const auto n = sizeof(array_header) + rank * sizeof(std::uint64_t);
+    return (n + array_alignment - 1) / array_alignment * array_alignment;
+  }
+
+  template<typename T>
+    void
+    write_header(std::ostream& os, std::span<const std::uint64_t> extents, std::uint64_t count)
+    {
+      array_header h = {
+        { array_magic[0], array_magic[1], array_magic[2], array_magic[3] },
+        1, native_endianness, element_code_of<T>(), sizeof(T),
+        static_cast<std::uint32_t>(extents.size()), array_alignment,
+        count, data_offset(extents.size())
+      };
+      os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+      os.write(reinterpret_cast<const char*>(extents.data()), extents.size_bytes());
+      const char padding[array_alignment] = { };
+      os.write(padding, static_cast<std::streamsize>(
+        h.data_offset - sizeof(h) - extents.size_bytes()));
+    }
+
+  // True if count arrays of the given extents, of elements of the given
+  // size, fit in limit bytes. The product is checked for overflow, as the
+  // extents of a file are not to be trusted.
+  inline bool
+  arrays_fit(std::span<const std::uint64_t> extents, std::uint64_t element_size,
+             std::uint64_t count, std::uint64_t limit) noexcept
+  {
+    if (std::ranges::find(extents, 0) != extents.end()) return true;
+    std::uint64_t n = std::max<std::uint64_t>(element_size, 1);
+    for (const auto e : extents) {
+      if (n > limit / e) return false;
+      n *= e;
+    }
+    return count <= limit / n;
+  }
+
+  // Checks a header, in native byte order, against the element type T.
+  template<typename T>
+    void
+    check_header(const array_header& h)
+    {
+      if (!std::equal(h.magic, h.magic + 4, array_magic) || h.version != 1
+          || h.data_offset < sizeof(h) + std::uint64_t(h.rank) * sizeof(std::uint64_t))
+        throw std::runtime_error("Not a num_array file");
+      if (h.element_type != element_code_of<T>() || h.element_size != sizeof(T))
+        throw std::invalid_argument("Incompatible element type");
+    }
+
+  // Reads a header and the extents that follow it, in native byte order,
+  // and skips to the elements. Returns true if the elements need their bytes
+  // swapped.
+  template<typename T>
+    bool
+    read_header(std::istream& is, array_header& h, std::vector<std::uint64_t>& extents)
+    {
+      if (!is.read(reinterpret_cast<char*>(&h), sizeof(h)))
+        throw std::runtime_error("Cannot read num_array header");
+      const bool swapped = h.endianness != native_endianness;
+      if (swapped) swap_bytes(h);
+      check_header<T>(h);
+      // One at a time, so that a corrupt rank does not allocate more than
+      // the stream holds
+      extents.clear();
+      std::uint64_t e;
+      while (extents.size() < h.rank && is.read(reinterpret_cast<char*>(&e), sizeof(e)))
+        extents.push_back(e);
+      if (swapped) swap_bytes(extents.data(), extents.size(), sizeof(std::uint64_t));
+      is.ignore(static_cast<std::streamsize>(
+        h.data_offset - sizeof(h) - h.rank * sizeof(std::uint64_t)));
+      if (!is) throw std::runtime_error("Cannot read num_array header");
+      return swapped;
+    }
+
+  template<typename T>
+    void
+    read_elements(std::istream& is, T* data, std::size_t n, bool swapped)
+    {
+      if (!is.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(n * sizeof(T))))
+        throw std::runtime_error("Cannot read num_array elements");
+      if (swapped) swap_bytes(data, n, sizeof(T));
+    }
+
+  template<std::size_t... N>
+    bool
+    same_extents(const std::vector<std::uint64_t>& extents)
+    {
+      const std::uint64_t expected[] = { N... };
+      return std::ranges::equal(extents, expected);
+    }
+
+  // A contiguous range of num_arrays, which are stored one after the other
+  template<typename R>
+    concept Contiguous_arrays = std::ranges::contiguous_range<R> && std::ranges::sized_range<R>
+      && is_num_array<std::remove_cvref_t<std::ranges::range_reference_t<R>>>::value;
+}
+
+namespace tb::math {
+
+  // Write Binary
+  // Writes the num_arrays of a contiguous range (e.g. a std::vector), or a
+  // single num_array or dynamic_num_array, to os in binary. The elements are
+  // written with a single call to os.write(). Failures are reported by the
+  // state of os.
+  template<detail::Contiguous_arrays R>
+    void
+    write_binary(std::ostream& os, const R& arrays)
+    {
+      using A = std::remove_cvref_t<std::ranges::range_reference_t<R>>;
+      using T = detail::element_t<A>;
+      static_assert(sizeof(A) == A::n_elements() * sizeof(T));
+      const auto extents = []<std::size_t... N>(std::index_sequence<N...>) {
+        return std::array<std::uint64_t, sizeof...(N)>{ N... };
+      }(detail::shape_t<A>());
+      const auto count = std::ranges::size(arrays);
+      detail::write_header<T>(os, extents, count);
+      os.write(reinterpret_cast<const char*>(std::ranges::data(arrays)),
+               static_cast<std::streamsize>(count * sizeof(A)));
+    }
+
+  template<Number T, std::size_t M, std::size_t... N>
+    void
+    write_binary(std::ostream& os, const num_array<T, M, N...>& x)
+    {
+      write_binary(os, std::span(&x, 1));
+    }
+
+  template<Number T, std::size_t Rank>
+    void
+    write_binary(std::ostream& os, const dynamic_num_array<T, Rank>& x)
+    {
+      std::array<std::uint64_t, Rank> extents;
+      std::ranges::copy(x.extents(), extents.begin());
+      detail::write_header<T>(os, extents, 1);
+      os.write(reinterpret_cast<const char*>(x.data()),
+               static_cast<std::streamsize>(x.n_elements() * sizeof(T)));
+    }
+
+  // Read Binary
+  // Reads x from is, written by write_binary(). std::invalid_argument is
+  // thrown if the element type or extents differ from those of x (or the
+  // number of arrays from the size of the range), and std::runtime_error if
+  // is does not hold a num_array file, ends too soon or holds extents too
+  // large to allocate.
+  template<detail::Contiguous_arrays R>
+    void
+    read_binary(std::istream& is, R&& arrays)
+    {
+      using A = std::remove_cvref_t<std::ranges::range_reference_t<R>>;
+      using T = detail::element_t<A>;
+      array_header h;
+      std::vector<std::uint64_t> extents;
+      const bool swapped = detail::read_header<T>(is, h, extents);
+      const auto count = std::ranges::size(arrays);
+      const bool conforming = []<std::size_t... N>(const auto& e, std::index_sequence<N...>) {
+        return detail::same_extents<N...>(e);
+      }(extents, detail::shape_t<A>());
+      if (!conforming || h.count != count) throw std::invalid_argument("Incompatible extents");
+      detail::read_elements(is, reinterpret_cast<T*>(std::ranges::data(arrays)),
+                            count * A::n_elements(), swapped);
+    }
+
+  template<Number T, std::size_t M, std::size_t... N>
+    void
+    read_binary(std::istream& is, num_array<T, M, N...>& x)
+    {
+      read_binary(is, std::span(&x, 1));
+    }
+
+  // Reads the first array of is into x, with the extents in the file.
+  template<Number T, std::size_t Rank>
+    void
+    read_binary(std::istream& is, dynamic_num_array<T, Rank>& x)
+    {
+      array_header h;
+      std::vector<std::uint64_t> extents;
+      const bool swapped = detail::read_header<T>(is, h, extents);
+      if (h.rank != Rank || h.count == 0) throw std::invalid_argument("Incompatible extents");
+      if (!detail::arrays_fit(extents, sizeof(T), 1, std::numeric_limits<std::streamsize>::max()))
+        throw std::runtime_error("Corrupt num_array extents");
+      typename dynamic_num_array<T, Rank>::extents_type e;
+      std::ranges::copy(extents, e.begin());
+      dynamic_num_array<T, Rank> result(e, x.resource());
+      detail::read_elements(is, result.data(), result.n_elements(), swapped);
+      x = std::move(result);
+    }
+
+#ifdef TB_MATH_HAS_MMAP
+  // A num_array file mapped into memory, read-only. The arrays it holds are
+  // accessed as views of the mapped pages, without copying: loading a file
+  // costs little more than the page faults of the elements that are read.
+  //
+  // std::runtime_error is thrown if the file cannot be mapped or does not
+  // hold num_arrays (including the arrays its header claims), or was
+  // written on a machine of the other byte order, and by data() and view()
+  // if the elements are not aligned for their type.
+  //
+  // NOTE: The views must not outlive the mapped_array_file.
+  class mapped_array_file {
+  public:
+    explicit mapped_array_file(const char* path);
+    ~mapped_array_file() { if (data_) ::munmap(data_, size_); }
+
+    mapped_array_file(mapped_array_file&& x) noexcept
+      : data_(std::exchange(x.data_, nullptr)), size_(x.size_) { }
+    mapped_array_file& operator=(mapped_array_file&&) = delete;
+
+    const array_header& header() const noexcept
+    { return *static_cast<const array_header*>(data_); }
+
+    std::size_t count() const noexcept { return header().count; }
+    std::size_t rank() const noexcept { return header().rank; }
+
+    std::span<const std::uint64_t> extents() const noexcept
+    {
+      return { reinterpret_cast<const std::uint64_t*>(&header() + 1), rank() };
+    }
+
+    // The number of elements of each array
+    std::size_t n_elements() const noexcept
+    {
+      std::size_t n = 1;
+      for (auto e : extents()) n *= e;
+      return n;
+    }
+
+    // The elements of the i-th array
+    template<Number T>
+      const T* data(std::size_t i = 0) const
+      {
+        detail::check_header<T>(header());
+        if (header().data_offset % alignof(T) != 0)
+          throw std::runtime_error("Misaligned num_array elements");
+        if (i >= count()) throw std::out_of_range("No such array");
+        return reinterpret_cast<const T*>(static_cast<const char*>(data_)
+                                          + header().data_offset) + i * n_elements();
+      }
+
+    // A view of the i-th array, whose extents must be M, N...
+    template<Number T, std::size_t M, std::size_t... N>
+      num_array_view<const T, M, N...> view(std::size_t i = 0) const
+      {
+        const std::vector<std::uint64_t> e(extents().begin(), extents().end());
+        if (!detail::same_extents<M, N...>(e)) throw std::invalid_argument("Incompatible extents");
+        return { data<T>(i), detail::row_major_strides<std::ptrdiff_t, M, N...>() };
+      }
+
+  private:
+    void* data_ = nullptr;
+    std::size_t size_ = 0;
+  };
+
+  inline
+  mapped_array_file::mapped_array_file(const char* path)
+  {
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) throw std::runtime_error("Cannot open num_array file");
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(array_header))) {
+      size_ = static_cast<std::size_t>(st.st_size);
+      data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data_ == MAP_FAILED) data_ = nullptr;
+    }
+    ::close(fd);
+    if (!data_) throw std::runtime_error("Cannot map num_array file");
+
+    const auto& h = header();
+    const bool valid = std::equal(h.magic, h.magic + 4, detail::array_magic) && h.version == 1
+      && h.endianness == detail::native_endianness && h.element_size > 0
+      && h.data_offset >= sizeof(h) + std::uint64_t(h.rank) * sizeof(std::uint64_t)
+      && h.data_offset <= size_
+      && detail::arrays_fit(extents(), h.element_size, h.count, size_ - h.data_offset);
+    if (!valid) {
+      ::munmap(data_, size_);
+      data_ = nullptr;
+      throw std::runtime_error("Not a num_array file of this machine's byte order");
+    }
+  }
+#endif
+}
+#endif//TB_MATH_NUM_ARRAY_SERIALIZATION_H
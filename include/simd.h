@@ -0,0 +1,1196 @@
+#ifndef TB_MATH_NUM_ARRAY_SIMD_H
+#define TB_MATH_NUM_ARRAY_SIMD_H
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+// Element-wise kernels over contiguous storage.
+//
+// The widest instruction set enabled at compile time is used (AVX-512F, AVX
+// or AVX2, SSE2/SSE4.1, in that order); compile with e.g. -march=native to
+// enable the wider sets. Element types or operations without a vector
+// implementation (e.g. integer division) fall back to a scalar loop.
+// Fused multiply-adds are used with AVX-512F, or with AVX and FMA (-mfma).
+namespace tb::math::simd {
+
+  // Compound assignment operations, x op= y
+  struct add_assign 
+  { constexpr void operator()(auto& x, const auto& y) const { x += y; } };
+  struct sub_assign 
+  { constexpr void operator()(auto& x, const auto& y) const { x -= y; } };
+  struct mul_assign 
+  { constexpr void operator()(auto& x, const auto& y) const { x *= y; } };
+  struct div_assign 
+  { constexpr void operator()(auto& x, const auto& y) const { x /= y; } };
+
+  // x = min(x, y) and x = max(x, y). x is kept if either is NaN.
+  struct minimum
+  { constexpr void operator()(auto& x, const auto& y) const { if (y < x) x = y; } };
+  struct maximum
+  { constexpr void operator()(auto& x, const auto& y) const { if (x < y) x = y; } };
+
+  // native<T> describes the vector register used for elements of type T.
+  // The primary template has no register (width 1).
+  //
+  // For the elementary functions (see elementwise.h), the floating point
+  // registers also have comparisons, giving a mask, select(m, x, y) (x where
+  // m is set, y elsewhere), an estimate of 1 / sqrt(x) (on some targets),
+  // pow2(n) = 2^n for integral n in the range of normal exponents, and
+  // split(x, e), which returns m with x = m * 2^e and m in [sqrt(1/2),
+  // sqrt(2)) for positive normal x.
+  template<typename T>
+    struct native { static constexpr std::size_t width = 1; };
+
+  template<typename T>
+    concept Int32 = std::integral<T> && sizeof(T) == 4;
+
+#if defined(__AVX512F__)
+
+  template<>
+    struct native<float> {
+      using type = __m512;
+      static constexpr std::size_t width = 16;
+      static type load(const float* p) { return _mm512_loadu_ps(p); }
+      static void store(float* p, type x) { _mm512_storeu_ps(p, x); }
+      static type broadcast(float x) { return _mm512_set1_ps(x); }
+      static type apply(add_assign, type x, type y) { return _mm512_add_ps(x, y); }
+      static type apply(sub_assign, type x, type y) { return _mm512_sub_ps(x, y); }
+      static type apply(mul_assign, type x, type y) { return _mm512_mul_ps(x, y); }
+      static type apply(div_assign, type x, type y) { return _mm512_div_ps(x, y); }
+      static type fma(type x, type y, type z) { return _mm512_fmadd_ps(x, y, z); }
+      // The masked forms avoid a spurious -Wmaybe-uninitialized in GCC 12.
+      static type sqrt(type x) { return _mm512_mask_sqrt_ps(x, __mmask16(-1), x); }
+      static type apply(minimum, type x, type y)
+      { return _mm512_mask_min_ps(x, __mmask16(-1), y, x); }
+      static type apply(maximum, type x, type y)
+      { return _mm512_mask_max_ps(x, __mmask16(-1), y, x); }
+      using mask = __mmask16;
+      static mask less(type x, type y) { return _mm512_cmp_ps_mask(x, y, _CMP_LT_OQ); }
+      static mask equal(type x, type y) { return _mm512_cmp_ps_mask(x, y, _CMP_EQ_OQ); }
+      static type select(mask m, type x, type y) { return _mm512_mask_blend_ps(m, y, x); }
+      static type rsqrt(type x) { return _mm512_mask_rsqrt14_ps(x, __mmask16(-1), x); }
+      static type pow2(type n)
+      {
+        const __m512i t = _mm512_castps_si512(_mm512_add_ps(n, _mm512_set1_ps(0x1.8p23f)));
+        return _mm512_castsi512_ps(_mm512_add_epi32(_mm512_mask_slli_epi32(t, __mmask16(-1), t, 23),
+                                                    _mm512_set1_epi32(127 << 23)));
+      }
+      static type split(type x, type& e)
+      {
+        const __m512i i = _mm512_add_epi32(_mm512_castps_si512(x),
+                                           _mm512_set1_epi32(0x3f800000 - 0x3f3504f3));
+        const __m512i n = _mm512_sub_epi32(_mm512_mask_srli_epi32(i, __mmask16(-1), i, 23),
+                                           _mm512_set1_epi32(127));
+        e = _mm512_mask_cvtepi32_ps(x, __mmask16(-1), n);
+        return _mm512_castsi512_ps(_mm512_add_epi32(_mm512_and_si512(i, _mm512_set1_epi32(0x007fffff)),
+                                                    _mm512_set1_epi32(0x3f3504f3)));
+      }
+    };
+
+  template<>
+    struct native<double> {
+      using type = __m512d;
+      static constexpr std::size_t width = 8;
+      static type load(const double* p) { return _mm512_loadu_pd(p); }
+      static void store(double* p, type x) { _mm512_storeu_pd(p, x); }
+      static type broadcast(double x) { return _mm512_set1_pd(x); }
+      static type apply(add_assign, type x, type y) { return _mm512_add_pd(x, y); }
+      static type apply(sub_assign, type x, type y) { return _mm512_sub_pd(x, y); }
+      static type apply(mul_assign, type x, type y) { return _mm512_mul_pd(x, y); }
+      static type apply(div_assign, type x, type y) { return _mm512_div_pd(x, y); }
+      static type fma(type x, type y, type z) { return _mm512_fmadd_pd(x, y, z); }
+      static type sqrt(type x) { return _mm512_mask_sqrt_pd(x, __mmask8(-1), x); }
+      static type apply(minimum, type x, type y)
+      { return _mm512_mask_min_pd(x, __mmask8(-1), y, x); }
+      static type apply(maximum, type x, type y)
+      { return _mm512_mask_max_pd(x, __mmask8(-1), y, x); }
+      using mask = __mmask8;
+      static mask less(type x, type y) { return _mm512_cmp_pd_mask(x, y, _CMP_LT_OQ); }
+      static mask equal(type x, type y) { return _mm512_cmp_pd_mask(x, y, _CMP_EQ_OQ); }
+      static type select(mask m, type x, type y) { return _mm512_mask_blend_pd(m, y, x); }
+      static type rsqrt(type x) { return _mm512_mask_rsqrt14_pd(x, __mmask8(-1), x); }
+      static type pow2(type n)
+      {
+        const __m512i t = _mm512_castpd_si512(_mm512_add_pd(n, _mm512_set1_pd(0x1.8p52)));
+        return _mm512_castsi512_pd(_mm512_add_epi64(_mm512_mask_slli_epi64(t, __mmask8(-1), t, 52),
+                                                    _mm512_set1_epi64(1023ll << 52)));
+      }
+      static type split(type x, type& e)
+      {
+        const __m512i i = _mm512_add_epi64(_mm512_castpd_si512(x),
+                                           _mm512_set1_epi64(0x3ff0000000000000 - 0x3fe6a09e667f3bcd));
+        const __m512d magic = _mm512_set1_pd(0x1.8p52);
+        e = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(_mm512_mask_srli_epi64(i, __mmask8(-1), i, 52),
+                                                              _mm512_castpd_si512(magic))),
+                          _mm512_set1_pd(0x1.8p52 + 1023));
+        return _mm512_castsi512_pd(_mm512_add_epi64(_mm512_and_si512(i, _mm512_set1_epi64(0x000fffffffffffff)),
+                                                    _mm512_set1_epi64(0x3fe6a09e667f3bcd)));
+      }
+    };
+
+  template<Int32 T>
+    struct native<T> {
+      using type = __m512i;
+      static constexpr std::size_t width = 16;
+      static type load(const T* p) { return _mm512_loadu_si512(p); }
+      static void store(T* p, type x) { _mm512_storeu_si512(p, x); }
+      static type broadcast(T x) { return _mm512_set1_epi32(x); }
+      static type apply(add_assign, type x, type y) { return _mm512_add_epi32(x, y); }
+      static type apply(sub_assign, type x, type y) { return _mm512_sub_epi32(x, y); }
+      static type apply(mul_assign, type x, type y) { return _mm512_mullo_epi32(x, y); }
+      static type apply(minimum, type x, type y)
+      {
+        if constexpr (std::is_signed_v<T>) return _mm512_mask_min_epi32(x, __mmask16(-1), x, y);
+        else return _mm512_mask_min_epu32(x, __mmask16(-1), x, y);
+      }
+      static type apply(maximum, type x, type y)
+      {
+        if constexpr (std::is_signed_v<T>) return _mm512_mask_max_epi32(x, __mmask16(-1), x, y);
+        else return _mm512_mask_max_epu32(x, __mmask16(-1), x, y);
+      }
+    };
+
+#elif defined(__AVX__)
+
+  template<>
+    struct native<float> {
+      using type = __m256;
+      static constexpr std::size_t width = 8;
+      static type load(const float* p) { return _mm256_loadu_ps(p); }
+      static void store(float* p, type x) { _mm256_storeu_ps(p, x); }
+      static type broadcast(float x) { return _mm256_set1_ps(x); }
+      static type apply(add_assign, type x, type y) { return _mm256_add_ps(x, y); }
+      static type apply(sub_assign, type x, type y) { return _mm256_sub_ps(x, y); }
+      static type apply(mul_assign, type x, type y) { return _mm256_mul_ps(x, y); }
+      static type apply(div_assign, type x, type y) { return _mm256_div_ps(x, y); }
+#if defined(__FMA__)
+      static type fma(type x, type y, type z) { return _mm256_fmadd_ps(x, y, z); }
+#endif
+      static type sqrt(type x) { return _mm256_sqrt_ps(x); }
+      static type apply(minimum, type x, type y) { return _mm256_min_ps(y, x); }
+      static type apply(maximum, type x, type y) { return _mm256_max_ps(y, x); }
+      using mask = __m256;
+      static mask less(type x, type y) { return _mm256_cmp_ps(x, y, _CMP_LT_OQ); }
+      static mask equal(type x, type y) { return _mm256_cmp_ps(x, y, _CMP_EQ_OQ); }
+      static type select(mask m, type x, type y) { return _mm256_blendv_ps(y, x, m); }
+      static type rsqrt(type x) { return _mm256_rsqrt_ps(x); }
+#if defined(__AVX2__)
+      static type pow2(type n)
+      {
+        const __m256i t = _mm256_castps_si256(_mm256_add_ps(n, _mm256_set1_ps(0x1.8p23f)));
+        return _mm256_castsi256_ps(_mm256_add_epi32(_mm256_slli_epi32(t, 23),
+                                                    _mm256_set1_epi32(127 << 23)));
+      }
+      static type split(type x, type& e)
+      {
+        const __m256i i = _mm256_add_epi32(_mm256_castps_si256(x),
+                                           _mm256_set1_epi32(0x3f800000 - 0x3f3504f3));
+        e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(i, 23), _mm256_set1_epi32(127)));
+        return _mm256_castsi256_ps(_mm256_add_epi32(_mm256_and_si256(i, _mm256_set1_epi32(0x007fffff)),
+                                                    _mm256_set1_epi32(0x3f3504f3)));
+      }
+#endif
+    };
+
+  template<>
+    struct native<double> {
+      using type = __m256d;
+      static constexpr std::size_t width = 4;
+      static type load(const double* p) { return _mm256_loadu_pd(p); }
+      static void store(double* p, type x) { _mm256_storeu_pd(p, x); }
+      static type broadcast(double x) { return _mm256_set1_pd(x); }
+      static type apply(add_assign, type x, type y) { return _mm256_add_pd(x, y); }
+      static type apply(sub_assign, type x, type y) { return _mm256_sub_pd(x, y); }
+      static type apply(mul_assign, type x, type y) { return _mm256_mul_pd(x, y); }
+      static type apply(div_assign, type x, type y) { return _mm256_div_pd(x, y); }
+#if defined(__FMA__)
+      static type fma(type x, type y, type z) { return _mm256_fmadd_pd(x, y, z); }
+#endif
+      static type sqrt(type x) { return _mm256_sqrt_pd(x); }
+      static type apply(minimum, type x, type y) { return _mm256_min_pd(y, x); }
+      static type apply(maximum, type x, type y) { return _mm256_max_pd(y, x); }
+      using mask = __m256d;
+      static mask less(type x, type y) { return _mm256_cmp_pd(x, y, _CMP_LT_OQ); }
+      static mask equal(type x, type y) { return _mm256_cmp_pd(x, y, _CMP_EQ_OQ); }
+      static type select(mask m, type x, type y) { return _mm256_blendv_pd(y, x, m); }
+#if defined(__AVX2__)
+      static type pow2(type n)
+      {
+        const __m256i t = _mm256_castpd_si256(_mm256_add_pd(n, _mm256_set1_pd(0x1.8p52)));
+        return _mm256_castsi256_pd(_mm256_add_epi64(_mm256_slli_epi64(t, 52),
+                                                    _mm256_set1_epi64x(1023ll << 52)));
+      }
+      static type split(type x, type& e)
+      {
+        const __m256i i = _mm256_add_epi64(_mm256_castpd_si256(x),
+                                           _mm256_set1_epi64x(0x3ff0000000000000 - 0x3fe6a09e667f3bcd));
+        const __m256d magic = _mm256_set1_pd(0x1.8p52);
+        e = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(i, 52),
+                                                              _mm256_castpd_si256(magic))),
+                          _mm256_set1_pd(0x1.8p52 + 1023));
+        return _mm256_castsi256_pd(_mm256_add_epi64(_mm256_and_si256(i, _mm256_set1_epi64x(0x000fffffffffffff)),
+                                                    _mm256_set1_epi64x(0x3fe6a09e667f3bcd)));
+      }
+#endif
+    };
+
+#if defined(__AVX2__)
+  template<Int32 T>
+    struct native<T> {
+      using type = __m256i;
+      static constexpr std::size_t width = 8;
+      static type load(const T* p)
+      { return _mm256_loadu_si256(reinterpret_cast<const type*>(p)); }
+      static void store(T* p, type x)
+      { _mm256_storeu_si256(reinterpret_cast<type*>(p), x); }
+      static type broadcast(T x) { return _mm256_set1_epi32(x); }
+      static type apply(add_assign, type x, type y) { return _mm256_add_epi32(x, y); }
+      static type apply(sub_assign, type x, type y) { return _mm256_sub_epi32(x, y); }
+      static type apply(mul_assign, type x, type y) { return _mm256_mullo_epi32(x, y); }
+      static type apply(minimum, type x, type y)
+      {
+        if constexpr (std::is_signed_v<T>) return _mm256_min_epi32(x, y);
+        else return _mm256_min_epu32(x, y);
+      }
+      static type apply(maximum, type x, type y)
+      {
+        if constexpr (std::is_signed_v<T>) return _mm256_max_epi32(x, y);
+        else return _mm256_max_epu32(x, y);
+      }
+    };
+#endif
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+  template<>
+    struct native<float> {
+      using type = __m128;
+      static constexpr std::size_t width = 4;
+      static type load(const float* p) { return _mm_loadu_ps(p); }
+      static void store(float* p, type x) { _mm_storeu_ps(p, x); }
+      static type broadcast(float x) { return _mm_set1_ps(x); }
+      static type apply(add_assign, type x, type y) { return _mm_add_ps(x, y); }
+      static type apply(sub_assign, type x, type y) { return _mm_sub_ps(x, y); }
+      static type apply(mul_assign, type x, type y) { return _mm_mul_ps(x, y); }
+      static type apply(div_assign, type x, type y) { return _mm_div_ps(x, y); }
+      static type sqrt(type x) { return _mm_sqrt_ps(x); }
+      static type apply(minimum, type x, type y) { return _mm_min_ps(y, x); }
+      static type apply(maximum, type x, type y) { return _mm_max_ps(y, x); }
+      using mask = __m128;
+      static mask less(type x, type y) { return _mm_cmplt_ps(x, y); }
+      static mask equal(type x, type y) { return _mm_cmpeq_ps(x, y); }
+      static type select(mask m, type x, type y)
+      { return _mm_or_ps(_mm_and_ps(m, x), _mm_andnot_ps(m, y)); }
+      static type rsqrt(type x) { return _mm_rsqrt_ps(x); }
+      static type pow2(type n)
+      {
+        const __m128i t = _mm_castps_si128(_mm_add_ps(n, _mm_set1_ps(0x1.8p23f)));
+        return _mm_castsi128_ps(_mm_add_epi32(_mm_slli_epi32(t, 23), _mm_set1_epi32(127 << 23)));
+      }
+      static type split(type x, type& e)
+      {
+        const __m128i i = _mm_add_epi32(_mm_castps_si128(x), _mm_set1_epi32(0x3f800000 - 0x3f3504f3));
+        e = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(i, 23), _mm_set1_epi32(127)));
+        return _mm_castsi128_ps(_mm_add_epi32(_mm_and_si128(i, _mm_set1_epi32(0x007fffff)),
+                                              _mm_set1_epi32(0x3f3504f3)));
+      }
+    };
+
+  template<>
+    struct native<double> {
+      using type = __m128d;
+      static constexpr std::size_t width = 2;
+      static type load(const double* p) { return _mm_loadu_pd(p); }
+      static void store(double* p, type x) { _mm_storeu_pd(p, x); }
+      static type broadcast(double x) { return _mm_set1_pd(x); }
+      static type apply(add_assign, type x, type y) { return _mm_add_pd(x, y); }
+      static type apply(sub_assign, type x, type y) { return _mm_sub_pd(x, y); }
+      static type apply(mul_assign, type x, type y) { return _mm_mul_pd(x, y); }
+      static type apply(div_assign, type x, type y) { return _mm_div_pd(x, y); }
+      static type sqrt(type x) { return _mm_sqrt_pd(x); }
+      static type apply(minimum, type x, type y) { return _mm_min_pd(y, x); }
+      static type apply(maximum, type x, type y) { return _mm_max_pd(y, x); }
+      using mask = __m128d;
+      static mask less(type x, type y) { return _mm_cmplt_pd(x, y); }
+      static mask equal(type x, type y) { return _mm_cmpeq_pd(x, y); }
+      static type select(mask m, type x, type y)
+      { return _mm_or_pd(_mm_and_pd(m, x), _mm_andnot_pd(m, y)); }
+      static type pow2(type n)
+      {
+        const __m128i t = _mm_castpd_si128(_mm_add_pd(n, _mm_set1_pd(0x1.8p52)));
+        return _mm_castsi128_pd(_mm_add_epi64(_mm_slli_epi64(t, 52), _mm_set1_epi64x(1023ll << 52)));
+      }
+      static type split(type x, type& e)
+      {
+        const __m128i i = _mm_add_epi64(_mm_castpd_si128(x),
+                                        _mm_set1_epi64x(0x3ff0000000000000 - 0x3fe6a09e667f3bcd));
+        const __m128d magic = _mm_set1_pd(0x1.8p52);
+        e = _mm_sub_pd(_mm_castsi128_pd(_mm_or_si128(_mm_srli_epi64(i, 52), _mm_castpd_si128(magic))),
+                       _mm_set1_pd(0x1.8p52 + 1023));
+        return _mm_castsi128_pd(_mm_add_epi64(_mm_and_si128(i, _mm_set1_epi64x(0x000fffffffffffff)),
+                                              _mm_set1_epi64x(0x3fe6a09e667f3bcd)));
+      }
+    };
+
+  template<Int32 T>
+    struct native<T> {
+      using type = __m128i;
+      static constexpr std::size_t width = 4;
+      static type load(const T* p)
+      { return _mm_loadu_si128(reinterpret_cast<const type*>(p)); }
+      static void store(T* p, type x)
+      { _mm_storeu_si128(reinterpret_cast<type*>(p), x); }
+      static type broadcast(T x) { return _mm_set1_epi32(x); }
+      static type apply(add_assign, type x, type y) { return _mm_add_epi32(x, y); }
+      static type apply(sub_assign, type x, type y) { return _mm_sub_epi32(x, y); }
+#if defined(__SSE4_1__)
+      static type apply(mul_assign, type x, type y) { return _mm_mullo_epi32(x, y); }
+      static type apply(minimum, type x, type y)
+      {
+        if constexpr (std::is_signed_v<T>) return _mm_min_epi32(x, y);
+        else return _mm_min_epu32(x, y);
+      }
+      static type apply(maximum, type x, type y)
+      {
+        if constexpr (std::is_signed_v<T>) return _mm_max_epi32(x, y);
+        else return _mm_max_epu32(x, y);
+      }
+#endif
+    };
+
+#endif
+
+  // True if Op has a vector implementation for elements of type T.
+  template<typename Op, typename T>
+    concept Vectorizable = requires(typename native<T>::type x)
+    {
+      native<T>::apply(Op{}, x, x);
+    };
+
+  // True if T has a vector fused multiply-add: x * y + z computed in one
+  // instruction, with a single rounding.
+  template<typename T>
+    concept Fusable = requires(typename native<T>::type x)
+    {
+      native<T>::fma(x, x, x);
+    };
+
+  // x * y + z, fused if T is Fusable (std::fma() then compiles to the scalar
+  // instruction), so that the scalar and vector kernels agree.
+  // NOTE: std::fma() is not constexpr, so constant evaluation rounds twice.
+  template<typename T>
+    constexpr T
+    multiply_add(const T& x, const T& y, const T& z)
+    {
+      if constexpr (Fusable<T>) {
+        if (!std::is_constant_evaluated()) return std::fma(x, y, z);
+      }
+      return T(x * y + z);
+    }
+
+  // True if T has the vector operations of the elementary functions.
+  template<typename T>
+    concept Elementary = requires(typename native<T>::type x)
+    {
+      native<T>::select(native<T>::less(x, x), x, x);
+      native<T>::equal(x, x);
+      native<T>::pow2(x);
+      native<T>::split(x, x);
+    };
+
+  // op(x[i], y) for i in [0, n)
+  template<typename T, typename Op>
+    inline void
+    transform(T* x, const T& y, Op op, std::size_t n)
+    {
+      std::size_t i = 0;
+      if constexpr (Vectorizable<Op, T>) {
+        using V = native<T>;
+        const auto v = V::broadcast(y);
+        for (; i + 2 * V::width <= n; i += 2 * V::width) {
+          V::store(x + i, V::apply(op, V::load(x + i), v));
+          V::store(x + i + V::width, V::apply(op, V::load(x + i + V::width), v));
+        }
+        for (; i + V::width <= n; i += V::width) {
+          V::store(x + i, V::apply(op, V::load(x + i), v));
+        }
+      }
+      for (; i < n; ++i) op(x[i], y);
+    }
+
+  // op(x[i], y[i]) for i in [0, n)
+  template<typename T, typename Op>
+    inline void
+    transform(T* x, const T* y, Op op, std::size_t n)
+    {
+      std::size_t i = 0;
+      if constexpr (Vectorizable<Op, T>) {
+        using V = native<T>;
+        for (; i + 2 * V::width <= n; i += 2 * V::width) {
+          V::store(x + i, V::apply(op, V::load(x + i), V::load(y + i)));
+          V::store(x + i + V::width,
+                   V::apply(op, V::load(x + i + V::width),
+                                V::load(y + i + V::width)));
+        }
+        for (; i + V::width <= n; i += V::width) {
+          V::store(x + i, V::apply(op, V::load(x + i), V::load(y + i)));
+        }
+      }
+      for (; i < n; ++i) op(x[i], y[i]);
+    }
+
+  // As transform(), for a number of elements N known at compile time, with
+  // the loops unrolled; for small arrays.
+  template<std::size_t N, typename T, typename Op>
+    inline void
+    transform_n(T* x, const T& y, Op op)
+    {
+      constexpr auto w = Vectorizable<Op, T> ? native<T>::width : 1;
+      constexpr auto m = w > 1 ? N / w * w : 0;
+      [&]<std::size_t... I>(std::index_sequence<I...>) {
+        if constexpr (m > 0) {
+          using V = native<T>;
+          const auto v = V::broadcast(y);
+          (V::store(x + I * w, V::apply(op, V::load(x + I * w), v)), ...);
+        }
+      }(std::make_index_sequence<m / std::max<std::size_t>(w, 1)>());
+      [&]<std::size_t... I>(std::index_sequence<I...>) {
+        (op(x[m + I], y), ...);
+      }(std::make_index_sequence<N - m>());
+    }
+
+  template<std::size_t N, typename T, typename Op>
+    inline void
+    transform_n(T* x, const T* y, Op op)
+    {
+      constexpr auto w = Vectorizable<Op, T> ? native<T>::width : 1;
+      constexpr auto m = w > 1 ? N / w * w : 0;
+      [&]<std::size_t... I>(std::index_sequence<I...>) {
+        if constexpr (m > 0) {
+          using V = native<T>;
+          (V::store(x + I * w, V::apply(op, V::load(x + I * w), V::load(y + I * w))), ...);
+        }
+      }(std::make_index_sequence<m / std::max<std::size_t>(w, 1)>());
+      [&]<std::size_t... I>(std::index_sequence<I...>) {
+        (op(x[m + I], y[m + I]), ...);
+      }(std::make_index_sequence<N - m>());
+    }
+
+  // pack<T> is a register of native<T>::width elements and scalar<T> a 
+  // single element, with a common interface for arithmetic, so that a kernel
+  // can be written once for both the vectorized body of a loop and its tail.
+  template<typename T>
+    struct pack {
+      using V = native<T>;
+      using value_type = T;
+      static constexpr std::size_t width = V::width;
+
+      pack() = default;
+      pack(typename V::type x) : v(x) { }
+      pack(const T& x) : v(V::broadcast(x)) { }
+
+      static pack load(const T* p) { return V::load(p); }
+      void store(T* p) const { V::store(p, v); }
+
+      friend pack operator+(pack x, pack y) { return V::apply(add_assign{}, x.v, y.v); }
+      friend pack operator-(pack x, pack y) { return V::apply(sub_assign{}, x.v, y.v); }
+      friend pack operator*(pack x, pack y) { return V::apply(mul_assign{}, x.v, y.v); }
+      friend pack operator/(pack x, pack y) { return V::apply(div_assign{}, x.v, y.v); }
+      friend pack sqrt(pack x) { return V::sqrt(x.v); }
+      friend pack fma(pack x, pack y, pack z)
+      {
+        if constexpr (Fusable<T>) return V::fma(x.v, y.v, z.v);
+        else return x * y + z;
+      }
+      friend pack min(pack x, pack y) { return V::apply(minimum{}, x.v, y.v); }
+      friend pack max(pack x, pack y) { return V::apply(maximum{}, x.v, y.v); }
+      friend pack abs(pack x)
+      {
+        if constexpr (std::is_unsigned_v<T>) return x;
+        else return max(x, pack(T(0)) - x);
+      }
+
+      // For Elementary T
+      friend auto operator<(pack x, pack y) { return V::less(x.v, y.v); }
+      friend auto operator==(pack x, pack y) { return V::equal(x.v, y.v); }
+      template<typename Mask>
+        friend pack select(Mask m, pack x, pack y) { return V::select(m, x.v, y.v); }
+      friend pack pow2(pack n) { return V::pow2(n.v); }
+      friend pack split(pack x, pack& e) { return V::split(x.v, e.v); }
+      friend pack rsqrt_estimate(pack x) { return V::rsqrt(x.v); }
+
+      typename V::type v;
+    };
+
+  template<typename T>
+    struct scalar {
+      using value_type = T;
+      static constexpr std::size_t width = 1;
+
+      scalar() = default;
+      constexpr scalar(const T& x) : v(x) { }
+
+      static constexpr scalar load(const T* p) { return *p; }
+      constexpr void store(T* p) const { *p = v; }
+
+      friend constexpr scalar operator+(scalar x, scalar y) { return T(x.v + y.v); }
+      friend constexpr scalar operator-(scalar x, scalar y) { return T(x.v - y.v); }
+      friend constexpr scalar operator*(scalar x, scalar y) { return T(x.v * y.v); }
+      friend constexpr scalar operator/(scalar x, scalar y) { return T(x.v / y.v); }
+      friend scalar sqrt(scalar x) { using std::sqrt; return T(sqrt(x.v)); }
+      friend constexpr scalar fma(scalar x, scalar y, scalar z)
+      { return multiply_add(x.v, y.v, z.v); }
+      friend constexpr scalar min(scalar x, scalar y) { return y.v < x.v ? y : x; }
+      friend constexpr scalar max(scalar x, scalar y) { return x.v < y.v ? y : x; }
+      friend constexpr scalar abs(scalar x) { return x.v < T(0) ? T(-x.v) : x.v; }
+
+      // As for pack<T>, with the same results, for floating point T
+      friend constexpr bool operator<(scalar x, scalar y) { return x.v < y.v; }
+      friend constexpr bool operator==(scalar x, scalar y) { return x.v == y.v; }
+      friend constexpr scalar select(bool m, scalar x, scalar y) { return m ? x : y; }
+      friend constexpr scalar pow2(scalar n)
+      {
+        using U = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+        constexpr int digits = std::numeric_limits<T>::digits - 1;
+        constexpr U bias = std::numeric_limits<T>::max_exponent - 1;
+        return std::bit_cast<T>(U(U(std::int64_t(n.v)) + bias) << digits);
+      }
+      friend constexpr scalar split(scalar x, scalar& e)
+      {
+        using U = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+        constexpr int digits = std::numeric_limits<T>::digits - 1;
+        constexpr U bias = std::numeric_limits<T>::max_exponent - 1;
+        constexpr U one = bias << digits, root = std::bit_cast<U>(T(0.70710678118654752440L));
+        const U i = std::bit_cast<U>(x.v) + (one - root);
+        e = T(std::int64_t(i >> digits) - std::int64_t(bias));
+        return std::bit_cast<T>((i & ((U(1) << digits) - 1)) + root);
+      }
+
+      T v;
+    };
+
+  // True if pack<T> supports +, - and * (and / and sqrt if Division).
+  template<typename T, bool Division = false>
+    concept Packable = Vectorizable<add_assign, T> 
+                    && Vectorizable<sub_assign, T> 
+                    && Vectorizable<mul_assign, T>
+                    && (!Division || (Vectorizable<div_assign, T> && 
+                                      requires(typename native<T>::type x) 
+                                      { native<T>::sqrt(x); }));
+
+  // Calls f(i, P()) for i in [0, n) in steps of P::width, where P is pack<T>
+  // for as much of the range as possible and scalar<T> for the rest.
+  template<typename T, bool Division = false, typename F>
+    inline void
+    for_each_pack(std::size_t n, F f)
+    {
+      std::size_t i = 0;
+      if constexpr (Packable<T, Division>) {
+        for (; i + pack<T>::width <= n; i += pack<T>::width) f(i, pack<T>());
+      }
+      for (; i < n; ++i) f(i, scalar<T>());
+    }
+
+  // The number of elements of [0, n) processed by pack<T>, in whole packs
+  template<typename T>
+    constexpr std::size_t
+    packed_count(std::size_t n) noexcept
+    {
+      if constexpr (Packable<T>) return n - n % pack<T>::width;
+      else return 0;
+    }
+
+  // r[i] = a[i] * b[i] + c[i] for i in [0, n), with multiply_add(). r may
+  // be any of a, b and c.
+  template<typename T>
+    inline void
+    multiply_add(T* r, const T* a, const T* b, const T* c, std::size_t n)
+    {
+      const auto m = packed_count<T>(n);
+      if constexpr (Packable<T>) {
+        using P = pack<T>;
+        for (std::size_t i = 0; i < m; i += P::width) {
+          fma(P::load(a + i), P::load(b + i), P::load(c + i)).store(r + i);
+        }
+      }
+      for (std::size_t i = m; i < n; ++i) r[i] = multiply_add(a[i], b[i], c[i]);
+    }
+
+  // y[i] = alpha * x[i] + y[i] for i in [0, n), with multiply_add().
+  template<typename T>
+    inline void
+    axpy(const T& alpha, const T* x, T* y, std::size_t n)
+    {
+      const auto m = packed_count<T>(n);
+      if constexpr (Packable<T>) {
+        using P = pack<T>;
+        const P a(alpha);
+        for (std::size_t i = 0; i < m; i += P::width) {
+          fma(a, P::load(x + i), P::load(y + i)).store(y + i);
+        }
+      }
+      for (std::size_t i = m; i < n; ++i) y[i] = multiply_add(alpha, x[i], y[i]);
+    }
+
+  // Returns init op f(x[0]) op f(x[1]) op ... op f(x[n - 1]) for an
+  // associative and commutative op. f and op are applied to pack<T> if
+  // Vectorized (in an unspecified order, with four independent accumulators
+  // to hide the latency of op), and to scalar<T> otherwise.
+  template<typename T, bool Vectorized, typename F, typename Op>
+    inline T
+    transform_reduce(const T* x, std::size_t n, T init, F f, Op op)
+    {
+      std::size_t i = 0;
+      scalar<T> result = init;
+      if constexpr (Vectorized) {
+        using P = pack<T>;
+        constexpr auto w = P::width;
+        if (n >= 4 * w) {
+          P acc[4] = { f(P::load(x)),         f(P::load(x + w)),
+                       f(P::load(x + 2 * w)), f(P::load(x + 3 * w)) };
+          for (i = 4 * w; i + 4 * w <= n; i += 4 * w) {
+            for (std::size_t k = 0; k < 4; ++k) {
+              acc[k] = op(acc[k], f(P::load(x + i + k * w)));
+            }
+          }
+          for (; i + w <= n; i += w) acc[0] = op(acc[0], f(P::load(x + i)));
+
+          T lanes[w];
+          op(op(acc[0], acc[1]), op(acc[2], acc[3])).store(lanes);
+          for (const auto& y : lanes) result = op(result, scalar<T>(y));
+        }
+      }
+      for (x += i, n -= i; n > 0; --n) result = op(result, f(scalar<T>::load(x++)));
+      return result.v;
+    }
+
+  // Kernels for 4x4 matrices of T, stored in rows, with each row held in a
+  // register: c = a * b, y = a * x and b = transpose(a). The products sum
+  // over k in order, as the scalar loops do. The primary template has no
+  // kernels.
+  template<typename T>
+    struct matrix_4x4 { static constexpr bool vectorized = false; };
+
+#if defined(__SSE2__) || defined(_M_X64)
+  template<>
+    struct matrix_4x4<float> {
+      static constexpr bool vectorized = true;
+
+      static void product(const float* a, const float* b, float* c)
+      {
+        const __m128 b0 = _mm_loadu_ps(b),     b1 = _mm_loadu_ps(b + 4);
+        const __m128 b2 = _mm_loadu_ps(b + 8), b3 = _mm_loadu_ps(b + 12);
+        for (std::size_t i = 0; i < 16; i += 4) {
+          const __m128 r = _mm_loadu_ps(a + i);
+          __m128 x = _mm_mul_ps(_mm_shuffle_ps(r, r, 0x00), b0);
+          x = _mm_add_ps(x, _mm_mul_ps(_mm_shuffle_ps(r, r, 0x55), b1));
+          x = _mm_add_ps(x, _mm_mul_ps(_mm_shuffle_ps(r, r, 0xaa), b2));
+          x = _mm_add_ps(x, _mm_mul_ps(_mm_shuffle_ps(r, r, 0xff), b3));
+          _mm_storeu_ps(c + i, x);
+        }
+      }
+
+      static void vector_product(const float* a, const float* x, float* y)
+      {
+        const __m128 v = _mm_loadu_ps(x);
+        __m128 p0 = _mm_mul_ps(_mm_loadu_ps(a), v),     p1 = _mm_mul_ps(_mm_loadu_ps(a + 4), v);
+        __m128 p2 = _mm_mul_ps(_mm_loadu_ps(a + 8), v), p3 = _mm_mul_ps(_mm_loadu_ps(a + 12), v);
+        _MM_TRANSPOSE4_PS(p0, p1, p2, p3);
+        _mm_storeu_ps(y, _mm_add_ps(_mm_add_ps(_mm_add_ps(p0, p1), p2), p3));
+      }
+
+      static void transpose(const float* a, float* b)
+      {
+        __m128 r0 = _mm_loadu_ps(a),     r1 = _mm_loadu_ps(a + 4);
+        __m128 r2 = _mm_loadu_ps(a + 8), r3 = _mm_loadu_ps(a + 12);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(b, r0);     _mm_storeu_ps(b + 4, r1);
+        _mm_storeu_ps(b + 8, r2); _mm_storeu_ps(b + 12, r3);
+      }
+    };
+#endif
+
+#if defined(__AVX__)
+  template<>
+    struct matrix_4x4<double> {
+      static constexpr bool vectorized = true;
+
+      static void product(const double* a, const double* b, double* c)
+      {
+        const __m256d b0 = _mm256_loadu_pd(b),     b1 = _mm256_loadu_pd(b + 4);
+        const __m256d b2 = _mm256_loadu_pd(b + 8), b3 = _mm256_loadu_pd(b + 12);
+        for (std::size_t i = 0; i < 16; i += 4) {
+          __m256d x = _mm256_mul_pd(_mm256_broadcast_sd(a + i), b0);
+          x = _mm256_add_pd(x, _mm256_mul_pd(_mm256_broadcast_sd(a + i + 1), b1));
+          x = _mm256_add_pd(x, _mm256_mul_pd(_mm256_broadcast_sd(a + i + 2), b2));
+          x = _mm256_add_pd(x, _mm256_mul_pd(_mm256_broadcast_sd(a + i + 3), b3));
+          _mm256_storeu_pd(c + i, x);
+        }
+      }
+
+      static void vector_product(const double* a, const double* x, double* y)
+      {
+        const __m256d v = _mm256_loadu_pd(x);
+        __m256d p[4] = { _mm256_mul_pd(_mm256_loadu_pd(a), v),
+                         _mm256_mul_pd(_mm256_loadu_pd(a + 4), v),
+                         _mm256_mul_pd(_mm256_loadu_pd(a + 8), v),
+                         _mm256_mul_pd(_mm256_loadu_pd(a + 12), v) };
+        transpose(p);
+        _mm256_storeu_pd(y, _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(p[0], p[1]), p[2]), p[3]));
+      }
+
+      static void transpose(const double* a, double* b)
+      {
+        __m256d r[4] = { _mm256_loadu_pd(a),     _mm256_loadu_pd(a + 4),
+                         _mm256_loadu_pd(a + 8), _mm256_loadu_pd(a + 12) };
+        transpose(r);
+        for (std::size_t i = 0; i < 4; ++i) _mm256_storeu_pd(b + 4 * i, r[i]);
+      }
+
+    private:
+      static void transpose(__m256d (&r)[4])
+      {
+        const __m256d t0 = _mm256_unpacklo_pd(r[0], r[1]), t1 = _mm256_unpackhi_pd(r[0], r[1]);
+        const __m256d t2 = _mm256_unpacklo_pd(r[2], r[3]), t3 = _mm256_unpackhi_pd(r[2], r[3]);
+        r[0] = _mm256_permute2f128_pd(t0, t2, 0x20);
+        r[1] = _mm256_permute2f128_pd(t1, t3, 0x20);
+        r[2] = _mm256_permute2f128_pd(t0, t2, 0x31);
+        r[3] = _mm256_permute2f128_pd(t1, t3, 0x31);
+      }
+    };
+#endif
+
+  // Conversions between float and the 16-bit floating point formats, held
+  // as their bits: IEEE binary16 (half precision, with 5 exponent and 10
+  // fraction bits) and bfloat16 (the upper half of a float). Narrowing
+  // rounds to nearest even, and keeps infinities and NaNs (quieted).
+  constexpr float
+  half_to_float(std::uint16_t h) noexcept
+  {
+#if defined(__F16C__)
+    if (!std::is_constant_evaluated()) return _cvtsh_ss(h);
+#endif
+    const std::uint32_t sign = std::uint32_t(h & 0x8000) << 16;
+    const std::uint32_t exponent = (h >> 10) & 0x1f, fraction = h & 0x3ff;
+    if (exponent == 0x1f) {
+      return std::bit_cast<float>(sign | 0x7f800000 | fraction << 13);
+    }
+    if (exponent == 0) { // zero or subnormal, fraction * 2^-24
+      const float x = static_cast<float>(fraction) * 0x1p-24f;
+      return sign ? -x : x;
+    }
+    return std::bit_cast<float>(sign | (exponent + 112) << 23 | fraction << 13);
+  }
+
+  constexpr std::uint16_t
+  float_to_half(float x) noexcept
+  {
+#if defined(__F16C__)
+    if (!std::is_constant_evaluated()) return _cvtss_sh(x, _MM_FROUND_TO_NEAREST_INT);
+#endif
+    const auto bits = std::bit_cast<std::uint32_t>(x);
+    const auto sign = static_cast<std::uint16_t>((bits >> 16) & 0x8000);
+    const std::uint32_t magnitude = bits & 0x7fffffff;
+    if (magnitude > 0x7f800000) { // NaN
+      return sign | 0x7e00 | static_cast<std::uint16_t>((magnitude >> 13) & 0x3ff);
+    }
+    if (magnitude >= 0x477ff000) return sign | 0x7c00; // at least 65520
+    if (magnitude < 0x38800000) {
+      // Below 2^-14, the result is subnormal: adding 0.5 leaves the fraction,
+      // in units of 2^-24, in the low bits of the sum, rounded by the FPU.
+      const float y = std::bit_cast<float>(magnitude) + 0.5f;
+      return sign | static_cast<std::uint16_t>(std::bit_cast<std::uint32_t>(y) - 0x3f000000);
+    }
+    // Rebias the exponent (127 - 15) and round off 13 bits of the fraction.
+    const std::uint32_t odd = (magnitude >> 13) & 1;
+    return sign | static_cast<std::uint16_t>((magnitude - 0x37fff001 + odd) >> 13);
+  }
+
+  constexpr float
+  bfloat16_to_float(std::uint16_t h) noexcept
+  {
+    return std::bit_cast<float>(std::uint32_t(h) << 16);
+  }
+
+  constexpr std::uint16_t
+  float_to_bfloat16(float x) noexcept
+  {
+    const auto bits = std::bit_cast<std::uint32_t>(x);
+    if ((bits & 0x7fffffff) > 0x7f800000) return static_cast<std::uint16_t>(bits >> 16 | 0x40);
+    return static_cast<std::uint16_t>((bits + 0x7fff + ((bits >> 16) & 1)) >> 16);
+  }
+
+  // The same, for arrays: y[i] = f(x[i]) for i in [0, n). The binary16
+  // kernels use F16C (-mf16c) or AVX-512F, the bfloat16 kernels AVX2 or
+  // AVX-512F.
+  inline void
+  half_to_float(const std::uint16_t* x, std::size_t n, float* y) noexcept
+  {
+    std::size_t i = 0;
+#if defined(__AVX512F__)
+    for (const auto m = n - n % 16; i < m; i += 16) {
+      const __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+      _mm512_storeu_ps(y + i, _mm512_maskz_cvtph_ps(__mmask16(-1), h));
+    }
+#elif defined(__F16C__)
+    for (const auto m = n - n % 8; i < m; i += 8) {
+      const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+      _mm256_storeu_ps(y + i, _mm256_cvtph_ps(h));
+    }
+#endif
+    for (; i < n; ++i) y[i] = half_to_float(x[i]);
+  }
+
+  inline void
+  float_to_half(const float* x, std::size_t n, std::uint16_t* y) noexcept
+  {
+    std::size_t i = 0;
+#if defined(__AVX512F__)
+    for (const auto m = n - n % 16; i < m; i += 16) {
+      const __m256i h = _mm512_maskz_cvtps_ph(__mmask16(-1), _mm512_loadu_ps(x + i),
+                                              _MM_FROUND_TO_NEAREST_INT);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i), h);
+    }
+#elif defined(__F16C__)
+    for (const auto m = n - n % 8; i < m; i += 8) {
+      const __m128i h = _mm256_cvtps_ph(_mm256_loadu_ps(x + i), _MM_FROUND_TO_NEAREST_INT);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(y + i), h);
+    }
+#endif
+    for (; i < n; ++i) y[i] = float_to_half(x[i]);
+  }
+
+  inline void
+  bfloat16_to_float(const std::uint16_t* x, std::size_t n, float* y) noexcept
+  {
+    std::size_t i = 0;
+#if defined(__AVX512F__)
+    for (const auto m = n - n % 16; i < m; i += 16) {
+      const __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i));
+      const __m512i t = _mm512_maskz_cvtepu16_epi32(__mmask16(-1), h);
+      _mm512_storeu_si512(y + i, _mm512_maskz_slli_epi32(__mmask16(-1), t, 16));
+    }
+#elif defined(__AVX2__)
+    for (const auto m = n - n % 8; i < m; i += 8) {
+      const __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + i));
+      const __m256i t = _mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i), t);
+    }
+#endif
+    for (; i < n; ++i) y[i] = bfloat16_to_float(x[i]);
+  }
+
+  inline void
+  float_to_bfloat16(const float* x, std::size_t n, std::uint16_t* y) noexcept
+  {
+    std::size_t i = 0;
+#if defined(__AVX512F__)
+    const __m512i bias = _mm512_set1_epi32(0x7fff), one = _mm512_set1_epi32(1);
+    const __m512i inf = _mm512_set1_epi32(0x7f800000), quiet = _mm512_set1_epi32(0x400000);
+    for (const auto m = n - n % 16; i < m; i += 16) {
+      __m512i t = _mm512_loadu_si512(x + i);
+      const __mmask16 nan = _mm512_cmpgt_epi32_mask(
+        _mm512_and_si512(t, _mm512_set1_epi32(0x7fffffff)), inf);
+      const __m512i odd = _mm512_and_si512(_mm512_maskz_srli_epi32(__mmask16(-1), t, 16), one);
+      t = _mm512_mask_or_epi32(_mm512_add_epi32(t, _mm512_add_epi32(bias, odd)), nan, t, quiet);
+      t = _mm512_maskz_srli_epi32(__mmask16(-1), t, 16);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i),
+                          _mm512_maskz_cvtepi32_epi16(__mmask16(-1), t));
+    }
+#elif defined(__AVX2__)
+    const __m256i bias = _mm256_set1_epi32(0x7fff), one = _mm256_set1_epi32(1);
+    const __m256i inf = _mm256_set1_epi32(0x7f800000), quiet = _mm256_set1_epi32(0x400000);
+    const __m256i abs = _mm256_set1_epi32(0x7fffffff);
+    const auto round = [&](__m256i t) {
+      const __m256i nan = _mm256_cmpgt_epi32(_mm256_and_si256(t, abs), inf);
+      const __m256i odd = _mm256_and_si256(_mm256_srli_epi32(t, 16), one);
+      const __m256i r = _mm256_add_epi32(t, _mm256_add_epi32(bias, odd));
+      // The upper halves, sign-extended, so that the saturating pack keeps them.
+      return _mm256_srai_epi32(_mm256_blendv_epi8(r, _mm256_or_si256(t, quiet), nan), 16);
+    };
+    for (const auto m = n - n % 16; i < m; i += 16) {
+      const __m256i lo = round(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i)));
+      const __m256i hi = round(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + i + 8)));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(y + i),
+                          _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8));
+    }
+#endif
+    for (; i < n; ++i) y[i] = float_to_bfloat16(x[i]);
+  }
+
+  // Access to arrays of 3-vectors of T, stored one after another (x0 y0 z0
+  // x1 ...), in groups of four vectors: one group in each 128-bit lane of a
+  // register of native<T>. load(p) gives the 16 bytes at p of each group,
+  // i.e. x0 y0 z0 x1, y1 z1 x2 y2 or z2 x3 y3 z3 for p = x, x + 4 and x + 8,
+  // and shuffle<Imm>() is _mm_shuffle_ps() in each lane. The primary
+  // template has no kernels.
+  template<typename T>
+    struct vec3_lanes { static constexpr bool vectorized = false; };
+
+#if defined(__AVX512F__)
+  template<>
+    struct vec3_lanes<float> {
+      using type = __m512;
+      static constexpr bool vectorized = true;
+      static constexpr std::size_t width = 16;
+
+      static type load(const float* p)
+      {
+        type x = _mm512_castps128_ps512(_mm_loadu_ps(p));
+        x = _mm512_maskz_insertf32x4(__mmask16(-1), x, _mm_loadu_ps(p + 12), 1);
+        x = _mm512_maskz_insertf32x4(__mmask16(-1), x, _mm_loadu_ps(p + 24), 2);
+        return _mm512_maskz_insertf32x4(__mmask16(-1), x, _mm_loadu_ps(p + 36), 3);
+      }
+      static void store(float* p, type x)
+      {
+        _mm_storeu_ps(p, _mm512_maskz_extractf32x4_ps(__mmask8(-1), x, 0));
+        _mm_storeu_ps(p + 12, _mm512_maskz_extractf32x4_ps(__mmask8(-1), x, 1));
+        _mm_storeu_ps(p + 24, _mm512_maskz_extractf32x4_ps(__mmask8(-1), x, 2));
+        _mm_storeu_ps(p + 36, _mm512_maskz_extractf32x4_ps(__mmask8(-1), x, 3));
+      }
+      template<int Imm>
+        static type shuffle(type x, type y)
+        { return _mm512_maskz_shuffle_ps(__mmask16(-1), x, y, Imm); }
+    };
+#elif defined(__AVX__)
+  template<>
+    struct vec3_lanes<float> {
+      using type = __m256;
+      static constexpr bool vectorized = true;
+      static constexpr std::size_t width = 8;
+
+      static type load(const float* p)
+      {
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p)),
+                                    _mm_loadu_ps(p + 12), 1);
+      }
+      static void store(float* p, type x)
+      {
+        _mm_storeu_ps(p, _mm256_castps256_ps128(x));
+        _mm_storeu_ps(p + 12, _mm256_extractf128_ps(x, 1));
+      }
+      template<int Imm>
+        static type shuffle(type x, type y) { return _mm256_shuffle_ps(x, y, Imm); }
+    };
+#elif defined(__SSE2__) || defined(_M_X64)
+  template<>
+    struct vec3_lanes<float> {
+      using type = __m128;
+      static constexpr bool vectorized = true;
+      static constexpr std::size_t width = 4;
+
+      static type load(const float* p) { return _mm_loadu_ps(p); }
+      static void store(float* p, type x) { _mm_storeu_ps(p, x); }
+      template<int Imm>
+        static type shuffle(type x, type y) { return _mm_shuffle_ps(x, y, Imm); }
+    };
+#endif
+
+  // y[i] = a * x[i] + t for i in [0, n), where x and y are arrays of n
+  // 3-vectors (stored as for vec3_lanes) and m = [a t] is a 3x4 matrix,
+  // given by rows. y may be x. The products sum as m0 * x + (m1 * y + (m2 *
+  // z + t)), with multiply_add().
+  template<typename T>
+    inline void
+    affine_transform_3(const T* m, const T* x, std::size_t n, T* y)
+    {
+      const auto rows = [m](auto x0, auto x1, auto x2, auto* r) {
+        using P = decltype(x0);
+        for (std::size_t i = 0; i < 3; ++i) {
+          const T* a = m + 4 * i;
+          r[i] = fma(P(a[0]), x0, fma(P(a[1]), x1, fma(P(a[2]), x2, P(a[3]))));
+        }
+      };
+      std::size_t i = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+      if constexpr (vec3_lanes<T>::vectorized) {
+        using L = vec3_lanes<T>;
+        using P = pack<T>;
+        for (const auto k = n - n % L::width; i < k; i += L::width) {
+          const auto a0 = L::load(x), a1 = L::load(x + 4), a2 = L::load(x + 8);
+          // The x, y and z components, each in the order of the vectors
+          const auto t0 = L::template shuffle<_MM_SHUFFLE(2, 1, 3, 2)>(a1, a2);
+          const auto t1 = L::template shuffle<_MM_SHUFFLE(1, 0, 2, 1)>(a0, a1);
+          P c[3];
+          rows(P(L::template shuffle<_MM_SHUFFLE(2, 0, 3, 0)>(a0, t0)),
+               P(L::template shuffle<_MM_SHUFFLE(3, 1, 2, 0)>(t1, t0)),
+               P(L::template shuffle<_MM_SHUFFLE(3, 0, 3, 1)>(t1, a2)), c);
+          const auto &X = c[0].v, &Y = c[1].v, &Z = c[2].v;
+          // Back to x0 y0 z0 x1, y1 z1 x2 y2 and z2 x3 y3 z3
+          const auto b0 = L::template shuffle<_MM_SHUFFLE(2, 0, 2, 0)>(
+            L::template shuffle<_MM_SHUFFLE(0, 0, 0, 0)>(X, Y),
+            L::template shuffle<_MM_SHUFFLE(0, 1, 0, 0)>(Z, X));
+          const auto b1 = L::template shuffle<_MM_SHUFFLE(2, 0, 2, 0)>(
+            L::template shuffle<_MM_SHUFFLE(0, 1, 0, 1)>(Y, Z),
+            L::template shuffle<_MM_SHUFFLE(0, 2, 0, 2)>(X, Y));
+          const auto b2 = L::template shuffle<_MM_SHUFFLE(2, 0, 2, 0)>(
+            L::template shuffle<_MM_SHUFFLE(0, 3, 0, 2)>(Z, X),
+            L::template shuffle<_MM_SHUFFLE(0, 3, 0, 3)>(Y, Z));
+          L::store(y, b0), L::store(y + 4, b1), L::store(y + 8, b2);
+          x += 3 * L::width, y += 3 * L::width;
+        }
+      }
+#endif
+      for (; i < n; ++i, x += 3, y += 3) {
+        scalar<T> r[3];
+        rows(scalar<T>(x[0]), scalar<T>(x[1]), scalar<T>(x[2]), r);
+        y[0] = r[0].v, y[1] = r[1].v, y[2] = r[2].v;
+      }
+    }
+
+  // Integer Kernels
+  //
+  // Sums of products of 8-bit integers, and of signed 16-bit ones, in 32-bit
+  // lanes. The operands are widened to int16 and multiplied in pairs by
+  // madd (or, with VNNI, dpwssd, which also adds them to the lanes): this is
+  // exact, where the pairs of u8 x s8 products of pmaddubsw saturate to
+  // int16. Only VNNI's dpbusd sums the products of bytes (four in a lane,
+  // unsigned by signed) exactly.
+  // NOTE: Sums that do not fit in int32 wrap around. Those of up to 32768
+  // products of 8-bit integers always fit.
+  template<typename T>
+    concept Small_integer = std::same_as<T, std::int8_t> || std::same_as<T, std::uint8_t>
+                         || std::same_as<T, std::int16_t>;
+
+  // The 32-bit lanes of the integer kernels: widen(p) loads 2 * width
+  // Small_integers as int16s, dot2(acc, a, b) adds the products of the pairs
+  // of int16s in each lane of a and b to acc, and, with VNNI (dot4_product),
+  // dot4(acc, a, b) those of the four bytes, unsigned in a and signed in b.
+#if defined(__AVX512BW__)
+  struct integer_lanes {
+    using type = __m512i;
+    static constexpr bool vectorized = true;
+#if defined(__AVX512VNNI__)
+    static constexpr bool dot4_product = true;
+#else
+    static constexpr bool dot4_product = false;
+#endif
+    static constexpr std::size_t width = 16;
+
+    static type zero() { return _mm512_setzero_si512(); }
+    static type broadcast(std::int32_t x) { return _mm512_set1_epi32(x); }
+    static type load(const void* p) { return _mm512_loadu_si512(p); }
+    static void store(std::int32_t* p, type x) { _mm512_storeu_si512(p, x); }
+    static std::int32_t sum(type x)
+    {
+      // The masked forms avoid a spurious -Wmaybe-uninitialized in GCC 12.
+      const auto y = _mm256_add_epi32(_mm512_maskz_extracti64x4_epi64(__mmask8(-1), x, 0),
+                                      _mm512_maskz_extracti64x4_epi64(__mmask8(-1), x, 1));
+      auto z = _mm_add_epi32(_mm256_castsi256_si128(y), _mm256_extracti128_si256(y, 1));
+      z = _mm_add_epi32(z, _mm_shuffle_epi32(z, _MM_SHUFFLE(1, 0, 3, 2)));
+      z = _mm_add_epi32(z, _mm_shuffle_epi32(z, _MM_SHUFFLE(2, 3, 0, 1)));
+      return _mm_cvtsi128_si32(z);
+    }
+
+    template<Small_integer T>
+      static type widen(const T* p)
+      {
+        if constexpr (std::same_as<T, std::int16_t>) return load(p);
+        const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        if constexpr (std::same_as<T, std::int8_t>) return _mm512_cvtepi8_epi16(x);
+        else return _mm512_cvtepu8_epi16(x);
+      }
+
+    static type dot2(type acc, type a, type b)
+    {
+#if defined(__AVX512VNNI__)
+      return _mm512_dpwssd_epi32(acc, a, b);
+#else
+      return _mm512_add_epi32(acc, _mm512_madd_epi16(a, b));
+#endif
+    }
+#if defined(__AVX512VNNI__)
+    static type dot4(type acc, type a, type b) { return _mm512_dpbusd_epi32(acc, a, b); }
+#endif
+  };
+#elif defined(__AVX2__)
+  struct integer_lanes {
+    using type = __m256i;
+    static constexpr bool vectorized = true;
+#if defined(__AVXVNNI__)
+    static constexpr bool dot4_product = true;
+#else
+    static constexpr bool dot4_product = false;
+#endif
+    static constexpr std::size_t width = 8;
+
+    static type zero() { return _mm256_setzero_si256(); }
+    static type broadcast(std::int32_t x) { return _mm256_set1_epi32(x); }
+    static type load(const void* p) { return _mm256_loadu_si256(static_cast<const type*>(p)); }
+    static void store(std::int32_t* p, type x) { _mm256_storeu_si256(reinterpret_cast<type*>(p), x); }
+    static std::int32_t sum(type x)
+    {
+      auto y = _mm_add_epi32(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+      y = _mm_add_epi32(y, _mm_shuffle_epi32(y, _MM_SHUFFLE(1, 0, 3, 2)));
+      y = _mm_add_epi32(y, _mm_shuffle_epi32(y, _MM_SHUFFLE(2, 3, 0, 1)));
+      return _mm_cvtsi128_si32(y);
+    }
+
+    template<Small_integer T>
+      static type widen(const T* p)
+      {
+        if constexpr (std::same_as<T, std::int16_t>) return load(p);
+        const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        if constexpr (std::same_as<T, std::int8_t>) return _mm256_cvtepi8_epi16(x);
+        else return _mm256_cvtepu8_epi16(x);
+      }
+
+    static type dot2(type acc, type a, type b)
+    {
+#if defined(__AVXVNNI__)
+      return _mm256_dpwssd_avx_epi32(acc, a, b);
+#else
+      return _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+#endif
+    }
+#if defined(__AVXVNNI__)
+    static type dot4(type acc, type a, type b) { return _mm256_dpbusd_avx_epi32(acc, a, b); }
+#endif
+  };
+#else
+  struct integer_lanes {
+    static constexpr bool vectorized = false, dot4_product = false;
+  };
+#endif
+
+  // The sum of x[i] * y[i] for i in [0, n), in int32 (see above).
+  template<Small_integer T1, Small_integer T2>
+    inline std::int32_t
+    integer_dot(const T1* x, const T2* y, std::size_t n) noexcept
+    {
+      std::uint32_t result = 0; // wraps around
+      std::size_t i = 0;
+#if defined(__AVX2__)
+      {
+        using L = integer_lanes;
+        constexpr auto w = 2 * L::width; // int16s
+        // Two sums, so that the latency of dpwssd is hidden
+        auto acc0 = L::zero(), acc1 = L::zero();
+        for (const auto m = n - n % (2 * w); i < m; i += 2 * w) {
+          acc0 = L::dot2(acc0, L::widen(x + i), L::widen(y + i));
+          acc1 = L::dot2(acc1, L::widen(x + i + w), L::widen(y + i + w));
+        }
+        for (const auto m = n - n % w; i < m; i += w) {
+          acc0 = L::dot2(acc0, L::widen(x + i), L::widen(y + i));
+        }
+        result = static_cast<std::uint32_t>(L::sum(acc0)) + static_cast<std::uint32_t>(L::sum(acc1));
+      }
+#endif
+      for (; i < n; ++i) {
+        result += static_cast<std::uint32_t>(std::int32_t(x[i]) * std::int32_t(y[i]));
+      }
+      return static_cast<std::int32_t>(result);
+    }
+}
+#endif//TB_MATH_NUM_ARRAY_SIMD_H
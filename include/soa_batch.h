@@ -0,0 +1,286 @@
+#ifndef TB_MATH_NUM_ARRAY_SOA_BATCH_H
+#define TB_MATH_NUM_ARRAY_SOA_BATCH_H
+
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include "dynamic_num_array.h"
+#include "simd.h"
+
+namespace tb::math {
+
+  // A soa_batch holds a sequence of num_array vectors in "structure of
+  // arrays" form: the k-th components of all vectors are stored contiguously,
+  // in their own lane, so that operations on the whole batch process
+  // SIMD-width groups of vectors at a time. Each lane is aligned to (and
+  // padded to a multiple of) a cache line.
+  template<typename V>
+    class soa_batch;
+
+  template<Number T, std::size_t N>
+    class soa_batch<num_array<T, N>> {
+    public:
+      using value_type      = num_array<T, N>;
+      using element_type    = T;
+      using size_type       = std::size_t;
+      using pointer         = T*;
+      using const_pointer   = const T*;
+
+      soa_batch() = default;
+      explicit soa_batch(size_type n);
+      soa_batch(size_type n, const value_type& value);
+      template<std::input_iterator I>
+        soa_batch(I first, I last);
+      soa_batch(std::initializer_list<value_type> init_list)
+        : soa_batch(init_list.begin(), init_list.end()) { }
+
+      size_type size() const noexcept { return size_; }
+      bool empty() const noexcept { return size_ == 0; }
+      size_type capacity() const noexcept { return lanes_.empty() ? 0 : lanes_.extent(1); }
+      static constexpr size_type components() { return N; }
+
+      // The k-th components of all vectors in the batch
+      const_pointer component(size_type k) const noexcept
+      { return lanes_.data() + k * capacity(); }
+      pointer component(size_type k) noexcept
+      { return lanes_.data() + k * capacity(); }
+
+      // Gathers the i-th vector of the batch
+      value_type operator[](size_type i) const noexcept;
+      // Scatters x to the i-th vector of the batch
+      void set(size_type i, const value_type& x) noexcept;
+
+      void reserve(size_type n);
+      void resize(size_type n);
+      void push_back(const value_type& x);
+      void clear() noexcept { size_ = 0; }
+
+    private:
+      // Lanes are padded to a multiple of the cache line size.
+      static constexpr size_type lane_block =
+        std::max<size_type>(1, dynamic_num_array<T, 2>::alignment / sizeof(T));
+
+      size_type size_ = 0;
+      dynamic_num_array<T, 2> lanes_;
+    };
+
+  template<Number T, std::size_t N>
+    soa_batch<num_array<T, N>>::soa_batch(size_type n)
+    {
+      resize(n);
+    }
+
+  template<Number T, std::size_t N>
+    soa_batch<num_array<T, N>>::soa_batch(size_type n, const value_type& value)
+    {
+      resize(n);
+      for (size_type k = 0; k < N; ++k) std::fill_n(component(k), n, value[k]);
+    }
+
+  template<Number T, std::size_t N>
+    template<std::input_iterator I>
+      soa_batch<num_array<T, N>>::soa_batch(I first, I last)
+      {
+        if constexpr (std::forward_iterator<I>) {
+          reserve(static_cast<size_type>(std::distance(first, last)));
+        }
+        for (; first != last; ++first) push_back(*first);
+      }
+
+  template<Number T, std::size_t N>
+    auto
+    soa_batch<num_array<T, N>>::operator[](size_type i) const noexcept
+      -> value_type
+    {
+      value_type result;
+      for (size_type k = 0; k < N; ++k) result[k] = component(k)[i];
+      return result;
+    }
+
+  template<Number T, std::size_t N>
+    void
+    soa_batch<num_array<T, N>>::set(size_type i, const value_type& x) noexcept
+    {
+      for (size_type k = 0; k < N; ++k) component(k)[i] = x[k];
+    }
+
+  template<Number T, std::size_t N>
+    void
+    soa_batch<num_array<T, N>>::reserve(size_type n)
+    {
+      if (n <= capacity()) return;
+      const auto padded = (n + lane_block - 1) / lane_block * lane_block;
+      dynamic_num_array<T, 2> lanes({ N, padded }, T(0));
+      for (size_type k = 0; k < N; ++k) {
+        std::copy_n(component(k), size_, lanes.data() + k * padded);
+      }
+      lanes_ = std::move(lanes);
+    }
+
+  template<Number T, std::size_t N>
+    void
+    soa_batch<num_array<T, N>>::resize(size_type n)
+    {
+      reserve(n);
+      for (size_type k = 0; k < N && n > size_; ++k) {
+        std::fill(component(k) + size_, component(k) + n, T(0));
+      }
+      size_ = n;
+    }
+
+  template<Number T, std::size_t N>
+    void
+    soa_batch<num_array<T, N>>::push_back(const value_type& x)
+    {
+      if (size_ == capacity()) reserve(std::max<size_type>(2 * size_, lane_block));
+      set(size_++, x);
+    }
+}
+
+namespace tb::math {
+
+  // Batched vector operations
+  //
+  // Each function applies the corresponding operation in vector.h to every
+  // vector of its argument batches (which must have the same size), using
+  // the pack<T> kernels in simd.h. Scalar results are returned as a
+  // dynamic_num_array<T, 1> and vector results as a soa_batch.
+
+  namespace detail {
+    template<typename... Batches>
+      void check_batch_sizes(const Batches&... x)
+      {
+        const std::size_t sizes[] = { x.size()... };
+        for (auto n : sizes) {
+          if (n != sizes[0]) throw std::invalid_argument("Incompatible batch sizes");
+        }
+      }
+  }
+
+  // Dot Product
+  template<Number T, std::size_t N>
+    [[nodiscard]] auto
+    dot_product(const soa_batch<num_array<T, N>>& v,
+                const soa_batch<num_array<T, N>>& w)
+    {
+      detail::check_batch_sizes(v, w);
+      dynamic_num_array<T, 1> result(v.size());
+      simd::for_each_pack<T>(v.size(), [&](std::size_t i, auto p) {
+        using P = decltype(p);
+        P sum = P::load(v.component(0) + i) * P::load(w.component(0) + i);
+        for (std::size_t k = 1; k < N; ++k) {
+          sum = sum + P::load(v.component(k) + i) * P::load(w.component(k) + i);
+        }
+        sum.store(result.data() + i);
+      });
+      return result;
+    }
+
+  // Cross Product
+  template<Number T>
+    [[nodiscard]] auto
+    cross_product(const soa_batch<num_array<T, 3>>& v,
+                  const soa_batch<num_array<T, 3>>& w)
+    {
+      detail::check_batch_sizes(v, w);
+      soa_batch<num_array<T, 3>> result(v.size());
+      simd::for_each_pack<T>(v.size(), [&](std::size_t i, auto p) {
+        using P = decltype(p);
+        const P v0 = P::load(v.component(0) + i), w0 = P::load(w.component(0) + i);
+        const P v1 = P::load(v.component(1) + i), w1 = P::load(w.component(1) + i);
+        const P v2 = P::load(v.component(2) + i), w2 = P::load(w.component(2) + i);
+        (v1 * w2 - v2 * w1).store(result.component(0) + i);
+        (v2 * w0 - v0 * w2).store(result.component(1) + i);
+        (v0 * w1 - v1 * w0).store(result.component(2) + i);
+      });
+      return result;
+    }
+
+  // Triple Product, u · (v × w)
+  template<Number T>
+    [[nodiscard]] auto
+    triple_product(const soa_batch<num_array<T, 3>>& u,
+                   const soa_batch<num_array<T, 3>>& v,
+                   const soa_batch<num_array<T, 3>>& w)
+    {
+      detail::check_batch_sizes(u, v, w);
+      dynamic_num_array<T, 1> result(u.size());
+      simd::for_each_pack<T>(u.size(), [&](std::size_t i, auto p) {
+        using P = decltype(p);
+        const P v0 = P::load(v.component(0) + i), w0 = P::load(w.component(0) + i);
+        const P v1 = P::load(v.component(1) + i), w1 = P::load(w.component(1) + i);
+        const P v2 = P::load(v.component(2) + i), w2 = P::load(w.component(2) + i);
+        const P x = P::load(u.component(0) + i) * (v1 * w2 - v2 * w1)
+                  + P::load(u.component(1) + i) * (v2 * w0 - v0 * w2)
+                  + P::load(u.component(2) + i) * (v0 * w1 - v1 * w0);
+        x.store(result.data() + i);
+      });
+      return result;
+    }
+
+  // Magnitude
+  template<std::floating_point T, std::size_t N>
+    [[nodiscard]] auto
+    magnitude(const soa_batch<num_array<T, N>>& v)
+    {
+      dynamic_num_array<T, 1> result(v.size());
+      simd::for_each_pack<T, true>(v.size(), [&](std::size_t i, auto p) {
+        using P = decltype(p);
+        P sum = P::load(v.component(0) + i) * P::load(v.component(0) + i);
+        for (std::size_t k = 1; k < N; ++k) {
+          const P x = P::load(v.component(k) + i);
+          sum = sum + x * x;
+        }
+        sqrt(sum).store(result.data() + i);
+      });
+      return result;
+    }
+
+  // Unit Vector
+  // NOTE: Division by zero when v = 0.
+  template<std::floating_point T, std::size_t N>
+    [[nodiscard]] auto
+    dir(const soa_batch<num_array<T, N>>& v)
+    {
+      soa_batch<num_array<T, N>> result(v.size());
+      simd::for_each_pack<T, true>(v.size(), [&](std::size_t i, auto p) {
+        using P = decltype(p);
+        P sum = P::load(v.component(0) + i) * P::load(v.component(0) + i);
+        for (std::size_t k = 1; k < N; ++k) {
+          const P x = P::load(v.component(k) + i);
+          sum = sum + x * x;
+        }
+        const P length = sqrt(sum);
+        for (std::size_t k = 0; k < N; ++k) {
+          (P::load(v.component(k) + i) / length).store(result.component(k) + i);
+        }
+      });
+      return result;
+    }
+
+  // Projection of w onto v
+  // NOTE: Division by zero when v = 0
+  template<std::floating_point T, std::size_t N>
+    [[nodiscard]] auto
+    projection(const soa_batch<num_array<T, N>>& v,
+               const soa_batch<num_array<T, N>>& w)
+    {
+      detail::check_batch_sizes(v, w);
+      soa_batch<num_array<T, N>> result(v.size());
+      simd::for_each_pack<T, true>(v.size(), [&](std::size_t i, auto p) {
+        using P = decltype(p);
+        P vw = T(0), vv = T(0);
+        for (std::size_t k = 0; k < N; ++k) {
+          const P x = P::load(v.component(k) + i);
+          vw = vw + x * P::load(w.component(k) + i);
+          vv = vv + x * x;
+        }
+        const P scale = vw / vv;
+        for (std::size_t k = 0; k < N; ++k) {
+          (P::load(v.component(k) + i) * scale).store(result.component(k) + i);
+        }
+      });
+      return result;
+    }
+}
+#endif//TB_MATH_NUM_ARRAY_SOA_BATCH_H
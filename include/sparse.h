@@ -0,0 +1,542 @@
+#ifndef TB_MATH_NUM_ARRAY_SPARSE_H
+#define TB_MATH_NUM_ARRAY_SPARSE_H
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include "dynamic_num_array.h"
+#include "matrix.h"
+#include "parallel.h"
+
+namespace tb::math {
+
+  template<Number T, std::unsigned_integral I = std::uint32_t> class coo_matrix;
+  template<Number T, std::unsigned_integral I = std::uint32_t> class csr_matrix;
+
+  // Sparse matrices
+  //
+  // Matrices of mostly zeros, which store only their non-zero elements:
+  //  - coo_matrix: in (row, column, value) triplets, in any order, for
+  //    building a matrix element by element.
+  //  - csr_matrix: in compressed sparse rows, the values and columns of each
+  //    row following those of the previous row, for computing.
+  // Either is built from the other, or from a dense num_array or
+  // dynamic_num_array (without its zeros). Rows and columns are indexed by
+  // I, which bounds the extents and the number of non-zeros: a
+  // std::length_error is thrown beyond it.
+  //
+  // matrix_vector_product() and matrix_product() (or operator*) multiply a
+  // sparse matrix by a dense vector or matrix, num_array or
+  // dynamic_num_array, into a dynamic_num_array, and with execution::par
+  // divide the rows among threads so that each has about the same number of
+  // non-zeros (see parallel.h).
+
+  template<Number T, std::unsigned_integral I>
+    class coo_matrix {
+    public:
+      using element_type = T;
+      using value_type   = T;
+      using size_type    = std::size_t;
+      using index_type   = I;
+
+      coo_matrix() : coo_matrix(0, 0) { }
+      coo_matrix(size_type m, size_type n);
+      template<Matrix_expression E>
+        explicit coo_matrix(const E& x) : coo_matrix(csr_matrix<T, I>(x)) { }
+      explicit coo_matrix(const dynamic_num_array<T, 2>& x) : coo_matrix(csr_matrix<T, I>(x)) { }
+      explicit coo_matrix(const csr_matrix<T, I>& x);
+
+      // Structure
+
+      size_type size() const noexcept { return extents_[0]; } // number of rows
+      static constexpr auto order() { return 2; }
+      size_type extent(std::size_t i) const { return extents_[i]; }
+      size_type non_zeros() const noexcept { return values_.size(); }
+
+      // Adds the element x at (i, j), to any already there. Throws
+      // std::out_of_range if (i, j) is not in the matrix.
+      void insert(size_type i, size_type j, const T& x);
+      void reserve(size_type n);
+
+      // The triplets, in the order of insertion
+      std::span<const I> rows()    const noexcept { return rows_; }
+      std::span<const I> columns() const noexcept { return columns_; }
+      std::span<const T> values()  const noexcept { return values_; }
+
+      // The dense matrix
+      dynamic_num_array<T, 2> dense() const;
+
+    private:
+      std::array<size_type, 2> extents_;
+      std::vector<I> rows_, columns_;
+      std::vector<T> values_;
+    };
+
+  template<Number T, std::unsigned_integral I>
+    class csr_matrix {
+    public:
+      using element_type = T;
+      using value_type   = T;
+      using size_type    = std::size_t;
+      using index_type   = I;
+
+      csr_matrix() : csr_matrix(0, 0) { }
+      csr_matrix(size_type m, size_type n); // of zeros
+      // Sums the elements at the same position.
+      explicit csr_matrix(const coo_matrix<T, I>& x);
+      template<Matrix_expression E>
+        explicit csr_matrix(const E& x);
+      explicit csr_matrix(const dynamic_num_array<T, 2>& x);
+
+      // Structure
+
+      size_type size() const noexcept { return extents_[0]; } // number of rows
+      static constexpr auto order() { return 2; }
+      size_type extent(std::size_t i) const { return extents_[i]; }
+      size_type non_zeros() const noexcept { return values_.size(); }
+
+      // Row i is made of the elements k in [row_offsets()[i],
+      // row_offsets()[i + 1]), with values()[k] in column columns()[k]. The
+      // columns of a row are in increasing order.
+      std::span<const I> row_offsets() const noexcept { return offsets_; }
+      std::span<const I> columns()     const noexcept { return columns_; }
+      std::span<const T> values()      const noexcept { return values_; }
+
+      // The element at (i, j), found by binary search in row i
+      T operator()(size_type i, size_type j) const;
+
+      // The dense matrix
+      dynamic_num_array<T, 2> dense() const;
+
+    private:
+      template<typename Row>
+        void append_row(const Row& row, size_type n);
+
+      std::array<size_type, 2> extents_;
+      std::vector<I> offsets_, columns_;
+      std::vector<T> values_;
+    };
+}
+
+namespace tb::math::detail {
+
+  // n as an index of type I, if it fits
+  template<std::unsigned_integral I>
+    I
+    sparse_index(std::size_t n)
+    {
+      if (n > std::numeric_limits<I>::max())
+        throw std::length_error("Sparse matrix too large for its index type");
+      return static_cast<I>(n);
+    }
+
+  // Sparse products with fewer non-zeros are done on the calling thread.
+  inline constexpr std::size_t parallel_sparse_threshold = 1 << 15;
+
+  // Boundaries of parts of the rows of a csr_matrix with about the same cost
+  // each, where a row costs its non-zeros and one more: the rows of part p
+  // are [rows[p], rows[p + 1]).
+  template<std::unsigned_integral I>
+    std::vector<std::size_t>
+    balanced_rows(std::span<const I> offsets, std::size_t parts)
+    {
+      const std::size_t m = offsets.size() - 1;
+      const std::size_t cost = offsets[m] + m;
+      std::vector<std::size_t> rows(parts + 1, m);
+      rows[0] = 0;
+      for (std::size_t p = 1; p < parts; ++p) {
+        const std::size_t target = cost * p / parts;
+        // The first row from which the cost of the rows before is target
+        std::size_t first = rows[p - 1], last = m;
+        while (first < last) {
+          const auto mid = first + (last - first) / 2;
+          if (offsets[mid] + mid < target) first = mid + 1;
+          else last = mid;
+        }
+        rows[p] = first;
+      }
+      return rows;
+    }
+
+  // The rows [first, last) of y = a * x, for a vector x
+  template<typename R, typename T, typename I, typename U>
+    void
+    sparse_vector_product(const csr_matrix<T, I>& a, const U* x, R* y,
+                          std::size_t first, std::size_t last)
+    {
+      const auto offsets = a.row_offsets();
+      const I* columns = a.columns().data();
+      const T* values = a.values().data();
+      for (std::size_t i = first; i < last; ++i) {
+        sum_t<accumulator_t<R>, R> sum = 0;
+        for (std::size_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+          sum += static_cast<R>(values[k]) * static_cast<R>(x[columns[k]]);
+        }
+        y[i] = sum;
+      }
+    }
+
+  // The rows [first, last) of c = a * b, for a dense matrix b of p columns
+  // whose rows are ldb apart. Each row of c is the sum of the rows of b
+  // scaled by the non-zeros of the row of a.
+  template<typename R, typename T, typename I, typename U>
+    void
+    sparse_matrix_product(const csr_matrix<T, I>& a, const U* b, std::size_t ldb,
+                          std::size_t p, R* c, std::size_t first, std::size_t last)
+    {
+      const auto offsets = a.row_offsets();
+      const I* columns = a.columns().data();
+      const T* values = a.values().data();
+      for (std::size_t i = first; i < last; ++i) {
+        R* row = c + i * p;
+        std::fill_n(row, p, R(0));
+        for (std::size_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+          const U* x = b + columns[k] * ldb;
+          if constexpr (std::same_as<R, U>) {
+            simd::axpy(static_cast<R>(values[k]), x, row, p);
+          } else {
+            const R v = values[k];
+            for (std::size_t j = 0; j < p; ++j) row[j] += v * static_cast<R>(x[j]);
+          }
+        }
+      }
+    }
+
+  // Calls f(first, last) for parts of the rows of a, on the threads of pool
+  // if a is large enough, or else on the calling thread.
+  template<typename T, typename I, typename F>
+    void
+    for_balanced_rows(thread_pool* pool, const csr_matrix<T, I>& a, F f)
+    {
+      if (!pool || pool->size() == 0 || a.non_zeros() < parallel_sparse_threshold) {
+        f(std::size_t(0), a.size());
+        return;
+      }
+      const auto rows = balanced_rows(a.row_offsets(), 4 * (pool->size() + 1));
+      pool->parallel_for(0, rows.size() - 1, 1, [&](std::size_t p, std::size_t q) {
+        for (; p < q; ++p) f(rows[p], rows[p + 1]);
+      });
+    }
+
+  // y = a * x, where x is a vector of a.extent(1) elements
+  template<typename R, typename T, typename I, typename U>
+    dynamic_num_array<R, 1>
+    sparse_vector_product(thread_pool* pool, const csr_matrix<T, I>& a,
+                          const U* x, std::size_t n)
+    {
+      if (n != a.extent(1)) throw std::invalid_argument("Incompatible extents");
+      dynamic_num_array<R, 1> y(a.size());
+      for_balanced_rows(pool, a, [&](std::size_t first, std::size_t last) {
+        sparse_vector_product(a, x, y.data(), first, last);
+      });
+      return y;
+    }
+
+  // c = a * b, where b is an n x p matrix whose rows are ldb apart
+  template<typename R, typename T, typename I, typename U>
+    dynamic_num_array<R, 2>
+    sparse_matrix_product(thread_pool* pool, const csr_matrix<T, I>& a,
+                          const U* b, std::size_t n, std::size_t ldb, std::size_t p)
+    {
+      if (n != a.extent(1)) throw std::invalid_argument("Incompatible extents");
+      dynamic_num_array<R, 2> c(a.size(), p);
+      for_balanced_rows(pool, a, [&](std::size_t first, std::size_t last) {
+        sparse_matrix_product(a, b, ldb, p, c.data(), first, last);
+      });
+      return c;
+    }
+
+  // y = a * x for a dense Vector_expression x, evaluated first unless it is
+  // a num_array
+  template<typename R, typename T, typename I, Vector_expression E>
+    auto
+    sparse_vector_product(thread_pool* pool, const csr_matrix<T, I>& a, const E& x)
+    {
+      if constexpr (is_num_array<E>::value) {
+        return sparse_vector_product<R>(pool, a, x.data(), E::size());
+      } else {
+        const auto y = eval(x);
+        return sparse_vector_product<R>(pool, a, y.data(), E::size());
+      }
+    }
+
+  // c = a * b for a dense Matrix_expression b, evaluated first unless its
+  // rows are stored contiguously
+  template<typename R, typename T, typename I, Matrix_expression E>
+    auto
+    sparse_matrix_product(thread_pool* pool, const csr_matrix<T, I>& a, const E& b)
+    {
+      constexpr auto n = E::extent(0), p = E::extent(1);
+      const auto [x, ldx] = row_major_storage(b);
+      if (x) return sparse_matrix_product<R>(pool, a, x, n, ldx, p);
+      const auto y = eval(b);
+      return sparse_matrix_product<R>(pool, a, y.data(), n, p, p);
+    }
+}
+
+namespace tb::math {
+
+  // coo_matrix
+
+  template<Number T, std::unsigned_integral I>
+    coo_matrix<T, I>::coo_matrix(size_type m, size_type n)
+      : extents_{ m, n }
+    {
+      detail::sparse_index<I>(m);
+      detail::sparse_index<I>(n);
+    }
+
+  template<Number T, std::unsigned_integral I>
+    coo_matrix<T, I>::coo_matrix(const csr_matrix<T, I>& x)
+      : extents_{ x.size(), x.extent(1) },
+        columns_(x.columns().begin(), x.columns().end()),
+        values_(x.values().begin(), x.values().end())
+    {
+      rows_.reserve(x.non_zeros());
+      const auto offsets = x.row_offsets();
+      for (size_type i = 0; i < x.size(); ++i) {
+        rows_.insert(rows_.end(), offsets[i + 1] - offsets[i], static_cast<I>(i));
+      }
+    }
+
+  template<Number T, std::unsigned_integral I>
+    void
+    coo_matrix<T, I>::insert(size_type i, size_type j, const T& x)
+    {
+      if (i >= size() || j >= extent(1)) throw std::out_of_range("Element out of range");
+      detail::sparse_index<I>(values_.size() + 1);
+      rows_.push_back(static_cast<I>(i));
+      columns_.push_back(static_cast<I>(j));
+      values_.push_back(x);
+    }
+
+  template<Number T, std::unsigned_integral I>
+    void
+    coo_matrix<T, I>::reserve(size_type n)
+    {
+      rows_.reserve(n);
+      columns_.reserve(n);
+      values_.reserve(n);
+    }
+
+  template<Number T, std::unsigned_integral I>
+    dynamic_num_array<T, 2>
+    coo_matrix<T, I>::dense() const
+    {
+      dynamic_num_array<T, 2> result(extents_, T(0));
+      for (size_type k = 0; k < non_zeros(); ++k) result(rows_[k], columns_[k]) += values_[k];
+      return result;
+    }
+
+  // csr_matrix
+
+  template<Number T, std::unsigned_integral I>
+    csr_matrix<T, I>::csr_matrix(size_type m, size_type n)
+      : extents_{ m, n }, offsets_(m + 1, I(0))
+    {
+      detail::sparse_index<I>(m);
+      detail::sparse_index<I>(n);
+    }
+
+  // The triplets are sorted by row (counting them), then by column within
+  // each row, and the elements at the same position summed.
+  template<Number T, std::unsigned_integral I>
+    csr_matrix<T, I>::csr_matrix(const coo_matrix<T, I>& x)
+      : csr_matrix(x.size(), x.extent(1))
+    {
+      const auto rows = x.rows(), columns = x.columns();
+      const auto values = x.values();
+      const size_type m = size(), nnz = x.non_zeros();
+
+      std::vector<I> start(m + 1, I(0)), order(nnz);
+      for (const I i : rows) ++start[i + 1];
+      std::partial_sum(start.begin(), start.end(), start.begin());
+      {
+        auto next = start;
+        for (size_type k = 0; k < nnz; ++k) order[next[rows[k]]++] = static_cast<I>(k);
+      }
+
+      columns_.reserve(nnz);
+      values_.reserve(nnz);
+      for (size_type i = 0; i < m; ++i) {
+        const auto first = order.begin() + start[i], last = order.begin() + start[i + 1];
+        std::stable_sort(first, last, [&](I a, I b) { return columns[a] < columns[b]; });
+        for (auto k = first; k != last; ++k) {
+          if (k != first && columns[*k] == columns_.back()) {
+            values_.back() += values[*k];
+          } else {
+            columns_.push_back(columns[*k]);
+            values_.push_back(values[*k]);
+          }
+        }
+        offsets_[i + 1] = static_cast<I>(values_.size());
+      }
+    }
+
+  template<Number T, std::unsigned_integral I>
+    template<Matrix_expression E>
+      csr_matrix<T, I>::csr_matrix(const E& x)
+        : csr_matrix(E::extent(0), E::extent(1))
+      {
+        for (size_type i = 0; i < size(); ++i) append_row(x[i], i);
+      }
+
+  template<Number T, std::unsigned_integral I>
+    csr_matrix<T, I>::csr_matrix(const dynamic_num_array<T, 2>& x)
+      : csr_matrix(x.size(), x.extent(1))
+    {
+      for (size_type i = 0; i < size(); ++i) append_row(x.data() + i * extent(1), i);
+    }
+
+  // Appends the non-zeros of row i of a dense matrix.
+  template<Number T, std::unsigned_integral I>
+    template<typename Row>
+      void
+      csr_matrix<T, I>::append_row(const Row& row, size_type i)
+      {
+        for (size_type j = 0; j < extent(1); ++j) {
+          const T x = row[j];
+          if (x != T(0)) {
+            columns_.push_back(static_cast<I>(j));
+            values_.push_back(x);
+          }
+        }
+        offsets_[i + 1] = detail::sparse_index<I>(values_.size());
+      }
+
+  template<Number T, std::unsigned_integral I>
+    T
+    csr_matrix<T, I>::operator()(size_type i, size_type j) const
+    {
+      const auto first = columns_.begin() + offsets_[i], last = columns_.begin() + offsets_[i + 1];
+      const auto k = std::lower_bound(first, last, j);
+      return k != last && *k == j ? values_[k - columns_.begin()] : T(0);
+    }
+
+  template<Number T, std::unsigned_integral I>
+    dynamic_num_array<T, 2>
+    csr_matrix<T, I>::dense() const
+    {
+      dynamic_num_array<T, 2> result(extents_, T(0));
+      for (size_type i = 0; i < size(); ++i) {
+        for (size_type k = offsets_[i]; k < offsets_[i + 1]; ++k) {
+          result(i, columns_[k]) = values_[k];
+        }
+      }
+      return result;
+    }
+
+  // Sparse matrix-vector product (SpMV)
+
+  template<Number T, std::unsigned_integral I, Vector_expression E,
+           Number R = std::common_type<T, detail::element_t<E>>::type>
+    [[nodiscard]] auto
+    matrix_vector_product(const csr_matrix<T, I>& lhs, const E& rhs)
+    {
+      return detail::sparse_vector_product<R>(nullptr, lhs, rhs);
+    }
+
+  template<Number T, std::unsigned_integral I, Number U,
+           Number R = std::common_type<T, U>::type>
+    [[nodiscard]] auto
+    matrix_vector_product(const csr_matrix<T, I>& lhs, const dynamic_num_array<U, 1>& rhs)
+    {
+      return detail::sparse_vector_product<R>(nullptr, lhs, rhs.data(), rhs.size());
+    }
+
+  template<Number T, std::unsigned_integral I, Vector_expression E,
+           Number R = std::common_type<T, detail::element_t<E>>::type>
+    [[nodiscard]] auto
+    matrix_vector_product(const execution::parallel_policy& policy,
+                          const csr_matrix<T, I>& lhs, const E& rhs)
+    {
+      return detail::sparse_vector_product<R>(&policy.get_pool(), lhs, rhs);
+    }
+
+  template<Number T, std::unsigned_integral I, Number U,
+           Number R = std::common_type<T, U>::type>
+    [[nodiscard]] auto
+    matrix_vector_product(const execution::parallel_policy& policy,
+                          const csr_matrix<T, I>& lhs, const dynamic_num_array<U, 1>& rhs)
+    {
+      return detail::sparse_vector_product<R>(&policy.get_pool(), lhs, rhs.data(), rhs.size());
+    }
+
+  // y = a * x from the triplets of a, which may be in any order
+  template<Number T, std::unsigned_integral I, typename V,
+           Number R = std::common_type<T, typename V::element_type>::type>
+    [[nodiscard]] auto
+    matrix_vector_product(const coo_matrix<T, I>& lhs, const V& rhs)
+      requires Vector_expression<V> || (is_dynamic_num_array<V>::value && V::order() == 1)
+    {
+      if (rhs.size() != lhs.extent(1)) throw std::invalid_argument("Incompatible extents");
+      const auto rows = lhs.rows(), columns = lhs.columns();
+      const auto values = lhs.values();
+      dynamic_num_array<R, 1> result({ lhs.size() }, R(0));
+      for (std::size_t k = 0; k < lhs.non_zeros(); ++k) {
+        result[rows[k]] += static_cast<R>(values[k]) * static_cast<R>(rhs[columns[k]]);
+      }
+      return result;
+    }
+
+  // Sparse-dense matrix product (SpMM)
+
+  template<Number T, std::unsigned_integral I, Matrix_expression E,
+           Number R = std::common_type<T, detail::element_t<E>>::type>
+    [[nodiscard]] auto
+    matrix_product(const csr_matrix<T, I>& lhs, const E& rhs)
+    {
+      return detail::sparse_matrix_product<R>(nullptr, lhs, rhs);
+    }
+
+  template<Number T, std::unsigned_integral I, Number U,
+           Number R = std::common_type<T, U>::type>
+    [[nodiscard]] auto
+    matrix_product(const csr_matrix<T, I>& lhs, const dynamic_num_array<U, 2>& rhs)
+    {
+      const auto n = rhs.size(), p = rhs.extent(1);
+      return detail::sparse_matrix_product<R>(nullptr, lhs, rhs.data(), n, p, p);
+    }
+
+  template<Number T, std::unsigned_integral I, Matrix_expression E,
+           Number R = std::common_type<T, detail::element_t<E>>::type>
+    [[nodiscard]] auto
+    matrix_product(const execution::parallel_policy& policy,
+                   const csr_matrix<T, I>& lhs, const E& rhs)
+    {
+      return detail::sparse_matrix_product<R>(&policy.get_pool(), lhs, rhs);
+    }
+
+  template<Number T, std::unsigned_integral I, Number U,
+           Number R = std::common_type<T, U>::type>
+    [[nodiscard]] auto
+    matrix_product(const execution::parallel_policy& policy,
+                   const csr_matrix<T, I>& lhs, const dynamic_num_array<U, 2>& rhs)
+    {
+      const auto n = rhs.size(), p = rhs.extent(1);
+      return detail::sparse_matrix_product<R>(&policy.get_pool(), lhs, rhs.data(), n, p, p);
+    }
+
+  // operator* for sparse products
+  template<Number T, std::unsigned_integral I, typename V>
+    [[nodiscard]] auto
+    operator*(const csr_matrix<T, I>& lhs, const V& rhs)
+      requires Vector_expression<V> || (is_dynamic_num_array<V>::value && V::order() == 1)
+    {
+      return matrix_vector_product(lhs, rhs);
+    }
+
+  template<Number T, std::unsigned_integral I, typename M>
+    [[nodiscard]] auto
+    operator*(const csr_matrix<T, I>& lhs, const M& rhs)
+      requires Matrix_expression<M> || (is_dynamic_num_array<M>::value && M::order() == 2)
+    {
+      return matrix_product(lhs, rhs);
+    }
+}
+#endif//TB_MATH_NUM_ARRAY_SPARSE_H
@@ -1,9 +1,17 @@
 #ifndef TB_MATH_NUM_ARRAY_STREAMING_H
 #define TB_MATH_NUM_ARRAY_STREAMING_H
 
+#include <charconv>
 #include <iostream>
+#include <string_view>
+#include <system_error>
+#include <version>
 #include "num_array.h"
 
+#ifdef __cpp_lib_format
+#include <format>
+#endif
+
 namespace tb::math {
   template<typename T, std::size_t M, std::size_t... N>
     std::ostream&
@@ -12,9 +20,189 @@ namespace tb::math {
       os << "{ ";
       for(std::size_t i = 0; i < M; ++i) {
         os << array[i] << (i < (M-1) ? ", " : "");
-      } 
+      }
 
       return os << " }";
     }
+
+  // Reads an array in the syntax written by operator<<, e.g. { { 1, 2 },
+  // { 3, 4 } }, in which whitespace is optional. The failbit of is is set if
+  // the input does not match the extents of array.
+  template<typename T, std::size_t M, std::size_t... N>
+    std::istream&
+    operator>>(std::istream& is, num_array<T, M, N...>& array)
+    {
+      const auto expect = [&is](char c) {
+        char x;
+        if (is >> x && x != c) is.setstate(std::ios::failbit);
+        return static_cast<bool>(is);
+      };
+      if (!expect('{')) return is;
+      for (std::size_t i = 0; i < M; ++i) {
+        if (!(is >> array[i]) || !expect(i < M - 1 ? ',' : '}')) return is;
+      }
+      return is;
+    }
+}
+
+namespace tb::math::detail {
+
+  inline const char*
+  skip_space(const char* first, const char* last) noexcept
+  {
+    while (first != last && (*first == ' ' || *first == '\t' || *first == '\n'
+                             || *first == '\r')) ++first;
+    return first;
+  }
+
+  inline std::to_chars_result
+  copy_chars(char* first, char* last, std::string_view s) noexcept
+  {
+    if (static_cast<std::size_t>(last - first) < s.size()) return { last, std::errc::value_too_large };
+    return { std::copy(s.begin(), s.end(), first), std::errc() };
+  }
+}
+
+namespace tb::math {
+
+  // Text Conversions
+  //
+  // to_chars() and from_chars() convert arrays of arithmetic types to and
+  // from the syntax of operator<< and operator>>, like std::to_chars() and
+  // std::from_chars(), which they use for the elements: nothing is allocated
+  // and no locale is consulted, so they are much faster than the stream
+  // operators. Floating point elements are written in the shortest form
+  // that reads back to the same value, so a round trip is exact.
+
+  // Writes x to [first, last). Returns the end of the characters written,
+  // or last and std::errc::value_too_large if they do not fit.
+  template<Array_expression E>
+    std::to_chars_result
+    to_chars(char* first, char* last, const E& x)
+      requires std::is_arithmetic_v<detail::element_t<E>>
+    {
+      auto r = detail::copy_chars(first, last, "{ ");
+      for (std::size_t i = 0; i < E::size() && r.ec == std::errc(); ++i) {
+        if (i > 0) r = detail::copy_chars(r.ptr, last, ", ");
+        if (r.ec != std::errc()) break;
+        if constexpr (E::order() == 1) r = std::to_chars(r.ptr, last, x[i]);
+        else r = to_chars(r.ptr, last, x[i]);
+      }
+      return r.ec == std::errc() ? detail::copy_chars(r.ptr, last, " }") : r;
+    }
+
+  // Reads x from [first, last), in which leading whitespace is skipped.
+  // Returns the end of the characters read; if they do not make an array
+  // with the extents of x, the position of the error and
+  // std::errc::invalid_argument (or std::errc::result_out_of_range if an
+  // element is out of the range of its type). x is then unspecified.
+  template<Number T, std::size_t M, std::size_t... N>
+    std::from_chars_result
+    from_chars(const char* first, const char* last, num_array<T, M, N...>& x)
+      requires std::is_arithmetic_v<T>
+    {
+      const auto expect = [last](const char* p, char c) -> std::from_chars_result {
+        p = detail::skip_space(p, last);
+        if (p == last || *p != c) return { p, std::errc::invalid_argument };
+        return { p + 1, std::errc() };
+      };
+      auto r = expect(first, '{');
+      for (std::size_t i = 0; i < M && r.ec == std::errc(); ++i) {
+        if (i > 0 && (r = expect(r.ptr, ',')).ec != std::errc()) break;
+        const auto p = detail::skip_space(r.ptr, last);
+        if constexpr (sizeof...(N) == 0) r = std::from_chars(p, last, x[i]);
+        else r = from_chars(p, last, x[i]);
+      }
+      return r.ec == std::errc() ? expect(r.ptr, '}') : r;
+    }
+
+  // Reads x from s, which must hold nothing else but whitespace.
+  // std::invalid_argument is thrown if it does not hold an array with the
+  // extents of x.
+  template<Number T, std::size_t M, std::size_t... N>
+    void
+    parse(std::string_view s, num_array<T, M, N...>& x)
+      requires std::is_arithmetic_v<T>
+    {
+      const auto last = s.data() + s.size();
+      const auto r = from_chars(s.data(), last, x);
+      if (r.ec != std::errc() || detail::skip_space(r.ptr, last) != last)
+        throw std::invalid_argument("Cannot parse num_array");
+    }
+}
+
+#ifdef __cpp_lib_format
+// Formats an array in the syntax of operator<<. A format specification
+// applies to each element, e.g. std::format("{:.3f}", x); without one, the
+// elements are written as by std::to_chars().
+template<tb::math::Array_expression E>
+  struct std::formatter<E, char> {
+    using T = tb::math::detail::element_t<E>;
+
+    constexpr auto parse(std::format_parse_context& ctx)
+    {
+      const auto it = ctx.begin();
+      default_ = it == ctx.end() || *it == '}';
+      return element_.parse(ctx);
+    }
+
+    template<typename Context>
+      auto format(const E& x, Context& ctx) const
+      {
+        return format_to(x, ctx.out(), ctx);
+      }
+
+  private:
+    template<typename A, typename Out, typename Context>
+      Out format_to(const A& x, Out out, Context& ctx) const
+      {
+        out = std::ranges::copy(std::string_view("{ "), out).out;
+        for (std::size_t i = 0; i < A::size(); ++i) {
+          if (i > 0) out = std::ranges::copy(std::string_view(", "), out).out;
+          if constexpr (A::order() > 1) out = format_to(x[i], out, ctx);
+          else out = format_element(T(x[i]), out, ctx);
+        }
+        return std::ranges::copy(std::string_view(" }"), out).out;
+      }
+
+    template<typename Out, typename Context>
+      Out format_element(const T& x, Out out, Context& ctx) const
+      {
+        if constexpr (std::is_arithmetic_v<T>) {
+          if (default_) {
+            char buffer[64];
+            const auto r = std::to_chars(buffer, buffer + sizeof(buffer), x);
+            return std::ranges::copy(buffer, r.ptr, out).out;
+          }
+        }
+        ctx.advance_to(out);
+        return element_.format(x, ctx);
+      }
+
+    std::formatter<T, char> element_;
+    bool default_ = true;
+  };
+
+#ifdef __cpp_lib_format_ranges
+// Arrays are ranges, which C++23 formats with a formatter of its own unless
+// their format_kind is disabled; that one would be ambiguous with the above.
+// (These specialize the kinds of Array_expression by their template, which 
+// a constrained specialization could not do more specifically than the
+// standard one for ranges.)
+namespace std {
+  template<tb::math::Number T, std::size_t M, std::size_t... N>
+    constexpr range_format format_kind<tb::math::num_array<T, M, N...>> =
+      range_format::disabled;
+  template<typename T, std::size_t M, std::size_t... N>
+    constexpr range_format format_kind<tb::math::num_array_view<T, M, N...>> =
+      range_format::disabled;
+  template<tb::math::Number T, typename Layout, std::size_t M, std::size_t... N>
+    constexpr range_format format_kind<tb::math::aligned_num_array<T, Layout, M, N...>> =
+      range_format::disabled;
+  template<typename Op, typename... Args>
+    constexpr range_format format_kind<tb::math::num_array_expr<Op, Args...>> =
+      range_format::disabled;
 }
-#endif//TB_MATH_NUM_ARRAY_STREAMING_H
\ No newline at end of file
+#endif
+#endif
+#endif//TB_MATH_NUM_ARRAY_STREAMING_H
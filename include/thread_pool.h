@@ -0,0 +1,225 @@
+#ifndef TB_MATH_NUM_ARRAY_THREAD_POOL_H
+#define TB_MATH_NUM_ARRAY_THREAD_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tb::math {
+
+  // A fixed set of worker threads that execute parallel_for() loops.
+  //
+  // Each worker owns a double-ended queue of tasks. A worker takes tasks from
+  // the back of its own queue and, when that is empty, steals from the front
+  // of the others'. parallel_for() splits its range in half recursively,
+  // pushing one half and keeping the other, until the pieces are no larger
+  // than the grain size; so idle workers steal the largest pending pieces and
+  // the load balances itself. The calling thread takes part in the loop and
+  // returns when every piece is done, which also makes nested loops safe.
+  class thread_pool {
+  public:
+    using size_type = std::size_t;
+
+    // A pool of n workers. The thread calling parallel_for() is an extra
+    // worker, so a pool of 0 threads runs loops on the calling thread only.
+    explicit thread_pool(size_type n = default_size());
+    ~thread_pool();
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    // The number of worker threads
+    size_type size() const noexcept { return workers_.size(); }
+
+    // Calls f(i, j) for disjoint sub-ranges [i, j) covering [first, last),
+    // none longer than grain (unless grain is 0, which selects about eight
+    // pieces per thread). The first exception thrown by f is rethrown after
+    // all pieces are done.
+    template<typename F>
+      void parallel_for(size_type first, size_type last, size_type grain, F f);
+
+    // The pool used by the library's parallel algorithms when none is given:
+    // one worker per hardware thread, less one for the calling thread.
+    static thread_pool& default_pool();
+
+    static size_type default_size() noexcept
+    {
+      const size_type n = std::thread::hardware_concurrency();
+      return n > 1 ? n - 1 : 0;
+    }
+
+  private:
+    using task = std::function<void()>;
+
+    struct task_queue {
+      std::mutex mutex;
+      std::deque<task> tasks;
+    };
+
+    void push(task t);
+    bool try_run();
+    bool try_pop(size_type k, task& t, bool steal);
+    void work(size_type k);
+
+    // The pool whose worker is running on this thread, if any, and the
+    // worker's index.
+    static inline thread_local const thread_pool* current_pool_ = nullptr;
+    static inline thread_local size_type current_worker_ = 0;
+
+    std::vector<std::unique_ptr<task_queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_type> pending_ = 0;   // tasks in the queues
+    std::atomic<size_type> next_queue_ = 0; // for tasks from other threads
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    bool stop_ = false;
+  };
+
+  inline
+  thread_pool::thread_pool(size_type n)
+  {
+    for (size_type k = 0; k < std::max<size_type>(n, 1); ++k) {
+      queues_.push_back(std::make_unique<task_queue>());
+    }
+    workers_.reserve(n);
+    for (size_type k = 0; k < n; ++k) workers_.emplace_back(&thread_pool::work, this, k);
+  }
+
+  inline
+  thread_pool::~thread_pool()
+  {
+    {
+      std::lock_guard lock(wake_mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) worker.join();
+  }
+
+  inline thread_pool&
+  thread_pool::default_pool()
+  {
+    static thread_pool pool;
+    return pool;
+  }
+
+  inline void
+  thread_pool::push(task t)
+  {
+    const auto k = current_pool_ == this
+      ? current_worker_ : next_queue_++ % queues_.size();
+    {
+      std::lock_guard lock(queues_[k]->mutex);
+      queues_[k]->tasks.push_back(std::move(t));
+    }
+    {
+      std::lock_guard lock(wake_mutex_);
+      ++pending_;
+    }
+    wake_.notify_one();
+  }
+
+  // Takes a task from the back of queue k, or from the front if stealing.
+  inline bool
+  thread_pool::try_pop(size_type k, task& t, bool steal)
+  {
+    std::lock_guard lock(queues_[k]->mutex);
+    auto& tasks = queues_[k]->tasks;
+    if (tasks.empty()) return false;
+    if (steal) {
+      t = std::move(tasks.front());
+      tasks.pop_front();
+    } else {
+      t = std::move(tasks.back());
+      tasks.pop_back();
+    }
+    --pending_;
+    return true;
+  }
+
+  // Runs one task from this thread's queue, or one stolen from another.
+  inline bool
+  thread_pool::try_run()
+  {
+    const auto n = queues_.size();
+    const bool worker = current_pool_ == this;
+    const auto k = worker ? current_worker_ : next_queue_.load() % n;
+    task t;
+    bool found = worker && try_pop(k, t, false);
+    for (size_type i = worker ? 1 : 0; !found && i < n; ++i) {
+      found = try_pop((k + i) % n, t, true);
+    }
+    if (found) t();
+    return found;
+  }
+
+  inline void
+  thread_pool::work(size_type k)
+  {
+    current_pool_ = this;
+    current_worker_ = k;
+    for (;;) {
+      if (try_run()) continue;
+      std::unique_lock lock(wake_mutex_);
+      wake_.wait(lock, [this]{ return stop_ || pending_ > 0; });
+      if (stop_) return;
+    }
+  }
+
+  template<typename F>
+    void
+    thread_pool::parallel_for(size_type first, size_type last, size_type grain, F f)
+    {
+      if (last <= first) return;
+      const auto n = last - first;
+      if (grain == 0) grain = std::max<size_type>(1, n / (8 * (size() + 1)));
+      if (n <= grain || size() == 0) {
+        for (; last - first > grain; first += grain) f(first, first + grain);
+        f(first, last);
+        return;
+      }
+
+      // Shared by the pieces of this loop, which all finish before it returns
+      std::atomic<size_type> remaining = n;
+      std::exception_ptr error;
+      std::mutex error_mutex;
+
+      std::function<void(size_type, size_type)> run = [&](size_type i, size_type j) {
+        while (j - i > grain) {
+          const auto mid = i + (j - i) / 2;
+          push([&run, mid, j]{ run(mid, j); });
+          j = mid;
+        }
+        try {
+          f(i, j);
+        } catch (...) {
+          std::lock_guard lock(error_mutex);
+          if (!error) error = std::current_exception();
+        }
+        remaining -= j - i;
+      };
+
+      run(first, last);
+      while (remaining > 0) {
+        if (!try_run()) std::this_thread::yield();
+      }
+      if (error) std::rethrow_exception(error);
+    }
+
+  // Calls f(i, j) for sub-ranges [i, j) of [first, last) on the default pool.
+  template<typename F>
+    void
+    parallel_for(std::size_t first, std::size_t last, std::size_t grain, F f)
+    {
+      thread_pool::default_pool().parallel_for(first, last, grain, std::move(f));
+    }
+}
+#endif//TB_MATH_NUM_ARRAY_THREAD_POOL_H
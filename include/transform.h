@@ -0,0 +1,358 @@
+#ifndef TB_MATH_NUM_ARRAY_TRANSFORM_H
+#define TB_MATH_NUM_ARRAY_TRANSFORM_H
+
+#include <cmath>
+#include <concepts>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include "matrix.h"
+#include "simd.h"
+#include "vector.h"
+
+// Rotations and affine transforms of three-dimensional space.
+//
+// Transforms are 4x4 matrices acting on column vectors: a point p is mapped
+// to the first three components of m * [p 1], and a direction v to those of
+// m * [v 0], so that the product a * b applies b first. Affine transforms
+// have a last row of [0 0 0 1]; rigid ones (a rotation, then a translation)
+// also have an orthonormal upper-left 3x3 block.
+namespace tb::math {
+
+  // Quaternion
+  // w + v, with a real part w and a vector part v. The unit quaternion
+  // cos(θ/2) + sin(θ/2) u is the rotation by an angle θ about a unit axis u.
+  template<std::floating_point T>
+    struct quaternion {
+      T w;
+      vec3<T> v;
+
+      constexpr bool operator==(const quaternion&) const = default;
+    };
+
+  using quatf = quaternion<float>;
+  using quatd = quaternion<double>;
+
+  // Hamilton product: the rotation q, then p
+  template<std::floating_point T>
+    [[nodiscard]] constexpr quaternion<T>
+    operator*(const quaternion<T>& p, const quaternion<T>& q)
+    {
+      return { p.w * q.w - dot_product(p.v, q.v),
+               p.w * q.v + q.w * p.v + cross_product(p.v, q.v) };
+    }
+
+  template<std::floating_point T>
+    [[nodiscard]] constexpr quaternion<T>
+    conjugate(const quaternion<T>& q)
+    {
+      return { q.w, -q.v };
+    }
+
+  template<std::floating_point T>
+    [[nodiscard]] T
+    magnitude(const quaternion<T>& q)
+    {
+      return std::sqrt(q.w * q.w + dot_product(q.v, q.v));
+    }
+
+  // NOTE: Division by zero when q = 0.
+  template<std::floating_point T>
+    [[nodiscard]] quaternion<T>
+    normalize(const quaternion<T>& q)
+    {
+      const T r = T(1) / magnitude(q);
+      return { q.w * r, q.v * r };
+    }
+
+  // The conjugate of a unit quaternion is its inverse, and cheaper.
+  template<std::floating_point T>
+    [[nodiscard]] constexpr quaternion<T>
+    inverse(const quaternion<T>& q)
+    {
+      const T r = T(1) / (q.w * q.w + dot_product(q.v, q.v));
+      return { q.w * r, q.v * -r };
+    }
+
+  // Axis-Angle Rotation
+  // The rotation by angle radians about a unit axis
+  template<std::floating_point T>
+    [[nodiscard]] quaternion<T>
+    axis_angle(const vec3<T>& axis, T angle)
+    {
+      return { std::cos(angle / 2), axis * std::sin(angle / 2) };
+    }
+
+  // Rotation of a vector by a unit quaternion, v + 2w (u × v) + 2u × (u × v)
+  template<std::floating_point T>
+    [[nodiscard]] constexpr vec3<T>
+    rotate(const quaternion<T>& q, const vec3<T>& v)
+    {
+      const vec3<T> t = cross_product(q.v, v) * T(2);
+      return v + q.w * t + cross_product(q.v, t);
+    }
+
+  // Rotation Matrix
+  // The 3x3 matrix of the rotation by a unit quaternion
+  template<std::floating_point T>
+    [[nodiscard]] constexpr mat3<T>
+    rotation_matrix(const quaternion<T>& q)
+    {
+      const T x = q.v[0], y = q.v[1], z = q.v[2], w = q.w;
+      return {{ 1 - 2 * (y * y + z * z), 2 * (x * y - w * z), 2 * (x * z + w * y) },
+              { 2 * (x * y + w * z), 1 - 2 * (x * x + z * z), 2 * (y * z - w * x) },
+              { 2 * (x * z - w * y), 2 * (y * z + w * x), 1 - 2 * (x * x + y * y) }};
+    }
+
+  // The unit quaternion of a rotation matrix (the upper-left 3x3 block of
+  // m), with a non-negative real part. The largest of |w|, |x|, |y| and |z|
+  // is found from the diagonal first, so that the others are computed by
+  // dividing by it (Shepperd's method).
+  template<Matrix_expression E>
+    [[nodiscard]] auto
+    to_quaternion(const E& m)
+      requires (E::extent(0) == E::extent(1) && E::extent(0) >= 3)
+    {
+      using T = detail::floating_t<detail::element_t<E>>;
+      const T m00 = m(0, 0), m11 = m(1, 1), m22 = m(2, 2);
+      quaternion<T> q;
+      if (m00 + m11 + m22 > 0) {
+        const T s = 2 * std::sqrt(1 + m00 + m11 + m22);
+        q = { s / 4, { (m(2, 1) - m(1, 2)) / s, (m(0, 2) - m(2, 0)) / s,
+                       (m(1, 0) - m(0, 1)) / s } };
+      } else if (m00 > m11 && m00 > m22) {
+        const T s = 2 * std::sqrt(1 + m00 - m11 - m22);
+        q = { (m(2, 1) - m(1, 2)) / s, { s / 4, (m(0, 1) + m(1, 0)) / s,
+                                         (m(0, 2) + m(2, 0)) / s } };
+      } else if (m11 > m22) {
+        const T s = 2 * std::sqrt(1 + m11 - m00 - m22);
+        q = { (m(0, 2) - m(2, 0)) / s, { (m(0, 1) + m(1, 0)) / s, s / 4,
+                                         (m(1, 2) + m(2, 1)) / s } };
+      } else {
+        const T s = 2 * std::sqrt(1 + m22 - m00 - m11);
+        q = { (m(1, 0) - m(0, 1)) / s, { (m(0, 2) + m(2, 0)) / s,
+                                         (m(1, 2) + m(2, 1)) / s, s / 4 } };
+      }
+      return q.w < 0 ? quaternion<T>{ -q.w, -q.v } : q;
+    }
+
+  // Spherical Linear Interpolation
+  // The rotation a fraction t of the way from p to q (unit quaternions),
+  // along the shorter arc, at a constant angular speed.
+  template<std::floating_point T>
+    [[nodiscard]] quaternion<T>
+    slerp(const quaternion<T>& p, const quaternion<T>& q, T t)
+    {
+      T d = p.w * q.w + dot_product(p.v, q.v);
+      const T sign = d < 0 ? T(-1) : T(1);
+      d *= sign;
+      T a = 1 - t, b = t * sign;
+      // NOTE: Nearly equal rotations are interpolated linearly, where
+      // sin(θ) would lose all precision.
+      if (d < T(0.9995)) {
+        const T theta = std::acos(d), r = T(1) / std::sin(theta);
+        a = std::sin(a * theta) * r;
+        b = std::sin(t * theta) * r * sign;
+      }
+      return normalize(quaternion<T>{ a * p.w + b * q.w, a * p.v + b * q.v });
+    }
+}
+
+namespace tb::math {
+
+  // Translation by t
+  template<Number T>
+    [[nodiscard]] constexpr mat4<T>
+    translation(const vec3<T>& t)
+    {
+      return {{ 1, 0, 0, t[0] }, { 0, 1, 0, t[1] }, { 0, 0, 1, t[2] }, { 0, 0, 0, 1 }};
+    }
+
+  // Scaling by s[i] along axis i
+  template<Number T>
+    [[nodiscard]] constexpr mat4<T>
+    scaling(const vec3<T>& s)
+    {
+      return {{ s[0], 0, 0, 0 }, { 0, s[1], 0, 0 }, { 0, 0, s[2], 0 }, { 0, 0, 0, 1 }};
+    }
+
+  // Affine Transform
+  // x -> a * x + t, for a 3x3 matrix a
+  template<Number T>
+    [[nodiscard]] constexpr mat4<T>
+    affine(const mat3<T>& a, const vec3<T>& t)
+    {
+      mat4<T> m(T(0));
+      for (std::size_t i = 0; i < 3; ++i) {
+        for (std::size_t j = 0; j < 3; ++j) m(i, j) = a(i, j);
+        m(i, 3) = t[i];
+      }
+      m(3, 3) = 1;
+      return m;
+    }
+
+  // The rigid transform x -> q x + t: the rotation by a unit quaternion q,
+  // then a translation by t
+  template<std::floating_point T>
+    [[nodiscard]] constexpr mat4<T>
+    affine(const quaternion<T>& q, const vec3<T>& t)
+    {
+      return affine(rotation_matrix(q), t);
+    }
+
+  // Composition
+  // The transform that applies the last argument first, then each one
+  // before it: a * b * ...
+  template<Number T, std::same_as<mat4<T>>... M>
+    [[nodiscard]] constexpr mat4<T>
+    compose(const mat4<T>& a, const M&... b)
+    {
+      mat4<T> result = a;
+      ((result = matrix_product(result, b)), ...);
+      return result;
+    }
+
+  // Inverse of an affine transform, x -> a⁻¹ (x - t)
+  // Only the 3x3 block a is inverted (as in inverse()).
+  // NOTE: The inverse of a singular a has non-finite elements.
+  template<Number T>
+    [[nodiscard]] constexpr auto
+    inverse_affine(const mat4<T>& m)
+    {
+      mat3<T> a;
+      for (std::size_t i = 0; i < 3; ++i)
+        for (std::size_t j = 0; j < 3; ++j) a(i, j) = m(i, j);
+      const auto b = inverse(a);
+      using R = detail::floating_t<T>;
+      const vec3<R> t = { R(m(0, 3)), R(m(1, 3)), R(m(2, 3)) };
+      return affine(b, vec3<R>(-(b * t)));
+    }
+
+  // Inverse of a rigid transform, x -> aᵀ (x - t)
+  // The inverse of the rotation a is its transpose, so nothing is divided.
+  // NOTE: The result is only the inverse of m if m is rigid.
+  template<Number T>
+    [[nodiscard]] constexpr mat4<T>
+    inverse_rigid(const mat4<T>& m)
+    {
+      mat4<T> result(T(0));
+      for (std::size_t i = 0; i < 3; ++i) {
+        for (std::size_t j = 0; j < 3; ++j) result(i, j) = m(j, i);
+        result(i, 3) = -(m(0, i) * m(0, 3) + m(1, i) * m(1, 3) + m(2, i) * m(2, 3));
+      }
+      result(3, 3) = 1;
+      return result;
+    }
+
+  // Normal Matrix
+  // The matrix that transforms the normals of surfaces transformed by m:
+  // the inverse transpose of its upper-left 3x3 block. For a rigid m, this
+  // is the block itself.
+  template<Number T>
+    [[nodiscard]] constexpr auto
+    normal_matrix(const mat4<T>& m)
+    {
+      mat3<T> a;
+      for (std::size_t i = 0; i < 3; ++i)
+        for (std::size_t j = 0; j < 3; ++j) a(i, j) = m(i, j);
+      return transpose(inverse(a));
+    }
+
+  // The image of a point p, and of a direction v, under an affine transform
+  template<Number T>
+    [[nodiscard]] constexpr vec3<T>
+    transform_point(const mat4<T>& m, const vec3<T>& p)
+    {
+      vec3<T> result;
+      for (std::size_t i = 0; i < 3; ++i) {
+        result[i] = m(i, 0) * p[0] + m(i, 1) * p[1] + m(i, 2) * p[2] + m(i, 3);
+      }
+      return result;
+    }
+
+  template<Number T>
+    [[nodiscard]] constexpr vec3<T>
+    transform_vector(const mat4<T>& m, const vec3<T>& v)
+    {
+      vec3<T> result;
+      for (std::size_t i = 0; i < 3; ++i) {
+        result[i] = m(i, 0) * v[0] + m(i, 1) * v[1] + m(i, 2) * v[2];
+      }
+      return result;
+    }
+}
+
+namespace tb::math::detail {
+
+  // y[i] = a * x[i] + t for arrays of vec3s, with the kernel of simd.h,
+  // where m = [a t] is given by rows.
+  template<Number T>
+    void
+    affine_transform(const num_array<T, 3, 4>& m, std::span<const vec3<T>> x,
+                     std::span<vec3<T>> y)
+    {
+      static_assert(sizeof(vec3<T>) == 3 * sizeof(T));
+      if (x.size() != y.size()) throw std::invalid_argument("Incompatible batch sizes");
+      if (x.empty()) return;
+      simd::affine_transform_3(m.data(), x.data()->data(), x.size(), y.data()->data());
+    }
+
+  // The rows of [a t] for the affine part of m, with t = 0 for directions
+  template<Number T, std::size_t N>
+    constexpr num_array<T, 3, 4>
+    affine_rows(const num_array<T, N, N>& m, bool translate)
+    {
+      num_array<T, 3, 4> result(T(0));
+      for (std::size_t i = 0; i < 3; ++i) {
+        for (std::size_t j = 0; j < 3; ++j) result(i, j) = m(i, j);
+        if constexpr (N == 4) result(i, 3) = translate ? m(i, 3) : T(0);
+      }
+      return result;
+    }
+}
+
+namespace tb::math {
+
+  // Batched Transforms
+  // y[i] = transform_point(m, x[i]) (or transform_vector()) for arrays of
+  // vec3s, of the same size, or in place. For float, groups of 4, 8 or 16
+  // vectors (with SSE2, AVX or AVX-512F) are transformed at once, with their
+  // x, y and z components in separate registers.
+  // NOTE: To transform by a matrix that is not affine (a projection), use
+  // batch_transform() of batch.h on vec4s.
+  template<Number T>
+    void
+    transform_points(const mat4<T>& m, std::span<const vec3<std::type_identity_t<T>>> x,
+                     std::span<vec3<std::type_identity_t<T>>> y)
+    {
+      detail::affine_transform(detail::affine_rows(m, true), x, y);
+    }
+
+  template<Number T>
+    void
+    transform_points(const mat4<T>& m, std::span<vec3<std::type_identity_t<T>>> x)
+    {
+      detail::affine_transform<T>(detail::affine_rows(m, true), x, x);
+    }
+
+  // Directions are transformed by the 3x3 block of m (or by m itself, e.g.
+  // a normal_matrix()), without the translation.
+  template<Number T, std::size_t N>
+    void
+    transform_vectors(const num_array<T, N, N>& m,
+                      std::span<const vec3<std::type_identity_t<T>>> x,
+                      std::span<vec3<std::type_identity_t<T>>> y)
+      requires (N == 3 || N == 4)
+    {
+      detail::affine_transform(detail::affine_rows(m, false), x, y);
+    }
+
+  template<Number T, std::size_t N>
+    void
+    transform_vectors(const num_array<T, N, N>& m, std::span<vec3<std::type_identity_t<T>>> x)
+      requires (N == 3 || N == 4)
+    {
+      detail::affine_transform<T>(detail::affine_rows(m, false), x, x);
+    }
+}
+#endif//TB_MATH_NUM_ARRAY_TRANSFORM_H
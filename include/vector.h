@@ -45,14 +45,18 @@ namespace tb::math {
   // Outer Product
   // Returns a num_array (matrix) that is the outer product of two 
   // num_array (vectors).
-  template<Number T1, Number T2, std::size_t N1, std::size_t N2>
+  template<Vector_expression E1, Vector_expression E2>
     [[nodiscard]] constexpr auto
-    outer_product(const num_array<T1, N1>& v, const num_array<T2, N2>& w)
-      requires std::common_with<T1, T2>
+    outer_product(const E1& v, const E2& w)
+      requires std::common_with<detail::element_t<E1>, detail::element_t<E2>>
     {
-      using R = typename std::common_type<T1, T2>::type;
-      num_array<R, N1, N2> result;
-      for (std::size_t m = 0; m < N1; ++m) {
+      using T2 = detail::element_t<E2>;
+      using R = typename std::common_type<detail::element_t<E1>, T2>::type;
+      constexpr auto M = E1::size(), N = E2::size();
+      const detail::counted_scope scope(instrument::operation::outer_product,
+        detail::operation_cost<R, E1, E2>(M * N, M * N));
+      num_array<R, M, N> result;
+      for (std::size_t m = 0; m < M; ++m) {
         result[m] = w * static_cast<T2>(v[m]);
       }
       return result;
@@ -60,24 +64,46 @@ namespace tb::math {
 
   // Dot Product
   // Returns the dot(scalar) product of two vectors
-  template<Number T1, Number T2, std::size_t N>
+  // NOTE: The products are summed in the accumulator type of the elements
+  // (float for the 16-bit floats of half.h, int32 for 8- and 16-bit
+  // integers, with the kernels of simd.h), which is also the result type.
+  template<Vector_expression E1, Vector_expression E2>
     [[nodiscard]] constexpr auto
-    dot_product(const num_array<T1, N>& v, const num_array<T2, N>& w)
+    dot_product(const E1& v, const E2& w)
+      requires detail::Same_shape<E1, E2>
     {
-      typename std::common_type<T1, T2>::type result{0};
-      for (std::size_t i = 0; i < N; ++i) {
-        result += w[i] * v[i];
+      using T1 = detail::element_t<E1>;
+      using T2 = detail::element_t<E2>;
+      using R = detail::accumulator_t<std::common_type_t<T1, T2>>;
+      const detail::counted_scope scope(instrument::operation::dot_product,
+        detail::operation_cost<R, E1, E2>(1, 2 * E1::size()));
+      detail::sum_t<R, T1, T2> result{0};
+      if constexpr (detail::Small<E1>) {
+        detail::unroll<E1::size()>([&](auto i) { result += w[i] * v[i]; });
+      } else if constexpr (is_num_array<E1>::value && is_num_array<E2>::value
+                           && simd::Small_integer<T1> && simd::Small_integer<T2>) {
+        if (!std::is_constant_evaluated()) return simd::integer_dot(v.data(), w.data(), E1::size());
+        for (std::size_t i = 0; i < E1::size(); ++i) result += w[i] * v[i];
+      } else {
+        for (std::size_t i = 0; i < E1::size(); ++i) {
+          result += w[i] * v[i];
+        }
       }
-      return result;    
+      return R(result);
     }
 
   // Cross Product
   // Returns the value of the cross product, v × w, between two three-dimensional 
   // vectors.
-  template<Number T1, Number T2, Number R = std::common_type<T1, T2>::type> 
+  template<Vector_expression E1, Vector_expression E2, 
+           Number R = std::common_type<detail::element_t<E1>, 
+                                       detail::element_t<E2>>::type> 
     [[nodiscard]] constexpr num_array<R, 3>
-    cross_product(const num_array<T1, 3>& v, const num_array<T2, 3>& w)
+    cross_product(const E1& v, const E2& w)
+      requires (E1::size() == 3 && E2::size() == 3)
     {
+      const detail::counted_scope scope(instrument::operation::cross_product,
+        detail::operation_cost<R, E1, E2>(3, 9));
       return { v[1] * w[2] - v[2] * w[1], 
                v[2] * w[0] - v[0] * w[2], 
                v[0] * w[1] - v[1] * w[0] };
@@ -86,19 +112,19 @@ namespace tb::math {
   // Triple Product
   // Returns the value of the scalar triple product, u · (v × w), where u, v and 
   // w are three-dimensional vectors.
-  template<Number T1, Number T2, Number T3> 
+  template<Vector_expression E1, Vector_expression E2, Vector_expression E3> 
     [[nodiscard]] constexpr auto
-    triple_product(const num_array<T1, 3>& u, const num_array<T2, 3>& v, 
-                   const num_array<T3, 3>& w)
+    triple_product(const E1& u, const E2& v, const E3& w)
+      requires (E1::size() == 3 && E2::size() == 3 && E3::size() == 3)
     {
       return dot_product(u, cross_product(v, w));
     }
 
   // Magnitude
   // Returns the magnitude of a vector
-  template<Number T, std::size_t N>
+  template<Vector_expression E>
     [[nodiscard]] constexpr auto
-    magnitude(const num_array<T, N>& v)
+    magnitude(const E& v)
     {
       return std::sqrt(dot_product(v, v)); // NOTE: std::sqrt is not constexpr
     }
@@ -106,21 +132,22 @@ namespace tb::math {
   // Unit Vector
   // Returns the unit vector (normalization) of a vector.
   // NOTE: Division by zero when v = 0.
-  template<Number T, std::size_t N>
+  template<Vector_expression E>
     [[nodiscard]] constexpr auto
-    dir(const num_array<T, N>& v)
+    dir(const E& v)
     {
-      return v / magnitude(v); // NOTE: magnitude() is not constexpr
+      return eval(v / magnitude(v)); // NOTE: magnitude() is not constexpr
     }
 
   // Projection
   // Returns the projection of w onto v.
   // NOTE: Division by zero when v = 0
-  template<Number T1, Number T2, std::size_t N>
+  template<Vector_expression E1, Vector_expression E2>
     [[nodiscard]] constexpr auto
-    projection(const num_array<T1, N>& v, const num_array<T2, N>& w)
+    projection(const E1& v, const E2& w)
+      requires detail::Same_shape<E1, E2>
     {
-      return v * (dot_product(v, w) / dot_product(v, v));
+      return eval(v * (dot_product(v, w) / dot_product(v, v)));
     }
 }
-#endif//TB_MATH_NUM_ARRAY_VECTOR_H
\ No newline at end of file
+#endif//TB_MATH_NUM_ARRAY_VECTOR_H
@@ -0,0 +1,341 @@
+#ifndef TB_MATH_NUM_ARRAY_VIEW_H
+#define TB_MATH_NUM_ARRAY_VIEW_H
+
+#include <array>
+#include <cstddef>
+#include "num_array.h"
+
+namespace tb::math::detail {
+
+  // Returns a pointer to the first element of a one-dimensional x.
+  template<typename A>
+    constexpr auto
+    first_element(A& x) noexcept requires (A::order() == 1)
+    { return x.begin(); }
+
+  // Returns a pointer to all the elements of a num_array x: data(), or in 
+  // constant evaluation, where that cannot be used (see num_array::data()),
+  // the first element of its first row.
+  template<typename A>
+    constexpr auto
+    all_elements(A& x) noexcept
+    {
+      if constexpr (A::order() == 1) return x.begin();
+      else if (std::is_constant_evaluated()) return all_elements(*x.begin());
+      else return x.data();
+    }
+
+  // The strides of a num_array<T, M, N...>, whose elements are stored 
+  // contiguously in row-major order.
+  template<typename D, std::size_t M, std::size_t... N>
+    constexpr auto
+    row_major_strides() noexcept
+    {
+      constexpr std::size_t extents[] = { M, N... };
+      std::array<D, sizeof...(N) + 1> strides;
+      strides.back() = 1;
+      for (std::size_t k = sizeof...(N); k > 0; --k) {
+        strides[k - 1] = strides[k] * static_cast<D>(extents[k]);
+      }
+      return strides;
+    }
+}
+
+namespace tb::math {
+
+  // A num_array_view refers to elements of a num_array (or of another view)
+  // that are laid out with a constant stride in each dimension, such as a
+  // column, a diagonal, a sub-matrix or the transpose of a matrix. Nothing is
+  // copied: reading from a view reads the underlying array and assigning to a
+  // view writes to it. A view of const T is read-only.
+  //
+  // Views are Array_expressions, so they can be used wherever a num_array is
+  // accepted by the operations in num_array.h, vector.h and matrix.h.
+  //
+  // NOTE: Like an expression, a view must not outlive the array it refers to.
+  // Assigning to a view from an expression that reads overlapping elements in
+  // a different order (e.g. an in-place transpose) is undefined.
+  template<typename T, std::size_t M, std::size_t... N>
+    class num_array_view
+      : public num_array_base<std::remove_const_t<T>, M, N...> {
+    public:
+      using element_type    = std::remove_const_t<T>;
+      using value_type      = element_type;
+      using size_type       = std::size_t;
+      using difference_type = std::ptrdiff_t;
+      using pointer         = T*;
+      using reference       = T&;
+      using strides_type    = std::array<difference_type, sizeof...(N) + 1>;
+
+      // A view of the elements data[i * strides[0] + j * strides[1] + ...]
+      constexpr num_array_view(pointer data, const strides_type& strides) noexcept
+        : data_(data), strides_(strides) { }
+
+      // A view of the whole of x
+      constexpr num_array_view(num_array<element_type, M, N...>& x) noexcept
+        requires (!std::is_const_v<T>);
+      constexpr num_array_view(const num_array<element_type, M, N...>& x) noexcept
+        requires std::is_const_v<T>;
+
+      // Conversion of a view to a read-only view
+      constexpr num_array_view(const num_array_view<element_type, M, N...>& x) noexcept
+        requires std::is_const_v<T>
+        : data_(x.data()), strides_(x.strides()) { }
+
+      constexpr num_array_view(const num_array_view&) = default;
+
+      // Assignment copies elements into the viewed array
+      constexpr num_array_view& operator=(const num_array_view& x)
+        requires (!std::is_const_v<T>)
+      { return assign(x, [](T& y, const auto& z){ y = z; }); }
+      template<detail::Conforming_expression<std::index_sequence<M, N...>> E>
+        constexpr num_array_view& operator=(const E& x)
+          requires (!std::is_const_v<T>)
+        { return assign(x, [](T& y, const auto& z){ y = z; }); }
+      template<Number U>
+        constexpr num_array_view& operator=(const num_array<U, M, N...>& x)
+          requires (!std::is_const_v<T>)
+        { return assign(x, [](T& y, const auto& z){ y = z; }); }
+      constexpr num_array_view& operator=(const element_type& x)
+        requires (!std::is_const_v<T>)
+      { return assign(x, [](T& y, const auto& z){ y = z; }); }
+
+      // Returns the i-th element of a one-dimensional view, or a view of the
+      // i-th "row" otherwise.
+      constexpr decltype(auto) operator[](size_type i) const noexcept;
+
+      template<Index_type Index, Index_type... Indices>
+        constexpr reference operator()(Index i, Indices... j) const noexcept
+          requires (sizeof...(Indices) == sizeof...(N))
+        { return data_[offset(i, j...)]; }
+
+      template<Index_type Index, Index_type... Indices>
+        constexpr reference at(Index i, Indices... j) const
+          requires (sizeof...(Indices) == sizeof...(N))
+        { assert(i < this->size()); return (*this)[i](j...); }
+
+      constexpr pointer data() const noexcept { return data_; }
+      constexpr difference_type stride(std::size_t i) const { return strides_[i]; }
+      constexpr const strides_type& strides() const noexcept { return strides_; }
+
+      // Arithmetic operations
+
+      constexpr auto& operator+=(const element_type& rhs)
+      { return assign(rhs, [](T& x, const auto& y){ x += y; }); }
+      constexpr auto& operator-=(const element_type& rhs)
+      { return assign(rhs, [](T& x, const auto& y){ x -= y; }); }
+      constexpr auto& operator*=(const element_type& rhs)
+      { return assign(rhs, [](T& x, const auto& y){ x *= y; }); }
+      constexpr auto& operator/=(const element_type& rhs)
+      { return assign(rhs, [](T& x, const auto& y){ x /= y; }); }
+
+      template<Array_expression E>
+        constexpr auto& operator+=(const E& rhs)
+          requires std::same_as<detail::shape_t<E>, std::index_sequence<M, N...>>
+        { return assign(rhs, [](T& x, const auto& y){ x += y; }); }
+      template<Array_expression E>
+        constexpr auto& operator-=(const E& rhs)
+          requires std::same_as<detail::shape_t<E>, std::index_sequence<M, N...>>
+        { return assign(rhs, [](T& x, const auto& y){ x -= y; }); }
+      template<Array_expression E>
+        constexpr auto& operator*=(const E& rhs)
+          requires std::same_as<detail::shape_t<E>, std::index_sequence<M, N...>>
+        { return assign(rhs, [](T& x, const auto& y){ x *= y; }); }
+      template<Array_expression E>
+        constexpr auto& operator/=(const E& rhs)
+          requires std::same_as<detail::shape_t<E>, std::index_sequence<M, N...>>
+        { return assign(rhs, [](T& x, const auto& y){ x /= y; }); }
+
+    private:
+      template<typename... Indices>
+        constexpr difference_type offset(Indices... i) const noexcept
+        {
+          difference_type result = 0, k = 0;
+          ((result += static_cast<difference_type>(i) * strides_[k++]), ...);
+          return result;
+        }
+
+      template<typename, std::size_t, std::size_t...> 
+        friend class num_array_view;
+
+      // Applies func(y, x') to each element y of the view, where x' is the
+      // corresponding element of x (or x itself if x is a scalar).
+      constexpr num_array_view& assign(const auto& x, auto func);
+
+      pointer data_;
+      strides_type strides_;
+    };
+
+  template<typename T, std::size_t M, std::size_t... N>
+    constexpr
+    num_array_view<T, M, N...>::num_array_view(
+      num_array<element_type, M, N...>& x) noexcept
+        requires (!std::is_const_v<T>)
+      : data_(detail::all_elements(x)),
+        strides_(detail::row_major_strides<difference_type, M, N...>())
+    { }
+
+  template<typename T, std::size_t M, std::size_t... N>
+    constexpr
+    num_array_view<T, M, N...>::num_array_view(
+      const num_array<element_type, M, N...>& x) noexcept
+        requires std::is_const_v<T>
+      : data_(detail::all_elements(x)),
+        strides_(detail::row_major_strides<difference_type, M, N...>())
+    { }
+
+  template<typename T, std::size_t M, std::size_t... N>
+    constexpr decltype(auto)
+    num_array_view<T, M, N...>::operator[](size_type i) const noexcept
+    {
+      if constexpr (sizeof...(N) == 0) {
+        return data_[static_cast<difference_type>(i) * strides_[0]];
+      } else {
+        typename num_array_view<T, N...>::strides_type sub_strides;
+        std::copy(strides_.begin() + 1, strides_.end(), sub_strides.begin());
+        return num_array_view<T, N...>(
+          data_ + static_cast<difference_type>(i) * strides_[0], sub_strides);
+      }
+    }
+
+  template<typename T, std::size_t M, std::size_t... N>
+    constexpr num_array_view<T, M, N...>&
+    num_array_view<T, M, N...>::assign(const auto& x, auto func)
+    {
+      for (size_type i = 0; i < M; ++i) {
+        if constexpr (sizeof...(N) == 0) {
+          func((*this)[i], detail::subscript(x, i));
+        } else {
+          (*this)[i].assign(detail::subscript(x, i), func);
+        }
+      }
+      return *this;
+    }
+}
+
+namespace tb::math::detail {
+
+  template<Number T, std::size_t M, std::size_t... N>
+    constexpr auto
+    as_view(num_array<T, M, N...>& x) noexcept
+    {
+      return num_array_view<T, M, N...>(x);
+    }
+
+  template<Number T, std::size_t M, std::size_t... N>
+    constexpr auto
+    as_view(const num_array<T, M, N...>& x) noexcept
+    {
+      return num_array_view<const T, M, N...>(x);
+    }
+
+  template<typename T, std::size_t M, std::size_t... N>
+    constexpr auto
+    as_view(const num_array_view<T, M, N...>& x) noexcept
+    {
+      return x;
+    }
+
+  // An aligned_num_array (see aligned.h) is viewed with its padding skipped.
+  template<typename A>
+    constexpr auto
+    as_view(A& x) noexcept
+      requires is_aligned_num_array<std::remove_const_t<A>>::value
+    {
+      return x.view();
+    }
+}
+
+namespace tb::math {
+
+  // Views of parts of a matrix (or higher order array)
+  //
+  // The functions below accept a num_array lvalue, or a view, and return a
+  // view of the requested elements.
+
+  // A Viewable is an lvalue num_array (or aligned_num_array) or a 
+  // num_array_view.
+  template<typename A>
+    concept Viewable =
+      is_num_array_view<std::remove_cvref_t<A>>::value ||
+      ((is_num_array<std::remove_cvref_t<A>>::value ||
+        is_aligned_num_array<std::remove_cvref_t<A>>::value) && 
+       std::is_lvalue_reference_v<A>);
+
+  // Returns a view of all of x.
+  template<Viewable A>
+    [[nodiscard]] constexpr auto
+    view(A&& x) noexcept
+    {
+      return detail::as_view(x);
+    }
+
+  // Returns a view of the i-th row of x.
+  template<Viewable A>
+    [[nodiscard]] constexpr auto
+    row(A&& x, std::size_t i) noexcept
+      requires (std::remove_cvref_t<A>::order() > 1)
+    {
+      assert(i < x.size());
+      return detail::as_view(x)[i];
+    }
+
+  // Returns a view of the j-th column of the matrix x.
+  template<Viewable A>
+    [[nodiscard]] constexpr auto
+    column(A&& x, std::size_t j) noexcept
+      requires (std::remove_cvref_t<A>::order() == 2)
+    {
+      using View = decltype(detail::as_view(x));
+      using T = std::remove_pointer_t<typename View::pointer>;
+      constexpr auto M = View::extent(0);
+      assert(j < View::extent(1));
+      const auto v = detail::as_view(x);
+      const auto offset = static_cast<std::ptrdiff_t>(j) * v.stride(1);
+      return num_array_view<T, M>(v.data() + offset, { v.stride(0) });
+    }
+
+  // Returns a view of the leading diagonal of the matrix x.
+  template<Viewable A>
+    [[nodiscard]] constexpr auto
+    diagonal(A&& x) noexcept
+      requires (std::remove_cvref_t<A>::order() == 2)
+    {
+      using View = decltype(detail::as_view(x));
+      using T = std::remove_pointer_t<typename View::pointer>;
+      constexpr auto M = std::min(View::extent(0), View::extent(1));
+      const auto v = detail::as_view(x);
+      return num_array_view<T, M>(v.data(), { v.stride(0) + v.stride(1) });
+    }
+
+  // Returns a view of the transpose of the matrix x.
+  template<Viewable A>
+    [[nodiscard]] constexpr auto
+    transpose_view(A&& x) noexcept
+      requires (std::remove_cvref_t<A>::order() == 2)
+    {
+      using View = decltype(detail::as_view(x));
+      using T = std::remove_pointer_t<typename View::pointer>;
+      constexpr auto M = View::extent(0), N = View::extent(1);
+      const auto v = detail::as_view(x);
+      return num_array_view<T, N, M>(v.data(), { v.stride(1), v.stride(0) });
+    }
+
+  // Returns a view of the P x Q sub-matrix of x whose first element is
+  // x(i, j).
+  template<std::size_t P, std::size_t Q, Viewable A>
+    [[nodiscard]] constexpr auto
+    block(A&& x, std::size_t i, std::size_t j) noexcept
+      requires (std::remove_cvref_t<A>::order() == 2)
+    {
+      using View = decltype(detail::as_view(x));
+      using T = std::remove_pointer_t<typename View::pointer>;
+      static_assert(P <= View::extent(0) && Q <= View::extent(1));
+      assert(i + P <= View::extent(0) && j + Q <= View::extent(1));
+      const auto v = detail::as_view(x);
+      const auto offset = static_cast<std::ptrdiff_t>(i) * v.stride(0) 
+                        + static_cast<std::ptrdiff_t>(j) * v.stride(1);
+      return num_array_view<T, P, Q>(v.data() + offset, v.strides());
+    }
+}
+#endif//TB_MATH_NUM_ARRAY_VIEW_H
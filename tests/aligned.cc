@@ -0,0 +1,129 @@
+#include "tests.h"
+#include "../src/aligned.h"
+#include "../src/matrix.h"
+#include "../src/reduce.h"
+
+#include <cstdint>
+
+using tb::math::num_array, tb::math::aligned_num_array, tb::math::aligned, tb::math::Number;
+
+bool is_aligned(const void* p, std::size_t alignment)
+{
+  return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+}
+
+template<Number T>
+  void test_layout()
+  {
+    using Mat3x5 = aligned_num_array<T, aligned<64>, 3, 5>;
+    static_assert(alignof(Mat3x5) == 64);
+    static_assert(Mat3x5::storage_type::extent(1) == 64 / sizeof(T));
+    static_assert(sizeof(Mat3x5) == 3 * 64);
+    static_assert(Mat3x5::size() == 3 && Mat3x5::extent(1) == 5);
+
+    using Unpadded = aligned_num_array<T, aligned<32, false>, 3, 5>;
+    static_assert(alignof(Unpadded) == 32);
+    static_assert(Unpadded::storage_type::extent(1) == 5);
+
+    static_assert(sizeof(tb::math::aligned_vec<T, 3>) == 4 * sizeof(T));
+    static_assert(alignof(tb::math::aligned_mat<T, 3>) == 4 * sizeof(T));
+
+    Mat3x5 a[2];
+    assert(is_aligned(a[0].data(), 64) && is_aligned(a[1].data(), 64));
+    for (std::size_t i = 0; i < 3; ++i) assert(is_aligned(a[1][i].data(), 64));
+  }
+
+template<Number T>
+  void test_operations()
+  {
+    using Matrix = num_array<T, 3, 5>;
+    using Aligned = aligned_num_array<T, aligned<32>, 3, 5>;
+    const Matrix x = {{ 1, 2, 3, 4, 5 }, { 6, 7, 8, 9, 10 }, { 11, 12, 13, 14, 15 }};
+
+    // The padding is not part of the elements
+    Aligned a = x;
+    assert(a == x && a(1, 2) == 8 && a[2][4] == 15);
+    for (std::size_t i = 0; i < 3; ++i)
+      for (std::size_t j = 5; j < Aligned::storage_type::extent(1); ++j)
+        assert(a.storage()(i, j) == 0);
+
+    Aligned b = { { 1, 1, 1, 1, 1 }, { 2, 2, 2, 2, 2 }, { 3, 3, 3, 3, 3 } };
+    assert(b(2, 4) == 3);
+
+    // Element-wise operations, on the padded rows and through expressions
+    a += b;
+    assert(a == x + b);
+    a *= T(2);
+    assert(a == (x + b) * T(2));
+    a = x - b;
+    assert((a == Matrix(x - b)));
+    a -= Matrix(T(1));
+    assert(a == x - b - Matrix(T(1)));
+    Matrix y = a + x;
+    assert(y == (x - b - Matrix(T(1))) + x);
+
+    Aligned c(T(4));
+    assert((c == Matrix(T(4))));
+
+    // One-dimensional
+    tb::math::aligned_vec<T, 3> u = { 1, 2, 3 }, v = { 4, 5, 6 };
+    assert(u[2] == 3);
+    assert(dot_product(u, v) == 32);
+    assert((cross_product(u, v) == num_array<T, 3>{ -3, 6, -3 }));
+    u += v;
+    assert((u == num_array<T, 3>{ 5, 7, 9 }));
+    assert(sum(u) == 21);
+
+    // Reductions and views
+    assert(sum(b) == 30 && max(x) == 15);
+    assert(sum(Aligned(x)) == 120);
+    assert(sum(column(b, 0)) == 6);
+    assert((row(b, 1) == num_array<T, 5>(T(2))));
+    column(b, 4) = num_array<T, 3>(T(0));
+    assert(b(0, 4) == 0 && b(2, 4) == 0 && b(2, 3) == 3);
+  }
+
+template<Number T>
+  void test_matrix()
+  {
+    using Matrix = num_array<T, 4, 4>;
+    using Aligned = tb::math::aligned_mat<T, 4>;
+    using Padded = aligned_num_array<T, aligned<64>, 4, 4>;
+    const Matrix x = {{ 2, 1, 0, 1 }, { 1, 3, 1, 0 }, { 0, 1, 4, 1 }, { 1, 0, 1, 5 }};
+    const Matrix y = transpose(x) * T(2) + Matrix(T(1));
+
+    const Aligned a = x, b = y;
+    const Padded p = x, q = y;
+    assert(matrix_product(a, b) == matrix_product(x, y));
+    assert(matrix_product(p, q) == matrix_product(x, y));
+    assert(matrix_product(p, b) == matrix_product(x, y));
+    assert(transpose(a) == transpose(x) && transpose(p) == transpose(x));
+    assert(det(p) == det(x));
+    assert((matrix_vector_product(p, num_array<T, 4>{ 1, 2, 3, 4 })
+            == matrix_vector_product(x, num_array<T, 4>{ 1, 2, 3, 4 })));
+
+    // Large enough for gemm
+    using Big = aligned_num_array<T, aligned<64>, 37, 37>;
+    Big m, n;
+    num_array<T, 37, 37> r, s;
+    for (std::size_t i = 0; i < 37; ++i) {
+      for (std::size_t j = 0; j < 37; ++j) {
+        m(i, j) = r(i, j) = T((i * 7 + j * 3) % 11);
+        n(i, j) = s(i, j) = T((i + j * 5) % 13);
+      }
+    }
+    assert(matrix_product(m, n) == matrix_product(r, s));
+  }
+
+int main()
+{
+  test_layout<float>();
+  test_layout<double>();
+  test_operations<float>();
+  test_operations<double>();
+  test_operations<int>();
+  test_matrix<float>();
+  test_matrix<double>();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+#include "tests.h"
+#include "../src/arena.h"
+#include "../src/dynamic_num_array.h"
+
+#include <cstdint>
+
+using tb::math::dynamic_num_array, tb::math::arena, tb::math::arena_scope, tb::math::Number;
+
+// Counts the allocations made through it
+class counting_resource : public std::pmr::memory_resource {
+public:
+  std::size_t allocations = 0, deallocations = 0;
+
+private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override
+  {
+    ++allocations;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) noexcept override
+  {
+    ++deallocations;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(const std::pmr::memory_resource& x) const noexcept override
+  {
+    return this == &x;
+  }
+};
+
+void test_arena()
+{
+  counting_resource upstream;
+  {
+    arena a(1024, &upstream);
+    const auto m = a.mark();
+    void* p = a.allocate(100, 64);
+    void* q = a.allocate(8, 8);
+    assert(reinterpret_cast<std::uintptr_t>(p) % 64 == 0);
+    assert(q >= static_cast<char*>(p) + 100);
+    assert(upstream.allocations == 1 && a.capacity() == 1024);
+
+    (void)a.allocate(4000, 16); // a larger block
+    assert(upstream.allocations == 2 && a.capacity() > 4000 + 1024);
+
+    a.rewind(m);
+    assert(a.allocate(100, 64) == p);
+    (void)a.allocate(4000, 16);
+    assert(upstream.allocations == 2); // the blocks are reused
+
+    a.reset();
+    assert(a.allocate(100, 64) == p);
+  }
+  assert(upstream.deallocations == upstream.allocations);
+}
+
+template<Number T>
+  void test_resources()
+  {
+    counting_resource r;
+    {
+      dynamic_num_array<T, 2> A({ 3, 4 }, T(1), &r);
+      assert(A.resource() == &r && r.allocations == 1);
+      assert(reinterpret_cast<std::uintptr_t>(A.data()) % A.alignment == 0);
+
+      const auto B = A; // copies use array_resource()
+      assert(B.resource() == tb::math::array_resource() && r.allocations == 1);
+
+      auto C = std::move(A); // moves take the resource
+      assert(C.resource() == &r && r.allocations == 1);
+
+      C = B + B;
+      assert(C.resource() == &r && C == 2);
+
+      tb::math::resource_scope scope(&r);
+      dynamic_num_array<T, 1> v(5);
+      assert(v.resource() == &r && r.allocations == 2);
+
+      // Operands of the result type are not copied
+      const auto D = B + B;
+      const auto E = hadamard_product(B, B);
+      assert(r.allocations == 4 && D == E + E);
+    }
+    assert(r.deallocations == r.allocations);
+  }
+
+// A "frame" of temporaries allocated from the thread's arena
+template<Number T>
+  void test_arena_scope()
+  {
+    counting_resource heap;
+    dynamic_num_array<T, 2> result({ 16, 16 }, &heap);
+    dynamic_num_array<T, 2> A({ 16, 16 }, T(1), &heap);
+
+    std::size_t capacity = 0;
+    for (int frame = 0; frame < 3; ++frame) {
+      arena_scope scope;
+      auto B = A * T(2) + A;
+      auto C = transpose(B) * B;
+      result = C - A;
+      assert(C.resource() == &tb::math::thread_arena());
+      if (frame == 0) capacity = tb::math::thread_arena().capacity();
+      assert(tb::math::thread_arena().capacity() == capacity);
+    }
+    assert(result.resource() == &heap && heap.allocations == 2);
+    assert(result(0, 0) == T(16 * 9 - 1));
+  }
+
+int main()
+{
+  test_arena();
+  test_resources<int>();
+  test_resources<double>();
+  test_arena_scope<float>();
+  test_arena_scope<int>();
+
+  return EXIT_SUCCESS;
+}
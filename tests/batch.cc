@@ -0,0 +1,65 @@
+#include "tests.h"
+#include "../src/batch.h"
+
+#include <span>
+#include <vector>
+
+using tb::math::num_array, tb::math::thread_pool, tb::math::Number;
+
+template<Number T>
+  void test_batch_transform(thread_pool& pool)
+  {
+    using Mat = num_array<T, 3, 4>;
+    using Vec4 = num_array<T, 4>;
+    using Vec3 = num_array<T, 3>;
+    const Mat a = {{ 1, 2, 3, 4 }, { 5, 6, 7, 8 }, { 9, 10, 11, 12 }};
+
+    std::vector<Vec4> x(10000);
+    for (std::size_t i = 0; i < x.size(); ++i) x[i] = Vec4{ T(i % 7), 1, T(i % 3), 2 };
+    std::vector<Vec3> y(x.size());
+    batch_transform(pool, a, x, y);
+    for (std::size_t i = 0; i < x.size(); ++i) assert(y[i] == a * x[i]);
+
+    std::vector<Vec3> z(x.size());
+    batch_transform(a, std::span<const Vec4>(x), std::span<Vec3>(z), 100);
+    assert(y == z);
+
+    bool thrown = false;
+    try { batch_transform(a, x, std::vector<Vec3>(1)); }
+    catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown);
+  }
+
+template<Number T>
+  void test_batch_product(thread_pool& pool)
+  {
+    using Mat23 = num_array<T, 2, 3>;
+    using Mat32 = num_array<T, 3, 2>;
+    using Mat22 = num_array<T, 2, 2>;
+
+    std::vector<Mat23> a(5000);
+    std::vector<Mat32> b(a.size());
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      a[i] = Mat23{{ T(i % 5), 1, 2 }, { 3, T(i % 2), 4 }};
+      b[i] = Mat32{{ 1, 2 }, { T(i % 3), 4 }, { 5, 6 }};
+    }
+    std::vector<Mat22> c(a.size());
+    matrix_product(pool, a, b, c, 16);
+    for (std::size_t i = 0; i < a.size(); ++i) assert(c[i] == a[i] * b[i]);
+
+    std::vector<Mat22> d(a.size());
+    matrix_product(a, b, d);
+    assert(c == d);
+  }
+
+int main()
+{
+  for (std::size_t n : { 0, 3 }) {
+    thread_pool pool(n);
+    test_batch_transform<float>(pool);
+    test_batch_transform<int>(pool);
+    test_batch_product<double>(pool);
+    test_batch_product<int>(pool);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,322 @@
+// Benchmarks of the main num_array operations.
+//
+//   bench [--filter TEXT] [--samples N] [--min-sample-ms MS]
+//         [--json FILE] [--compare FILE] [--threshold PERCENT]
+//
+// Each benchmark is warmed up and then timed in N samples (default 15) of at
+// least MS milliseconds (default 5). The median, 10th and 90th percentile
+// times per call are printed, and written as JSON (one benchmark per line)
+// to FILE with --json. With --compare, the medians are compared with those
+// of an earlier --json FILE; the exit status is non-zero if any benchmark is
+// slower by more than PERCENT (default 10).
+
+#include "timer.h"
+#include "../src/dynamic_num_array.h"
+#include "../src/matrix.h"
+#include "../src/vector.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using tb::math::num_array, tb::math::dynamic_num_array, tb::math::Number;
+
+struct Benchmark {
+  std::string name;   // operation
+  std::string type;   // element type
+  std::string shape;  // e.g. 4x4
+  std::function<void()> run;
+
+  std::string id() const { return name + "/" + type + "/" + shape; }
+};
+
+std::vector<Benchmark> benchmarks;
+
+template<typename T> const char* type_name();
+template<> const char* type_name<float>()  { return "float"; }
+template<> const char* type_name<double>() { return "double"; }
+template<> const char* type_name<int>()    { return "int"; }
+
+// Deterministic, non-trivial element values
+template<Number T>
+  T value(std::size_t i)
+  {
+    return static_cast<T>(static_cast<int>(i * 7919 % 17) - 8) / static_cast<T>(4);
+  }
+
+template<Number T, std::size_t M, std::size_t N>
+  std::shared_ptr<num_array<T, M, N>> make_matrix(std::size_t seed)
+  {
+    auto x = std::make_shared<num_array<T, M, N>>();
+    for (std::size_t i = 0; i < M; ++i)
+      for (std::size_t j = 0; j < N; ++j) (*x)(i, j) = value<T>(seed + i * N + j);
+    return x;
+  }
+
+template<Number T>
+  dynamic_num_array<T, 2> make_dynamic(std::size_t m, std::size_t n, std::size_t seed)
+  {
+    dynamic_num_array<T, 2> x(m, n);
+    for (std::size_t i = 0; i < x.n_elements(); ++i) x.data()[i] = value<T>(seed + i);
+    return x;
+  }
+
+template<typename... Args>
+  void add(std::string name, std::string type, std::string shape, Args&&... args)
+  {
+    benchmarks.push_back({ std::move(name), std::move(type), std::move(shape),
+                           std::forward<Args>(args)... });
+  }
+
+// Element-wise operations, matrix_product and transpose of N x N num_arrays
+template<Number T, std::size_t N>
+  void add_fixed()
+  {
+    using Matrix = num_array<T, N, N>;
+    const auto a = make_matrix<T, N, N>(1), b = make_matrix<T, N, N>(2);
+    const auto c = std::make_shared<Matrix>();
+    const auto shape = std::to_string(N) + "x" + std::to_string(N);
+    const auto type = type_name<T>();
+
+    add("add", type, shape, [=]{
+      do_not_optimize(*a);
+      *c = *a + *b;
+      do_not_optimize(*c);
+    });
+    add("scale", type, shape, [=]{
+      do_not_optimize(*a);
+      *c = *a * T(3);
+      do_not_optimize(*c);
+    });
+    // The sum alternates between b and b + a, so that every call adds the
+    // same (bounded) values, whichever benchmarks ran before
+    const auto d = std::make_shared<Matrix>(*b), e = std::make_shared<Matrix>(-*a);
+    add("add_assign", type, shape, [=, odd = false]() mutable {
+      *d += odd ? *e : *a;
+      odd = !odd;
+      do_not_optimize(*d);
+    });
+    add("fused", type, shape, [=]{
+      do_not_optimize(*a);
+      *c = *a * T(2) + *b - *a;
+      do_not_optimize(*c);
+    });
+    add("matrix_product", type, shape, [=]{
+      do_not_optimize(*a);
+      *c = matrix_product(*a, *b);
+      do_not_optimize(*c);
+    });
+    add("transpose", type, shape, [=]{
+      do_not_optimize(*a);
+      *c = transpose(*a);
+      do_not_optimize(*c);
+    });
+  }
+
+// The same operations on N x N dynamic_num_arrays
+template<Number T>
+  void add_dynamic(std::size_t n)
+  {
+    const auto a = std::make_shared<dynamic_num_array<T, 2>>(make_dynamic<T>(n, n, 1));
+    const auto b = std::make_shared<dynamic_num_array<T, 2>>(make_dynamic<T>(n, n, 2));
+    const auto c = std::make_shared<dynamic_num_array<T, 2>>(n, n);
+    const auto shape = std::to_string(n) + "x" + std::to_string(n);
+    const auto type = type_name<T>();
+
+    add("add", type, shape, [=]{
+      do_not_optimize(a->data());
+      *c = *a + *b;
+      do_not_optimize(c->data());
+    });
+    // As for num_arrays, the sum alternates between b and b + a
+    const auto d = std::make_shared<dynamic_num_array<T, 2>>(*b);
+    const auto e = std::make_shared<dynamic_num_array<T, 2>>(-*a);
+    add("add_assign", type, shape, [=, odd = false]() mutable {
+      *d += odd ? *e : *a;
+      odd = !odd;
+      do_not_optimize(d->data());
+      clobber_memory();
+    });
+    add("add_arena", type, shape, [=]{ // the result from the thread's arena
+      tb::math::arena_scope scope;
+      do_not_optimize(a->data());
+      const auto d = *a + *b;
+      do_not_optimize(d.data());
+    });
+    add("matrix_product", type, shape, [=]{
+      do_not_optimize(a->data());
+      *c = matrix_product(*a, *b);
+      do_not_optimize(c->data());
+    });
+    add("transpose", type, shape, [=]{
+      do_not_optimize(a->data());
+      *c = transpose(*a);
+      do_not_optimize(c->data());
+    });
+  }
+
+// det, inverse and solve of an N x N matrix with a dominant diagonal
+template<Number T, std::size_t N>
+  void add_solve()
+  {
+    const auto a = make_matrix<T, N, N>(1);
+    for (std::size_t i = 0; i < N; ++i) (*a)(i, i) += T(2 * N);
+    const auto c = std::make_shared<num_array<T, N, N>>();
+    num_array<T, N> b;
+    for (std::size_t i = 0; i < N; ++i) b[i] = value<T>(i);
+    const auto shape = std::to_string(N) + "x" + std::to_string(N);
+    const auto type = type_name<T>();
+
+    add("det", type, shape, [=]{
+      do_not_optimize(*a);
+      const auto x = det(*a);
+      do_not_optimize(x);
+    });
+    add("inverse", type, shape, [=]{
+      do_not_optimize(*a);
+      *c = inverse(*a);
+      do_not_optimize(*c);
+    });
+    add("solve", type, shape, [=]{
+      do_not_optimize(*a);
+      const auto x = solve(*a, b);
+      do_not_optimize(x);
+    });
+  }
+
+// dot_product and outer_product of N-vectors, and cross_product if N = 3
+template<Number T, std::size_t N>
+  void add_vector()
+  {
+    using Vector = num_array<T, N>;
+    Vector v, w;
+    for (std::size_t i = 0; i < N; ++i) v[i] = value<T>(i), w[i] = value<T>(i + 5);
+    const auto type = type_name<T>();
+    const auto shape = std::to_string(N);
+
+    add("dot_product", type, shape, [=]{
+      do_not_optimize(v);
+      const auto x = dot_product(v, w);
+      do_not_optimize(x);
+    });
+    add("outer_product", type, shape, [=]{
+      do_not_optimize(v);
+      const auto x = std::make_unique<num_array<T, N, N>>(outer_product(v, w));
+      do_not_optimize(*x);
+    });
+    if constexpr (N == 3) {
+      add("cross_product", type, shape, [=]{
+        do_not_optimize(v);
+        const auto x = cross_product(v, w);
+        do_not_optimize(x);
+      });
+    }
+  }
+
+template<Number T>
+  void add_type()
+  {
+    add_fixed<T, 2>();
+    add_fixed<T, 4>();
+    add_fixed<T, 16>();
+    add_fixed<T, 64>();
+    add_fixed<T, 128>();
+    for (std::size_t n : { 256, 512, 1024 }) add_dynamic<T>(n);
+    if constexpr (std::floating_point<T>) {
+      add_solve<T, 3>();
+      add_solve<T, 4>();
+      add_solve<T, 16>();
+    }
+    add_vector<T, 3>();
+    add_vector<T, 4>();
+    add_vector<T, 16>();
+    add_vector<T, 256>();
+  }
+
+std::string to_json(const Benchmark& b, const Sample_stats& s)
+{
+  std::ostringstream out;
+  out.precision(6);
+  out << "{\"id\": \"" << b.id() << "\", \"name\": \"" << b.name
+      << "\", \"type\": \"" << b.type << "\", \"shape\": \"" << b.shape
+      << "\", \"samples\": " << s.samples << ", \"iterations\": " << s.iterations
+      << ", \"min_ns\": " << s.min << ", \"p10_ns\": " << s.p10
+      << ", \"median_ns\": " << s.median << ", \"p90_ns\": " << s.p90
+      << ", \"mean_ns\": " << s.mean << "}";
+  return out.str();
+}
+
+// Reads the medians of an earlier run, by id.
+std::map<std::string, double> read_medians(const char* path)
+{
+  std::map<std::string, double> result;
+  std::ifstream in(path);
+  for (std::string line; std::getline(in, line); ) {
+    const auto id = line.find("\"id\": \""), median = line.find("\"median_ns\": ");
+    if (id == line.npos || median == line.npos) continue;
+    const auto first = id + 7, last = line.find('"', first);
+    result[line.substr(first, last - first)] = std::atof(line.c_str() + median + 13);
+  }
+  return result;
+}
+
+int main(int argc, char* argv[])
+{
+  const char* filter = "";
+  const char* json_path = nullptr;
+  const char* baseline_path = nullptr;
+  std::size_t samples = 15;
+  double min_sample_ns = 5e6, threshold = 10;
+
+  for (int i = 1; i < argc; ++i) {
+    const auto option = [&](const char* name) {
+      return std::strcmp(argv[i], name) == 0 && i + 1 < argc;
+    };
+    if (option("--filter")) filter = argv[++i];
+    else if (option("--samples")) samples = std::strtoul(argv[++i], nullptr, 10);
+    else if (option("--min-sample-ms")) min_sample_ns = std::atof(argv[++i]) * 1e6;
+    else if (option("--json")) json_path = argv[++i];
+    else if (option("--compare")) baseline_path = argv[++i];
+    else if (option("--threshold")) threshold = std::atof(argv[++i]);
+    else {
+      std::fprintf(stderr, "usage: %s [--filter TEXT] [--samples N] [--min-sample-ms MS]"
+                           " [--json FILE] [--compare FILE] [--threshold PERCENT]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  add_type<float>();
+  add_type<double>();
+  add_type<int>();
+
+  const auto baseline = baseline_path ? read_medians(baseline_path)
+                                      : std::map<std::string, double>{};
+  std::ofstream json;
+  if (json_path) json.open(json_path);
+  bool regressed = false;
+
+  std::printf("%-36s %12s %12s %12s %9s\n", "benchmark", "median ns", "p10 ns", "p90 ns",
+              baseline_path ? "change" : "");
+  for (const auto& b : benchmarks) {
+    if (b.id().find(filter) == std::string::npos) continue;
+    const auto stats = measure(b.run, samples, min_sample_ns);
+    std::printf("%-36s %12.1f %12.1f %12.1f", b.id().c_str(), stats.median, stats.p10,
+                stats.p90);
+    if (const auto old = baseline.find(b.id()); old != baseline.end() && old->second > 0) {
+      const auto change = (stats.median / old->second - 1) * 100;
+      const bool slower = change > threshold;
+      regressed = regressed || slower;
+      std::printf(" %+8.1f%%%s", change, slower ? "  REGRESSION" : "");
+    }
+    std::printf("\n");
+    std::fflush(stdout);
+    if (json) json << to_json(b, stats) << '\n';
+  }
+  return regressed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,136 @@
+#include "../src/dynamic_num_array.h"
+#include "../src/matrix.h"
+
+using tb::math::dynamic_num_array, tb::math::num_array, tb::math::Number;
+
+template<Number T>
+  void test_constructors()
+  {
+    dynamic_num_array<T, 2> A(3, 4);
+    assert(A.size() == 3 && A.extent(1) == 4 && A.n_elements() == 12);
+    A = T(1);
+    assert(A == 1);
+
+    dynamic_num_array<T, 2> B(A);      // copy construction
+    assert(A == B);
+
+    const auto* p = B.data();
+    dynamic_num_array<T, 2> C(std::move(B)); // move construction steals
+    assert(C.data() == p && B.empty());
+
+    constexpr num_array<T, 2, 3> x = {{ 1, 2, 3 }, { 4, 5, 6 }};
+    dynamic_num_array<T, 2> D(x);
+    assert(D(1, 2) == 6 && D.extent(0) == 2 && D.extent(1) == 3);
+  }
+
+template<Number T>
+  void test_operators()
+  {
+    dynamic_num_array<T, 2> A(5, 7);
+    for (std::size_t i = 0; i < A.size(); ++i)
+      for (std::size_t j = 0; j < A.extent(1); ++j) A(i, j) = T(i + j);
+
+    auto B(A + A);
+    assert(A * 2 == B);
+    assert(B / 2 == A);
+    assert(B - A == A);
+    auto C(A - A);
+    assert(C == 0 && C == 0u);
+    assert(abs(A) == A);
+    assert(C + 1 == 1);
+    assert(A + B * 2 - A == B * 2);
+
+    bool thrown = false;
+    try { A += dynamic_num_array<T, 2>(7, 5); } 
+    catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown);
+  }
+
+template<Number T>
+  void test_elementwise()
+  {
+    dynamic_num_array<T, 2> A(7, 5), B({ 7, 5 }, T(2)), C({ 7, 5 }, T(3));
+    for (std::size_t i = 0; i < A.n_elements(); ++i) A.data()[i] = T(i + 1);
+
+    auto D = A;
+    D *= B;
+    assert(D == A * 2);
+    D /= B;
+    assert(D == A);
+    assert(hadamard_product(A, B) == A * 2);
+    assert(hadamard_quotient(hadamard_product(A, B), B) == A);
+    assert(fma(A, B, C) == A * 2 + 3);
+    axpy(2, A, C);
+    assert(C == A * 2 + 3);
+
+    bool thrown = false;
+    try { D *= dynamic_num_array<T, 2>(5, 7); } 
+    catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown);
+  }
+
+template<Number T>
+  void test_matrix_operations()
+  {
+    constexpr num_array<T, 2, 3> a = {{ 1, 2, 3 }, { 4, 5, 6 }};
+    constexpr num_array<T, 3> x = { 1, 2, 3 };
+    const dynamic_num_array<T, 2> A(a);
+    const dynamic_num_array<T, 1> X(x);
+
+    using Matrix = dynamic_num_array<T, 2>;
+    using Vector = dynamic_num_array<T, 1>;
+    assert(transpose(A) == Matrix(transpose(a)));
+    assert(A * transpose(A) == Matrix(a * transpose(a)));
+    assert(A * X == Vector(a * x));
+    assert(dot_product(X, X) == dot_product(x, x));
+
+    // With the element type of the result first, for both kinds of arrays
+    const auto Q = matrix_product<double>(A, transpose(A));
+    static_assert(std::same_as<decltype(Q), const dynamic_num_array<double, 2>>);
+    assert((Q == dynamic_num_array<double, 2>(matrix_product<double>(a, transpose(a)))));
+    assert((matrix_vector_product<double>(A, X)
+            == dynamic_num_array<double, 1>(matrix_vector_product<double>(a, x))));
+    assert((vector_matrix_product<double>(X, transpose(A))
+            == dynamic_num_array<double, 1>(vector_matrix_product<double>(x, transpose(a)))));
+    static_assert(std::same_as<decltype(matrix_product<float>(A, dynamic_num_array<double, 2>())),
+                               dynamic_num_array<float, 2>>);
+
+    // A wider result type is accumulated in, products and all
+    const T t = std::is_integral_v<T> ? T(1 << 20) : T(1 + 0x1p-20f);
+    const dynamic_num_array<T, 2> W({ 3, 5 }, t);
+    const dynamic_num_array<T, 1> w({ 5 }, t);
+    const auto wide = std::is_integral_v<T> ? 5.0 * 0x1p40 : 5.0 * (1 + 0x1p-20) * (1 + 0x1p-20);
+    for (const auto e : matrix_vector_product<double>(W, w)) assert(e == wide);
+    for (const auto e : vector_matrix_product<double>(w, transpose(W))) assert(e == wide);
+
+    dynamic_num_array<T, 2> M(67, 45), N(45, 33);
+    for (std::size_t i = 0; i < M.n_elements(); ++i) M.data()[i] = T(i % 7);
+    for (std::size_t i = 0; i < N.n_elements(); ++i) N.data()[i] = T(i % 5);
+    const auto P = M * N;
+    for (std::size_t i = 0; i < 67; ++i) {
+      for (std::size_t j = 0; j < 33; ++j) {
+        T sum = 0;
+        for (std::size_t k = 0; k < 45; ++k) sum += M(i, k) * N(k, j);
+        assert(P(i, j) == sum);
+      }
+    }
+  }
+
+template<Number T>
+  void test_type()
+  {
+    test_constructors<T>();
+    test_operators<T>();
+    test_elementwise<T>();
+    test_matrix_operations<T>();
+  }
+
+int main()
+{
+  test_type<int>();
+  test_type<unsigned>();
+  test_type<float>();
+  test_type<double>();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,205 @@
+#include "tests.h"
+#include "../src/elementwise.h"
+
+#include <cmath>
+#include <limits>
+
+using tb::math::dynamic_num_array, tb::math::num_array, tb::math::accuracy;
+
+// The distance of x from the exact value y, in units of the last place of y
+template<std::floating_point T>
+  long double ulp_error(T x, long double y)
+  {
+    if (std::isnan(y)) return std::isnan(x) ? 0 : INFINITY;
+    if (std::isinf(y) || x == y) return x == y ? 0 : INFINITY;
+    const T t = T(y);
+    const long double ulp = std::nextafter(std::abs(t), std::numeric_limits<T>::infinity())
+                          - std::abs(t);
+    return std::abs(x - y) / std::max(ulp, (long double)std::numeric_limits<T>::denorm_min());
+  }
+
+// n values evenly spaced in [a, b], plus a scalar tail
+template<std::floating_point T>
+  dynamic_num_array<T, 1> range(long double a, long double b, std::size_t n = 10'003)
+  {
+    dynamic_num_array<T, 1> x({ n }, T(0));
+    for (std::size_t i = 0; i < n; ++i) x[i] = T(a + (b - a) * i / (n - 1));
+    return x;
+  }
+
+// The largest error of y = f(x) in ULP, or relative to the exact value
+template<typename F, typename T>
+  long double max_error(const dynamic_num_array<T, 1>& x, const dynamic_num_array<T, 1>& y, F f,
+                        bool relative = false)
+  {
+    long double e = 0;
+    for (std::size_t i = 0; i < x.size(); ++i) {
+      const long double exact = f((long double)x[i]);
+      e = std::max(e, relative ? std::abs((y[i] - exact) / exact) : ulp_error(y[i], exact));
+    }
+    return e;
+  }
+
+template<std::floating_point T>
+  void test_precise()
+  {
+    using L = long double;
+    const auto exp_x = range<T>(sizeof(T) == 4 ? -103 : -744, sizeof(T) == 4 ? 88.7 : 709.7);
+    assert(max_error(exp_x, exp(exp_x), [](L x) { return std::exp(x); }) <= 1.5);
+
+    const auto log_x = range<T>(0.01, 1000), log_y = range<T>(0x1p-20, 2);
+    assert(max_error(log_x, log(log_x), [](L x) { return std::log(x); }) <= 1);
+    assert(max_error(log_y, log(log_y), [](L x) { return std::log(x); }) <= 1);
+
+    const auto trig_x = range<T>(-8000, 8000), trig_y = range<T>(-4, 4);
+    for (const auto& x : { trig_x, trig_y }) {
+      assert(max_error(x, sin(x), [](L x) { return std::sin(x); }) <= 2.5);
+      assert(max_error(x, cos(x), [](L x) { return std::cos(x); }) <= 2.5);
+    }
+
+    const auto tanh_x = range<T>(-12, 12), tanh_y = range<T>(-0.01, 0.01);
+    assert(max_error(tanh_x, tanh(tanh_x), [](L x) { return std::tanh(x); }) <= 3);
+    assert(max_error(tanh_y, tanh(tanh_y), [](L x) { return std::tanh(x); }) <= 3);
+
+    const auto sqrt_x = range<T>(0, 1e6);
+    assert(max_error(sqrt_x, sqrt(sqrt_x), [](L x) { return std::sqrt(x); }) <= 0.5);
+    const auto rsqrt_x = range<T>(1e-3, 1e6);
+    assert(max_error(rsqrt_x, rsqrt(rsqrt_x), [](L x) { return 1 / std::sqrt(x); }) <= 1.5);
+
+    const auto pow_x = range<T>(0.1, 10);
+    assert(max_error(pow_x, pow(pow_x, T(2.5)), [](L x) { return std::pow(x, 2.5L); }) <= 2);
+    const auto neg_x = range<T>(-10, -0.1);
+    assert(max_error(neg_x, pow(neg_x, T(-7)), [](L x) { return std::pow(x, -7.0L); }) <= 2);
+
+    // Up to |y * log(x)| near the bounds of exp(), where the rounding of
+    // y * log(x) alone would be many ULP of the result
+    const L e_max = sizeof(T) == 4 ? 87 : 705;
+    const auto check_pow = [](const auto& x, const auto& y) {
+      const auto z = pow(x, y);
+      for (std::size_t i = 0; i < z.size(); ++i) {
+        assert(ulp_error(z[i], std::pow((L)x[i], (L)y[i])) <= 2);
+      }
+    };
+    check_pow(range<T>(0.01, 100), range<T>(-e_max / std::log(100.0L), e_max / std::log(100.0L)));
+    check_pow(range<T>(0.75, 1.4), range<T>(-e_max / std::log(1.4L), e_max / std::log(1.4L)));
+    check_pow(range<T>(1e-30, 1e-20), range<T>(-e_max / std::log(1e30L), 0));
+    check_pow(range<T>(1.01, 1.02), range<T>(-e_max / std::log(1.02L), e_max / std::log(1.02L)));
+  }
+
+// The fast form, whose error grows with |y * log(x)|
+template<std::floating_point T>
+  void test_fast_pow()
+  {
+    using L = long double;
+    const L bound = sizeof(T) == 4 ? 1e-5 : 1e-10;
+    const auto x = range<T>(0.1, 10), y = range<T>(-8, 8);
+    const auto z = pow<accuracy::fast>(x, y);
+    for (std::size_t i = 0; i < z.size(); ++i) {
+      const L exact = std::pow((L)x[i], (L)y[i]);
+      const L y_log_x = std::abs(y[i] * std::log((L)x[i]));
+      assert(std::abs((z[i] - exact) / exact) < bound * (1 + 2 * y_log_x));
+    }
+  }
+
+template<std::floating_point T>
+  void test_fast()
+  {
+    using L = long double;
+    const L bound = sizeof(T) == 4 ? 1e-5 : 1e-10;
+    const auto x = range<T>(-80, 80), y = range<T>(0.01, 1000), z = range<T>(-1000, 1000);
+    assert(max_error(x, exp<accuracy::fast>(x), [](L x) { return std::exp(x); }, true) < bound);
+    assert(max_error(y, log<accuracy::fast>(y), [](L x) { return std::log(x); }, true) < bound);
+    assert(max_error(x, tanh<accuracy::fast>(x), [](L x) { return std::tanh(x); }, true) < bound);
+    const auto s = sin<accuracy::fast>(z), c = cos<accuracy::fast>(z);
+    for (std::size_t i = 0; i < z.size(); ++i) {
+      assert(std::abs(s[i] - std::sin((L)z[i])) < bound);
+      assert(std::abs(c[i] - std::cos((L)z[i])) < bound);
+    }
+    assert(max_error(y, rsqrt<accuracy::fast>(y), [](L x) { return 1 / std::sqrt(x); }, true)
+           < (sizeof(T) == 4 ? 0x1p-21 : 0x1p-27));
+  }
+
+// Infinities, NaNs, zeros, subnormals and negative numbers
+template<std::floating_point T>
+  void test_special()
+  {
+    using limits = std::numeric_limits<T>;
+    constexpr T inf = limits::infinity(), nan = limits::quiet_NaN();
+    dynamic_num_array<T, 1> x({ 11 }, T(0));
+    const T values[] = { inf, -inf, nan, 0, -0.0, 1, -1, limits::denorm_min(), limits::min(),
+                         limits::max(), limits::min() / 4 };
+    std::copy(std::begin(values), std::end(values), x.data());
+
+    const auto check = [&x](const auto& y, auto f) {
+      for (std::size_t i = 0; i < x.size(); ++i) assert(ulp_error(y[i], f(x[i])) <= 2);
+    };
+    check(exp(x), [](T x) { return std::exp(x); });
+    check(log(x), [](T x) { return std::log(x); });
+    check(tanh(x), [](T x) { return std::tanh(x); });
+    check(sqrt(x), [](T x) { return std::sqrt(x); });
+    const auto s = sin(x), c = cos(x);
+    assert(std::isnan(s[0]) && std::isnan(s[1]) && std::isnan(s[2]));
+    assert(std::isnan(c[0]) && std::isnan(c[1]) && std::isnan(c[2]));
+    assert(s[3] == 0 && c[3] == 1 && s[7] == limits::denorm_min());
+
+    const auto p = pow(x, T(0)), q = pow(x, T(0.5));
+    for (std::size_t i = 0; i < x.size(); ++i) assert(p[i] == 1);
+    assert(q[0] == inf && q[1] == inf && std::isnan(q[2]) && q[3] == 0 && q[5] == 1);
+    assert(std::isnan(q[6]));
+
+    // Negative x, for integral y only, and zeros and infinities of either sign
+    for (const T y : { T(3), T(-3), T(2), T(-2), T(0.5), T(-0.5), inf, -inf, nan }) {
+      const auto p = pow(x, y);
+      for (std::size_t i = 0; i < x.size(); ++i) assert(ulp_error(p[i], std::pow(x[i], y)) <= 2);
+    }
+    assert(pow(x, T(-3))[4] == -inf && pow(x, T(3))[1] == -inf);
+    assert(rsqrt(x)[3] == inf && std::isnan(rsqrt(x)[6]));
+  }
+
+// Fixed-size arrays and expressions, and rvalues
+template<std::floating_point T>
+  void test_arrays()
+  {
+    num_array<T, 7, 9> a;
+    for (std::size_t i = 0; i < a.size(); ++i)
+      for (std::size_t j = 0; j < a[i].size(); ++j) a[i][j] = T(i * 9 + j) / 8;
+
+    const num_array<T, 7, 9> b = log(exp(a));
+    for (std::size_t i = 0; i < a.size(); ++i)
+      for (std::size_t j = 0; j < a[i].size(); ++j) assert(std::abs(b[i][j] - a[i][j]) < 1e-5);
+
+    const num_array<T, 3> c = { 0, 1, 4 };
+    assert((sqrt(c + c) == num_array<T, 3>{ 0, std::sqrt(T(2)), std::sqrt(T(8)) }));
+    const auto d = pow(c, c);
+    assert(d[0] == 1 && d[1] == 1 && std::abs(d[2] - 256) < 1e-3);
+    assert(sin(c * 0) == 0 && cos(c * 0) == 1);
+
+    dynamic_num_array<T, 2> x({ 4, 5 }, T(4));
+    const auto* p = x.data();
+    const auto e = sqrt(std::move(x)); // reuses the storage of x
+    assert(e == 2 && e.data() == p);
+    assert(pow(e, e) == pow(e, T(2)));
+
+    bool thrown = false;
+    try { (void)pow(e, dynamic_num_array<T, 2>({ 5, 4 }, T(1))); }
+    catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown);
+  }
+
+template<std::floating_point T>
+  void test_type()
+  {
+    test_precise<T>();
+    test_fast<T>();
+    test_fast_pow<T>();
+    test_special<T>();
+    test_arrays<T>();
+  }
+
+int main()
+{
+  test_type<float>();
+  test_type<double>();
+
+  return EXIT_SUCCESS;
+}
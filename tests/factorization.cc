@@ -0,0 +1,103 @@
+#include "tests.h"
+#include "../src/matrix.h"
+
+#include <cmath>
+#include <limits>
+
+using tb::math::num_array, tb::math::lu_pivots;
+
+template<typename T, std::size_t M, std::size_t N>
+  bool near(const num_array<T, M, N>& x, const num_array<T, M, N>& y, T tolerance)
+  {
+    for (std::size_t i = 0; i < M; ++i)
+      for (std::size_t j = 0; j < N; ++j)
+        if (std::abs(x(i, j) - y(i, j)) > tolerance) return false;
+    return true;
+  }
+
+// The factors of P A = L U, multiplied back together
+template<typename T, std::size_t N>
+  num_array<T, N, N> lu_product(const num_array<T, N, N>& lu, const lu_pivots<N>& pivots)
+  {
+    num_array<T, N, N> l(T(0)), u(T(0));
+    for (std::size_t i = 0; i < N; ++i) {
+      for (std::size_t j = 0; j < i; ++j) l(i, j) = lu(i, j);
+      l(i, i) = 1;
+      for (std::size_t j = i; j < N; ++j) u(i, j) = lu(i, j);
+    }
+    auto a = l * u;
+    for (std::size_t k = N; k-- > 0; ) std::swap(a[k], a[pivots[k]]);
+    return a;
+  }
+
+template<typename T>
+  void test_lu()
+  {
+    const auto eps = 16 * std::numeric_limits<T>::epsilon();
+    const num_array<T, 4, 4> a = {{ 1, 2, 3, 4 }, { 2, 1, 0, 3 }, { 4, 0, 2, 1 }, { 0, 3, 1, 2 }};
+
+    auto lu = a;
+    lu_pivots<4> pivots;
+    const int sign = lu_factor(lu, pivots);
+    assert(sign == 1 || sign == -1);
+    assert(near(lu_product(lu, pivots), a, eps * 4));
+    for (std::size_t i = 1; i < 4; ++i)
+      for (std::size_t j = 0; j < i; ++j) assert(std::abs(lu(i, j)) <= 1);
+
+    // Vector and matrix right-hand sides
+    const num_array<T, 4> x = { 1, -1, 2, 0.5 };
+    auto b = matrix_vector_product(a, x);
+    lu_solve(lu, pivots, b);
+    for (std::size_t i = 0; i < 4; ++i) assert(std::abs(b[i] - x[i]) <= eps * 4);
+
+    const num_array<T, 4, 2> X = {{ 1, 0 }, { 2, -1 }, { -3, 4 }, { 0, 1 }};
+    auto B = a * X;
+    lu_solve(lu, pivots, B);
+    assert(near(B, X, eps * 8));
+
+    // Singular
+    num_array<T, 3, 3> s = {{ 1, 2, 3 }, { 2, 4, 6 }, { 1, 0, 1 }};
+    lu_pivots<3> p;
+    assert(lu_factor(s, p) == 0);
+
+    // At compile time
+    constexpr auto det = [] {
+      num_array<T, 3, 3> m = {{ 0, 2, 1 }, { 1, 1, 1 }, { 2, 0, 3 }};
+      lu_pivots<3> q;
+      T d = lu_factor(m, q);
+      for (std::size_t i = 0; i < 3; ++i) d *= m(i, i);
+      return d;
+    }();
+    static_assert(det > T(-4.0001) && det < T(-3.9999));
+  }
+
+template<typename T>
+  void test_cholesky()
+  {
+    const auto eps = 16 * std::numeric_limits<T>::epsilon();
+    const num_array<T, 3, 3> a = {{ 4, 12, -16 }, { 12, 37, -43 }, { -16, -43, 98 }};
+
+    auto l = a;
+    assert(cholesky_factor(l));
+    const num_array<T, 3, 3> expected = {{ 2, 0, 0 }, { 6, 1, 0 }, { -8, 5, 3 }};
+    for (std::size_t i = 0; i < 3; ++i)
+      for (std::size_t j = 0; j <= i; ++j) assert(std::abs(l(i, j) - expected(i, j)) <= eps * 8);
+
+    const num_array<T, 3> x = { 1, 2, 3 };
+    auto b = matrix_vector_product(a, x);
+    cholesky_solve(l, b);
+    for (std::size_t i = 0; i < 3; ++i) assert(std::abs(b[i] - x[i]) <= eps * 64);
+
+    num_array<T, 2, 2> indefinite = {{ 1, 2 }, { 2, 1 }};
+    assert(!cholesky_factor(indefinite));
+  }
+
+int main()
+{
+  test_lu<float>();
+  test_lu<double>();
+  test_cholesky<float>();
+  test_cholesky<double>();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+#include "tests.h"
+#include "../src/half.h"
+#include "../src/matrix.h"
+
+#include <cmath>
+#include <limits>
+
+using tb::math::bfloat16, tb::math::dynamic_num_array, tb::math::float16,
+      tb::math::num_array;
+
+// Encodings, rounding and limits at compile time (the software conversions)
+static_assert(float16(1.0f).bits() == 0x3c00 && bfloat16(1.0f).bits() == 0x3f80);
+static_assert(float16(-2.0f).bits() == 0xc000 && float(float16::from_bits(0x3555)) == 0x1.554p-2f);
+static_assert(float16(1 + 0x1p-11f).bits() == 0x3c00);     // tie, to even
+static_assert(float16(1 + 0x3p-11f).bits() == 0x3c02);
+static_assert(float16(1 + 0x1p-11 + 0x1p-40).bits() == 0x3c01); // no double rounding
+static_assert(float16(65519.0f).bits() == 0x7bff && float16(65520.0f).bits() == 0x7c00);
+static_assert(float16(0x1p-25f).bits() == 0 && float16(0x1.8p-25f).bits() == 1);
+static_assert(float(float16::from_bits(1)) == 0x1p-24f && float(float16::from_bits(0x8000)) == 0);
+static_assert(bfloat16(1 + 0x1p-8f).bits() == 0x3f80 && bfloat16(1 + 0x3p-8f).bits() == 0x3f82);
+static_assert(bfloat16(std::numeric_limits<float>::max()).bits() == 0x7f80);
+static_assert(float(std::numeric_limits<float16>::max()) == 65504);
+static_assert(float(std::numeric_limits<float16>::epsilon()) == 0x1p-10f);
+static_assert(float(std::numeric_limits<bfloat16>::min()) == std::numeric_limits<float>::min());
+static_assert(float(std::numeric_limits<bfloat16>::epsilon()) == 0x1p-7f);
+static_assert(std::same_as<std::common_type_t<float16, int>, float>);
+static_assert(std::same_as<std::common_type_t<double, bfloat16>, double>);
+
+// Every encoding round trips through float, and the values halfway between
+// consecutive ones (and their neighbours) round to nearest even, both one
+// at a time and with the array kernels.
+template<typename T>
+  void test_conversions()
+  {
+    using limits = std::numeric_limits<T>;
+    dynamic_num_array<float, 1> x({ 6 * 0x8000 }, 0.0f);
+    dynamic_num_array<std::uint16_t, 1> expected({ 6 * 0x8000 }, std::uint16_t(0));
+    std::size_t n = 0;
+    for (std::uint32_t h = 0; h < 0x10000; ++h) {
+      const auto y = T::from_bits(static_cast<std::uint16_t>(h));
+      if (std::isnan(float(y))) {
+        assert(std::isnan(float(T(float(y)))));
+        continue;
+      }
+      assert(T(float(y)).bits() == h);
+      assert(T(double(y)).bits() == h);
+      if ((h & 0x7fff) >= limits::infinity().bits() - 1) continue;
+
+      // Halfway to the next encoding away from zero
+      const float a = y, b = T::from_bits(static_cast<std::uint16_t>(h + 1));
+      const float mid = a + (b - a) / 2;
+      const std::uint32_t even = h & 1 ? h + 1 : h;
+      const float below = std::nextafter(mid, 0.0f), above = std::nextafter(mid, b);
+      assert(T(mid).bits() == even && T(below).bits() == h && T(above).bits() == h + 1);
+      for (const auto& [value, bits] : { std::pair(mid, even), std::pair(below, h),
+                                        std::pair(above, h + 1) }) {
+        x[n] = value, expected[n++] = static_cast<std::uint16_t>(bits);
+      }
+    }
+    assert(T(limits::max() + 0.0).bits() == limits::max().bits());
+    assert(float(T(1e300)) == limits::infinity() && float(T(-1e300)) == -limits::infinity());
+    assert(std::isnan(float(T(NAN))) && std::isnan(float(limits::quiet_NaN())));
+
+    const auto y = convert<T>(x);
+    for (std::size_t i = 0; i < n; ++i) assert(y[i].bits() == expected[i]);
+    const auto z = convert<float>(y);
+    for (std::size_t i = 0; i < n; ++i) assert(z[i] == float(y[i]));
+
+    // Non-finite values in the array kernels
+    dynamic_num_array<float, 1> special({ 37 }, NAN);
+    special[3] = INFINITY, special[20] = -INFINITY, special[36] = -0.0f;
+    const auto s = convert<T>(special);
+    for (std::size_t i = 0; i < s.size(); ++i) assert(s[i].bits() == T(special[i]).bits());
+    assert(std::isnan(float(s[0])) && float(s[3]) == INFINITY && std::signbit(float(s[36])));
+  }
+
+// Arrays of 16-bit floats: conversions and element-wise arithmetic, which
+// rounds each stored result
+template<typename T>
+  void test_arrays()
+  {
+    num_array<float, 3, 4> a;
+    for (std::size_t i = 0; i < a.size(); ++i)
+      for (std::size_t j = 0; j < a[i].size(); ++j) a(i, j) = float(i * 4 + j) / 4;
+
+    const num_array<T, 3, 4> b(a);
+    assert(convert<T>(a) == b);
+    for (std::size_t i = 0; i < a.size(); ++i)
+      for (std::size_t j = 0; j < a[i].size(); ++j) {
+        assert(b(i, j) == a(i, j));
+      }
+
+    const num_array<T, 3, 4> c = b + b * 2;
+    for (std::size_t i = 0; i < a.size(); ++i)
+      for (std::size_t j = 0; j < a[i].size(); ++j) assert(c(i, j) == T(3 * b(i, j)));
+
+    num_array<T, 3, 4> d = b;
+    d += 1;
+    d *= T(2);
+    assert((d == num_array<T, 3, 4>((b + 1) * 2)) && d != b);
+
+    dynamic_num_array<T, 2> x({ 3, 4 }, T(0.5f));
+    x += dynamic_num_array<T, 2>(b);
+    assert((x == dynamic_num_array<T, 2>(convert<T>(num_array<float, 3, 4>(a + 0.5f)))));
+    assert((convert<float>(x) == dynamic_num_array<float, 2>(x)));
+  }
+
+// Products sum in float: with integers, the results are exact sums rounded
+// once to 16 bits, where sums in 16 bits would have rounded at every step.
+template<typename T, std::size_t N>
+  void test_products()
+  {
+    num_array<T, N, N> a, b;
+    num_array<float, N, N> af, bf;
+    for (std::size_t i = 0; i < N; ++i)
+      for (std::size_t j = 0; j < N; ++j) {
+        af(i, j) = a(i, j) = T(float((i * 7 + j * 3) % 17));
+        bf(i, j) = b(i, j) = T(float((i * 5 + j * 11) % 13) - 6);
+      }
+
+    const num_array<T, N> ones(T(1));
+    static_assert(std::same_as<decltype(dot_product(a[0], b[0])), float>);
+    assert(dot_product(ones, ones) == N);
+    for (std::size_t i = 0; i < N; ++i) assert(dot_product(a[i], a[i]) == dot_product(af[i], af[i]));
+
+    const auto c = matrix_product(a, b), expected = convert<T>(matrix_product(af, bf));
+    assert(c == expected);
+    assert((matrix_vector_product(a, ones) == convert<T>(matrix_vector_product(af, num_array<float, N>(1)))));
+    assert((vector_matrix_product(ones, b) == convert<T>(vector_matrix_product(num_array<float, N>(1), bf))));
+
+    const dynamic_num_array<T, 2> x(a), y(b);
+    assert((matrix_product(x, y) == dynamic_num_array<T, 2>(expected)));
+    const dynamic_num_array<T, 1> v({ N }, T(1));
+    assert(dot_product(v, v) == N);
+    assert((matrix_vector_product(x, v) == dynamic_num_array<T, 1>(matrix_vector_product(a, ones))));
+    assert((vector_matrix_product(v, y) == dynamic_num_array<T, 1>(vector_matrix_product(ones, b))));
+  }
+
+int main()
+{
+  test_conversions<float16>();
+  test_conversions<bfloat16>();
+  test_arrays<float16>();
+  test_arrays<bfloat16>();
+  test_products<float16, 4>();     // unrolled
+  test_products<float16, 24>();    // loops
+  test_products<float16, 64>();    // gemm()
+  test_products<bfloat16, 4>();
+  test_products<bfloat16, 64>();
+
+  // 4096 ones sum to 2048 in float16, which cannot hold 2049
+  const dynamic_num_array<float16, 1> ones({ 4096 }, float16(1));
+  assert(dot_product(ones, ones) == 4096);
+
+  return EXIT_SUCCESS;
+}
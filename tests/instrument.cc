@@ -0,0 +1,133 @@
+#define TB_MATH_INSTRUMENT
+#include "tests.h"
+#include "../src/instrument.h"
+#include "../src/matrix.h"
+#include "../src/thread_pool.h"
+
+#include <chrono>
+#include <future>
+#include <sstream>
+#include <thread>
+
+using tb::math::num_array, tb::math::instrument::counts, tb::math::instrument::operation;
+namespace instrument = tb::math::instrument;
+
+static_assert(instrument::enabled);
+
+// Constant evaluation is not counted (nor affected)
+static_assert(dot_product(num_array<int, 3>{ 1, 2, 3 }, num_array<int, 3>{ 1, 1, 1 }) == 6);
+
+constexpr std::size_t n = 64;
+using matrix = num_array<float, 8, 8>;
+
+// Element-wise passes: elements (and bytes) read from the operands plus
+// those written, and one flop per operation per element
+void test_elementwise()
+{
+  const matrix a(1.0f), b(2.0f);
+  instrument::reset();
+
+  matrix c;
+  c = a + b * 2.0f;
+  auto r = instrument::thread_totals();
+  assert((r[operation::elementwise] == counts{ 1, 3 * n, 2 * n, 3 * n * sizeof(float) }));
+
+  c += a;
+  c *= 2.0f;
+  r = instrument::thread_totals();
+  assert((r[operation::elementwise] == counts{ 3, 3 * n + 3 * n + 2 * n, 2 * n + n + n,
+                                               8 * n * sizeof(float) }));
+
+  // The evaluation of a num_array constructed from an expression is part of
+  // the construction
+  const matrix d = fma(a, b, c);
+  const matrix e = a - b;
+  r = instrument::thread_totals();
+  assert((r[operation::construct] == counts{ 2, 4 * n + 3 * n, 2 * n + n,
+                                             7 * n * sizeof(float) }));
+  assert(r[operation::elementwise].calls == 3);
+  assert(d(0, 0) == 14 && e(0, 0) == -1);
+}
+
+// Products count the nominal flops, and the operations they call are part
+// of them
+void test_products()
+{
+  const matrix a(1.0f), b(2.0f);
+  const num_array<float, 8> v(1.0f);
+  instrument::reset();
+
+  const matrix c = a * b;
+  const auto w = a * v;
+  const auto x = dot_product(v, w) + dot_product(v, v);
+  const auto y = solve(num_array<double, 3, 3>{{ 2, 0, 0 }, { 0, 3, 0 }, { 0, 0, 4 }},
+                       num_array<double, 3>{ 2, 3, 4 });
+
+  const auto r = instrument::thread_totals();
+  assert((r[operation::matrix_product] == counts{ 1, 3 * n, 2 * 8 * 8 * 8, 3 * n * sizeof(float) }));
+  assert((r[operation::matrix_vector_product] == counts{ 1, n + 16, 2 * n, (n + 16) * sizeof(float) }));
+  assert((r[operation::dot_product] == counts{ 2, 2 * 17, 2 * 16, 2 * 17 * sizeof(float) }));
+  assert(r[operation::solve].calls == 1 && r[operation::solve].flops == 18 + 18);
+  assert(r[operation::inverse].calls == 0 && r[operation::construct].calls == 0);
+  assert((r.total().calls == 5));
+  assert(c(0, 0) == 16 && x == 72 && y[2] == 1);
+}
+
+// The counts of all threads, while they run and after they exit
+void test_threads()
+{
+  const num_array<float, 8> v(1.0f);
+  instrument::reset();
+  const float x = dot_product(v, v);
+
+  std::thread([&v] { (void)dot_product(v, v); }).join();
+  std::promise<void> counted, done;
+  std::thread t([&] {
+    (void)dot_product(v, v);
+    counted.set_value();
+    done.get_future().wait();
+  });
+  counted.get_future().wait();
+
+  assert(instrument::totals()[operation::dot_product].calls == 3);
+  assert(instrument::thread_totals()[operation::dot_product].calls == 1);
+  done.set_value();
+  t.join();
+  assert(instrument::totals()[operation::dot_product].calls == 3);
+
+  std::ostringstream os;
+  os << instrument::totals();
+  assert(os.str().find("dot_product") != std::string::npos);
+  assert(os.str().find("solve") == std::string::npos);
+
+  instrument::reset();
+  assert((instrument::totals() == instrument::report()));
+  assert(x == 8);
+}
+
+// The workers of a static pool, constructed before the counters of any
+// thread, exit after static objects constructed later are destroyed
+tb::math::thread_pool pool(3);
+
+void test_pool()
+{
+  const num_array<float, 8> v(1.0f);
+  instrument::reset();
+  pool.parallel_for(0, 32, 1, [&v](std::size_t i, std::size_t j) {
+    for (; i < j; ++i) {
+      (void)dot_product(v, v);
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  });
+  assert(instrument::totals()[operation::dot_product].calls == 32);
+}
+
+int main()
+{
+  test_elementwise();
+  test_products();
+  test_threads();
+  test_pool();
+
+  return EXIT_SUCCESS;
+}
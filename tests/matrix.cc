@@ -1,7 +1,222 @@
 #include "../src/matrix.h"
 
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// Compares the product (unrolled for small matrices, blocked for large ones)
+// against the naive triple loop.
+template<typename T, std::size_t M, std::size_t N, std::size_t P>
+  void test_product()
+  {
+    static tb::math::num_array<T, M, N> A;
+    static tb::math::num_array<T, N, P> B;
+    for (std::size_t i = 0; i < M; ++i)
+      for (std::size_t k = 0; k < N; ++k) A(i, k) = T((i + 2 * k) % 7) - 3;
+    for (std::size_t k = 0; k < N; ++k)
+      for (std::size_t j = 0; j < P; ++j) B(k, j) = T((3 * k + j) % 5) - 2;
+
+    const auto C = A * B;
+    for (std::size_t i = 0; i < M; ++i) {
+      for (std::size_t j = 0; j < P; ++j) {
+        T sum = 0;
+        for (std::size_t k = 0; k < N; ++k) sum += A(i, k) * B(k, j);
+        assert(C(i, j) == sum);
+      }
+    }
+  }
+
+// The unrolled and register kernels for small matrices against loops
+template<typename T, std::size_t M, std::size_t N>
+  void test_small()
+  {
+    tb::math::num_array<T, M, N> A;
+    tb::math::num_array<T, N> x;
+    for (std::size_t i = 0; i < M; ++i)
+      for (std::size_t j = 0; j < N; ++j) A(i, j) = T((i * 3 + j * 5) % 7) - 2;
+    for (std::size_t j = 0; j < N; ++j) x[j] = T(j) - 1;
+
+    const auto B = transpose(A);
+    const auto y = A * x;
+    const auto C = A + A * T(2) - A;
+    for (std::size_t i = 0; i < M; ++i) {
+      T sum = 0;
+      for (std::size_t j = 0; j < N; ++j) {
+        assert(B(j, i) == A(i, j));
+        assert(C(i, j) == 2 * A(i, j));
+        sum += A(i, j) * x[j];
+      }
+      assert(y[i] == sum);
+    }
+    assert(transpose(A + A) == B + B);
+    assert((A + A) * x == y * T(2));
+  }
+
+// A * inverse(A) and A * solve(A, B) against the identity and B, for an
+// N x N matrix with a dominant diagonal.
+template<typename T, std::size_t N>
+  void test_inverse()
+  {
+    const auto eps = 64 * N * std::numeric_limits<T>::epsilon();
+    tb::math::num_array<T, N, N> A, I(T(0));
+    for (std::size_t i = 0; i < N; ++i) {
+      for (std::size_t j = 0; j < N; ++j) A(i, j) = T((i * 5 + j * 3) % 7) - 3;
+      A(i, i) += T(2 * N);
+      I(i, i) = 1;
+    }
+    const auto X = A * inverse(A);
+    for (std::size_t i = 0; i < N; ++i)
+      for (std::size_t j = 0; j < N; ++j) assert(std::abs(X(i, j) - I(i, j)) <= eps);
+
+    tb::math::num_array<T, N> b;
+    for (std::size_t i = 0; i < N; ++i) b[i] = T(i) - 1;
+    const auto y = A * solve(A, b);
+    for (std::size_t i = 0; i < N; ++i) assert(std::abs(y[i] - b[i]) <= eps * N);
+
+    const auto Y = A * solve(A, I);
+    for (std::size_t i = 0; i < N; ++i)
+      for (std::size_t j = 0; j < N; ++j) assert(std::abs(Y(i, j) - I(i, j)) <= eps);
+
+    // The closed forms agree with the LU factorization
+    auto lu = A;
+    tb::math::lu_pivots<N> pivots;
+    T d = lu_factor(lu, pivots);
+    for (std::size_t i = 0; i < N; ++i) d *= lu(i, i);
+    assert(std::abs(det(A) - d) <= eps * std::abs(d));
+  }
+
+void test_det()
+{
+  constexpr tb::math::num_array<int, 3, 3> A = {{ 2, -3, 1 }, { 2, 0, -1 }, { 1, 4, 5 }};
+  static_assert(det(A) == 49);
+  static_assert(det(A + A) == 8 * 49);
+
+  constexpr tb::math::num_array<int, 4, 4> B = 
+    {{ 1, 0, 2, -1 }, { 3, 0, 0, 5 }, { 2, 1, 4, -3 }, { 1, 0, 5, 0 }};
+  static_assert(det(B) == 30);
+  constexpr auto I = B * inverse(B);
+  static_assert(I(2, 2) > 0.999999 && I(2, 2) < 1.000001);
+  static_assert(I(2, 3) > -0.000001 && I(2, 3) < 0.000001);
+
+  constexpr tb::math::num_array<double, 5, 5> C = 
+    {{ 0, 0, 0, 0, 2 }, { 0, 0, 0, 3, 0 }, { 0, 0, 1, 0, 0 }, 
+     { 0, 4, 0, 0, 0 }, { 5, 0, 0, 0, 0 }};
+  static_assert(det(C) == 120);
+
+  constexpr tb::math::num_array<double, 3, 3> S = {{ 1, 2, 3 }, { 2, 4, 6 }, { 0, 1, 1 }};
+  static_assert(det(S) == 0);
+  assert(!std::isfinite(inverse(S)(0, 0)));
+
+  // Narrow integers give the determinant in int64, and 64-bit ones exactly
+  constexpr tb::math::num_array<std::int8_t, 3, 3> D = 
+    {{ 20, 1, 0 }, { 0, 20, 1 }, { 1, 0, 20 }};
+  static_assert(std::same_as<decltype(det(D)), std::int64_t>);
+  static_assert(det(D) == 8001);
+  constexpr tb::math::num_array<std::int8_t, 4, 4> E = 
+    {{ 30, 1, 0, 0 }, { 0, 30, 1, 0 }, { 0, 0, 30, 1 }, { -1, 0, 0, 30 }};
+  static_assert(std::same_as<decltype(det(E)), std::int64_t>);
+  static_assert(det(E) == 810001);
+  constexpr tb::math::num_array<std::uint8_t, 4, 4> F = 
+    {{ 200, 0, 0, 0 }, { 0, 200, 0, 0 }, { 0, 0, 200, 0 }, { 0, 0, 0, 200 }};
+  static_assert(det(F) == 1600000000);
+  constexpr tb::math::num_array<std::uint8_t, 2, 2> G = {{ 1, 2 }, { 3, 4 }};
+  static_assert(det(G) == -2);
+  constexpr std::int64_t k = std::int64_t(1) << 31;
+  constexpr tb::math::num_array<std::int64_t, 2, 2> H = {{ k + 1, k }, { k, k - 1 }};
+  static_assert(std::same_as<decltype(det(H)), std::int64_t>);
+  static_assert(det(H) == -1);
+  constexpr tb::math::num_array<long, 2, 2> L = {{ k + 1, k }, { k, k - 1 }};
+  static_assert(std::same_as<decltype(det(L)), long> && det(L) == -1);
+}
+
+// Products with a wider element type R than that of their operands are
+// accumulated in R, and so are the products of their elements: int8 sums
+// that exceed int8, int32 products that exceed int32, and float products
+// whose low bits would be rounded off.
+template<typename T, typename R, std::size_t N>
+  void test_wide_product(T a, T b)
+  {
+    tb::math::num_array<T, N, N> A(a), B(b);
+    tb::math::num_array<T, N> x(b);
+    const R expected = R(N) * (R(a) * R(b));
+    const auto y = matrix_vector_product<R>(A, x);
+    const auto z = vector_matrix_product<R>(x, A);
+    const auto C = matrix_product<R>(A, B);
+    static_assert(std::same_as<decltype(y), const tb::math::num_array<R, N>>);
+    for (std::size_t i = 0; i < N; ++i) {
+      assert(y[i] == expected && z[i] == expected);
+      assert(C(i, 0) == expected && C(i, N - 1) == expected);
+    }
+  }
+
+// Integer matrices, whose cofactors may not be representable in their
+// element type, give the inverses and solutions in double
+template<typename T, std::size_t N>
+  void test_integer_inverse(const tb::math::num_array<T, N, N>& A)
+  {
+    const auto X = inverse(A);
+    static_assert(std::same_as<decltype(X), const tb::math::num_array<double, N, N>>);
+    tb::math::num_array<double, N> b;
+    for (std::size_t i = 0; i < N; ++i) b[i] = double(i) - 1;
+    const auto y = solve(A, b);
+    for (std::size_t i = 0; i < N; ++i) {
+      double sum = 0;
+      for (std::size_t j = 0; j < N; ++j) {
+        double p = 0;
+        for (std::size_t k = 0; k < N; ++k) p += double(A(i, k)) * X(k, j);
+        assert(std::abs(p - (i == j)) <= 1e-12);
+        sum += double(A(i, j)) * y[j];
+      }
+      assert(std::abs(sum - b[i]) <= 1e-12);
+    }
+  }
+
 int main()
 {
+  test_det();
+  test_integer_inverse(tb::math::num_array<unsigned, 2, 2>{{ 2, 1 }, { 1, 1 }});
+  assert((inverse(tb::math::num_array<unsigned, 2, 2>{{ 2, 1 }, { 1, 1 }})
+          == tb::math::num_array<double, 2, 2>{{ 1, -1 }, { -1, 2 }}));
+  test_integer_inverse(tb::math::num_array<std::int8_t, 3, 3>{{ 20, 1, 0 }, { 0, 20, 1 }, { 1, 0, 20 }});
+  test_integer_inverse(tb::math::num_array<unsigned, 3, 3>{{ 1, 2, 0 }, { 0, 1, 3 }, { 4, 0, 1 }});
+  test_integer_inverse(tb::math::num_array<std::uint8_t, 4, 4>
+    {{ 30, 1, 0, 2 }, { 0, 30, 1, 0 }, { 3, 0, 30, 1 }, { 1, 2, 0, 30 }});
+  test_inverse<float, 2>();
+  test_inverse<float, 3>();
+  test_inverse<float, 4>();
+  test_inverse<double, 3>();
+  test_inverse<double, 4>();
+  test_inverse<double, 7>();
+  test_inverse<double, 16>();
+
+  test_wide_product<std::int8_t, std::int32_t, 4>(100, 100);
+  test_wide_product<std::int8_t, std::int32_t, 37>(-128, 127);
+  test_wide_product<std::int32_t, std::int64_t, 3>(1 << 20, 1 << 20);
+  test_wide_product<std::int32_t, std::int64_t, 19>(-(1 << 30), 3);
+  test_wide_product<float, double, 4>(1 + 0x1p-20f, 1 + 0x1p-20f);
+  test_wide_product<float, double, 9>(1 + 0x1p-20f, 1 - 0x1p-20f);
+
+  test_product<float, 101, 300, 67>();
+  test_product<double, 64, 64, 64>();
+  test_product<int, 37, 45, 129>();
+  test_product<float, 4, 4, 4>();
+  test_product<double, 4, 4, 4>();
+  test_product<int, 4, 4, 4>();
+  test_product<float, 3, 2, 4>();
+  test_product<double, 2, 3, 1>();
+
+  test_small<float, 4, 4>();
+  test_small<double, 4, 4>();
+  test_small<int, 4, 4>();
+  test_small<float, 3, 3>();
+  test_small<double, 2, 4>();
+  test_small<float, 5, 3>();
+
+  constexpr tb::math::num_array<int, 2, 2> P = {{ 1, 2 }, { 3, 4 }};
+  static_assert(P * P == tb::math::num_array<int, 2, 2>{{ 7, 10 }, { 15, 22 }});
+  static_assert(transpose(P)(0, 1) == 3);
+  static_assert(dot_product(P[0], P[1]) == 11);
+
   constexpr tb::math::num_array<float, 2, 3> A({{1,2,3}, {4,5,6}});
 
   constexpr auto B = transpose(A);
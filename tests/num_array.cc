@@ -1,6 +1,9 @@
 #include "tests.h"
 #include "../src/matrix.h"
 
+#include <cstring>
+#include <numeric>
+
 using tb::math::num_array, tb::math::Number;
 
 template<Number T, std::size_t M, std::size_t... N>
@@ -76,6 +79,91 @@ template<Number T, std::size_t M, std::size_t... N>
     assert(C - 1 == -1);
   }
 
+template<Number T, std::size_t M, std::size_t... N>
+  constexpr auto test_expressions()
+  {
+    using Num_array = num_array<T, M, N...>;
+    Num_array A(1), B(2), C(3);
+
+    Num_array D = A + B * 2 - C; // evaluated in a single pass
+    assert(D == 2);
+    D = (D + A) / 3;
+    assert(D == 1);
+    D += A + B;
+    assert(D == 4);
+    D -= B * 2;
+    assert(D == 0);
+
+    auto E = A + B;               // unevaluated
+    assert(E == C);
+    assert(eval(E) == C);
+    assert(E * 2.0 == 6.0);
+  }
+
+template<Number T, std::size_t M, std::size_t... N>
+  constexpr auto test_elementwise()
+  {
+    using Num_array = num_array<T, M, N...>;
+    Num_array A, B(2), C(3);
+    for (std::size_t i = 0; i < A.size(); ++i) A[i] = i + 1;
+
+    Num_array D(A);
+    D *= B;
+    assert(D == A * 2);
+    D /= B;
+    assert(D == A);
+    D *= A + A;
+    assert(D == hadamard_product(A, A) * 2);
+    D /= A + A;
+    assert(D == A);
+    assert(hadamard_quotient(hadamard_product(A, B), B) == A);
+
+    assert(fma(A, B, C) == A * 2 + 3);
+    assert(fma(A, B, C + 0) == A * 2 + 3);
+    Num_array Y(C);
+    axpy(2, A, Y);
+    assert(Y == A * 2 + 3);
+    axpy(T(2), A + 0, Y);
+    assert(Y == A * 4 + 3);
+  }
+
+template<Number T, std::size_t M, std::size_t... N>
+  void test_flat()
+  {
+    using Num_array = num_array<T, M, N...>;
+    constexpr std::size_t n = Num_array::n_elements();
+    Num_array A, B;
+    static_assert(sizeof(Num_array) == n * sizeof(T));
+    assert(A.end_flat() - A.begin_flat() == std::ptrdiff_t(n));
+    std::iota(A.begin_flat(), A.end_flat(), T(1));
+    assert(A.data()[n - 1] == T(n));
+    std::memcpy(B.data(), A.data(), n * sizeof(T));
+    assert(B == A);
+    assert(std::accumulate(B.begin_flat(), B.end_flat(), T(0)) == T(n * (n + 1) / 2));
+
+    // Row-major order
+    std::size_t k = 0;
+    const auto check = [&](const auto& x, const auto& self) -> void {
+      if constexpr (std::is_arithmetic_v<std::remove_cvref_t<decltype(x)>>) {
+        assert(x == A.data()[k++]);
+      } else {
+        for (const auto& y : x) self(y, self);
+      }
+    };
+    check(A, check);
+
+    // Expressions of num_arrays and scalars are evaluated in a flat loop,
+    // and compared element by element
+    Num_array C = A * 2 + B - 1;
+    for (std::size_t i = 0; i < n; ++i) assert(C.data()[i] == T(3 * (i + 1) - 1));
+    C -= A + B;
+    assert(C == A - 1 && !(C == A) && C != A);
+    assert(A - A == 0 && A != 0);
+
+    const num_array<double, M, N...> D(A); // converting copy
+    for (std::size_t i = 0; i < n; ++i) assert(D.data()[i] == double(A.data()[i]));
+  }
+
 template<Number T, std::size_t M, std::size_t... N>
   constexpr auto general_tests()
   {
@@ -84,6 +172,9 @@ template<Number T, std::size_t M, std::size_t... N>
     test_constructors<T, M, N...>();
     test_accessors<T, M, N...>();
     test_operators<T, M, N...>();
+    test_expressions<T, M, N...>();
+    test_elementwise<T, M, N...>();
+    test_flat<T, M, N...>();
   }
 
 template<Number T>
@@ -92,9 +183,46 @@ template<Number T>
     general_tests<T, 1>();
     general_tests<T, 4>();
     general_tests<T, 4, 10>();
+    general_tests<T, 7, 9>(); // vectorized kernels with a scalar tail
     //general_tests<T, 100, 4, 3>();
+
+    constexpr num_array<T, 3> a = { 1, 2, 3 };
+    static_assert(fma(a, a, a) == num_array<T, 3>{ 2, 6, 12 });
+    static_assert(*a.data() == 1 && a.end_flat() - a.begin_flat() == 3);
+    constexpr num_array<T, 7, 9> b(2);
+    static_assert(b * 2 - b == b);
   }
 
+// fma() rounds once exactly when the target has vector FMA instructions
+void test_fused()
+{
+  const double x = 1 + 0x1p-30;
+  const num_array<double, 9> a(x), c(-1);
+  const auto y = fma(a, a, c);
+  const auto expected = tb::math::simd::Fusable<double> ? 0x1p-29 + 0x1p-60 : 0x1p-29;
+  assert(y == expected);
+  num_array<double, 9> z(-1);
+  axpy(x, a, z);
+  assert(z == expected);
+}
+
+// Expressions hold temporary num_arrays by value, so they can be stored
+num_array<int, 2, 3> make_array(int x) { return num_array<int, 2, 3>(x); }
+
+void test_temporaries()
+{
+  const num_array<int, 2, 3> b(1);
+  const num_array<int, 3, 2> c = { { 1, 2 }, { 3, 4 }, { 5, 6 } };
+  auto e = make_array(2) + b;
+  auto f = transpose(c) - make_array(1);
+  auto g = 3 * make_array(2);
+  auto h = -make_array(4) / 2;
+  auto k = hadamard_product(make_array(2), make_array(3));
+  const num_array<int, 2, 3> x = e + f + g + h + k;
+  assert(x == (num_array<int, 2, 3>{ { 13, 15, 17 }, { 14, 16, 18 } }));
+  assert(x[1] == (num_array<int, 3>{ 14, 16, 18 }));
+}
+
 int main()
 {
   constexpr num_array<int,0> x; // empty num_array
@@ -103,6 +231,8 @@ int main()
   test_type<unsigned>();
   test_type<float>();
   test_type<double>();
+  test_fused();
+  test_temporaries();
 
   return EXIT_SUCCESS;
 }
\ No newline at end of file
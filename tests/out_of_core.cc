@@ -0,0 +1,105 @@
+#include "tests.h"
+#include "../src/out_of_core.h"
+
+#include <filesystem>
+#include <fstream>
+
+using tb::math::dynamic_num_array, tb::math::out_of_core_matrix, tb::math::Number;
+
+template<typename F>
+  bool throws(F f)
+  {
+    try { f(); } catch (const std::exception&) { return true; }
+    return false;
+  }
+
+template<Number T>
+  void test_out_of_core()
+  {
+    const auto dir = std::filesystem::temp_directory_path();
+    const auto path = dir / "tb_math_out_of_core.tbna", path_t = dir / "tb_math_out_of_core_t.tbna";
+    constexpr std::size_t m = 1000, n = 300;
+
+    // In memory, for comparison
+    dynamic_num_array<T, 2> a(m, n);
+    for (std::size_t i = 0; i < m; ++i)
+      for (std::size_t j = 0; j < n; ++j) a(i, j) = T((i * 31 + j * 17) % 101) - T(50);
+    a(617, 42) = T(1000);
+
+    // A small budget, so there are many tiles and the last one is partial
+    const tb::math::out_of_core_options options{ 64 << 10, 3 };
+    {
+      auto x = out_of_core_matrix<T>::create(path, m, n, options);
+      assert(x.size() == m && x.extent(1) == n && x.n_elements() == m * n);
+      assert(x.tile_rows() == (64 << 10) / 3 / (n * sizeof(T)));
+      assert(sum(x) == 0);
+      for (std::size_t i = 0; i < m; i += 128) {
+        dynamic_num_array<T, 2> rows(std::min<std::size_t>(128, m - i), n);
+        std::copy_n(a.data() + i * n, rows.n_elements(), rows.data());
+        x.write_rows(i, rows);
+      }
+    }
+
+    const out_of_core_matrix<T> x(path, options);
+    std::size_t tiles = 0, rows = 0;
+    x.for_each_tile([&](std::size_t first, const auto& tile) {
+      assert(first == rows && tile.extent(1) == n);
+      for (std::size_t k = 0; k < tile.n_elements(); ++k)
+        assert(tile.data()[k] == a.data()[first * n + k]);
+      ++tiles;
+      rows += tile.size();
+    });
+    assert(rows == m && tiles == (m + x.tile_rows() - 1) / x.tile_rows());
+
+    // Reductions
+    assert(sum(x) == sum(a) && min(x) == min(a) && max(x) == T(1000));
+    assert(argmax(x) == 617 * n + 42);
+    assert(mean(x) == mean(a));
+
+    // Products
+    dynamic_num_array<T, 1> v(n), w(m);
+    for (std::size_t j = 0; j < n; ++j) v[j] = T(j % 7);
+    for (std::size_t i = 0; i < m; ++i) w[i] = T(i % 5) - T(2);
+    assert(matrix_vector_product(x, v) == a * v);
+    assert(vector_matrix_product(w, x) == w * a);
+
+    // Transpose, to another file
+    {
+      const auto t = transpose(x, path_t, options);
+      assert(t.size() == n && t.extent(1) == m);
+      dynamic_num_array<T, 2> b(n, m);
+      t.read_rows(0, b);
+      assert(b == transpose(a));
+    }
+    {
+      // In a single block, read and written whole
+      const auto t = transpose(x, path_t);
+      dynamic_num_array<T, 2> b(n, m);
+      t.read_rows(0, b);
+      assert(b == transpose(a));
+    }
+
+    // A file written by write_binary()
+    {
+      std::ofstream os(path_t, std::ios::binary);
+      write_binary(os, a);
+    }
+    assert(sum(out_of_core_matrix<T>(path_t)) == sum(a));
+
+    // Incompatible element type, extents or range
+    if constexpr (!std::is_same_v<T, float>)
+      assert(throws([&]{ out_of_core_matrix<float> y(path_t); }));
+    assert(throws([&]{ (void)matrix_vector_product(x, w); }));
+    assert(throws([&]{ T e; x.read(m * n, &e, 1); }));
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(path_t);
+  }
+
+int main()
+{
+  test_out_of_core<double>();
+  test_out_of_core<int>();
+
+  return EXIT_SUCCESS;
+}
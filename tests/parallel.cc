@@ -0,0 +1,59 @@
+#include "tests.h"
+#include "../src/parallel.h"
+
+using tb::math::num_array, tb::math::dynamic_num_array, tb::math::thread_pool,
+      tb::math::Number;
+namespace execution = tb::math::execution;
+
+template<Number T>
+  dynamic_num_array<T, 2> make_matrix(std::size_t m, std::size_t n, int seed)
+  {
+    dynamic_num_array<T, 2> result(m, n);
+    for (std::size_t i = 0; i < m; ++i)
+      for (std::size_t j = 0; j < n; ++j) result(i, j) = T((seed + 3 * i + 5 * j) % 13) - 6;
+    return result;
+  }
+
+template<Number T>
+  void test_dynamic(thread_pool& pool)
+  {
+    for (auto [m, n, p] : { std::array<std::size_t, 3>{ 300, 257, 411 },
+                            std::array<std::size_t, 3>{ 97, 1000, 33 },
+                            std::array<std::size_t, 3>{ 3, 4, 5 } }) {
+      const auto A = make_matrix<T>(m, n, 1), B = make_matrix<T>(n, p, 2);
+      assert(matrix_product(execution::par.on(pool), A, B) == matrix_product(A, B));
+      assert(transpose(execution::par.on(pool), A) == transpose(A));
+    }
+    assert(transpose(execution::par, dynamic_num_array<T, 2>(0, 5)).extent(0) == 5);
+
+    bool thrown = false;
+    try { (void)matrix_product(execution::par, make_matrix<T>(2, 3, 0), make_matrix<T>(2, 3, 0)); }
+    catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown);
+  }
+
+template<Number T>
+  void test_fixed(thread_pool& pool)
+  {
+    using Lhs = num_array<T, 150, 160>;
+    using Rhs = num_array<T, 160, 170>;
+    static Lhs a;
+    static Rhs b;
+    for (std::size_t i = 0; i < 150; ++i)
+      for (std::size_t j = 0; j < 160; ++j) a(i, j) = T((i + 2 * j) % 7), b(j, i) = T((i * j) % 5);
+    assert(matrix_product(execution::par.on(pool), a, b) == matrix_product(a, b));
+    assert(transpose(execution::par.on(pool), a) == transpose(a));
+    assert(transpose(execution::par, a + a) == transpose(a + a));
+  }
+
+int main()
+{
+  for (std::size_t n : { 0, 3 }) {
+    thread_pool pool(n);
+    test_dynamic<float>(pool);
+    test_dynamic<double>(pool);
+    test_dynamic<int>(pool);
+    test_fixed<double>(pool);
+  }
+  return EXIT_SUCCESS;
+}
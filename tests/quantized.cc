@@ -0,0 +1,190 @@
+#include "tests.h"
+#include "../src/quantized.h"
+#include "../src/matrix.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+using tb::math::dynamic_num_array, tb::math::num_array, tb::math::quantization;
+
+static_assert(std::same_as<tb::math::detail::accumulator_t<std::int8_t>, std::int32_t>);
+static_assert(dot_product(num_array<std::int8_t, 3>{ 100, 100, 100 },
+                          num_array<std::int8_t, 3>{ 100, 100, -100 }) == 10000);
+// Sums that do not fit in int32 wrap around, in every path
+static_assert(dot_product(num_array<std::int16_t, 3>(-32768), num_array<std::int16_t, 3>(-32768))
+              == -0x40000000);
+
+template<typename T>
+  T
+  random_integer(std::mt19937& g)
+  {
+    return static_cast<T>(g());
+  }
+
+// The sum of the products of the integers, wrapped around to int32 as the
+// kernels do
+template<typename T1, typename T2>
+  std::int32_t
+  reference_dot(const T1* x, std::size_t xs, const T2* y, std::size_t ys, std::size_t n)
+  {
+    std::int64_t sum = 0;
+    for (std::size_t i = 0; i < n; ++i) sum += std::int64_t(x[i * xs]) * y[i * ys];
+    return static_cast<std::int32_t>(static_cast<std::uint32_t>(sum));
+  }
+
+// Dot and matrix products of the integers are exact, for sizes with and
+// without tails, and on both sides of the gemm() threshold
+template<typename T1, typename T2>
+  void test_integer_products()
+  {
+    std::mt19937 g(7);
+    for (const std::size_t n : { 0, 1, 15, 16, 31, 32, 33, 64, 65, 100, 1000, 40000 }) {
+      dynamic_num_array<T1, 1> x(n);
+      dynamic_num_array<T2, 1> y(n);
+      for (auto& v : x) v = random_integer<T1>(g);
+      for (auto& v : y) v = random_integer<T2>(g);
+      const std::int32_t d = dot_product(x, y);
+      assert(d == reference_dot(x.data(), 1, y.data(), 1, n));
+    }
+
+    num_array<T1, 100> u;
+    num_array<T2, 100> v;
+    for (auto& e : u) e = random_integer<T1>(g);
+    for (auto& e : v) e = random_integer<T2>(g);
+    assert(dot_product(u, v) == reference_dot(u.data(), 1, v.data(), 1, 100));
+
+    for (const auto& [m, n, p] : { std::array<std::size_t, 3>{ 3, 5, 7 }, { 33, 70, 35 },
+                                   { 64, 64, 64 }, { 5, 1030, 67 }, { 100, 9, 130 } }) {
+      dynamic_num_array<T1, 2> a(m, n);
+      dynamic_num_array<T2, 2> b(n, p);
+      for (auto& e : a) e = random_integer<T1>(g);
+      for (auto& e : b) e = random_integer<T2>(g);
+      const auto c = matrix_product<std::int32_t>(a, b);
+      dynamic_num_array<T2, 1> x(n);
+      for (std::size_t k = 0; k < n; ++k) x[k] = b(k, 0);
+      const auto y = matrix_vector_product<std::int32_t>(a, x);
+      for (std::size_t i = 0; i < m; ++i) {
+        for (std::size_t j = 0; j < p; ++j) {
+          assert(c(i, j) == reference_dot(a.data() + i * n, 1, b.data() + j, p, n));
+        }
+        assert(y[i] == c(i, 0));
+      }
+    }
+
+    // Below and above the gemm() threshold
+    num_array<T1, 8, 8> s;
+    num_array<T2, 8, 8> t;
+    std::generate(s.begin_flat(), s.end_flat(), [&g] { return random_integer<T1>(g); });
+    std::generate(t.begin_flat(), t.end_flat(), [&g] { return random_integer<T2>(g); });
+    const auto st = matrix_product<std::int32_t>(s, t);
+    const auto sv = matrix_vector_product<std::int32_t>(s, t[0]);
+    for (std::size_t i = 0; i < 8; ++i) {
+      for (std::size_t j = 0; j < 8; ++j) {
+        assert(st(i, j) == reference_dot(&s(i, 0), 1, &t(0, j), 8, 8));
+      }
+      assert(sv[i] == reference_dot(&s(i, 0), 1, &t(0, 0), 1, 8));
+    }
+
+    num_array<T1, 40, 40> a;
+    num_array<T2, 40, 40> b;
+    std::generate(a.begin_flat(), a.end_flat(), [&g] { return random_integer<T1>(g); });
+    std::generate(b.begin_flat(), b.end_flat(), [&g] { return random_integer<T2>(g); });
+    const auto c = matrix_product<std::int32_t>(a, b);
+    for (std::size_t i = 0; i < 40; ++i) {
+      for (std::size_t j = 0; j < 40; ++j) {
+        assert(c(i, j) == reference_dot(&a(i, 0), 1, &b(0, j), 40, 40));
+      }
+    }
+  }
+
+// Quantized values round to the nearest integer, and products of them are
+// those of the reals they stand for
+template<typename Q1, typename Q2>
+  void test_quantized()
+  {
+    std::mt19937 g(11);
+    std::uniform_real_distribution<float> uniform(-1.0f, 3.0f);
+    const std::size_t m = 37, n = 300, p = 41;
+    dynamic_num_array<float, 2> a(m, n), b(n, p);
+    for (auto& e : a) e = uniform(g);
+    for (auto& e : b) e = uniform(g) - 1;
+
+    const auto qa = tb::math::quantize<Q1>(a);
+    const auto qb = tb::math::quantize<Q2>(b);
+    if constexpr (std::is_signed_v<Q1>) assert(qa.params.zero_point == 0);
+    else assert(qa.params.zero_point > 0);
+    const auto da = dequantize(qa);
+    for (std::size_t i = 0; i < a.n_elements(); ++i) {
+      assert(std::abs(da.data()[i] - a.data()[i]) <= qa.params.scale / 2 * 1.001f);
+    }
+
+    // Against the products of the dequantized reals, which differ only by
+    // the rounding of the float sums
+    const auto db = dequantize(qb);
+    const auto c = qa * qb;
+    const auto expected = da * db;
+    for (std::size_t i = 0; i < m; ++i) {
+      for (std::size_t j = 0; j < p; ++j) {
+        assert(std::abs(c(i, j) - expected(i, j)) <= 1e-3f * (1 + std::abs(expected(i, j))));
+      }
+    }
+    // ... and to within the quantization error of the reals themselves
+    const auto exact = a * b;
+    assert(std::abs(c(3, 5) - exact(3, 5)) < 0.05f * n * (qa.params.scale + qb.params.scale));
+
+    const auto qx = tb::math::quantize<Q2>(dynamic_num_array<float, 1>({ n }, -1.5f),
+                                           quantization{ 0.5f, 3 });
+    const auto y = qa * qx;
+    for (std::size_t i = 0; i < m; ++i) {
+      float sum = 0;
+      for (std::size_t k = 0; k < n; ++k) sum += da(i, k) * -1.5f;
+      assert(std::abs(y[i] - sum) <= 1e-3f * (1 + std::abs(sum)));
+    }
+
+    dynamic_num_array<float, 1> r(n);
+    for (std::size_t k = 0; k < n; ++k) r[k] = da(0, k);
+    const auto qr = tb::math::quantize<Q1>(r, qa.params);
+    assert(qr.values(5) == qa.values(0, 5));
+    assert(std::abs(dot_product(qr, qx) - y[0]) <= 1e-3f * (1 + std::abs(y[0])));
+
+    bool thrown = false;
+    try { (void)(qb * qa); }
+    catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown);
+  }
+
+void test_quantization()
+{
+  using tb::math::choose_quantization;
+  assert((choose_quantization<std::int8_t>(-2.0f, 1.0f) == quantization{ 2.0f / 127, 0 }));
+  assert((choose_quantization<std::uint8_t>(0.0f, 255.0f) == quantization{ 1.0f, 0 }));
+  assert((choose_quantization<std::uint8_t>(-1.0f, 0.0f) == quantization{ 1.0f / 255, 255 }));
+  assert((choose_quantization<std::uint8_t>(2.0f, 2.0f).zero_point == 0));
+  assert((choose_quantization<std::int8_t>(0.0f, 0.0f) == quantization{ 1.0f, 0 }));
+
+  const auto q = tb::math::quantize<std::int8_t>(dynamic_num_array<float, 1>({ 4 }, 1.0f),
+                                                quantization{ 0.25f, 0 });
+  assert(q.values[0] == 4);
+  const auto s = tb::math::quantize<std::int8_t>(dynamic_num_array<float, 1>({ 4 }, -100.0f),
+                                                quantization{ 0.25f, 0 });
+  assert(s.values[3] == -128);
+}
+
+int main()
+{
+  test_integer_products<std::int8_t, std::int8_t>();
+  test_integer_products<std::uint8_t, std::int8_t>();
+  test_integer_products<std::int8_t, std::uint8_t>();
+  test_integer_products<std::uint8_t, std::uint8_t>();
+  test_integer_products<std::int16_t, std::int16_t>();
+  test_integer_products<std::int16_t, std::int8_t>();
+  test_quantization();
+  test_quantized<std::int8_t, std::int8_t>();
+  test_quantized<std::uint8_t, std::int8_t>();
+  test_quantized<std::uint8_t, std::uint8_t>();
+  test_quantized<std::int8_t, std::uint8_t>();
+
+  return EXIT_SUCCESS;
+}
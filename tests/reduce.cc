@@ -0,0 +1,145 @@
+#include "tests.h"
+#include "../src/reduce.h"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+using tb::math::num_array, tb::math::dynamic_num_array, tb::math::summation,
+      tb::math::Number;
+
+template<Number T>
+  void test_small()
+  {
+    constexpr num_array<T, 2, 3> a = {{ 1, -2, 3 }, { 4, 5, -6 }};
+    static_assert(sum(a) == 5);
+    static_assert(product(a) == 720);
+    static_assert(min(a) == -6 && max(a) == 5);
+    static_assert(argmin(a) == 5 && argmax(a) == 4);
+    static_assert(norm_l1(a) == 21 && norm_inf(a) == 6);
+    static_assert(sum(a + a) == 10);
+
+    assert(sum(a) == 5 && product(a) == 720);
+    assert(min(a) == -6 && max(a) == 5);
+    assert(argmin(a) == 5 && argmax(a) == 4);
+    assert(norm_l1(a) == 21 && norm_inf(a) == 6);
+    using R = std::conditional_t<std::floating_point<T>, T, double>;
+    assert(mean(a) == R(5) / 6);
+    assert(norm_l2(a) == std::sqrt(R(91)));
+
+    using Row = num_array<T, 3>;
+    using Column = num_array<T, 2>;
+    assert((sum<0>(a) == Row{ 5, 3, -3 }));
+    assert((sum<1>(a) == Column{ 2, 3 }));
+    assert((min<0>(a) == Row{ 1, -2, -6 }));
+    assert((max<1>(a) == Column{ 3, 5 }));
+    assert((product<1>(a) == Column{ -6, -120 }));
+    assert(sum<0>(a[0]) == 2);
+    assert((sum<0>(a - a) == Row{ 0, 0, 0 }));
+    static_assert(sum<1>(a)[1] == 3);
+
+    constexpr num_array<T, 2, 3, 4> b(1);
+    assert((sum<1>(b) == num_array<T, 2, 4>(3)));
+    assert((sum<2>(b) == num_array<T, 2, 3>(4)));
+    assert((mean<2>(b) == num_array<R, 2, 3>(1)));
+  }
+
+template<Number T>
+  void test_large()
+  {
+    // Long enough to use the vector kernels, with a tail
+    dynamic_num_array<T, 1> x(1003);
+    for (std::size_t i = 0; i < x.size(); ++i) x[i] = T(int(i % 17) - 8);
+    x[700] = T(-20);
+    x[33] = T(30);
+
+    T s = 0, l1 = 0;
+    for (const auto& y : x) { s += y; l1 += y < 0 ? T(-y) : y; }
+    assert(sum(x) == s && norm_l1(x) == l1);
+    assert(min(x) == -20 && argmin(x) == 700);
+    assert(max(x) == 30 && argmax(x) == 33);
+    assert(norm_inf(x) == 30);
+
+    static num_array<T, 40, 50> a;
+    for (std::size_t i = 0; i < 40; ++i)
+      for (std::size_t j = 0; j < 50; ++j) a(i, j) = T(int((i * 7 + j) % 11) - 5);
+    T t = 0;
+    for (const auto& row : a) for (const auto& y : row) t += y;
+    assert(sum(a) == t);
+    assert(sum(tb::math::view(a)) == t);
+    assert(sum(a * T(2)) == 2 * t);
+    num_array<T, 50> columns = sum<0>(a);
+    assert(sum(columns) == t && sum(sum<1>(a)) == t);
+
+    bool thrown = false;
+    try { (void)min(dynamic_num_array<T, 2>(0, 3)); }
+    catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown);
+  }
+
+template<typename T>
+  void test_accuracy()
+  {
+    // 1 followed by many values too small to change a running sum of 1
+    const std::size_t n = 1 << 20;
+    const T eps = std::numeric_limits<T>::epsilon() / 4;
+    dynamic_num_array<T, 1> x(n);
+    x = eps;
+    x[0] = 1;
+    const T exact = 1 + (n - 1) * eps;
+    assert(std::abs(sum(x, summation::kahan) - exact) <= 2 * std::numeric_limits<T>::epsilon());
+    assert(std::abs(sum(x, summation::pairwise) - exact) <= 8 * std::numeric_limits<T>::epsilon());
+    assert(std::abs(mean(x, summation::kahan) - exact / n) <= exact / n * 1e-5);
+  }
+
+// The sums of narrow integers do not overflow their type
+void test_narrow_integers()
+{
+  using std::int8_t, std::uint8_t, std::int16_t;
+  constexpr num_array<uint8_t, 4> a{ 200, 200, 200, 200 };
+  static_assert(std::same_as<decltype(sum(a)), std::uint64_t>);
+  static_assert(sum(a) == 800 && mean(a) == 200);
+  assert(sum(a) == 800 && mean(a) == 200 && norm_l1(a) == 800);
+  assert(norm_l2(a) == 400);
+  assert((mean<0>(a) == 200));
+
+  constexpr num_array<int8_t, 2> b{ 100, 100 };
+  static_assert(sum(b) == 200 && norm_l1(-b) == 200);
+  assert(std::abs(norm_l2(b) - 100 * std::sqrt(2.0)) < 1e-12);
+  assert(norm_l1(num_array<int8_t, 3>{ -128, -128, 1 }) == 257);
+
+  const num_array<uint8_t, 4, 3> y(200);
+  static_assert(std::same_as<decltype(sum<0>(y)), num_array<std::uint64_t, 3>>);
+  assert(sum(y) == 2400 && (sum<0>(y) == num_array<std::uint64_t, 3>(800)));
+  assert((sum<1>(y) == num_array<std::uint64_t, 4>(600)));
+  assert((product<1>(y) == num_array<std::uint64_t, 4>(8000000)));
+  static_assert(sum<0>(b) == 200 && product<0>(b) == 10000);
+
+  constexpr num_array<int16_t, 2, 2> c = {{ 30000, 30000 }, { -30000, 30000 }};
+  static_assert(sum(c) == 60000 && norm_l1(c) == 120000);
+  assert((mean<1>(c) == num_array<double, 2>{ 30000, 0 }));
+
+  dynamic_num_array<uint8_t, 1> x(1000);
+  x = uint8_t(255);
+  assert(sum(x) == 255000 && mean(x) == 255);
+  assert(norm_l2(x) == 255 * std::sqrt(1000.0));
+}
+
+template<Number T>
+  void test_type()
+  {
+    test_small<T>();
+    test_large<T>();
+  }
+
+int main()
+{
+  test_type<float>();
+  test_type<double>();
+  test_type<int>();
+  test_type<long>();
+  test_accuracy<float>();
+  test_accuracy<double>();
+  test_narrow_integers();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+#include "tests.h"
+#include "../src/matrix.h"
+#include "../src/serialization.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+using tb::math::num_array, tb::math::dynamic_num_array, tb::math::Number;
+
+template<typename F>
+  bool throws(F f)
+  {
+    try { f(); } catch (const std::exception&) { return true; }
+    return false;
+  }
+
+template<Number T>
+  void test_streams()
+  {
+    using Matrix = num_array<T, 3, 4>;
+    Matrix a;
+    for (std::size_t i = 0; i < 3; ++i)
+      for (std::size_t j = 0; j < 4; ++j) a(i, j) = T(i * 4 + j) - T(5);
+
+    // A single array
+    std::stringstream s;
+    write_binary(s, a);
+    assert(s.str().size() == 64 + sizeof(Matrix));
+    Matrix b(T(0));
+    read_binary(s, b);
+    assert(a == b);
+
+    // A vector of arrays
+    std::vector<Matrix> v(5, a);
+    v[3] *= T(2);
+    std::stringstream t;
+    write_binary(t, v);
+    std::vector<Matrix> w(5);
+    read_binary(t, w);
+    assert(v == w);
+
+    // Incompatible element type, extents or number of arrays
+    t.seekg(0);
+    assert(throws([&]{ num_array<T, 4, 3> c; read_binary(t, c); }));
+    t.seekg(0);
+    assert(throws([&]{ std::vector<Matrix> c(4); read_binary(t, c); }));
+    t.seekg(0);
+    assert(throws([&]{ num_array<std::int8_t, 3, 4> c; read_binary(t, c); }));
+    std::stringstream u("not a num_array file, but long enough to hold a header");
+    assert(throws([&]{ read_binary(u, b); }));
+
+    // Dynamic arrays take the extents of the file
+    std::stringstream d;
+    write_binary(d, dynamic_num_array<T, 2>(a));
+    dynamic_num_array<T, 2> x;
+    read_binary(d, x);
+    assert(x.extent(0) == 3 && x.extent(1) == 4 && x(2, 3) == a(2, 3));
+  }
+
+// A file written on a machine of the other byte order
+void test_byte_order()
+{
+  const num_array<std::uint32_t, 2> a = { 0x01020304, 0xa0b0c0d0 };
+  std::stringstream s;
+  write_binary(s, a);
+  auto bytes = s.str();
+  auto& h = *reinterpret_cast<tb::math::array_header*>(bytes.data());
+  h.endianness = 3 - h.endianness;
+  tb::math::detail::swap_bytes(h);
+  tb::math::detail::swap_bytes(bytes.data() + sizeof(h), 1, 8); // the extent
+  tb::math::detail::swap_bytes(bytes.data() + 64, 2, 4);
+
+  std::stringstream t(bytes);
+  num_array<std::uint32_t, 2> b;
+  read_binary(t, b);
+  assert(a == b);
+}
+
+template<Number T>
+  void test_mapped()
+  {
+    using Matrix = num_array<T, 4, 4>;
+    std::vector<Matrix> v(3);
+    for (std::size_t k = 0; k < 3; ++k)
+      for (std::size_t i = 0; i < 4; ++i)
+        for (std::size_t j = 0; j < 4; ++j) v[k](i, j) = T(k * 100 + i * 4 + j);
+
+    const auto path = std::filesystem::temp_directory_path() / "tb_math_serialization.tbna";
+    {
+      std::ofstream out(path, std::ios::binary);
+      write_binary(out, v);
+    }
+    {
+      tb::math::mapped_array_file f(path.c_str());
+      assert(f.count() == 3 && f.rank() == 2 && f.n_elements() == 16);
+      assert(reinterpret_cast<std::uintptr_t>(f.data<T>()) % 64 == 0);
+      const auto m = f.view<T, 4, 4>(2);
+      assert(m == v[2] && m(1, 2) == T(206));
+      assert(matrix_product(f.view<T, 4, 4>(0), v[1]) == matrix_product(v[0], v[1]));
+      assert(throws([&]{ (void)f.view<T, 2, 8>(); }));
+      assert(throws([&]{ (void)f.data<T>(3); }));
+    }
+    std::filesystem::remove(path);
+  }
+
+// Truncated and corrupt files are rejected, not read out of bounds
+template<Number T>
+  void test_corrupt()
+  {
+    using Matrix = num_array<T, 4, 4>;
+    const auto path = std::filesystem::temp_directory_path() / "tb_math_corrupt.tbna";
+    std::stringstream s;
+    write_binary(s, std::vector<Matrix>(3, Matrix(T(1))));
+    const std::string good = s.str();
+
+    // By read_binary() into 3 arrays, into a dynamic_num_array (which takes
+    // the first one), and by mapping the file
+    const auto read_all = [](const std::string& bytes) {
+      std::stringstream t(bytes);
+      std::vector<Matrix> v(3);
+      return throws([&]{ read_binary(t, v); });
+    };
+    const auto read_first = [](const std::string& bytes) {
+      std::stringstream t(bytes);
+      dynamic_num_array<T, 2> x;
+      return throws([&]{ read_binary(t, x); });
+    };
+    const auto map = [&path](const std::string& bytes) {
+      std::ofstream(path, std::ios::binary).write(bytes.data(), std::streamsize(bytes.size()));
+      return throws([&]{ tb::math::mapped_array_file f(path.c_str()); (void)f.data<T>(); });
+    };
+    const auto edit = [&good](auto f) {
+      std::string bytes = good;
+      f(*reinterpret_cast<tb::math::array_header*>(bytes.data()),
+        reinterpret_cast<std::uint64_t*>(bytes.data() + sizeof(tb::math::array_header)));
+      return bytes;
+    };
+    assert(!read_all(good) && !read_first(good) && !map(good));
+
+    const auto short_last = good.substr(0, good.size() - 1);
+    assert(read_all(short_last) && !read_first(short_last) && map(short_last));
+    const auto short_first = good.substr(0, 64 + sizeof(T));
+    assert(read_all(short_first) && read_first(short_first) && map(short_first));
+    const auto short_header = good.substr(0, 40);
+    assert(read_all(short_header) && read_first(short_header) && map(short_header));
+
+    // Extents whose product, or its size in bytes, overflows to a small number
+    for (const auto& bytes : {
+           edit([](auto&, auto* e) { e[0] = std::uint64_t(1) << 62; e[1] = 4; }),
+           edit([](auto&, auto* e) { e[0] = e[1] = std::uint64_t(1) << 32; }) }) {
+      assert(read_all(bytes) && read_first(bytes) && map(bytes));
+    }
+    const auto count = edit([](auto& h, auto*) { h.count = ~std::uint64_t(0) / 64 + 1; });
+    assert(read_all(count) && map(count));
+
+    // Extents past the offset of the elements, and elements misaligned for T
+    const auto rank = edit([](auto& h, auto*) { h.rank = 5; });
+    assert(read_all(rank) && read_first(rank) && map(rank));
+    const auto offset = edit([](auto& h, auto*) { h.data_offset = 49; });
+    assert(map(offset));
+    std::filesystem::remove(path);
+  }
+
+int main()
+{
+  test_streams<float>();
+  test_streams<double>();
+  test_streams<int>();
+  test_byte_order();
+  test_mapped<float>();
+  test_mapped<std::int16_t>();
+  test_corrupt<float>();
+  test_corrupt<std::int16_t>();
+
+  return EXIT_SUCCESS;
+}
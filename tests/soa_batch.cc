@@ -0,0 +1,115 @@
+#include "tests.h"
+#include "../src/soa_batch.h"
+
+#include <cmath>
+#include <vector>
+
+using tb::math::num_array, tb::math::soa_batch, tb::math::Number;
+
+template<Number T>
+  bool close(T x, T y)
+  {
+    if constexpr (std::is_floating_point_v<T>)
+      return std::abs(x - y) <= T(1e-4) * std::max(T(1), std::abs(y));
+    else
+      return x == y;
+  }
+
+template<Number T, std::size_t N>
+  bool close(const num_array<T, N>& x, const num_array<T, N>& y)
+  {
+    for (std::size_t k = 0; k < N; ++k) if (!close(x[k], y[k])) return false;
+    return true;
+  }
+
+// Returns n vectors with small, distinct non-zero components.
+template<Number T, std::size_t N>
+  std::vector<num_array<T, N>> make_vectors(std::size_t n, int seed)
+  {
+    std::vector<num_array<T, N>> result(n);
+    for (std::size_t i = 0; i < n; ++i)
+      for (std::size_t k = 0; k < N; ++k)
+        result[i][k] = T(1 + (seed + 7 * i + 3 * k) % 11);
+    return result;
+  }
+
+template<Number T>
+  void test_container()
+  {
+    using Vec3 = num_array<T, 3>;
+    soa_batch<Vec3> b;
+    assert(b.empty() && b.capacity() == 0);
+    for (int i = 0; i < 100; ++i) b.push_back(Vec3{ T(i), T(i + 1), T(i + 2) });
+    assert(b.size() == 100 && b.capacity() >= 100);
+    assert((b[42] == Vec3{ 42, 43, 44 }));
+    assert(b.component(1)[42] == 43);
+
+    b.set(3, Vec3{ 7, 8, 9 });
+    assert((b[3] == Vec3{ 7, 8, 9 }));
+
+    b.resize(5);
+    assert((b.size() == 5 && b[4] == Vec3{ 4, 5, 6 }));
+    b.resize(8);
+    assert((b[7] == Vec3{ 0, 0, 0 }));
+
+    const soa_batch<Vec3> c = {{ 1, 2, 3 }, { 4, 5, 6 }};
+    assert((c.size() == 2 && c[1] == Vec3{ 4, 5, 6 }));
+    const soa_batch<Vec3> d(3, Vec3{ 1, 1, 1 });
+    assert((d[2] == Vec3{ 1, 1, 1 }));
+  }
+
+template<Number T, std::size_t N>
+  void test_operations(std::size_t n)
+  {
+    const auto xs = make_vectors<T, N>(n, 1), ys = make_vectors<T, N>(n, 5);
+    const soa_batch<num_array<T, N>> v(xs.begin(), xs.end()), w(ys.begin(), ys.end());
+    assert(v.size() == n);
+
+    const auto dots = dot_product(v, w);
+    for (std::size_t i = 0; i < n; ++i) assert(close(dots[i], dot_product(xs[i], ys[i])));
+
+    if constexpr (N == 3) {
+      const auto zs = make_vectors<T, N>(n, 9);
+      const soa_batch<num_array<T, N>> u(zs.begin(), zs.end());
+      const auto crosses = cross_product(v, w);
+      const auto triples = triple_product(u, v, w);
+      for (std::size_t i = 0; i < n; ++i) {
+        assert(close(crosses[i], cross_product(xs[i], ys[i])));
+        assert(close(triples[i], triple_product(zs[i], xs[i], ys[i])));
+      }
+    }
+
+    if constexpr (std::is_floating_point_v<T>) {
+      const auto lengths = magnitude(v);
+      const auto units = dir(v);
+      const auto projections = projection(v, w);
+      for (std::size_t i = 0; i < n; ++i) {
+        assert(close(lengths[i], magnitude(xs[i])));
+        assert(close(units[i], dir(xs[i])));
+        assert(close(projections[i], projection(xs[i], ys[i])));
+      }
+    }
+
+    bool thrown = false;
+    try { (void)dot_product(v, soa_batch<num_array<T, N>>(n + 1)); }
+    catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown);
+  }
+
+template<Number T>
+  void test_type()
+  {
+    test_container<T>();
+    for (std::size_t n : { 0, 1, 7, 16, 33, 1000 }) {
+      test_operations<T, 3>(n);
+      test_operations<T, 4>(n);
+    }
+  }
+
+int main()
+{
+  test_type<float>();
+  test_type<double>();
+  test_type<int>();
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,115 @@
+#include "tests.h"
+#include "../src/sparse.h"
+
+using tb::math::coo_matrix, tb::math::csr_matrix, tb::math::dynamic_num_array,
+      tb::math::num_array, tb::math::Number;
+namespace execution = tb::math::execution;
+
+template<typename F>
+  bool throws(F f)
+  {
+    try { f(); } catch (const std::exception&) { return true; }
+    return false;
+  }
+
+template<Number T>
+  void test_conversions()
+  {
+    constexpr num_array<T, 3, 4> a = {{ 1, 0, 0, 2 }, { 0, 0, 0, 0 }, { 0, 3, 4, 0 }};
+    const csr_matrix<T> x(a);
+    assert(x.size() == 3 && x.extent(1) == 4 && x.non_zeros() == 4);
+    assert((std::equal(x.row_offsets().begin(), x.row_offsets().end(),
+                       std::initializer_list<unsigned>{ 0, 2, 2, 4 }.begin())));
+    assert(x(0, 3) == 2 && x(2, 2) == 4 && x(1, 1) == 0 && x(2, 0) == 0);
+    assert((x.dense() == dynamic_num_array<T, 2>(a)));
+    assert(csr_matrix<T>(dynamic_num_array<T, 2>(a)).dense() == x.dense());
+
+    // Triplets in any order, with duplicates summed
+    coo_matrix<T> y(3, 4);
+    y.insert(2, 2, 3);
+    y.insert(0, 3, 2);
+    y.insert(2, 1, 3);
+    y.insert(0, 0, 1);
+    y.insert(2, 2, 1);
+    assert(y.non_zeros() == 5);
+    assert(y.dense() == x.dense());
+    const csr_matrix<T> z(y);
+    assert(z.non_zeros() == 4 && z.dense() == x.dense());
+    assert((std::equal(z.columns().begin(), z.columns().end(),
+                       std::initializer_list<unsigned>{ 0, 3, 1, 2 }.begin())));
+    assert(coo_matrix<T>(z).dense() == x.dense() && coo_matrix<T>(a).non_zeros() == 4);
+
+    assert(throws([&]{ y.insert(3, 0, 1); }));
+    assert(throws([&]{ csr_matrix<T, std::uint8_t>(300, 2); }));
+  }
+
+template<Number T>
+  void test_products()
+  {
+    num_array<T, 7, 9> a(0);
+    for (std::size_t i = 0; i < 7; ++i) a(i, (i * 4) % 9) = T(i + 1), a(i, (i + 5) % 9) = T(2);
+    const csr_matrix<T> x(a);
+
+    // SpMV, with num_array, expression and dynamic vectors
+    num_array<T, 9> v;
+    for (std::size_t j = 0; j < 9; ++j) v[j] = T(j) - T(3);
+    const dynamic_num_array<T, 1> expected(a * v);
+    assert(matrix_vector_product(x, v) == expected);
+    assert(x * (v + 0) == expected);
+    assert((x * dynamic_num_array<T, 1>(v) == expected));
+    assert(matrix_vector_product(coo_matrix<T>(x), v) == expected);
+    assert(matrix_vector_product(execution::par, x, v) == expected);
+
+    // SpMM
+    num_array<T, 9, 5> b;
+    for (std::size_t k = 0; k < 9; ++k)
+      for (std::size_t j = 0; j < 5; ++j) b(k, j) = T(k * 5 + j) - T(20);
+    const dynamic_num_array<T, 2> c(a * b);
+    assert(matrix_product(x, b) == c);
+    assert(x * transpose(transpose(b)) == c);
+    assert((x * dynamic_num_array<T, 2>(b) == c));
+    assert(matrix_product(execution::par, x, b) == c);
+
+    assert(throws([&]{ (void)(x * dynamic_num_array<T, 1>({ 7 }, T(1))); }));
+    assert(throws([&]{ (void)(x * dynamic_num_array<T, 2>({ 7, 2 }, T(1))); }));
+  }
+
+// A large matrix, with a few dense rows, so that the threads get parts of
+// very different numbers of rows
+template<Number T>
+  void test_parallel()
+  {
+    constexpr std::size_t m = 20'000, n = 5'000;
+    coo_matrix<T> y(m, n);
+    for (std::size_t i = 0; i < m; ++i) {
+      const std::size_t k = i % 1000 == 0 ? n : 3;
+      for (std::size_t j = 0; j < k; ++j) y.insert(i, (i * 7 + j * 13) % n, T((i + j) % 5) - T(2));
+    }
+    const csr_matrix<T> x(y);
+    assert(x.non_zeros() > tb::math::detail::parallel_sparse_threshold);
+
+    const auto rows = tb::math::detail::balanced_rows(x.row_offsets(), 8);
+    assert(rows.front() == 0 && rows.back() == m && std::is_sorted(rows.begin(), rows.end()));
+
+    dynamic_num_array<T, 1> v({ n }, T(0));
+    for (std::size_t j = 0; j < n; ++j) v[j] = T(j % 11) - T(5);
+    assert(matrix_vector_product(execution::par, x, v) == matrix_vector_product(x, v));
+    assert(matrix_vector_product(x, v) == matrix_vector_product(y, v));
+
+    dynamic_num_array<T, 2> b({ n, 3 }, T(1));
+    assert(matrix_product(execution::par, x, b) == x * b);
+    tb::math::thread_pool pool(3);
+    assert(matrix_product(execution::par.on(pool), x, b) == x * b);
+  }
+
+int main()
+{
+  test_conversions<int>();
+  test_conversions<double>();
+  test_products<int>();
+  test_products<double>();
+  test_parallel<int>();
+  test_parallel<double>();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,120 @@
+#include "tests.h"
+#include "../src/streaming.h"
+
+#include <limits>
+#include <sstream>
+#include <string>
+
+using tb::math::num_array, tb::math::Number;
+
+template<Number T>
+  void test_streams()
+  {
+    const num_array<T, 2, 3> a = {{ 1, 2, 3 }, { 4, 5, 6 }};
+    std::ostringstream out;
+    out << a;
+    assert(out.str() == "{ { 1, 2, 3 }, { 4, 5, 6 } }");
+
+    num_array<T, 2, 3> b(T(0));
+    std::istringstream in(out.str());
+    assert(in >> b);
+    assert(a == b);
+
+    std::istringstream compact("{{1,2,3},{4,5,6}}  { 1, 2 }");
+    assert(compact >> b && a == b);
+    assert(!(compact >> b)); // too few elements
+  }
+
+template<Number T>
+  void test_chars()
+  {
+    num_array<T, 3, 2> a;
+    for (std::size_t i = 0; i < 3; ++i)
+      for (std::size_t j = 0; j < 2; ++j) a(i, j) = T(1) / T(i * 2 + j + 3);
+    a(2, 1) = std::numeric_limits<T>::max();
+
+    char buffer[256];
+    const auto w = to_chars(buffer, buffer + sizeof(buffer), a);
+    assert(w.ec == std::errc());
+
+    // The round trip is exact
+    num_array<T, 3, 2> b(T(0));
+    const auto r = from_chars(buffer, w.ptr, b);
+    assert(r.ec == std::errc() && r.ptr == w.ptr);
+    assert(a == b);
+
+    // Not enough room
+    assert(to_chars(buffer, buffer + 10, a).ec == std::errc::value_too_large);
+  }
+
+void test_parse()
+{
+  num_array<int, 2, 2> x;
+  parse(" {{ 1, -2 },\n { 3, 4 }} ", x);
+  assert((x == num_array<int, 2, 2>{{ 1, -2 }, { 3, 4 }}));
+
+  num_array<double, 3> v;
+  parse("{ 0.5, 1e-3, -2 }", v);
+  assert((v == num_array<double, 3>{ 0.5, 1e-3, -2 }));
+
+  const auto fails = [](const char* s) {
+    num_array<int, 2, 2> y;
+    try { parse(s, y); } catch (const std::invalid_argument&) { return true; }
+    return false;
+  };
+  assert(fails("{ { 1, 2 }, { 3, 4 } } 5"));  // trailing characters
+  assert(fails("{ { 1, 2 }, { 3 } }"));       // too few
+  assert(fails("{ { 1, 2, 3 }, { 4, 5 } }")); // too many
+  assert(fails("{ { 1, x }, { 3, 4 } }"));
+  assert(fails("{ { 1, 99999999999 }, { 3, 4 } }"));
+
+  num_array<unsigned char, 2> c;
+  const char s[] = "{ 1, 300 }";
+  const auto r = from_chars(s, s + sizeof(s) - 1, c);
+  assert(r.ec == std::errc::result_out_of_range);
+}
+
+#ifdef __cpp_lib_format
+void test_format()
+{
+  // The shortest forms that round-trip, as to_chars() writes them
+  const num_array<double, 3> v = { 0.1, 1.0 / 3, -2 };
+  assert(std::format("{}", v) == "{ 0.1, 0.3333333333333333, -2 }");
+  num_array<double, 3> w(0.0);
+  parse(std::format("{}", v), w);
+  assert(w == v);
+  assert(std::format("{}", num_array<float, 2>{ 0.1f, 1e-8f }) == "{ 0.1, 1e-08 }");
+
+  // A format specification applies to each element
+  assert(std::format("{:.3f}", v) == "{ 0.100, 0.333, -2.000 }");
+  assert(std::format("[{:+}]", num_array<int, 2>{ 1, -2 }) == "[{ +1, -2 }]");
+
+  // Nested, and of expressions
+  const num_array<int, 2, 3> a = {{ 1, 2, 3 }, { 4, 5, 6 }};
+  assert(std::format("{}", a) == "{ { 1, 2, 3 }, { 4, 5, 6 } }");
+  assert(std::format("{:>2}", a) == "{ {  1,  2,  3 }, {  4,  5,  6 } }");
+  assert(std::format("{:.1f}", a * 0.5) == "{ { 0.5, 1.0, 1.5 }, { 2.0, 2.5, 3.0 } }");
+  const num_array<int, 2, 2, 2> b = {{{ 1, 2 }, { 3, 4 }}, {{ 5, 6 }, { 7, 8 }}};
+  assert(std::format("{}", b) == "{ { { 1, 2 }, { 3, 4 } }, { { 5, 6 }, { 7, 8 } } }");
+#ifdef __cpp_lib_format_ranges
+  // Not formatted as ranges, with brackets
+  static_assert(std::format_kind<num_array<int, 2, 3>> == std::range_format::disabled);
+  assert(std::format("{}", a[1]) == "{ 4, 5, 6 }");
+#endif
+}
+#endif
+
+int main()
+{
+  test_streams<int>();
+  test_streams<double>();
+  test_chars<float>();
+  test_chars<double>();
+  test_chars<int>();
+  test_parse();
+#ifdef __cpp_lib_format
+  test_format();
+#endif
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,62 @@
+#include "tests.h"
+#include "../src/thread_pool.h"
+
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+using tb::math::thread_pool;
+
+void test_parallel_for(thread_pool& pool)
+{
+  for (std::size_t n : { 0, 1, 10, 1000, 100000 }) {
+    for (std::size_t grain : { 0, 1, 7, 4096 }) {
+      std::vector<int> visits(n, 0);
+      pool.parallel_for(0, n, grain, [&](std::size_t i, std::size_t j) {
+        assert(i < j && (grain == 0 || j - i <= grain));
+        for (; i < j; ++i) ++visits[i];
+      });
+      assert(std::all_of(visits.begin(), visits.end(), [](int x){ return x == 1; }));
+    }
+  }
+}
+
+void test_nested(thread_pool& pool)
+{
+  constexpr std::size_t n = 64;
+  std::vector<long> sums(n, 0);
+  pool.parallel_for(0, n, 1, [&](std::size_t i, std::size_t j) {
+    for (; i < j; ++i) {
+      std::vector<long> row(1000);
+      pool.parallel_for(0, row.size(), 10, [&](std::size_t k, std::size_t l) {
+        for (; k < l; ++k) row[k] = static_cast<long>(i * k);
+      });
+      sums[i] = std::accumulate(row.begin(), row.end(), 0L);
+    }
+  });
+  for (std::size_t i = 0; i < n; ++i) assert(sums[i] == static_cast<long>(i * 999 * 500));
+}
+
+void test_exceptions(thread_pool& pool)
+{
+  bool thrown = false;
+  try {
+    pool.parallel_for(0, 1000, 10, [](std::size_t i, std::size_t j) {
+      if (i <= 500 && 500 < j) throw std::runtime_error("500");
+    });
+  } catch (const std::runtime_error&) { thrown = true; }
+  assert(thrown);
+}
+
+int main()
+{
+  for (std::size_t n : { 0, 1, 4 }) {
+    thread_pool pool(n);
+    assert(pool.size() == n);
+    test_parallel_for(pool);
+    test_nested(pool);
+    test_exceptions(pool);
+  }
+  test_parallel_for(thread_pool::default_pool());
+  return EXIT_SUCCESS;
+}
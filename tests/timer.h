@@ -1,7 +1,9 @@
 #pragma once
 
+#include <algorithm>
 #include <functional>
 #include <chrono>
+#include <vector>
 
 class Timer {
   public:
@@ -39,4 +41,67 @@ template<typename F>
     }
     timer.stop();
     return timer.elapsed().count();
-  }
\ No newline at end of file
+  }
+
+// Prevents the compiler from optimizing away the computation of value, or
+// (with clobber_memory) from assuming that memory is unchanged.
+template<typename T>
+  inline void do_not_optimize(const T& value)
+  {
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+  }
+
+inline void clobber_memory()
+{
+#if defined(__GNUC__)
+  asm volatile("" : : : "memory");
+#endif
+}
+
+// Statistics of the time per call of a benchmarked function, in ns.
+struct Sample_stats {
+  std::size_t samples = 0;
+  std::size_t iterations = 0; // calls per sample
+  double min = 0, p10 = 0, median = 0, p90 = 0, mean = 0;
+};
+
+// Times func after warming up, in samples of enough calls to take at least
+// min_sample_ns each, and returns statistics of the time per call.
+template<typename F>
+  Sample_stats measure(F func, std::size_t samples, double min_sample_ns)
+  {
+    // Warm up (caches, branch predictors, page faults) and find the number
+    // of calls per sample.
+    std::size_t iterations = 1;
+    for (;;) {
+      const auto t = static_cast<double>(benchmark(func, iterations));
+      if (t >= min_sample_ns || iterations >= (std::size_t(1) << 30)) break;
+      iterations *= t > 0 ? std::clamp<std::size_t>(
+        static_cast<std::size_t>(min_sample_ns / t * 1.2), 2, 100) : 100;
+    }
+
+    std::vector<double> times(std::max<std::size_t>(samples, 1));
+    for (auto& t : times) {
+      t = static_cast<double>(benchmark(func, iterations)) / static_cast<double>(iterations);
+    }
+    std::sort(times.begin(), times.end());
+
+    const auto percentile = [&](double p) {
+      return times[static_cast<std::size_t>(p * static_cast<double>(times.size() - 1) + 0.5)];
+    };
+    Sample_stats stats;
+    stats.samples = times.size();
+    stats.iterations = iterations;
+    stats.min = times.front();
+    stats.p10 = percentile(0.1);
+    stats.median = percentile(0.5);
+    stats.p90 = percentile(0.9);
+    for (auto t : times) stats.mean += t;
+    stats.mean /= static_cast<double>(times.size());
+    return stats;
+  }
@@ -0,0 +1,156 @@
+#include "tests.h"
+#include "../src/transform.h"
+
+#include <cmath>
+#include <numbers>
+#include <span>
+#include <vector>
+
+using tb::math::mat3, tb::math::mat4, tb::math::quaternion, tb::math::vec3;
+
+static_assert(transform_point(compose(tb::math::translation(vec3<int>{ 1, 2, 3 }),
+                                      tb::math::scaling(vec3<int>{ 2, 2, 2 })),
+                              vec3<int>{ 1, 1, 1 }) == vec3<int>{ 3, 4, 5 });
+
+template<typename T, std::size_t N>
+  bool near(const tb::math::num_array<T, N, N>& x, const tb::math::num_array<T, N, N>& y,
+            double tolerance)
+  {
+    for (std::size_t i = 0; i < x.size(); ++i)
+      for (std::size_t j = 0; j < x[i].size(); ++j)
+        if (std::abs(x[i][j] - y[i][j]) > tolerance) return false;
+    return true;
+  }
+
+template<typename T>
+  bool near(const vec3<T>& x, const vec3<T>& y, double tolerance)
+  {
+    return std::abs(x[0] - y[0]) <= tolerance && std::abs(x[1] - y[1]) <= tolerance
+        && std::abs(x[2] - y[2]) <= tolerance;
+  }
+
+template<typename T>
+  bool near(const quaternion<T>& p, const quaternion<T>& q, double tolerance)
+  {
+    return std::abs(p.w - q.w) <= tolerance && near(p.v, q.v, tolerance);
+  }
+
+template<std::floating_point T>
+  void test_quaternions()
+  {
+    constexpr T pi = std::numbers::pi_v<T>;
+    const T eps = sizeof(T) == 4 ? 1e-5 : 1e-12;
+    const vec3<T> x = { 1, 0, 0 }, y = { 0, 1, 0 }, z = { 0, 0, 1 };
+    const auto rz = axis_angle(z, pi / 2);
+    assert(near(rotate(rz, x), y, eps) && near(rotate(rz, z), z, eps));
+    assert(near(rotation_matrix(rz) * x, y, eps));
+
+    const vec3<T> axis = dir(vec3<T>{ 1, -2, 3 }), v = { T(0.5), 4, -2 };
+    const auto p = axis_angle(axis, T(0.7)), q = axis_angle(dir(vec3<T>{ -3, 1, 1 }), T(2.1));
+    assert(std::abs(magnitude(p) - 1) < eps);
+    assert(near(rotate(p, v), rotation_matrix(p) * v, eps * 10));
+    assert(near(rotate(p * q, v), rotate(p, rotate(q, v)), eps * 10));
+    assert(near(rotation_matrix(p * q), rotation_matrix(p) * rotation_matrix(q), eps));
+    assert(near(rotate(conjugate(p), rotate(p, v)), v, eps * 10));
+    const quaternion<T> s = { 2, { 0, 1, -1 } };
+    assert(near(s * inverse(s), quaternion<T>{ 1, { 0, 0, 0 } }, eps));
+    assert(near(normalize(s), quaternion<T>{ T(2 / std::sqrt(6.0)), s.v / T(std::sqrt(6.0)) }, eps));
+
+    // The four cases of to_quaternion(), with the sign of w made positive
+    for (const auto& r : { p, q, axis_angle(x, T(3)), axis_angle(y, T(3)), axis_angle(z, T(3)),
+                           axis_angle(z, T(-3)) }) {
+      const auto expected = r.w < 0 ? quaternion<T>{ -r.w, -r.v } : r;
+      assert(near(to_quaternion(rotation_matrix(r)), expected, eps));
+      assert(near(to_quaternion(affine(r, x)), expected, eps));
+    }
+
+    assert(near(slerp(p, q, T(0)), p, eps) && near(slerp(p, q, T(1)), q, eps));
+    const auto half = slerp(quaternion<T>{ 1, { 0, 0, 0 } }, axis_angle(z, T(2)), T(0.5));
+    assert(near(half, axis_angle(z, T(1)), eps));
+    assert(near(slerp(p, quaternion<T>{ -q.w, -q.v }, T(0.25)), slerp(p, q, T(0.25)), eps));
+    assert(near(slerp(p, p, T(0.5)), p, eps));
+  }
+
+template<std::floating_point T>
+  void test_affine()
+  {
+    const T eps = sizeof(T) == 4 ? 1e-5 : 1e-12;
+    const auto r = axis_angle(dir(vec3<T>{ 2, 1, -1 }), T(1.2));
+    const vec3<T> t = { 3, -1, 2 }, s = { 2, 3, T(0.5) }, p = { 1, 2, 3 };
+
+    const mat4<T> rigid = affine(r, t);
+    assert(near(transform_point(rigid, p), vec3<T>(rotate(r, p) + t), eps * 10));
+    assert(near(transform_vector(rigid, p), rotate(r, p), eps * 10));
+    assert(near(rigid, compose(tb::math::translation(t), affine(rotation_matrix(r), vec3<T>(0))), eps));
+
+    const mat4<T> m = compose(rigid, tb::math::scaling(s), tb::math::translation(p));
+    mat4<T> identity(T(0));
+    for (std::size_t i = 0; i < 4; ++i) identity(i, i) = 1;
+    assert(near(inverse_affine(m) * m, identity, eps * 10));
+    assert(near(inverse_rigid(rigid) * rigid, identity, eps));
+    assert(near(inverse_rigid(rigid), inverse_affine(rigid), eps));
+    assert(inverse_rigid(rigid)(3, 3) == 1 && inverse_affine(m)(3, 0) == 0);
+
+    // Normals stay perpendicular to the tangents of a surface
+    const vec3<T> n = { 0, 0, 1 }, u = { 1, 0, 0 }, w = { 1, 1, 0 };
+    const auto nm = normal_matrix(m);
+    assert(std::abs(dot_product(nm * n, transform_vector(m, u))) < eps * 10);
+    assert(std::abs(dot_product(nm * n, transform_vector(m, w))) < eps * 10);
+    assert(near(normal_matrix(rigid), rotation_matrix(r), eps));
+  }
+
+// The batched transforms, for sizes with and without a tail, against the
+// same sums one vector at a time
+template<std::floating_point T>
+  void test_batches()
+  {
+    using tb::math::simd::multiply_add;
+    const mat4<T> m = compose(affine(axis_angle(dir(vec3<T>{ 1, 1, 1 }), T(0.3)), vec3<T>{ 1, 2, 3 }),
+                              tb::math::scaling(vec3<T>{ 1, 2, 3 }));
+    const auto nm = normal_matrix(m);
+    const auto expected = [](const auto& a, const vec3<T>& x, bool translate) {
+      vec3<T> y;
+      for (std::size_t i = 0; i < 3; ++i) {
+        const T t = a.size() == 4 && translate ? a(i, 3) : T(0);
+        y[i] = multiply_add(a(i, 0), x[0], multiply_add(a(i, 1), x[1], multiply_add(a(i, 2), x[2], t)));
+      }
+      return y;
+    };
+
+    for (const std::size_t n : { 0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 33, 64, 1001 }) {
+      std::vector<vec3<T>> x(n), y(n);
+      for (std::size_t i = 0; i < n; ++i) x[i] = { T(i), T(i % 7) - 3, T(1) / T(i + 1) };
+
+      transform_points(m, x, y);
+      for (std::size_t i = 0; i < n; ++i) assert(y[i] == expected(m, x[i], true));
+      auto z = x;
+      transform_points(m, std::span(z));
+      assert(z == y);
+
+      transform_vectors(m, x, y);
+      for (std::size_t i = 0; i < n; ++i) assert(y[i] == expected(m, x[i], false));
+      transform_vectors(nm, x, y);
+      for (std::size_t i = 0; i < n; ++i) assert(y[i] == expected(nm, x[i], false));
+      z = x;
+      transform_vectors(nm, std::span(z));
+      assert(z == y);
+    }
+
+    std::vector<vec3<T>> x(5), y(4);
+    bool thrown = false;
+    try { transform_points(m, x, y); }
+    catch (const std::invalid_argument&) { thrown = true; }
+    assert(thrown);
+  }
+
+int main()
+{
+  test_quaternions<float>();
+  test_quaternions<double>();
+  test_affine<float>();
+  test_affine<double>();
+  test_batches<float>();
+  test_batches<double>();
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,55 @@
+#include "tests.h"
+#include "../src/matrix.h"
+#include "../src/view.h"
+
+using tb::math::num_array, tb::math::Number;
+
+template<Number T>
+  void test_views()
+  {
+    using Vec2 = num_array<T, 2>;
+    using Vec3 = num_array<T, 3>;
+    using Mat2 = num_array<T, 2, 2>;
+    num_array<T, 3, 4> A = {{ 1, 2, 3, 4 }, { 5, 6, 7, 8 }, { 9, 10, 11, 12 }};
+
+    const auto c = column(A, 1);
+    assert(c.size() == 3 && c[0] == 2 && c[1] == 6 && c[2] == 10);
+    assert((c == Vec3{ 2, 6, 10 }));
+
+    const auto d = diagonal(A);
+    assert((d.size() == 3 && d == Vec3{ 1, 6, 11 }));
+
+    const auto t = transpose_view(A);
+    assert(t == transpose(A));
+    assert(A * t == A * transpose(A));
+
+    const auto b = block<2, 2>(A, 1, 2);
+    assert((b == Mat2{{ 7, 8 }, { 11, 12 }}));
+    assert(det(b) == 7 * 12 - 8 * 11);
+
+    assert(row(A, 2) == A[2]);
+    assert(column(t, 2) == A[2]);
+
+    // Operations on views
+    assert(dot_product(column(A, 0), column(A, 1)) == 1 * 2 + 5 * 6 + 9 * 10);
+    assert((b * Vec2{ 1, 1 } == Vec2{ 15, 23 }));
+    Vec3 x = c + d * 2;
+    assert((x == Vec3{ 4, 18, 32 }));
+
+    // Assignment through views
+    column(A, 3) = Vec3(0);
+    assert(A[0][3] == 0 && A[1][3] == 0 && A[2][3] == 0);
+    block<2, 2>(A, 0, 0) += 1;
+    assert(A(0, 0) == 2 && A(1, 1) == 7 && A(2, 2) == 11);
+    diagonal(A) = column(A, 1);
+    assert(A(0, 0) == 3 && A(1, 1) == 7 && A(2, 2) == 10);
+  }
+
+int main()
+{
+  test_views<int>();
+  test_views<float>();
+  test_views<double>();
+
+  return EXIT_SUCCESS;
+}